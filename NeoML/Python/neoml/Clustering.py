@@ -102,16 +102,31 @@ class Hierarchical(PythonWrapper.Hierarchical) :
 
     :param min_cluster_count: the minimum number of clusters in the result.
     :type min_cluster_count: int
+
+    :param linkage: the distance between two clusters:
+        'centroid' is the distance between the cluster centers;
+        'single', 'average' and 'complete' are the minimum, average and maximum distance between the elements;
+        'ward' is the increase of the sum of squared distances to the center, only 'euclid' distance may be used with it.
+    :type linkage: str, {'centroid', 'single', 'average', 'complete', 'ward'}, default='centroid'
+
+    :param thread_count: number of threads
+    :type thread_count: int, > 0, default=1
     """
 
-    def __init__(self, max_cluster_distance, min_cluster_count, distance='euclid'):
+    def __init__(self, max_cluster_distance, min_cluster_count, distance='euclid', linkage='centroid', thread_count=1):
 
         if distance != 'euclid' and distance != 'machalanobis' and distance != 'cosine':
             raise ValueError('The `distance` must be one of {`euclid`, `machalanobis`, `cosine`}.')
         if min_cluster_count <= 0:
             raise ValueError('The `min_cluster_count` must be > 0.')
+        if linkage not in ('centroid', 'single', 'average', 'complete', 'ward'):
+            raise ValueError('The `linkage` must be one of {`centroid`, `single`, `average`, `complete`, `ward`}.')
+        if linkage == 'ward' and distance != 'euclid':
+            raise ValueError('The `ward` linkage may be used only with `euclid` distance.')
+        if thread_count <= 0:
+            raise ValueError('The `thread_count` must be > 0')
 
-        super().__init__(distance, int(max_cluster_distance), int(min_cluster_count))
+        super().__init__(distance, int(max_cluster_distance), int(min_cluster_count), linkage, int(thread_count))
 
     def clusterize(self, X, weight=None):
         """Performs clustering of the given data.
@@ -107,12 +107,17 @@ class GradientBoostClassifier(PythonWrapper.GradientBoost):
 
     :param min_subtree_weight: the minimum subtree weight. The 0 default value means no lower limit.
     :type min_subtree_weight: float, default=0.0
+
+    :param max_leaves: the maximum number of leaves in a tree for ``hist`` and ``multi_hist`` modes.
+        If set, the trees grow leaf-wise: the leaf with the largest gain is split first.
+        -1 means the trees grow depth-first.
+    :type max_leaves: int, default=-1
     """
 
     def __init__(self, loss='binomial', iteration_count=100, learning_rate=0.1,
         subsample=1.0, subfeature=1.0, random_seed=0, max_depth=10,
         max_node_count=-1, l1_reg=0.0, l2_reg=1.0, prune=0.0, thread_count=1,
-        builder_type='full', max_bins=32, min_subtree_weight=0.0):
+        builder_type='full', max_bins=32, min_subtree_weight=0.0, max_leaves=-1):
 
         if loss != 'binomial' and loss != 'exponential' and loss != 'squared_hinge' and loss != 'l2':
             raise ValueError('The `loss` must be one of: `exponential`, `binomial`, `squared_hinge`, `l2`.')
@@ -134,9 +139,11 @@ class GradientBoostClassifier(PythonWrapper.GradientBoost):
             raise ValueError('The `thread_count` must be > 0.')
         if min_subtree_weight < 0:
             raise ValueError('The `min_subtree_weight` must be >= 0.')
+        if max_leaves <= 1 and max_leaves != -1:
+            raise ValueError('The `max_leaves` must be > 1 or equal to -1.')
 
         super().__init__(loss, int(iteration_count), float(learning_rate), float(subsample), float(subfeature), int(random_seed), int(max_depth),
-            int(max_node_count), float(l1_reg), float(l2_reg), float(prune), int(thread_count), builder_type, int(max_bins), float(min_subtree_weight))
+            int(max_node_count), float(l1_reg), float(l2_reg), float(prune), int(thread_count), builder_type, int(max_bins), float(min_subtree_weight), int(max_leaves))
 
     def train(self, X, Y, weight=None):
         """Trains the gradient boosting model for classification.
@@ -261,12 +268,17 @@ class GradientBoostRegressor(PythonWrapper.GradientBoost):
 
     :param min_subtree_weight: the minimum subtree weight. The 0 default value means no lower limit.
     :type min_subtree_weight: float, default=0.0
+
+    :param max_leaves: the maximum number of leaves in a tree for ``hist`` and ``multi_hist`` modes.
+        If set, the trees grow leaf-wise: the leaf with the largest gain is split first.
+        -1 means the trees grow depth-first.
+    :type max_leaves: int, default=-1
     """
 
     def __init__(self, loss='l2', iteration_count=100, learning_rate=0.1,
         subsample=1.0, subfeature=1.0, random_seed=0, max_depth=10,
         max_node_count=-1, l1_reg=0.0, l2_reg=1.0, prune=0.0, thread_count=1,
-        builder_type='full', max_bins=32, min_subtree_weight=0.0):
+        builder_type='full', max_bins=32, min_subtree_weight=0.0, max_leaves=-1):
 
         if loss != 'l2':
             raise ValueError('The `loss` must be `l2` for regression.')
@@ -288,9 +300,11 @@ class GradientBoostRegressor(PythonWrapper.GradientBoost):
             raise ValueError('The `thread_count` must be > 0.')
         if min_subtree_weight < 0:
             raise ValueError('The `min_subtree_weight` must be >= 0.')
+        if max_leaves <= 1 and max_leaves != -1:
+            raise ValueError('The `max_leaves` must be > 1 or equal to -1.')
 
         super().__init__(loss, int(iteration_count), float(learning_rate), float(subsample), float(subfeature), int(random_seed), int(max_depth),
-            int(max_node_count), float(l1_reg), float(l2_reg), float(prune), int(thread_count), builder_type, int(max_bins), float(min_subtree_weight))
+            int(max_node_count), float(l1_reg), float(l2_reg), float(prune), int(thread_count), builder_type, int(max_bins), float(min_subtree_weight), int(max_leaves))
 
     def train(self, X, Y, weight=None):
         """Trains the gradient boosting model for regression.
@@ -360,7 +360,7 @@ void InitializeTrainingModel(py::module& m)
 	py::class_<CPyDecisionTree, CPyTrainingModel>(m, "DecisionTree")
 		.def(
 			py::init([]( int min_subset_size, float min_subset_part, int min_split_size, int max_tree_depth, int max_node_count, const std::string& criterion,
-						float const_threshold, int random_selected_feature_count, const std::string& multiclass_mode )
+						float const_threshold, int random_selected_feature_count, int thread_count, const std::string& multiclass_mode, int max_bins )
 						{
 							CDecisionTreeTrainingModel::CParams p;
 							p.SplitCriterion = CDecisionTreeTrainingModel::SC_Count;
@@ -377,6 +377,8 @@ void InitializeTrainingModel(py::module& m)
 							p.MaxNodesCount = max_node_count;
 							p.ConstNodeThreshold = const_threshold;
 							p.RandomSelectedFeaturesCount = random_selected_feature_count;
+							p.ThreadCount = thread_count;
+							p.MaxBins = max_bins;
 
 							if( multiclass_mode == "single_tree" ) {
 								p.MulticlassMode = MM_SingleClassifier;
@@ -475,7 +477,7 @@ void InitializeTrainingModel(py::module& m)
 		.def( py::init(
 			[]( const std::string& loss, int iteration_count, float learning_rate, float subsample, float subfeature,
 					int random_seed, int max_depth, int max_node_count, float l1_reg, float l2_reg, float prune, int thread_count,
-					const std::string& builder_type, int max_bins, float min_subtree_weight ) {
+					const std::string& builder_type, int max_bins, float min_subtree_weight, int max_leaves ) {
 				CGradientBoost::CParams p;
 				p.LossFunction = CGradientBoost::LF_Undefined;
 				if( loss == "exponential" ) {
@@ -510,6 +512,7 @@ void InitializeTrainingModel(py::module& m)
 				}
 				p.MaxBins = max_bins;
 				p.MinSubsetWeight = min_subtree_weight;
+				p.MaxLeavesCount = max_leaves;
 				p.Representation = GBMR_Compact;
 
 				return new CPyGradientBoost( p, p.Random );
@@ -254,6 +254,10 @@ protected:
 
 	virtual void OnDnnChanged( CDnn* ) {}
 
+	// Called after the trainable parameters have been changed by the solver, loaded or shared from another layer
+	// The layers that keep data calculated from paramBlobs should drop it here
+	virtual void OnParamBlobsChanged() {}
+
 	void SetOutputBlob(int num, CDnnBlob* blob);
 
 	// Indicates if the layer may be used for in-place processing (the output blobs replace the input blobs)
@@ -263,6 +267,10 @@ protected:
 	// Fills with zeros the parameters that are less (but not equal) than a given threshold
 	virtual void FilterLayerParams( float /*threshold*/ ) {}
 
+	// Makes the layer of the same type and configuration use this layer's trainable parameters
+	// The parameter blobs are shared, not copied
+	virtual void TransferParamsBlob( CBaseLayer& dist ) const;
+
 	// Retrieves the reference to the IMathEngine with which the layer was created
 	IMathEngine& MathEngine() const;
 
@@ -313,6 +321,8 @@ private:
 	CArray<int> outputs;
 	// The number of times each output was processed
 	CArray<int> outputProcessedCount;
+	// The offsets of the output blobs in the network memory arena (NotFound for the outputs out of the plan)
+	CArray<__int64> outputArenaOffsets;
 
 	// Indicates if the layer should be reshaped
 	bool isReshapeNeeded;
@@ -383,6 +393,8 @@ private:
 	friend class CDnn;
 	friend class CDnnLayerGraph;
 	friend class CDnnSolver;
+	friend class CCompositeLayer;
+	friend class CDnnFrozenModel;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -509,6 +521,22 @@ public:
 	// The method may be useful for controlling the rebuild frequency
 	bool IsRebuildRequested() const { return isRebuildNeeded; }
 
+	// Enables the static memory planning for RunOnce
+	// The output blobs of all layers are placed into one memory arena, and the blobs
+	// that are never used at the same time share memory. The plan is calculated once per set of blob sizes
+	// The output blobs are overwritten on the next run (same as usual); the sink blobs stay valid until then
+	// Out of the plan (allocated as usual):
+	// - the outputs of the source layers, as they are set from outside;
+	// - the outputs of the in-place and composite layers, as they may be the input blobs;
+	//   the plan keeps such inputs as long as these outputs are used
+	// - the blobs of the networks inside the composite layers, which are run by the composite layers themselves
+	// - the temporary buffers the layers allocate while running
+	void EnableStaticMemoryPlanning( bool enable );
+	bool IsStaticMemoryPlanningEnabled() const { return isStaticMemoryPlanningEnabled; }
+	// Gets the size of the planned memory arena in bytes
+	// Valid after RunOnce; returns 0 if the planning is disabled or the network has not been run yet
+	size_t GetPlannedArenaSize() const;
+
 	// Gets a reference to the random numbers generator
 	CRandom& Random() { return random; }
 
@@ -581,12 +609,26 @@ private:
 	// The low memory use mode
 	bool isReuseMemoryMode;
 
+	//////////////////////////////////////
+	// Static memory planning
+	bool isStaticMemoryPlanningEnabled;
+	// The memory arena for the planned output blobs; null if there is no valid plan
+	CPtr<CDnnBlob> memoryArena;
+	// The size of the arena in elements; it may exceed the maximum blob size
+	size_t memoryArenaSize;
+	// The output descriptions of all layers the plan was calculated for
+	CArray<CBlobDesc> plannedOutputDescs;
+
 	void setProcessingParams(bool isRecurrentMode, int sequenceLength, bool isReverseSequense, bool isBackwardPerformed);
 	void runOnce(int curSequencePos);
 	void backwardRunAndLearnOnce(int curSequencePos);
 	void reshape();
 	void rebuild();
 	size_t getOutputBlobsSize() const;
+	bool isMemoryPlanValid() const;
+	void planMemory();
+	void dropMemoryPlan();
+	void addToExecutionOrder( CBaseLayer* layer, CArray<CBaseLayer*>& order, CMap<const CBaseLayer*, int>& steps ) const;
 
 	friend class CBaseLayer;
 	friend class CCompositeLayer;
@@ -607,6 +649,15 @@ inline CArchive& operator>>( CArchive& archive, CDnn& dnn)
 
 void NEOML_API SerializeLayer( CArchive& archive, IMathEngine& mathEngine, CPtr<CBaseLayer>& layer );
 
+// Loads the network from a file mapped into memory
+// The file should contain the network stored by CDnn::Serialize into an archive that starts at the file beginning
+// With the CPU math engine the parameter blobs use the mapped file contents directly:
+// no copies are made and all the processes that load the same file share the memory
+// The changed parameters are copied to the process memory and are never written to the file
+// The blobs stored by the previous versions and the blobs of the other math engines are loaded as usual
+// The file should not be changed while the network exists
+void NEOML_API LoadDnnFromMappedFile( CDnn& dnn, const char* fileName );
+
 } // namespace NeoML
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -219,6 +219,7 @@ private:
 	CBlobDesc desc;
 	CMemoryHandle data;
 	bool dataOwned;
+	CPtr<IObject> dataHolder; // the owner of the data if it is not allocated by the math engine
 
 	CPtr<CDnnBlob> parent;	// parent blob
 	int parentPos;
@@ -0,0 +1,95 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Dnn.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace NeoML {
+
+// CDnnDynamicBatchExecutor serves the inference requests coming from many threads with one network
+// The requests are accumulated along the BatchWidth dimension of the source blobs until
+// the maximum batch width is reached or the oldest request has waited for the maximum wait time
+// Then the network is run once and the sink blobs are split back between the requests
+// Only the requests with the same blob sizes (except BatchWidth) are processed together
+class NEOML_API CDnnDynamicBatchExecutor {
+public:
+	// The network is run on the executor's own thread and must not be used elsewhere while the executor exists
+	// sourceNames and sinkNames are the names of the CSourceLayer and CSinkLayer layers of the network
+	// The network should keep the BatchWidth of the data (every sink blob has the total BatchWidth of the inputs)
+	CDnnDynamicBatchExecutor( CDnn& dnn, const CArray<CString>& sourceNames, const CArray<CString>& sinkNames,
+		int maxBatchWidth, int maxWaitMilliseconds );
+	~CDnnDynamicBatchExecutor();
+
+	// Processes one request and waits for the result; may be called from several threads
+	// inputs contains one blob per source layer in the sourceNames order; all of them must have the same BatchWidth
+	// outputs receives one blob per sink layer in the sinkNames order
+	void Run( const CObjectArray<CDnnBlob>& inputs, CObjectArray<CDnnBlob>& outputs );
+
+	// The number of network runs and processed requests since the executor was created
+	int GetProcessedBatchCount() const;
+	int GetProcessedRequestCount() const;
+
+private:
+	// A request from one of the calling threads
+	struct CRequest {
+		CObjectArray<CDnnBlob> Inputs;
+		CObjectArray<CDnnBlob> Outputs;
+		int BatchWidth;
+		std::chrono::steady_clock::time_point ArrivalTime;
+		std::exception_ptr Error;
+		bool IsDone;
+
+		CRequest() : BatchWidth( 0 ), IsDone( false ) {}
+	};
+
+	CDnn& dnn;
+	CArray<CString> sourceNames;
+	CArray<CString> sinkNames;
+	const int maxBatchWidth;
+	const std::chrono::milliseconds maxWait;
+
+	mutable std::mutex mutex;
+	// Signals the worker about new requests and stopping
+	std::condition_variable queueCondition;
+	// Signals the callers that their requests are done
+	std::condition_variable doneCondition;
+	// The requests waiting for processing, in arrival order
+	CArray<CRequest*> queue;
+	// The total BatchWidth of the queued requests
+	int queuedBatchWidth;
+	bool isStopping;
+	int processedBatchCount;
+	int processedRequestCount;
+
+	std::thread worker;
+
+	void workerLoop();
+	void extractBatch( CArray<CRequest*>& batch );
+	void processBatch( const CArray<CRequest*>& batch );
+	static bool areCompatible( const CRequest& first, const CRequest& second );
+
+	CDnnDynamicBatchExecutor( const CDnnDynamicBatchExecutor& );
+	CDnnDynamicBatchExecutor& operator=( const CDnnDynamicBatchExecutor& );
+};
+
+} // namespace NeoML
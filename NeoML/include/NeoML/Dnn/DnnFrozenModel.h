@@ -0,0 +1,88 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Random.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+// CDnnInferenceContext is a network created by CDnnFrozenModel
+// It has its own input, output and temporary blobs, but the trainable parameters
+// of its layers are the blobs of the frozen model (no copies are made)
+// The context may be used only for inference and only by one thread at a time
+class NEOML_API CDnnInferenceContext : public IObject {
+public:
+	// The network to be run
+	CDnn& Dnn() { return dnn; }
+	const CDnn& Dnn() const { return dnn; }
+
+protected:
+	virtual ~CDnnInferenceContext() {}
+
+private:
+	CRandom random;
+	CDnn dnn;
+
+	CDnnInferenceContext( IMathEngine& mathEngine, unsigned int seed );
+
+	friend class CDnnFrozenModel;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// CDnnFrozenModel stores the parameters of a trained network once
+// and creates any number of inference contexts that reference them
+// Typical usage is one model per process and one context per worker thread
+// The math engine should outlive the model and all its contexts
+class NEOML_API CDnnFrozenModel : public IObject {
+public:
+	// Loads the trained network from the archive
+	CDnnFrozenModel( IMathEngine& mathEngine, CArchive& archive, unsigned int seed = 42 );
+	// Loads the trained network from a file mapped into memory (see LoadDnnFromMappedFile)
+	// With the CPU math engine the parameters are shared with all the processes that load the same file
+	// The file is opened again by CreateContext, so it should stay unchanged while the model exists
+	CDnnFrozenModel( IMathEngine& mathEngine, const char* fileName, unsigned int seed = 42 );
+
+	// Creates a new inference context
+	// While the context is being created a temporary copy of the parameters is made;
+	// it is released before the method returns
+	// The model loaded from a mapped file maps it once more instead of making the copy
+	// May be called from several threads
+	CPtr<CDnnInferenceContext> CreateContext();
+
+	// The total size of the shared trainable parameters
+	size_t GetTrainableParametersSize() const;
+
+protected:
+	virtual ~CDnnFrozenModel() {}
+
+private:
+	IMathEngine& mathEngine;
+	const unsigned int seed;
+	CRandom random;
+	// The network that owns the parameters; it is never run
+	CDnn dnn;
+	// Indicates if the network is loaded from a mapped file
+	const bool isMappedFile;
+	// The mapped file from which the network is loaded
+	const CString mappedFileName;
+	// Guards the serialization of the network
+	CCriticalSection section;
+};
+
+} // namespace NeoML
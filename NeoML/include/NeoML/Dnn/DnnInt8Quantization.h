@@ -0,0 +1,82 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+// The weights of a layer quantized into int8 for inference
+// Each row of the weights matrix (the weights of one output channel) has its own scale: w = scale * q, q in [-127, 127]
+// The int8 values are packed by 4 into an integer blob, as expected by IMathEngine::MultiplyMatrixByTransposedQuantizedMatrix
+// The layer input is quantized with a single scale calculated from the range collected during calibration
+class NEOML_API CDnnInt8Weights {
+public:
+	explicit CDnnInt8Weights( IMathEngine& mathEngine );
+
+	// While the calibration is enabled, the layer passes its inputs to UpdateInputRange on every run
+	bool IsCalibrationEnabled() const { return isCalibrationEnabled; }
+	void EnableCalibration( bool enable ) { isCalibrationEnabled = enable; }
+	void UpdateInputRange( const CDnnBlob& input );
+	// The maximum absolute value of the inputs seen during calibration
+	float GetInputRange() const { return inputRange; }
+	float GetInputScale() const { return inputRange / 127.f; }
+
+	// Quantizes the weights; each object of the blob is one row of the weights matrix
+	void Quantize( const CDnnBlob& weights );
+	// Removes the quantized weights
+	void Reset();
+	// Makes the other object use the same quantized weights; the blobs are shared, not copied
+	void ShareWith( CDnnInt8Weights& other ) const;
+	bool IsQuantized() const { return quantizedWeights != nullptr; }
+
+	// The description of the original float weights blob
+	const CBlobDesc& GetWeightsDesc() const { return weightsDesc; }
+	int GetRowCount() const { return weightsDesc.ObjectCount(); }
+	int GetRowSize() const { return weightsDesc.ObjectSize(); }
+	// The packed int8 weights and the scales of the rows
+	CIntHandle GetQuantizedWeights() const { return quantizedWeights->GetData<int>(); }
+	CFloatHandle GetScales() const { return scales->GetData(); }
+
+	// Restores the float weights of the original size from the quantized values
+	CPtr<CDnnBlob> Dequantize() const;
+
+	void Serialize( CArchive& archive );
+
+private:
+	IMathEngine& mathEngine;
+	bool isCalibrationEnabled;
+	float inputRange;
+	CBlobDesc weightsDesc;
+	CPtr<CDnnBlob> quantizedWeights;
+	CPtr<CDnnBlob> scales;
+};
+
+// Post-training int8 quantization of a network
+// The supported layers are CFullyConnectedLayer, CConvLayer and CChannelwiseConvLayer, including those inside composite layers
+// CChannelwiseConvLayer does not need the calibration: only its filter is quantized
+// Usage:
+//  1. call EnableInt8Calibration( dnn, true )
+//  2. run the network on a representative set of inputs
+//  3. call QuantizeInt8( dnn )
+// After that the network may be used only for inference; it is serialized with the int8 weights
+// Only the CPU math engine supports the quantized layers
+NEOML_API void EnableInt8Calibration( CDnnLayerGraph& graph, bool enable );
+// Quantizes the layers that have been run during calibration; returns the number of quantized layers
+NEOML_API int QuantizeInt8( CDnnLayerGraph& graph );
+
+} // namespace NeoML
@@ -51,6 +51,13 @@ public:
 	float GetMaxGradientNorm() const { return maxGradientNorm; }
 	void SetMaxGradientNorm(float _maxGradientNorm) { maxGradientNorm = _maxGradientNorm; }
 
+	// Indicates if the parameters of all the layers are updated at once by the fused math engine steps
+	// (see IBlasEngine::FusedAdamStep), which read and write each parameter only once
+	// The fused update is used only on CPU and CUDA; the result is the same up to the rounding errors
+	// By default is true
+	bool IsFusedUpdateEnabled() const { return isFusedUpdateEnabled; }
+	void EnableFusedUpdate( bool enable ) { isFusedUpdateEnabled = enable; }
+
 	// Serialize to archive
 	virtual void Serialize( CArchive& archive, CDnn& dnn );
 
@@ -73,12 +80,28 @@ protected:
 	virtual void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& learningHistory ) = 0;
 
+	// A layer to be trained on the current step
+	struct CLayerToTrain {
+		const CBaseLayer* Layer;
+		const CObjectArray<CDnnBlob>* ParamBlobs;
+		const CObjectArray<CDnnBlob>* ParamDiffBlobs;
+		CObjectArray<CDnnBlob>* LearningHistory;
+	};
+	// Modifies trainable parameters of all the layers that have gradients on the current step
+	// Called once per step after the gradients are averaged and clipped
+	// The default implementation calls TrainLayer for each layer
+	virtual void TrainLayers( const CArray<CLayerToTrain>& layers );
+
+	// Checks if the fused update may be used with the current settings and math engine
+	bool IsFusedUpdateUsed() const { return isFusedUpdateEnabled && ( mathEngine.GetType() == MET_Cpu || mathEngine.GetType() == MET_Cuda ); }
+
 private:
 	IMathEngine& mathEngine;
 	float learningRate;
 	float regularizationL2;
 	float regularizationL1;
 	float maxGradientNorm;
+	bool isFusedUpdateEnabled;
 
 	// The blobs sum
 	struct CDiffBlobSum {
@@ -162,6 +185,8 @@ public:
 protected:
 	void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs, 
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	// Updates the trainable weights of all the layers by one fused step
+	void TrainLayers( const CArray<CLayerToTrain>& layers ) override;
 
 private:
 	// Moment decay rate (moment is a weighted sum of previous gradients)
@@ -213,6 +238,12 @@ public:
 	// Turns AMSGrad mode on. May be called only before training starts.
 	void EnableAmsGrad( bool enable );
 
+	// AdamW: the L2 regularization is applied to the weights directly (decoupled weight decay)
+	// instead of being added to the gradient (see https://arxiv.org/pdf/1711.05101.pdf)
+	// The weights are multiplied by ( 1 - learningRate * L2 ) on each step
+	bool IsDecoupledWeightDecay() const { return isDecoupledWeightDecay; }
+	void SetDecoupledWeightDecay( bool decoupled ) { isDecoupledWeightDecay = decoupled; }
+
 	void Serialize( CArchive& archive, CDnn& dnn ) override;
 
 protected:
@@ -223,6 +254,8 @@ protected:
 	// Updates the trainable weights of the layer
 	virtual void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	// Updates the trainable weights of all the layers by one fused step
+	void TrainLayers( const CArray<CLayerToTrain>& layers ) override;
 
 private:
 	// The gradientHistory array stores the previous values of gradients of different types
@@ -254,6 +287,8 @@ private:
 	float epsilon;
 	// Indicates if AMSGrad is used
 	bool isAmsGradEnabled;
+	// Indicates if the weight decay is decoupled from the gradient (AdamW)
+	bool isDecoupledWeightDecay;
 
 	// Backward compatibility mode
 	bool isInCompatibilityMode;
@@ -268,6 +303,7 @@ private:
 		TV_L1Threshold,
 		TV_L1Mult,
 		TV_EpsilonVar,
+		TV_OpWeightDecayVar,
 		TV_Count
 	};
 
@@ -314,6 +350,8 @@ protected:
 	// Updates the trainable weights of the layer
 	virtual void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	// Updates the trainable weights of all the layers by one fused step
+	void TrainLayers( const CArray<CLayerToTrain>& layers ) override;
 
 private:
 	// The gradientHistory array stores the previous values of gradients of different types
@@ -453,6 +491,8 @@ public:
 protected:
 	void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	// Updates the trainable weights of all the layers by one fused step
+	void TrainLayers( const CArray<CLayerToTrain>& layers ) override;
 
 	void OnTrain() override;
 
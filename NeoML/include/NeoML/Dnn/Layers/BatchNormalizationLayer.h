@@ -63,6 +63,7 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void TransferParamsBlob( CBaseLayer& dist ) const override;
 
 private:
 	bool isChannelBased;
@@ -40,6 +40,13 @@ public:
 	// If newFilter is null, the filter data will be reset.
 	void SetFilterData( const CPtr<CDnnBlob>& newFilter ) override;
 
+	// Int8 quantization (see DnnInt8Quantization.h)
+	// The channelwise convolution is limited by the memory bandwidth, not by the arithmetic,
+	// so only the filter is stored in int8; the float filter is restored on each run
+	// Returns false if the filter has not been initialized
+	bool QuantizeInt8();
+	bool IsInt8Quantized() const { return int8Filter.IsQuantized(); }
+
 protected:
 	virtual ~CChannelwiseConvLayer() { destroyConvDesc(); }
 
@@ -48,11 +55,16 @@ protected:
 	void BackwardOnce() override;
 	void LearnOnce() override;
 	bool IsFilterTransposed() const override { return true; }
+	void TransferParamsBlob( CBaseLayer& dist ) const override;
 
 private:
 	// Convolution descriptor
 	CChannelwiseConvolutionDesc* convDesc;
+	// The quantized filter; each row is the filter of one channel
+	CDnnInt8Weights int8Filter;
 
+	CBlobDesc filterDesc() const;
+	void dequantizeFilter( const CFloatHandle& filter ) const;
 	void initConvDesc();
 	void destroyConvDesc();
 };
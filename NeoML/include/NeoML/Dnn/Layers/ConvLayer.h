@@ -18,6 +18,7 @@ limitations under the License.
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
 #include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/DnnInt8Quantization.h>
 
 namespace NeoML {
 
@@ -119,6 +120,17 @@ public:
 
 	void Serialize( CArchive& archive ) override;
 
+	CPtr<CDnnBlob> GetFilterData() const override;
+	void SetFilterData( const CPtr<CDnnBlob>& newFilter ) override;
+
+	// Int8 quantization (see DnnInt8Quantization.h)
+	// While the calibration is enabled, the layer collects the range of its inputs
+	void EnableInt8Calibration( bool enable ) { int8Filter.EnableCalibration( enable ); }
+	// Replaces the filter with the int8 quantized one; returns false if no input has been seen during calibration
+	// After that the layer may be used only for inference
+	bool QuantizeInt8();
+	bool IsInt8Quantized() const { return int8Filter.IsQuantized(); }
+
 protected:
 	virtual ~CConvLayer();
 
@@ -126,13 +138,24 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void OnParamBlobsChanged() override;
+	void TransferParamsBlob( CBaseLayer& dist ) const override;
 
 private:
+	class CPreparedFilter;
+
 	CConvolutionDesc* convDesc; // the convolution descriptor
+	CDnnInt8Weights int8Filter; // the quantized filter
+	// The filter prepared for the convolution algorithm (see IMathEngine::PrepareBlobConvolutionFilter)
+	// Shared with the layers that share the parameters
+	CPtr<CPreparedFilter> preparedFilter;
+	// The prepared filter used by this layer; taken from preparedFilter on the first run
+	CPtr<CDnnBlob> preparedFilterBlob;
 
 	void calcOutputBlobSize(int& outputHeight, int& outputWidth) const;
 	void initConvDesc();
 	void destroyConvDesc();
+	const CDnnBlob* getPreparedFilter();
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
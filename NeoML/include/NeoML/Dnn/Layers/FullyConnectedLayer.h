@@ -18,6 +18,7 @@ limitations under the License.
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
 #include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/DnnInt8Quantization.h>
 
 namespace NeoML {
 
@@ -45,6 +46,11 @@ public:
 	CPtr<CDnnBlob> GetFreeTermData() const;
 	void SetFreeTermData(const CDnnBlob* newFreeTerms);
 
+	// The weights and the free term blobs used by the layer (not copied), for reading only
+	// May be null if not initialized; the weights are null after the int8 quantization
+	const CDnnBlob* GetWeights() const { return Weights(); }
+	const CDnnBlob* GetFreeTerms() const { return FreeTerms(); }
+
 	// Applies the batch normalization parameters to the internal parameters of the layer
 	// The layer will then return the same output 
 	// that was previously returned by the combination of this layer with batch normalization
@@ -54,6 +60,14 @@ public:
 	bool IsZeroFreeTerm() const { return isZeroFreeTerm; }
 	void SetZeroFreeTerm(bool _isZeroFreeTerm);
 
+	// Int8 quantization (see DnnInt8Quantization.h)
+	// While the calibration is enabled, the layer collects the range of its inputs
+	void EnableInt8Calibration( bool enable ) { int8Weights.EnableCalibration( enable ); }
+	// Replaces the weights with the int8 quantized ones; returns false if no input has been seen during calibration
+	// After that the layer may be used only for inference
+	bool QuantizeInt8();
+	bool IsInt8Quantized() const { return int8Weights.IsQuantized(); }
+
 protected:
 	virtual ~CFullyConnectedLayer();
 
@@ -62,6 +76,7 @@ protected:
 	void BackwardOnce() override;
 	void LearnOnce() override;
 	void FilterLayerParams( float threshold ) override;
+	void TransferParamsBlob( CBaseLayer& dist ) const override;
 
 	// The filter. The pointer is valid only if the desired parameters are known (either defined externally or obtained on reshape)
 	CPtr<CDnnBlob>& Weights() { return paramBlobs[0]; }
@@ -76,6 +91,7 @@ protected:
 private:
 	int numberOfElements; // the number of elements (neurons) of the fully-connected layer
 	bool isZeroFreeTerm; // indicates if the free term should be set to zero
+	CDnnInt8Weights int8Weights; // the quantized weights
 };
 
 NEOML_API CLayerWrapper<CFullyConnectedLayer> FullyConnected(
@@ -47,6 +47,18 @@ public:
 	void SetGateWeightsData(CDnnBlob* newWeights) { gateLayer->SetWeightsData(newWeights); }
 	void SetGateFreeTermData(CDnnBlob* newFreeTerm) { gateLayer->SetFreeTermData(newFreeTerm); }
 
+	// Fused inference mode: the whole sequence is processed by a few math engine calls
+	// (matrix multiplications for the inputs and IMathEngine::GruRecurrent for the recurrent part)
+	// instead of running the internal network step by step
+	// The mode is used only on CPU, during inference, without repeats and initial state inputs;
+	// otherwise the internal network is run
+	// Off by default
+	bool IsFusedInference() const { return isFusedInference; }
+	void SetFusedInference( bool isFused ) { isFusedInference = isFused; }
+
+protected:
+	void RunOnce() override;
+
 private:
 	// The indices of the gates in the hidden layer output
 	enum TGateOut {
@@ -60,8 +72,11 @@ private:
 	CPtr<CFullyConnectedLayer> gateLayer;
 	CPtr<CSplitChannelsLayer> splitLayer;
 	CPtr<CBackLinkLayer> mainBackLink;
+	bool isFusedInference;
 
 	void buildLayer();
+	bool canRunFused() const;
+	void runFused();
 };
 
 NEOML_API CLayerWrapper<CGruLayer> Gru( int hiddenSize );
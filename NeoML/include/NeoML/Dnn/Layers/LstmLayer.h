@@ -66,6 +66,18 @@ public:
 	bool IsInCompatibilityMode() const { return isInCompatibilityMode; }
 	void SetCompatibilityMode( bool compatibilityMode );
 
+	// Fused inference mode: the whole sequence is processed by a few math engine calls
+	// (one matrix multiplication for the inputs and IMathEngine::LstmRecurrent for the recurrent part)
+	// instead of running the internal network step by step
+	// The mode is used only on CPU, during inference, with the sigmoid recurrent activation,
+	// without the compatibility mode, repeats and initial state inputs; otherwise the internal network is run
+	// Off by default
+	bool IsFusedInference() const { return isFusedInference; }
+	void SetFusedInference( bool isFused ) { isFusedInference = isFused; }
+
+protected:
+	void RunOnce() override;
+
 private:
 	// The gate numbers for the hidden layer output
 	enum TGateOut {
@@ -91,8 +103,11 @@ private:
 
 	TActivationFunction recurrentActivation;
 	bool isInCompatibilityMode;
+	bool isFusedInference;
 
 	void buildLayer(float dropout);
+	bool canRunFused() const;
+	void runFused();
 	void setWeightsData(const CPtr<CDnnBlob>& newWeights);
 };
 
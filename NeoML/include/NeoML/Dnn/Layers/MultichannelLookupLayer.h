@@ -79,6 +79,7 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void TransferParamsBlob( CBaseLayer& dist ) const override;
 
 private:
 	// The size of stored vectors
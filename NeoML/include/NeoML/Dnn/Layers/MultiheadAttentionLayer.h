@@ -73,10 +73,19 @@ public:
 	int GetOutputSize() const { return outputSize; }
 	void SetOutputSize( int _outputSize );
 
+	// Fused inference mode: the attention is calculated by IMathEngine::ScaledDotProductAttention
+	// without storing the attention matrix, instead of running the internal network
+	// The mode is used only on CPU, during inference, when the second output (the attention matrix) is not connected;
+	// otherwise the internal network is run
+	// Off by default
+	bool IsFusedInference() const { return isFusedInference; }
+	void SetFusedInference( bool isFused );
+
 	void Serialize( CArchive& archive ) override;
 
 protected:
 	void Reshape() override;
+	void RunOnce() override;
 
 private:
 	// The amount of heads
@@ -89,8 +98,18 @@ private:
 	bool useMask;
 	// Output size
 	int outputSize;
+	// Fused inference mode
+	bool isFusedInference;
+	// The buffers of the fused inference, allocated on reshape
+	CPtr<CDnnBlob> fusedQ;
+	CPtr<CDnnBlob> fusedK;
+	CPtr<CDnnBlob> fusedV;
+	CPtr<CDnnBlob> fusedHeads;
+	CPtr<CDnnBlob> fusedMask;
 
 	void create();
+	bool canRunFused();
+	void runFused();
 
 	// Layer inputs
 	enum TInputs {
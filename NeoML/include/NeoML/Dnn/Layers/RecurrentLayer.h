@@ -55,6 +55,10 @@ protected:
 	void RunInternalDnnBackward() override;
 	void SetInternalDnnParams() override;
 
+	// Indicates if the whole sequence may be processed at once instead of running the internal network step by step:
+	// the network is not learning, the layer is not inside another recurrent layer and the sequence is not repeated
+	bool IsWholeSequenceInference() const;
+
 private:
 	// The backward links
 	CObjectArray<CBackLinkLayer> backLinks;
@@ -25,6 +25,7 @@ limitations under the License.
 #include "internal/FastArrayFOL.h"
 #include "ObjectFOL.h"
 #include "ArrayFOL.h"
+#include "MemoryFileFOL.h"
 #include "internal/PointerArrayFOL.h"
 #include "internal/HashTableAllocatorFOL.h"
 #include "internal/HashTableFOL.h"
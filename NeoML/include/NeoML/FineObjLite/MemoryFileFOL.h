@@ -0,0 +1,100 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "BaseFileFOL.h"
+#include "ArrayFOL.h"
+
+namespace FObj {
+
+// The binary file that stores its contents in memory
+class CMemoryFile : public CBaseFile {
+public:
+	CMemoryFile() : position( 0 ) {}
+
+	// Retrieves the file contents
+	const BYTE* GetBufferPtr() const { return buffer.GetPtr(); }
+	int GetBufferSize() const { return buffer.Size(); }
+
+	// CBaseFile class methods
+	const char* GetFileName() const override { return "Memory file."; }
+	int Read( void* ptr, int bytesCount ) override;
+	void Write( const void* ptr, int bytesCount ) override;
+	__int64 GetPosition() const override { return position; }
+	__int64 Seek( __int64 offset, TSeekPosition from ) override;
+	void SetLength( __int64 newLength ) override;
+	__int64 GetLength() const override { return buffer.Size(); }
+	void Abort() override { Close(); }
+	void Flush() override {}
+	void Close() override { buffer.DeleteAll(); buffer.FreeBuffer(); position = 0; }
+
+private:
+	CArray<BYTE> buffer;
+	int position;
+};
+
+inline int CMemoryFile::Read( void* ptr, int bytesCount )
+{
+	AssertFO( bytesCount >= 0 );
+	const int result = min( bytesCount, buffer.Size() - position );
+	if( result > 0 ) {
+		::memcpy( ptr, buffer.GetPtr() + position, result );
+		position += result;
+	}
+	return max( result, 0 );
+}
+
+inline void CMemoryFile::Write( const void* ptr, int bytesCount )
+{
+	AssertFO( bytesCount >= 0 );
+	if( bytesCount == 0 ) {
+		return;
+	}
+	if( position + bytesCount > buffer.Size() ) {
+		buffer.SetSize( position + bytesCount );
+	}
+	::memcpy( buffer.GetPtr() + position, ptr, bytesCount );
+	position += bytesCount;
+}
+
+inline __int64 CMemoryFile::Seek( __int64 offset, TSeekPosition from )
+{
+	__int64 newPosition = offset;
+	switch( from ) {
+		case begin:
+			break;
+		case current:
+			newPosition += position;
+			break;
+		case end:
+			newPosition += buffer.Size();
+			break;
+		default:
+			AssertFO( false );
+	}
+	AssertFO( 0 <= newPosition && newPosition <= INT_MAX );
+	position = static_cast<int>( newPosition );
+	return position;
+}
+
+inline void CMemoryFile::SetLength( __int64 newLength )
+{
+	AssertFO( 0 <= newLength && newLength <= INT_MAX );
+	buffer.SetSize( static_cast<int>( newLength ) );
+	position = min( position, buffer.Size() );
+}
+
+} // namespace FObj
@@ -78,6 +78,9 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/GruLayer.h>
 #include <NeoML/Dnn/DnnSolver.h>
 #include <NeoML/Dnn/DnnInitializer.h>
+#include <NeoML/Dnn/DnnFrozenModel.h>
+#include <NeoML/Dnn/DnnDynamicBatchExecutor.h>
+#include <NeoML/Dnn/DnnInt8Quantization.h>
 #include <NeoML/Dnn/Layers/MultichannelLookupLayer.h>
 #include <NeoML/Dnn/Layers/MaxOverTimePoolingLayer.h>
 #include <NeoML/Dnn/Layers/3dConvLayer.h>
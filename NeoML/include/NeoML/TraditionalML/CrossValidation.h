@@ -35,12 +35,18 @@ class NEOML_API CCrossValidation {
 public:
 	CCrossValidation( ITrainingModel& trainingModel, const IProblem* problem );
 
+	// Sets the total number of threads used for cross-validation
+	// The models are trained in parallel by single-thread copies of the base training model
+	// (see ITrainingModel::CreateCopy); by default they are trained one after another
+	void SetThreadCount( int newThreadCount ) { NeoAssert( newThreadCount > 0 ); threadCount = newThreadCount; }
+
 	// Performs cross-validation
 	void Execute( int partsCount, TScore score, CCrossValidationResult& results, bool stratified );
 
 private:
 	ITrainingModel& trainingModel; // the base training model
 	const CPtr<const IProblem> problem; // the input data
+	int threadCount; // the total number of threads
 };
 
 } // namespace NeoML
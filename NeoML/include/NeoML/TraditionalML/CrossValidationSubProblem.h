@@ -50,6 +50,8 @@ private:
 	int vectorsCount; // the number of vectors in the subset
 	CArray<int> pointerB; // vector start pointers
 	CArray<int> pointerE; // vector end pointers
+	CArray<__int64> pointerB64; // vector start pointers if the base matrix uses 64-bit indices
+	CArray<__int64> pointerE64; // vector end pointers if the base matrix uses 64-bit indices
 	CFloatMatrixDesc matrix; // the matrix descriptor for the problem
 
 	int translateIndex( int index ) const;
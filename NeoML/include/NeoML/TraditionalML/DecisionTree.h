@@ -138,6 +138,12 @@ public:
 		size_t AvailableMemory; 
 		// The algorithm used for multi-class classification
 		TMulticlassMode MulticlassMode;
+		// The number of processing threads to be used while training the model
+		int ThreadCount;
+		// The maximum number of histogram bins for each feature; 0 means the exact feature values are used
+		// Otherwise the feature values are quantized and the split search works over the bin histograms,
+		// which is much faster and needs less memory on large data sets. All features are treated as continuous in this mode
+		int MaxBins;
 
 		CParams() :
 			MinContinuousSubsetSize( 1 ),
@@ -151,7 +157,9 @@ public:
 			ConstNodeThreshold( 0.99 ),
 			RandomSelectedFeaturesCount( NotFound ),
 			AvailableMemory( Gigabyte ),
-			MulticlassMode( MM_SingleClassifier )
+			MulticlassMode( MM_SingleClassifier ),
+			ThreadCount( 1 ),
+			MaxBins( 0 )
 		{
 		}
 	};
@@ -165,8 +173,12 @@ public:
 
 	// The ITrainingModel interface methods:
 	virtual CPtr<IModel> Train( const IProblem& problem );
+	// The copies are not supported when the features are selected randomly, as the random generator is shared
+	virtual ITrainingModel* CreateCopy( int threadCount ) const;
 
 private:
+	struct CSplit;
+
 	static const int MaxClassifyNodesCacheSize = 10 * Megabyte; // the cache size for leaf nodes
 	CParams params; // the classification parameters
 	CRandom defRandom; // the default random numbers generator
@@ -182,7 +194,8 @@ private:
 	CPtr<CDecisionTreeNodeBase> buildTree( int vectorCount );
 	bool buildTreeLevel( const CFloatMatrixDesc& matrix, int level, CDecisionTreeNodeBase& root ) const;
 	bool collectStatistics( const CFloatMatrixDesc& matrix, int level, CDecisionTreeNodeBase* root ) const;
-	bool split( const CDecisionTreeNodeStatisticBase& nodeStatistics, int level ) const;
+	void findSplit( const CDecisionTreeNodeStatisticBase& nodeStatistics, int level, int threadCount, CSplit& nodeSplit ) const;
+	bool split( const CDecisionTreeNodeStatisticBase& nodeStatistics, CSplit& nodeSplit, int level ) const;
 	void generateUsedFeatures( int randomSelectedFeaturesCount, int featuresCount, CArray<int>& features ) const;
 
 	CPtr<CDecisionTreeNodeBase> createNode() const;
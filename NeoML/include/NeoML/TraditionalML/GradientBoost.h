@@ -30,7 +30,6 @@ class CGradientBoostStatisticsSingle;
 class CGradientBoostStatisticsMulti;
 template<class T>
 class CGradientBoostFastHistTreeBuilder;
-class IGradientBoostingLossFunction;
 class CGradientBoostModel;
 class CGradientBoostFullProblem;
 class CGradientBoostFastHistProblem;
@@ -80,6 +79,34 @@ enum TGradientBoostModelRepresentation {
 	GBMR_QuickScorer
 };
 
+// The loss function optimized by the gradient boosting
+// Implement this interface to train the ensemble with a custom loss (see CGradientBoost::LF_Custom)
+class NEOML_API IGradientBoostingLossFunction : public virtual IObject {
+public:
+	virtual ~IGradientBoostingLossFunction();
+
+	// Calculates the first (gradients) and the second (hessians) derivatives of the loss by the predictions
+	// For classification, the answer is 1 if the vector belongs to the class and 0 otherwise
+	// The buffers are processed by parts, several parts may be processed in parallel
+	virtual void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const = 0;
+	// Calculates the sum of the loss values
+	virtual double CalcLossSum( const double* predicts, const double* answers, int size ) const = 0;
+};
+
+// The problem data split into parts for writing the binned data (see CGradientBoost::WriteBinnedData)
+// The parts are requested one at a time and several times each, so only one part should be kept in memory
+class NEOML_API IGradientBoostProblemParts : public virtual IObject {
+public:
+	virtual ~IGradientBoostProblemParts();
+
+	// Gets the number of parts
+	virtual int GetPartCount() const = 0;
+	// Gets the part; the vectors of all parts in turn are the vectors of the trained problem
+	// Only the vectors and their weights are binned, so the values of the part do not matter
+	virtual CPtr<const IMultivariateRegressionProblem> GetPart( int index ) const = 0;
+};
+
 // Gradient tree boosting
 class NEOML_API CGradientBoost : public ITrainingModel, public IRegressionTrainingModel {
 public:
@@ -89,12 +116,14 @@ public:
 		LF_Binomial, // LogitBoost - classification only
 		LF_SquaredHinge, // smoothed squared hinge - classification only
 		LF_L2, // quadratic function
+		LF_Custom, // the function set in CParams::CustomLossFunction
 		LF_Undefined
 	};
 
 	// Classification parameters
 	struct CParams {
 		TLossFunction LossFunction; // the loss function
+		CPtr<IGradientBoostingLossFunction> CustomLossFunction; // the loss function for LF_Custom
 		int IterationsCount; // the maximum number of iterations (the number of trees in the ensemble)
 		float LearningRate; // the multiplier of each classifier
 		float Subsample; // the fraction of input data that is used for building one tree; may be from 0 to 1
@@ -113,8 +142,19 @@ public:
 		int ThreadCount; // the number of processing threads to be used while training the model
 		TGradientBoostTreeBuilder TreeBuilder; // the type of tree builder used
 		int MaxBins; // the largest possible histogram size to be used in *GBTB_FastHist* mode
+		// The maximum number of leaves in a tree for *GBTB_FastHist* and *GBTB_MultiFastHist* modes
+		// If set, the trees grow leaf-wise: the leaf with the largest gain is split first
+		// Set to -1 to grow the trees depth-first
+		int MaxLeavesCount;
+		// The maximum number of node histograms kept in memory while growing a tree leaf-wise
+		// The least recently built histograms are evicted and rebuilt when necessary (set to -1 for no limitation)
+		int MaxHistCount;
 		float MinSubsetWeight; // the minimum subtree weight (set to 0 to have no lower limit)
 		float DenseTreeBoostCoefficient; // the dense tree boost coefficient (only for GBTB_MultiFull)
+		// The number of iterations without the validation loss improvement after which the training stops
+		// The trees built after the best iteration are removed from the ensemble
+		// Works only if the validation problem is set (see SetValidationProblem); set to 0 to build all IterationsCount trees
+		int EarlyStoppingPatience;
 		// Representation of training result.
 		TGradientBoostModelRepresentation Representation;
 
@@ -133,8 +173,11 @@ public:
 			ThreadCount( 1 ),
 			TreeBuilder( GBTB_Full ),
 			MaxBins( 32 ),
+			MaxLeavesCount( NotFound ),
+			MaxHistCount( NotFound ),
 			MinSubsetWeight( 0.f ),
 			DenseTreeBoostCoefficient( 0.f ),
+			EarlyStoppingPatience( 0 ),
 			Representation( GBMR_Compact )
 		{
 		}
@@ -155,10 +198,37 @@ public:
 
 	// ITrainingModel interface methods:
 	virtual CPtr<IModel> Train( const IProblem& problem );
+	// The copies are not supported when CParams::Random is set, as the random generator is shared
+	virtual ITrainingModel* CreateCopy( int threadCount ) const;
 
 	// Returns the last loss mean
 	double GetLastLossMean() const { return loss; }
 
+	// Writes the problem data binned for the GBTB_FastHist and GBTB_MultiFastHist builders (see CParams::MaxBins) to a file
+	// The binned data is written vector by vector, so it does not have to fit into memory
+	void WriteBinnedData( const IProblem& problem, const char* fileName ) const;
+	void WriteBinnedData( const IRegressionProblem& problem, const char* fileName ) const;
+	void WriteBinnedData( const IMultivariateRegressionProblem& problem, const char* fileName ) const;
+	// Writes the binned data of the problem that is loaded by parts, so the problem does not have to fit into memory either
+	void WriteBinnedData( const IGradientBoostProblemParts& parts, const char* fileName ) const;
+	// Sets the file written by WriteBinnedData for the problem that will be trained
+	// The GBTB_FastHist and GBTB_MultiFastHist builders will read the binned data from the memory-mapped file
+	// instead of keeping it in memory, and the training predictions are calculated from it as well
+	// Then the vectors of the trained problem are not read, only their values and weights are used
+	// Set an empty name to bin the data in memory again
+	void SetBinnedDataFile( const char* fileName ) { binnedDataFileName = fileName; }
+
+	// Sets the validation problem for the next training
+	// The loss on this problem is calculated after each iteration, updating the predictions only with the new trees
+	// The problem should be of the same kind as the trained one; set to null to train without validation
+	void SetValidationProblem( const IProblem* problem );
+	void SetValidationProblem( const IRegressionProblem* problem );
+	void SetValidationProblem( const IMultivariateRegressionProblem* problem );
+	// Returns the validation loss mean after each iteration of the last training
+	const CArray<double>& GetValidationLoss() const { return validationLoss; }
+	// Returns the number of iterations with the best validation loss in the last training
+	int GetBestIterationsCount() const { return bestIterationsCount; }
+
 private:
 	// A cache element that contains the ensemble predictions for a vector on a given step
 	struct CPredictionCacheItem {
@@ -169,6 +239,8 @@ private:
 	const CParams params; // the classification parameters
 	CRandom defaultRandom; // the default random number generator
 	CTextStream* logStream; // the logging stream
+	CString binnedDataFileName; // the binned data file for the FastHist builders
+	CPtr<const IMultivariateRegressionProblem> validationProblem; // the problem for the validation loss
 	CPtr<CGradientBoostFullTreeBuilder<CGradientBoostStatisticsSingle>> fullSingleClassTreeBuilder; // TGBT_Full tree builder for single class
 	CPtr<CGradientBoostFullTreeBuilder<CGradientBoostStatisticsMulti>> fullMultiClassTreeBuilder; // TGBT_Full tree builder for multi class
 	CPtr<CGradientBoostFastHistTreeBuilder<CGradientBoostStatisticsSingle>> fastHistSingleClassTreeBuilder; // TGBT_FastHist tree builder for single class
@@ -196,6 +268,12 @@ private:
 	// The inverse mapping of features
 	// The array length is equal to the total number of features
 	CArray<int> featureNumbers;
+	// The ensemble predictions and the correct answers for the validation problem vectors
+	// The indices are the same as in predicts and answers
+	CArray< CArray<double> > validationPredicts;
+	CArray< CArray<double> > validationAnswers;
+	CArray<double> validationLoss; // the validation loss after each iteration
+	int bestIterationsCount; // the number of iterations with the best validation loss
 
 	CPtr<IObject> train(
 		const IMultivariateRegressionProblem* problem,
@@ -208,7 +286,12 @@ private:
 		const IMultivariateRegressionProblem* problem, const CArray<CGradientBoostEnsemble>& models,
 		CObjectArray<IRegressionTreeNode>& curModels );
 	void buildPredictions( const IMultivariateRegressionProblem& problem, const CArray<CGradientBoostEnsemble>& models, int curStep );
+	void getTrainingVector( const CFloatMatrixDesc& matrix, int index, CArray<int>& indexesBuffer,
+		CArray<float>& valuesBuffer, CFloatVectorDesc& vector ) const;
 	void buildFullPredictions( const IMultivariateRegressionProblem& problem, const CArray<CGradientBoostEnsemble>& models );
+	void initializeValidation( const IMultivariateRegressionProblem& problem );
+	double updateValidationPredictions( const IGradientBoostingLossFunction& lossFunction,
+		const CArray<CGradientBoostEnsemble>& models, int prevStep );
 	CPtr<IObject> createOutputRepresentation(
 		CArray<CGradientBoostEnsemble>& models, int predictionSize );
 };
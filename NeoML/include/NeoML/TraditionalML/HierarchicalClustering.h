@@ -27,11 +27,35 @@ namespace NeoML {
 // until the limit to the clusters number or the distance between them is reached
 class NEOML_API CHierarchicalClustering : public IClustering {
 public:
+	// The distance between two clusters
+	enum TLinkage {
+		// The distance between the cluster centers; the distances to the merged cluster are calculated anew
+		L_Centroid = 0,
+		// The minimum distance between the initial clusters of the two clusters
+		L_Single,
+		// The average distance between the initial clusters of the two clusters (weighted by their element weights)
+		L_Average,
+		// The maximum distance between the initial clusters of the two clusters
+		L_Complete,
+		// The increase of the sum of squared distances to the cluster center after the merge
+		// Only DF_Euclid distance may be used; the merge of two single elements costs the squared distance between them
+		L_Ward,
+
+		L_Count
+	};
+
 	// Algorithm settings
 	struct CParam {
 		TDistanceFunc DistanceType; // the distance function
 		double MaxClustersDistance; // the maximum distance between two clusters that still may be merged
 		int MinClustersCount; // the minimum number of clusters in the result
+		TLinkage Linkage; // the distance between the clusters
+		int ThreadCount; // the number of threads used to calculate the distances
+
+		CParam() : DistanceType( DF_Euclid ), MaxClustersDistance( 1e32 ), MinClustersCount( 1 ), Linkage( L_Centroid ),
+			ThreadCount( 1 )
+		{
+		}
 	};
 
 	CHierarchicalClustering( const CArray<CClusterCenter>& clusters, const CParam& params );
@@ -47,15 +71,39 @@ public:
 	bool Clusterize( IClusteringData* input, CClusteringResult& result ) override;
 
 private:
+	// The merge of two clusters
+	struct CMerge {
+		int First; // the first cluster
+		int Second; // the second cluster
+		float Distance; // the distance between the clusters
+
+		CMerge() : First( NotFound ), Second( NotFound ), Distance( 0 ) {}
+		CMerge( int first, int second, float distance ) : First( first ), Second( second ), Distance( distance ) {}
+	};
+
 	const CParam params; // the clustering parameters
 	CTextStream* log; // the logging stream
 	CArray<CClusterCenter> initialClusters; // the initial cluster centers
 	CObjectArray<CCommonCluster> clusters; // the current clusters
-	CFloatVectorArray distances; // the matrix containing distances between clusters
+	CArray<double> clusterWeights; // the total element weight of each cluster
+	// The upper triangle of the matrix containing distances between clusters
+	// The distance between the i and j clusters (i < j) is stored in distances[i][j - i - 1]
+	CArray< CArray<float> > distances;
+	// The nearest of the clusters with larger indices for each cluster (used for L_Centroid)
+	CArray<int> nearestClusters;
 
 	void initialize( const CFloatMatrixDesc& matrix, const CArray<double>& weights );
+	float getDistance( int first, int second ) const;
+	void setDistance( int first, int second, float distance );
+	bool clusterizeCentroid( const CFloatMatrixDesc& matrix, const CArray<double>& weights );
+	void findNearestCluster( int cluster );
 	void findNearestClusters( int& first, int& second ) const;
 	void mergeClusters( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int first, int second );
+	bool clusterizeLinkage( const CFloatMatrixDesc& matrix, const CArray<double>& weights );
+	void buildDendrogram( CArray<CMerge>& merges );
+	float calcLinkageDistance( double firstWeight, double secondWeight, double otherWeight,
+		float firstDistance, float secondDistance, float distance ) const;
+	void addClusterElements( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int target, int source );
 };
 
 } // namespace NeoML
@@ -106,6 +106,7 @@ public:
 	// ITrainingModel interface methods:
 	// Trains IOneVersusAllModel if number of classes > 2
 	CPtr<IModel> Train( const IProblem& trainingClassificationData ) override;
+	ITrainingModel* CreateCopy( int threadCount ) const override;
 
 private:
 	const CParams params; // classification parameters
@@ -28,7 +28,8 @@ public:
 	// and the total number of vectors is not greater than rowsBufferSize
 	// and the total number of non-zero elements across all vectors is not greater than elementsBufferSize
 	// then it's guaranteed that there will be no additional allocations during the CMemoryProblem::Add calls.
-	CMemoryProblem( int featureCount, int classCount, int rowsBufferSize = 0, int elementsBufferSize = 0 );
+	// The total number of elements may exceed INT_MAX, then the matrix will use 64-bit indices (see CFloatMatrixDesc)
+	CMemoryProblem( int featureCount, int classCount, int rowsBufferSize = 0, __int64 elementsBufferSize = 0 );
 	CMemoryProblem(); // used for loading serialized problems
 
 	// Adds a vector to the set
@@ -37,6 +37,11 @@ public:
 	virtual bool Classify( const CFloatVector& data, CClassificationResult& result ) const
 		{ return Classify( data.GetDesc(), result ); }
 
+	// Classifies all rows of the matrix using threadCount threads; results[i] is the result for the i-th row
+	// Returns true if all the rows have been classified successfully
+	// The default implementation calls Classify for each row
+	virtual bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const;
+
 	// Serializes the model
 	virtual void Serialize( CArchive& archive ) = 0;
 };
@@ -53,6 +58,10 @@ public:
 	virtual double Predict( const CFloatVector& data ) const
 		{ return Predict( data.GetDesc() ); };
 
+	// Predicts the function values on all rows of the matrix using threadCount threads
+	// The default implementation calls Predict for each row
+	virtual void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const;
+
 	// Serializes the model
 	virtual void Serialize( CArchive& archive ) = 0;
 };
@@ -56,12 +56,18 @@ public:
 	// Sets a text stream for logging processing
 	void SetLog( CTextStream* newLog ) { logStream = newLog; }
 
+	// Sets the total number of threads used for training
+	// The binary classifiers are trained in parallel by single-thread copies of the base classifier
+	// (see ITrainingModel::CreateCopy); by default they are trained one after another
+	void SetThreadCount( int newThreadCount ) { NeoAssert( newThreadCount > 0 ); threadCount = newThreadCount; }
+
 	// ITrainingModel interface methods:
 	virtual CPtr<IModel> Train( const IProblem& trainingClassificationData );
 
 private:
 	ITrainingModel& baseBinaryClassifier; // the basic binary classifier used
 	CTextStream* logStream; // the logging stream
+	int threadCount; // the total number of threads
 };
 
 } // namespace NeoML
@@ -32,12 +32,18 @@ public:
 	// Sets a text stream for logging
 	void SetLog( CTextStream* newLog ) { log = newLog; }
 
+	// Sets the total number of threads used for training
+	// The binary classifiers are trained in parallel by single-thread copies of the base classifier
+	// (see ITrainingModel::CreateCopy); by default they are trained one after another
+	void SetThreadCount( int newThreadCount ) { NeoAssert( newThreadCount > 0 ); threadCount = newThreadCount; }
+
 	// ITrainingModel interface methods
 	CPtr<IModel> Train( const IProblem& traningData ) override;
 
 private:
 	ITrainingModel& baseClassifier; // the basic binary classifier used
 	CTextStream* log; // the logging stream
+	int threadCount; // the total number of threads
 };
 
 } // namespace NeoML
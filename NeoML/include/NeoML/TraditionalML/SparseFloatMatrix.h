@@ -24,6 +24,7 @@ namespace NeoML {
 // A matrix descriptor
 // If Columns field is not set assume dense representation, otherwise assume sparse.
 // Note that PointerB and PointerE must be defined for both! 
+// If the matrix has more than INT_MAX elements, PointerB64 and PointerE64 are set instead of PointerB and PointerE
 struct NEOML_API CFloatMatrixDesc {
 	int Height; // the matrix height
 	int Width; // the matrix width
@@ -31,12 +32,23 @@ struct NEOML_API CFloatMatrixDesc {
 	float* Values; // the values array
 	int* PointerB; // the array of indices for vector start in Columns/Values
 	int* PointerE; // the array of indices for vector end in Columns/Values
+	__int64* PointerB64; // the 64-bit array of indices for vector start in Columns/Values
+	__int64* PointerE64; // the 64-bit array of indices for vector end in Columns/Values
 
-	CFloatMatrixDesc() : Height(0), Width(0), Columns(nullptr), Values(nullptr), PointerB(nullptr), PointerE(nullptr) {}
+	CFloatMatrixDesc() : Height(0), Width(0), Columns(nullptr), Values(nullptr), PointerB(nullptr), PointerE(nullptr),
+		PointerB64(nullptr), PointerE64(nullptr) {}
+
+	// Checks if the 64-bit indices are used
+	bool Is64Bit() const { return PointerB64 != nullptr; }
+	// Retrieves the indices of the row start and end in Columns/Values
+	__int64 GetRowBegin( int index ) const { return PointerB64 == nullptr ? PointerB[index] : PointerB64[index]; }
+	__int64 GetRowEnd( int index ) const { return PointerE64 == nullptr ? PointerE[index] : PointerE64[index]; }
 
 	// Retrieves the descriptor of a row (as a sparse vector)
 	void GetRow( int index, CFloatVectorDesc& desc ) const;
 	CFloatVectorDesc GetRow( int index ) const;
+	// Retrieves the descriptor of rowCount rows starting from firstRow (as a matrix)
+	CFloatMatrixDesc GetRows( int firstRow, int rowCount ) const;
 
 	static CFloatMatrixDesc Empty; // the empty matrix descriptor
 };
@@ -47,14 +59,18 @@ typedef CFloatMatrixDesc CSparseFloatMatrixDesc;
 inline void CFloatMatrixDesc::GetRow( int index, CFloatVectorDesc& desc ) const
 {
 	NeoAssert( 0 <= index && index < Height );
-	desc.Size = PointerE[index] - PointerB[index];
-	desc.Values = Values + PointerB[index];
-	if( Columns == nullptr ) { // dense representation
-		NeoPresume( desc.Size == Width );
-		desc.Indexes = nullptr;
+	if( PointerB64 == nullptr ) {
+		desc.Size = PointerE[index] - PointerB[index];
+		desc.Values = Values + PointerB[index];
+		desc.Indexes = Columns == nullptr ? nullptr : Columns + PointerB[index];
 	} else {
-		desc.Indexes = Columns + PointerB[index];
+		// A single row always fits into int
+		NeoPresume( PointerE64[index] - PointerB64[index] <= INT_MAX );
+		desc.Size = static_cast<int>( PointerE64[index] - PointerB64[index] );
+		desc.Values = Values + PointerB64[index];
+		desc.Indexes = Columns == nullptr ? nullptr : Columns + PointerB64[index];
 	}
+	NeoPresume( Columns != nullptr || desc.Size == Width ); // dense representation
 }
 
 inline CFloatVectorDesc CFloatMatrixDesc::GetRow( int index ) const
@@ -64,18 +80,34 @@ inline CFloatVectorDesc CFloatMatrixDesc::GetRow( int index ) const
 	return res;
 }
 
+inline CFloatMatrixDesc CFloatMatrixDesc::GetRows( int firstRow, int rowCount ) const
+{
+	NeoAssert( 0 <= firstRow && 0 <= rowCount && firstRow + rowCount <= Height );
+	CFloatMatrixDesc res = *this;
+	res.Height = rowCount;
+	if( PointerB64 == nullptr ) {
+		res.PointerB = PointerB + firstRow;
+		res.PointerE = PointerE + firstRow;
+	} else {
+		res.PointerB64 = PointerB64 + firstRow;
+		res.PointerE64 = PointerE64 + firstRow;
+	}
+	return res;
+}
+
 //---------------------------------------------------------------------------------------------------------
 
 // A sparse matrix
 // Any value that is not specified is 0
+// The matrix uses 32-bit row pointers while it has no more than INT_MAX elements and 64-bit ones after that
 class NEOML_API CSparseFloatMatrix {
 	static const int InitialRowsBufferSize = 32;
 	static const int InitialElementsBufferSize = 512;
 	static const int MaxRowsCount = INT_MAX;
-	static const int MaxElementsCount = INT_MAX;
+	static const __int64 MaxElementsCount = LLONG_MAX;
 public:
 	CSparseFloatMatrix() {}
-	explicit CSparseFloatMatrix( int width, int rowsBufferSize = 0, int elementsBufferSize = 0 );
+	explicit CSparseFloatMatrix( int width, int rowsBufferSize = 0, __int64 elementsBufferSize = 0 );
 	explicit CSparseFloatMatrix( const CFloatMatrixDesc& desc );
 	CSparseFloatMatrix( const CSparseFloatMatrix& other );
 
@@ -84,9 +116,11 @@ public:
 
 	int GetHeight() const { return body == 0 ? 0 : body->Desc.Height; }
 	int GetWidth() const { return body == 0 ? 0 : body->Desc.Width; }
+	// The total number of elements in the matrix
+	__int64 GetElementCount() const { return body == 0 ? 0 : body->ValuesBuf.Size(); }
 
 	void GrowInRows( int newRowsBufferSize );
-	void GrowInElements( int newElementsBufferSize );
+	void GrowInElements( __int64 newElementsBufferSize );
 
 	void AddRow( const CSparseFloatVector& row );
 	void AddRow( const CFloatVectorDesc& row );
@@ -98,25 +132,95 @@ public:
 	void Serialize( CArchive& archive );
 
 private:
+	// The buffer for the matrix elements; unlike CFastArray its size may exceed INT_MAX
+	template<class T>
+	class CElementsBuffer {
+	public:
+		CElementsBuffer() : ptr( nullptr ), size( 0 ), bufferSize( 0 ) {}
+		~CElementsBuffer() { CurrentMemoryManager::Free( ptr ); }
+
+		T* GetBufferPtr() const { return ptr; }
+		__int64 Size() const { return size; }
+		void SetSize( __int64 newSize ) { Grow( newSize ); size = newSize; }
+		void Add( T value ) { Grow( size + 1 ); ptr[size++] = value; }
+		void SetBufferSize( __int64 newBufferSize );
+		// Reallocates the buffer with a reserve if it is smaller than newSize
+		void Grow( __int64 newSize );
+		void CopyTo( CElementsBuffer& dest ) const;
+
+	private:
+		T* ptr;
+		__int64 size;
+		__int64 bufferSize;
+
+		CElementsBuffer( const CElementsBuffer& );
+		CElementsBuffer& operator=( const CElementsBuffer& );
+	};
+
 	// The matrix body, that is, the object that stores all its data
 	struct NEOML_API CSparseFloatMatrixBody : public IObject {
 		CFloatMatrixDesc Desc;
 
 		// Memory holders
-		CFastArray<int, 1> ColumnsBuf;
-		CFastArray<float, 1> ValuesBuf;
+		CElementsBuffer<int> ColumnsBuf;
+		CElementsBuffer<float> ValuesBuf;
+		// Only one pair of the row pointers is used, depending on the number of elements
 		CFastArray<int, 1> BeginPointersBuf;
 		CFastArray<int, 1> EndPointersBuf;
+		CFastArray<__int64, 1> BeginPointersBuf64;
+		CFastArray<__int64, 1> EndPointersBuf64;
 
-		CSparseFloatMatrixBody( int height, int width, int elementCount, int rowsBufferSize, int elementsBufferSize );
+		CSparseFloatMatrixBody( int height, int width, __int64 elementCount, int rowsBufferSize, __int64 elementsBufferSize );
 		explicit CSparseFloatMatrixBody( const CFloatMatrixDesc& desc );
 		~CSparseFloatMatrixBody() override = default;
+
+		// Checks if the 64-bit row pointers are used
+		bool Is64Bit() const { return Desc.PointerB64 != nullptr; }
+		// Switches to the 64-bit row pointers
+		void ConvertTo64Bit();
+		// Sets the pointers in Desc after the buffers have been reallocated
+		void UpdateDesc();
+		// Adds the row pointers
+		void AddRowPointers( __int64 begin, __int64 end );
 	};
  
 	CPtr<CSparseFloatMatrixBody> body; // The matrix body.
-	CSparseFloatMatrixBody* copyOnWriteAndGrow( int rowsBufferSize = 0, int columnsBufferSize = 0 );
+	CSparseFloatMatrixBody* copyOnWriteAndGrow( int rowsBufferSize = 0, __int64 elementsBufferSize = 0 );
 };
 
+template<class T>
+inline void CSparseFloatMatrix::CElementsBuffer<T>::SetBufferSize( __int64 newBufferSize )
+{
+	if( newBufferSize <= bufferSize ) {
+		return;
+	}
+	T* newPtr = static_cast<T*>( CurrentMemoryManager::Alloc( static_cast<size_t>( newBufferSize ) * sizeof( T ) ) );
+	if( size > 0 ) {
+		::memcpy( newPtr, ptr, static_cast<size_t>( size ) * sizeof( T ) );
+	}
+	CurrentMemoryManager::Free( ptr );
+	ptr = newPtr;
+	bufferSize = newBufferSize;
+}
+
+template<class T>
+inline void CSparseFloatMatrix::CElementsBuffer<T>::Grow( __int64 newSize )
+{
+	if( newSize > bufferSize ) {
+		SetBufferSize( max( newSize, bufferSize + max( bufferSize / 2, static_cast<__int64>( 16 ) ) ) );
+	}
+}
+
+template<class T>
+inline void CSparseFloatMatrix::CElementsBuffer<T>::CopyTo( CElementsBuffer& dest ) const
+{
+	dest.size = 0;
+	dest.SetSize( size );
+	if( size > 0 ) {
+		::memcpy( dest.ptr, ptr, static_cast<size_t>( size ) * sizeof( T ) );
+	}
+}
+
 // Writing into a CTextStream
 inline CTextStream& operator<<( CTextStream& stream, const CSparseFloatMatrix& matrix )
 {
@@ -56,6 +56,8 @@ private:
 	int objectsBeforeTestPart; // the number of objects before the test part
 	CArray<int> pointerB; // the pointers to the vector beginnings
 	CArray<int> pointerE; // the pointers to the vector ends
+	CArray<__int64> pointerB64; // the pointers to the vector beginnings if the base matrix uses 64-bit indices
+	CArray<__int64> pointerE64; // the pointers to the vector ends if the base matrix uses 64-bit indices
 	CFloatMatrixDesc matrix; // the problem matrix descriptor
 
 	int translateIndex( int index ) const;
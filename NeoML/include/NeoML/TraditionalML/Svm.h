@@ -85,6 +85,7 @@ public:
 	// The resulting IModel is either a ILinearBinaryModel (if the KT_Linear kernel was used)
 	// or a ISvmBinaryModel (if some other kernel was used) or params.MulticlassMode model (if number of classes > 2)
 	CPtr<IModel> Train( const IProblem& trainingClassificationData ) override;
+	ITrainingModel* CreateCopy( int threadCount ) const override;
 
 private:
 	const CParams params; // classification parameters
@@ -39,6 +39,9 @@ public:
 	// Calculates the kernel value on given vectors
 	double Calculate(const CFloatVectorDesc& x1, const CFloatVectorDesc& x2) const;
 	double Calculate(const CFloatVector& x1, const CFloatVectorDesc& x2) const { return Calculate( x1.GetDesc(), x2 ); }
+	// Calculates the kernel value from the dot product of the vectors
+	// The squared norms of the vectors are used only by the KT_RBF kernel
+	double CalculateByDotProduct( double dotProduct, double firstSquaredNorm, double secondSquaredNorm ) const;
 
 	friend CArchive& operator << ( CArchive& archive, const CSvmKernel& center );
 	friend CArchive& operator >> ( CArchive& archive, CSvmKernel& center );
@@ -59,6 +62,31 @@ private:
 	double rbfSparseBySparse( const CFloatVectorDesc& x1, const CFloatVectorDesc& x2 ) const;
 };
 
+inline double CSvmKernel::CalculateByDotProduct( double dotProduct, double firstSquaredNorm,
+	double secondSquaredNorm ) const
+{
+	switch( kernelType ) {
+		case KT_Linear:
+			return dotProduct;
+		case KT_Poly:
+		{
+			const double base = gamma * dotProduct + coef0;
+			double result = 1;
+			for( int i = 0; i < degree; i++ ) {
+				result *= base;
+			}
+			return result;
+		}
+		case KT_RBF:
+			return exp( -gamma * max( firstSquaredNorm + secondSquaredNorm - 2 * dotProduct, 0. ) );
+		case KT_Sigmoid:
+			return tanh( gamma * dotProduct + coef0 );
+		default:
+			NeoAssert( false );
+			return 0;
+	}
+}
+
 inline CArchive& operator << ( CArchive& archive, const CSvmKernel& kernel )
 {
 	CSvmKernel::TKernelType kernelType = kernel.kernelType;
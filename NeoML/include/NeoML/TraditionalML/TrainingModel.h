@@ -41,6 +41,11 @@ public:
 		return CheckCast<TModel>( Train( trainingClassificationData ) );
 	}
 
+	// Creates a training model with the same parameters that uses threadCount threads
+	// The copies are used to train several independent models at the same time (see COneVersusAll)
+	// The caller owns the copy; returns nullptr if the training model does not support copying
+	virtual ITrainingModel* CreateCopy( int threadCount ) const;
+
 	virtual ~ITrainingModel();
 };
 
@@ -196,13 +196,29 @@ public:
 	bool need;
 };
 
+// The blob that uses a part of the network memory arena
+class CDnnArenaBlob : public CDnnBlob {
+public:
+	CDnnArenaBlob( CDnnBlob* _arena, const CBlobDesc& desc, __int64 offset ) :
+		CDnnBlob( _arena->GetMathEngine(), desc, _arena->GetData() + offset, false ), arena( _arena ) {}
+
+private:
+	const CPtr<CDnnBlob> arena; // keeps the arena memory while the blob is used
+};
+
 void CBaseLayer::AllocateOutputBlobs()
 {
 	CMemoryModeSwitcher switcher( MathEngine(), GetDnn()->isReuseMemoryMode );
 
 	for( int i = 0; i < outputDescs.Size(); ++i ) {
 		if( outputBlobs[i] == 0 ) {
-			outputBlobs[i] = CDnnBlob::CreateBlob( MathEngine(), outputDescs[i].GetDataType(), outputDescs[i] );
+			if( i < outputArenaOffsets.Size() && outputArenaOffsets[i] != NotFound ) {
+				// The place for the blob is determined by the static memory plan
+				NeoPresume( GetDnn()->memoryArena != 0 );
+				outputBlobs[i] = FINE_DEBUG_NEW CDnnArenaBlob( GetDnn()->memoryArena, outputDescs[i], outputArenaOffsets[i] );
+			} else {
+				outputBlobs[i] = CDnnBlob::CreateBlob( MathEngine(), outputDescs[i].GetDataType(), outputDescs[i] );
+			}
 		} else {
 			if( !outputBlobs[i]->GetDesc().HasEqualDimensions( outputDescs[i] ) ) {
 				// If this output can be connected to in-place transform. And on the second run outputBlob's shape can mismatch with outputDesc.
@@ -732,11 +748,21 @@ void CBaseLayer::Serialize( CArchive& archive )
 		archive >> baseLearningRate >> baseL2RegularizationMult >> baseL1RegularizationMult;
 
 		SerializeBlobs( mathEngine, archive, paramBlobs );
+		OnParamBlobsChanged();
 	} else {
 		NeoAssert( false );
 	}
 }
 
+void CBaseLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	NeoAssert( dist.paramBlobs.Size() == paramBlobs.Size() );
+	for( int i = 0; i < paramBlobs.Size(); ++i ) {
+		dist.paramBlobs[i] = paramBlobs[i];
+	}
+	dist.OnParamBlobsChanged();
+}
+
 void CBaseLayer::CheckInputs() const
 {
 	CheckArchitecture( !inputs.IsEmpty(), GetName(), "layer has no input" );
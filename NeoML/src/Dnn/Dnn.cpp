@@ -340,7 +340,9 @@ CDnn::CDnn( CRandom& _random, IMathEngine& _mathEngine ) :
 	currentSequencePos( 0 ),
 	isReverseSequense( false ),
 	autoRestartMode( true ),
-	isReuseMemoryMode( false )
+	isReuseMemoryMode( false ),
+	isStaticMemoryPlanningEnabled( false ),
+	memoryArenaSize( 0 )
 {
 	solver = FINE_DEBUG_NEW CDnnSimpleGradientSolver( mathEngine );
 	initializer = FINE_DEBUG_NEW CDnnXavierInitializer( random );
@@ -408,6 +410,8 @@ void CDnn::DeleteLayerImpl( CBaseLayer& layer )
 	ForceRebuild();
 	// Unlink all layer connections
 	layer.unlink();
+	// The layer may not use the memory arena of this network anymore
+	layer.outputArenaOffsets.DeleteAll();
 	// Delete the layer from the table
 	layerMap.Delete(layer.GetName());
 
@@ -517,8 +521,15 @@ void CDnn::RunOnce()
 			RestartSequence();
 		}
 		reshape(); // rebuild the network if necessary
-		
-		isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+
+		if( isStaticMemoryPlanningEnabled ) {
+			if( !isMemoryPlanValid() ) {
+				planMemory();
+			}
+			isReuseMemoryMode = false;
+		} else {
+			isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+		}
 		runOnce(0);
 	}
 #ifdef NEOML_USE_FINEOBJ
@@ -553,6 +564,8 @@ void CDnn::RunAndBackwardOnce()
 			RestartSequence();
 		}
 		reshape(); // rebuild the network if necessary
+		// The blobs needed for backpropagation live longer than the plan assumes
+		dropMemoryPlan();
 		isReuseMemoryMode = false;
 		runOnce(0);
 		backwardRunAndLearnOnce(0);
@@ -625,6 +638,7 @@ void CDnn::rebuild()
 	if( solver != 0 ) {
 		solver->Reset();
 	}
+	dropMemoryPlan();
 
 	// Unlink all layers
 	for( int i = 0; i < layers.Size(); i++ ) {
@@ -661,6 +675,221 @@ size_t CDnn::getOutputBlobsSize() const
 	return result;
 }
 
+void CDnn::EnableStaticMemoryPlanning( bool enable )
+{
+	if( isStaticMemoryPlanningEnabled == enable ) {
+		return;
+	}
+	isStaticMemoryPlanningEnabled = enable;
+	dropMemoryPlan();
+}
+
+size_t CDnn::GetPlannedArenaSize() const
+{
+	return memoryArena == 0 ? 0 : memoryArenaSize * sizeof( float );
+}
+
+// The alignment of the blobs in the memory arena, in elements
+static const __int64 MemoryArenaAlignment = 16;
+
+// The memory arena of the static memory plan
+// The memory is allocated directly, as the arena may exceed the maximum blob size; the description is a stub
+class CDnnMemoryArena : public CDnnBlob {
+public:
+	CDnnMemoryArena( IMathEngine& mathEngine, size_t size ) :
+		CDnnBlob( mathEngine, CBlobDesc( CT_Float ), mathEngine.HeapAlloc( size * sizeof( float ) ), false ) {}
+
+protected:
+	~CDnnMemoryArena() override { GetMathEngine().HeapFree( GetData() ); }
+};
+
+// An output blob placed into the memory arena
+struct CPlannedBlob {
+	CBaseLayer* Layer;
+	int Output;
+	// The execution steps of the first and the last use of the blob
+	int FirstStep;
+	int LastStep;
+	// The aligned size and the offset in the arena, in elements
+	__int64 Size;
+	__int64 Offset;
+};
+
+// Checks if the layer output may be the same blob as one of its inputs
+static bool mayAliasInputs( const CBaseLayer* layer )
+{
+	return dynamic_cast<const CBaseInPlaceLayer*>( layer ) != 0 || dynamic_cast<const CCompositeLayer*>( layer ) != 0;
+}
+
+// Checks if the layer sets the output blobs itself instead of allocating them
+static bool hasExternalOutputs( const CBaseLayer* layer )
+{
+	return dynamic_cast<const CSourceLayer*>( layer ) != 0 || dynamic_cast<const CCompositeSourceLayer*>( layer ) != 0;
+}
+
+// Checks if the plan was calculated for the current blob sizes
+bool CDnn::isMemoryPlanValid() const
+{
+	if( memoryArena == 0 ) {
+		return false;
+	}
+	int descIndex = 0;
+	for( int i = 0; i < layers.Size(); ++i ) {
+		const CArray<CBlobDesc>& descs = layers[i]->outputDescs;
+		for( int j = 0; j < descs.Size(); ++j ) {
+			if( descIndex >= plannedOutputDescs.Size()
+				|| descs[j].GetDataType() != plannedOutputDescs[descIndex].GetDataType()
+				|| !descs[j].HasEqualDimensions( plannedOutputDescs[descIndex] ) )
+			{
+				return false;
+			}
+			descIndex++;
+		}
+	}
+	return descIndex == plannedOutputDescs.Size();
+}
+
+// Adds the layer to the execution order after all its inputs, the same way runOnce visits the layers
+void CDnn::addToExecutionOrder( CBaseLayer* layer, CArray<CBaseLayer*>& order, CMap<const CBaseLayer*, int>& steps ) const
+{
+	if( steps.Has( layer ) ) {
+		return;
+	}
+	steps.Add( layer, NotFound );
+	for( int i = 0; i < layer->GetInputCount(); ++i ) {
+		addToExecutionOrder( layer->GetInputLayer( i ), order, steps );
+	}
+	steps.Set( layer, order.Size() );
+	order.Add( layer );
+}
+
+// Calculates the blob lifetimes for the current blob sizes and places the output blobs into one arena
+void CDnn::planMemory()
+{
+	static_assert( sizeof( float ) == sizeof( int ), "The arena elements must fit any blob data type" );
+	dropMemoryPlan();
+
+	CArray<CBaseLayer*> order;
+	CMap<const CBaseLayer*, int> steps;
+	for( int i = 0; i < sinkLayers.Size(); ++i ) {
+		addToExecutionOrder( sinkLayers[i], order, steps );
+	}
+	const int endStep = order.Size();
+
+	// The last step on which each output is used
+	CArray<CArray<int>> lastUse;
+	lastUse.SetSize( order.Size() );
+	for( int step = 0; step < order.Size(); ++step ) {
+		lastUse[step].Add( step, order[step]->GetOutputCount() );
+	}
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		// The layers without outputs (sinks, losses) keep the links to their inputs after the run
+		const int useStep = layer->GetOutputCount() == 0 ? endStep : step;
+		for( int i = 0; i < layer->GetInputCount(); ++i ) {
+			int& inputLastUse = lastUse[steps.Get( layer->GetInputLayer( i ) )][layer->inputLinks[i].OutputNumber];
+			inputLastUse = max( inputLastUse, useStep );
+		}
+	}
+	// The inputs of the layers that may pass them to the outputs are used as long as these outputs
+	for( int step = order.Size() - 1; step >= 0; --step ) {
+		CBaseLayer* layer = order[step];
+		if( !mayAliasInputs( layer ) ) {
+			continue;
+		}
+		int outputLastUse = step;
+		for( int j = 0; j < lastUse[step].Size(); ++j ) {
+			outputLastUse = max( outputLastUse, lastUse[step][j] );
+		}
+		for( int i = 0; i < layer->GetInputCount(); ++i ) {
+			int& inputLastUse = lastUse[steps.Get( layer->GetInputLayer( i ) )][layer->inputLinks[i].OutputNumber];
+			inputLastUse = max( inputLastUse, outputLastUse );
+		}
+	}
+
+	CArray<CPlannedBlob> blobs;
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		layer->outputArenaOffsets.DeleteAll();
+		layer->outputArenaOffsets.Add( NotFound, layer->outputDescs.Size() );
+		if( mayAliasInputs( layer ) || hasExternalOutputs( layer ) ) {
+			continue;
+		}
+		for( int j = 0; j < layer->outputDescs.Size(); ++j ) {
+			CPlannedBlob blob;
+			blob.Layer = layer;
+			blob.Output = j;
+			blob.FirstStep = step;
+			blob.LastStep = lastUse[step][j];
+			blob.Size = ( layer->outputDescs[j].BlobSize() + MemoryArenaAlignment - 1 ) / MemoryArenaAlignment * MemoryArenaAlignment;
+			blob.Offset = NotFound;
+			blobs.Add( blob );
+		}
+	}
+
+	// Greedy placement: the largest blobs first, each into the smallest suitable gap
+	// between the already placed blobs with intersecting lifetimes
+	blobs.QuickSort< DescendingByMember<CPlannedBlob, __int64, &CPlannedBlob::Size> >();
+	__int64 arenaSize = 0;
+	CArray<CPlannedBlob> neighbours;
+	for( int i = 0; i < blobs.Size(); ++i ) {
+		CPlannedBlob& blob = blobs[i];
+		neighbours.DeleteAll();
+		for( int j = 0; j < i; ++j ) {
+			if( blobs[j].FirstStep <= blob.LastStep && blob.FirstStep <= blobs[j].LastStep ) {
+				neighbours.Add( blobs[j] );
+			}
+		}
+		neighbours.QuickSort< AscendingByMember<CPlannedBlob, __int64, &CPlannedBlob::Offset> >();
+
+		__int64 gapStart = 0;
+		__int64 bestGap = NotFound;
+		for( int j = 0; j < neighbours.Size(); ++j ) {
+			const __int64 gap = neighbours[j].Offset - gapStart;
+			if( gap >= blob.Size && ( blob.Offset == NotFound || gap < bestGap ) ) {
+				blob.Offset = gapStart;
+				bestGap = gap;
+			}
+			gapStart = max( gapStart, neighbours[j].Offset + neighbours[j].Size );
+		}
+		if( blob.Offset == NotFound ) {
+			blob.Offset = gapStart;
+		}
+		blob.Layer->outputArenaOffsets[blob.Output] = blob.Offset;
+		arenaSize = max( arenaSize, blob.Offset + blob.Size );
+	}
+
+	memoryArenaSize = static_cast<size_t>( max( arenaSize, static_cast<__int64>( 1 ) ) );
+	memoryArena = FINE_DEBUG_NEW CDnnMemoryArena( mathEngine, memoryArenaSize );
+	for( int i = 0; i < layers.Size(); ++i ) {
+		plannedOutputDescs.Add( layers[i]->outputDescs );
+	}
+}
+
+// Releases the memory arena and all blobs placed into it
+void CDnn::dropMemoryPlan()
+{
+	if( memoryArena == 0 ) {
+		return;
+	}
+	for( int i = 0; i < layers.Size(); ++i ) {
+		CBaseLayer* layer = layers[i];
+		layer->outputArenaOffsets.DeleteAll();
+		// The inputs and the outputs of all layers may refer to the arena
+		for( int j = 0; j < layer->inputBlobs.Size(); ++j ) {
+			layer->inputBlobs[j] = 0;
+		}
+		if( !hasExternalOutputs( layer ) ) {
+			for( int j = 0; j < layer->outputBlobs.Size(); ++j ) {
+				layer->outputBlobs[j] = 0;
+			}
+		}
+	}
+	memoryArena = 0;
+	memoryArenaSize = 0;
+	plannedOutputDescs.DeleteAll();
+}
+
 void CDnn::FilterLayersParams( float threshold )
 {
 	for( int i = 0; i < layers.Size(); ++i ) {
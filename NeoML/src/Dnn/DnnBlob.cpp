@@ -19,6 +19,7 @@ limitations under the License.
 #include <NeoML/Dnn/DnnBlob.h>
 #include <NeoMathEngine/NeoMathEngine.h>
 #include <NeoML/Dnn/Layers/LossLayer.h>
+#include <Dnn/DnnMappedFile.h>
 
 namespace NeoML {
 
@@ -505,10 +506,31 @@ static void readRawData( IMathEngine& mathEngine, CArchive& archive, const CType
 	}
 }
 
+// The blob data is aligned in the archive, so that it could be used directly when the file is mapped into memory
+// The padding size is written in one byte before the padding
+static void writeDataAlignment( CArchive& archive )
+{
+	const __int64 alignment = static_cast<__int64>( CpuExternalMemoryAlignment );
+	const int padding = static_cast<int>( ( alignment - ( archive.GetPosition() + 1 ) % alignment ) % alignment );
+	archive << static_cast<unsigned char>( padding );
+	for( int i = 0; i < padding; i++ ) {
+		archive << static_cast<unsigned char>( 0 );
+	}
+}
+
+static void skipDataAlignment( CArchive& archive )
+{
+	unsigned char padding = 0;
+	archive >> padding;
+	check( padding < CpuExternalMemoryAlignment, ERR_BAD_ARCHIVE, archive.Name() );
+	archive.Skip( padding );
+}
+
 template<typename T>
 static void writeRawData( IMathEngine& mathEngine, const int size, const CTypedMemoryHandle<T>& handle, CArchive& archive )
 {
 	archive << static_cast<unsigned int>( size );
+	writeDataAlignment( archive );
 
 	if( size > 0 ) {
 		void* ptr = mathEngine.GetBuffer( handle, 0, size * sizeof(T), true );
@@ -517,13 +539,14 @@ static void writeRawData( IMathEngine& mathEngine, const int size, const CTypedM
 	}
 }
 
-static const int BlobVersion = 2000;
+// 2001: the data is aligned
+static const int BlobVersion = 2001;
 
 void CDnnBlob::Serialize( CArchive& archive )
 {
 	NeoAssert( parent == 0 ); // a blob that links to another may not be serialized
 
-	archive.SerializeVersion( BlobVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( BlobVersion, CDnn::ArchiveMinSupportedVersion );
 
 	if( archive.IsStoring() ) {
 		archive << static_cast<int>( GetDataType() );
@@ -546,22 +569,58 @@ void CDnnBlob::Serialize( CArchive& archive )
 		int intType;
 		archive >> intType;
 		TBlobType type = static_cast<TBlobType>(intType);
+		check( type == CT_Float || type == CT_Int, ERR_BAD_ARCHIVE, archive.Name() );
 
 		int intPack;
 		archive >> intPack;
 		int batchLength, batchWidth, listSize, height, width, depth, channels;
 		archive >> batchLength >> batchWidth >> listSize >> height >> width >> depth >> channels;
-		initializeBlob(type, batchLength, batchWidth, listSize, height, width, depth, channels);
 
-		switch( type ) {
-			case CT_Float:
+		if( version < 2001 ) {
+			initializeBlob(type, batchLength, batchWidth, listSize, height, width, depth, channels);
+			if( type == CT_Float ) {
 				readRawData( mathEngine, archive, GetData<float>() );
-				break;
-			case CT_Int:
+			} else {
 				readRawData( mathEngine, archive, GetData<int>() );
-				break;
-			default:
-				NeoAssert( false );
+			}
+			parentPos = 0;
+			return;
+		}
+
+		CBlobDesc pattern;
+		pattern.SetDimSize( BD_BatchLength, batchLength );
+		pattern.SetDimSize( BD_BatchWidth, batchWidth );
+		pattern.SetDimSize( BD_ListSize, listSize );
+		pattern.SetDimSize( BD_Height, height );
+		pattern.SetDimSize( BD_Width, width );
+		pattern.SetDimSize( BD_Depth, depth );
+		pattern.SetDimSize( BD_Channels, channels );
+
+		unsigned int size = 0;
+		archive >> size;
+		check( static_cast<int>( size ) == pattern.BlobSize(), ERR_BAD_ARCHIVE, archive.Name() );
+		skipDataAlignment( archive );
+		// Both float and int are 4 bytes long
+		const int dataSize = static_cast<int>( size * sizeof( float ) );
+
+		// The data from a mapped file is used directly (see LoadDnnFromMappedFile)
+		CDnnMappedFile* mappedFile = mathEngine.GetType() == MET_Cpu && size > 0 ? CDnnMappedFile::GetLoading( archive ) : nullptr;
+		void* mappedData = mappedFile == nullptr ? nullptr : mappedFile->GetData( archive.GetPosition(), dataSize );
+		if( mappedData != nullptr ) {
+			NeoAssert( desc.GetDataType() == CT_Invalid );
+			desc = pattern;
+			desc.SetDataType( type );
+			data = CreateCpuExternalMemoryHandle( mathEngine, mappedData );
+			dataOwned = false;
+			dataHolder = mappedFile;
+			archive.Skip( dataSize );
+		} else {
+			initializeByPattern( type, pattern );
+			if( size > 0 ) {
+				void* ptr = mathEngine.GetBuffer( data, 0, dataSize, false );
+				archive.Read( ptr, dataSize );
+				mathEngine.ReleaseBuffer( data, ptr, true );
+			}
 		}
 		parentPos = 0;
 	} else {
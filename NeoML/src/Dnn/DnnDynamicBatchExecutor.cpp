@@ -0,0 +1,235 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnDynamicBatchExecutor.h>
+#include <NeoML/Dnn/Layers/SourceLayer.h>
+#include <NeoML/Dnn/Layers/SinkLayer.h>
+
+namespace NeoML {
+
+CDnnDynamicBatchExecutor::CDnnDynamicBatchExecutor( CDnn& _dnn, const CArray<CString>& _sourceNames,
+		const CArray<CString>& _sinkNames, int _maxBatchWidth, int maxWaitMilliseconds ) :
+	dnn( _dnn ),
+	maxBatchWidth( _maxBatchWidth ),
+	maxWait( maxWaitMilliseconds ),
+	queuedBatchWidth( 0 ),
+	isStopping( false ),
+	processedBatchCount( 0 ),
+	processedRequestCount( 0 )
+{
+	NeoAssert( maxBatchWidth > 0 );
+	NeoAssert( maxWaitMilliseconds >= 0 );
+	NeoAssert( !_sourceNames.IsEmpty() );
+	NeoAssert( !_sinkNames.IsEmpty() );
+
+	for( int i = 0; i < _sourceNames.Size(); ++i ) {
+		CheckArchitecture( dynamic_cast<CSourceLayer*>( dnn.GetLayer( _sourceNames[i] ).Ptr() ) != nullptr,
+			_sourceNames[i], "the layer is not a source" );
+	}
+	for( int i = 0; i < _sinkNames.Size(); ++i ) {
+		CheckArchitecture( dynamic_cast<CSinkLayer*>( dnn.GetLayer( _sinkNames[i] ).Ptr() ) != nullptr,
+			_sinkNames[i], "the layer is not a sink" );
+	}
+	_sourceNames.CopyTo( sourceNames );
+	_sinkNames.CopyTo( sinkNames );
+
+	worker = std::thread( &CDnnDynamicBatchExecutor::workerLoop, this );
+}
+
+CDnnDynamicBatchExecutor::~CDnnDynamicBatchExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		isStopping = true;
+	}
+	queueCondition.notify_all();
+	worker.join();
+}
+
+void CDnnDynamicBatchExecutor::Run( const CObjectArray<CDnnBlob>& inputs, CObjectArray<CDnnBlob>& outputs )
+{
+	NeoAssert( inputs.Size() == sourceNames.Size() );
+
+	CRequest request;
+	inputs.CopyTo( request.Inputs );
+	request.BatchWidth = inputs[0]->GetBatchWidth();
+	for( int i = 1; i < inputs.Size(); ++i ) {
+		NeoAssert( inputs[i]->GetBatchWidth() == request.BatchWidth );
+	}
+	request.ArrivalTime = std::chrono::steady_clock::now();
+
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		NeoAssert( !isStopping );
+		queue.Add( &request );
+		queuedBatchWidth += request.BatchWidth;
+		queueCondition.notify_one();
+		doneCondition.wait( lock, [&request]() { return request.IsDone; } );
+	}
+
+	if( request.Error != nullptr ) {
+		std::rethrow_exception( request.Error );
+	}
+	request.Outputs.MoveTo( outputs );
+}
+
+int CDnnDynamicBatchExecutor::GetProcessedBatchCount() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return processedBatchCount;
+}
+
+int CDnnDynamicBatchExecutor::GetProcessedRequestCount() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return processedRequestCount;
+}
+
+void CDnnDynamicBatchExecutor::workerLoop()
+{
+	CArray<CRequest*> batch;
+	while( true ) {
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			queueCondition.wait( lock, [this]() { return isStopping || !queue.IsEmpty(); } );
+			if( queue.IsEmpty() ) {
+				// Stopping and nothing left to do
+				return;
+			}
+			// Wait for more requests until the batch is full or the oldest request has waited long enough
+			const std::chrono::steady_clock::time_point deadline = queue[0]->ArrivalTime + maxWait;
+			queueCondition.wait_until( lock, deadline,
+				[this]() { return isStopping || queuedBatchWidth >= maxBatchWidth; } );
+			extractBatch( batch );
+		}
+
+		processBatch( batch );
+
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			for( int i = 0; i < batch.Size(); ++i ) {
+				batch[i]->IsDone = true;
+			}
+			processedBatchCount++;
+			processedRequestCount += batch.Size();
+		}
+		doneCondition.notify_all();
+	}
+}
+
+// Takes the oldest request and the following compatible ones while they fit into the batch
+// Must be called under the lock
+void CDnnDynamicBatchExecutor::extractBatch( CArray<CRequest*>& batch )
+{
+	NeoPresume( !queue.IsEmpty() );
+
+	batch.DeleteAll();
+	batch.Add( queue[0] );
+	queue.DeleteAt( 0 );
+	int batchWidth = batch[0]->BatchWidth;
+
+	for( int i = 0; i < queue.Size() && batchWidth < maxBatchWidth; ) {
+		if( batchWidth + queue[i]->BatchWidth <= maxBatchWidth && areCompatible( *batch[0], *queue[i] ) ) {
+			batchWidth += queue[i]->BatchWidth;
+			batch.Add( queue[i] );
+			queue.DeleteAt( i );
+		} else {
+			++i;
+		}
+	}
+	queuedBatchWidth -= batchWidth;
+}
+
+// Runs the network for the batch of requests and fills their outputs
+// The errors are passed to the waiting callers
+void CDnnDynamicBatchExecutor::processBatch( const CArray<CRequest*>& batch )
+{
+	IMathEngine& mathEngine = dnn.GetMathEngine();
+	int totalBatchWidth = 0;
+	for( int r = 0; r < batch.Size(); ++r ) {
+		totalBatchWidth += batch[r]->BatchWidth;
+	}
+
+	try {
+		for( int i = 0; i < sourceNames.Size(); ++i ) {
+			CPtr<CDnnBlob> input;
+			if( batch.Size() == 1 ) {
+				input = batch[0]->Inputs[i];
+			} else {
+				CObjectArray<CDnnBlob> parts;
+				for( int r = 0; r < batch.Size(); ++r ) {
+					parts.Add( batch[r]->Inputs[i] );
+				}
+				CBlobDesc desc = parts[0]->GetDesc();
+				desc.SetDimSize( BD_BatchWidth, totalBatchWidth );
+				input = CDnnBlob::CreateBlob( mathEngine, parts[0]->GetDataType(), desc );
+				CDnnBlob::MergeByBatchWidth( mathEngine, parts, input );
+			}
+			CheckCast<CSourceLayer>( dnn.GetLayer( sourceNames[i] ) )->SetBlob( input );
+		}
+
+		dnn.RunOnce();
+
+		for( int i = 0; i < sinkNames.Size(); ++i ) {
+			const CPtr<CDnnBlob>& output = CheckCast<CSinkLayer>( dnn.GetLayer( sinkNames[i] ) )->GetBlob();
+			CheckArchitecture( output->GetBatchWidth() == totalBatchWidth, sinkNames[i],
+				"the sink BatchWidth differs from the total BatchWidth of the requests" );
+			// The sink blob is overwritten on the next run so the results are always copied
+			if( batch.Size() == 1 ) {
+				batch[0]->Outputs.Add( output->GetCopy() );
+			} else {
+				CObjectArray<CDnnBlob> parts;
+				for( int r = 0; r < batch.Size(); ++r ) {
+					CBlobDesc desc = output->GetDesc();
+					desc.SetDimSize( BD_BatchWidth, batch[r]->BatchWidth );
+					parts.Add( CDnnBlob::CreateBlob( mathEngine, output->GetDataType(), desc ) );
+				}
+				CDnnBlob::SplitByBatchWidth( mathEngine, output, parts );
+				for( int r = 0; r < batch.Size(); ++r ) {
+					batch[r]->Outputs.Add( parts[r] );
+				}
+			}
+		}
+	} catch( ... ) {
+		const std::exception_ptr error = std::current_exception();
+		for( int r = 0; r < batch.Size(); ++r ) {
+			batch[r]->Outputs.DeleteAll();
+			batch[r]->Error = error;
+		}
+	}
+}
+
+bool CDnnDynamicBatchExecutor::areCompatible( const CRequest& first, const CRequest& second )
+{
+	NeoPresume( first.Inputs.Size() == second.Inputs.Size() );
+	for( int i = 0; i < first.Inputs.Size(); ++i ) {
+		const CBlobDesc& firstDesc = first.Inputs[i]->GetDesc();
+		const CBlobDesc& secondDesc = second.Inputs[i]->GetDesc();
+		if( firstDesc.GetDataType() != secondDesc.GetDataType() ) {
+			return false;
+		}
+		for( int d = 0; d < BD_Count; ++d ) {
+			if( d != BD_BatchWidth && firstDesc.DimSize( d ) != secondDesc.DimSize( d ) ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+} // namespace NeoML
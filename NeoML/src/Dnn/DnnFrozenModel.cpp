@@ -0,0 +1,101 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnFrozenModel.h>
+
+namespace NeoML {
+
+CDnnInferenceContext::CDnnInferenceContext( IMathEngine& mathEngine, unsigned int seed ) :
+	random( seed ),
+	dnn( random, mathEngine )
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CDnnFrozenModel::CDnnFrozenModel( IMathEngine& _mathEngine, CArchive& archive, unsigned int _seed ) :
+	mathEngine( _mathEngine ),
+	seed( _seed ),
+	random( _seed ),
+	dnn( random, _mathEngine ),
+	isMappedFile( false )
+{
+	NeoAssert( archive.IsLoading() );
+	dnn.Serialize( archive );
+	dnn.DisableLearning();
+}
+
+CDnnFrozenModel::CDnnFrozenModel( IMathEngine& _mathEngine, const char* fileName, unsigned int _seed ) :
+	mathEngine( _mathEngine ),
+	seed( _seed ),
+	random( _seed ),
+	dnn( random, _mathEngine ),
+	isMappedFile( true ),
+	mappedFileName( fileName )
+{
+	LoadDnnFromMappedFile( dnn, fileName );
+	dnn.DisableLearning();
+}
+
+CPtr<CDnnInferenceContext> CDnnFrozenModel::CreateContext()
+{
+	CPtr<CDnnInferenceContext> context = FINE_DEBUG_NEW CDnnInferenceContext( mathEngine, seed );
+
+	// Copy the architecture; the parameters are copied too but will be replaced right away
+	if( isMappedFile ) {
+		// The parameters are taken from the mapping of the same file
+		LoadDnnFromMappedFile( context->dnn, mappedFileName );
+	} else {
+		CMemoryFile file;
+		{
+			CCriticalSectionLock lock( section );
+			CArchive archive( &file, CArchive::SD_Storing );
+			dnn.Serialize( archive );
+		}
+		file.SeekToBegin();
+		{
+			CArchive archive( &file, CArchive::SD_Loading );
+			context->dnn.Serialize( archive );
+		}
+		file.Close();
+	}
+	context->dnn.DisableLearning();
+
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CPtr<CBaseLayer> layer = dnn.GetLayer( layerList[i] );
+		layer->TransferParamsBlob( *context->dnn.GetLayer( layerList[i] ) );
+	}
+
+	return context;
+}
+
+size_t CDnnFrozenModel::GetTrainableParametersSize() const
+{
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+
+	size_t result = 0;
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		result += dnn.GetLayer( layerList[i] )->GetTrainableParametersSize();
+	}
+	return result;
+}
+
+} // namespace NeoML
@@ -0,0 +1,199 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnInt8Quantization.h>
+#include <NeoML/Dnn/Layers/CompositeLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <NeoML/Dnn/Layers/ConvLayer.h>
+#include <NeoML/Dnn/Layers/ChannelwiseConvLayer.h>
+
+namespace NeoML {
+
+// The maximum absolute value of the quantized numbers
+static const int Int8MaxValue = 127;
+
+CDnnInt8Weights::CDnnInt8Weights( IMathEngine& _mathEngine ) :
+	mathEngine( _mathEngine ),
+	isCalibrationEnabled( false ),
+	inputRange( 0 )
+{
+}
+
+void CDnnInt8Weights::UpdateInputRange( const CDnnBlob& input )
+{
+	NeoAssert( input.GetDataType() == CT_Float );
+
+	CArray<float> data;
+	data.SetSize( input.GetDataSize() );
+	input.CopyTo( data.GetPtr() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		inputRange = max( inputRange, abs( data[i] ) );
+	}
+}
+
+void CDnnInt8Weights::Quantize( const CDnnBlob& weights )
+{
+	NeoAssert( weights.GetDataType() == CT_Float );
+
+	weightsDesc = weights.GetDesc();
+	const int rowCount = GetRowCount();
+	const int rowSize = GetRowSize();
+	const int packedRowSize = ( rowSize + 3 ) / 4;
+
+	CArray<float> data;
+	data.SetSize( weights.GetDataSize() );
+	weights.CopyTo( data.GetPtr() );
+
+	CArray<float> rowScales;
+	rowScales.Add( 1.f, rowCount );
+	CArray<int> packed;
+	packed.Add( 0, rowCount * packedRowSize );
+	for( int i = 0; i < rowCount; ++i ) {
+		const float* row = data.GetPtr() + i * rowSize;
+		float rowRange = 0;
+		for( int j = 0; j < rowSize; ++j ) {
+			rowRange = max( rowRange, abs( row[j] ) );
+		}
+		if( rowRange > 0 ) {
+			rowScales[i] = rowRange / Int8MaxValue;
+		}
+
+		signed char* packedRow = reinterpret_cast<signed char*>( packed.GetPtr() + i * packedRowSize );
+		for( int j = 0; j < rowSize; ++j ) {
+			const int value = Round( row[j] / rowScales[i] );
+			packedRow[j] = static_cast<signed char>( min( Int8MaxValue, max( -Int8MaxValue, value ) ) );
+		}
+	}
+
+	quantizedWeights = CDnnBlob::CreateVector( mathEngine, CT_Int, packed.Size() );
+	quantizedWeights->CopyFrom( packed.GetPtr() );
+	scales = CDnnBlob::CreateVector( mathEngine, CT_Float, rowCount );
+	scales->CopyFrom( rowScales.GetPtr() );
+}
+
+void CDnnInt8Weights::Reset()
+{
+	weightsDesc = CBlobDesc();
+	quantizedWeights = nullptr;
+	scales = nullptr;
+}
+
+void CDnnInt8Weights::ShareWith( CDnnInt8Weights& other ) const
+{
+	NeoAssert( &other.mathEngine == &mathEngine );
+
+	other.isCalibrationEnabled = isCalibrationEnabled;
+	other.inputRange = inputRange;
+	other.weightsDesc = weightsDesc;
+	other.quantizedWeights = quantizedWeights;
+	other.scales = scales;
+}
+
+CPtr<CDnnBlob> CDnnInt8Weights::Dequantize() const
+{
+	NeoAssert( IsQuantized() );
+
+	const int rowCount = GetRowCount();
+	const int rowSize = GetRowSize();
+	const int packedRowSize = ( rowSize + 3 ) / 4;
+
+	CArray<int> packed;
+	packed.SetSize( quantizedWeights->GetDataSize() );
+	quantizedWeights->CopyTo( packed.GetPtr() );
+	CArray<float> rowScales;
+	rowScales.SetSize( rowCount );
+	scales->CopyTo( rowScales.GetPtr() );
+
+	CArray<float> data;
+	data.SetSize( rowCount * rowSize );
+	for( int i = 0; i < rowCount; ++i ) {
+		const signed char* packedRow = reinterpret_cast<const signed char*>( packed.GetPtr() + i * packedRowSize );
+		for( int j = 0; j < rowSize; ++j ) {
+			data[i * rowSize + j] = rowScales[i] * packedRow[j];
+		}
+	}
+
+	CPtr<CDnnBlob> result = CDnnBlob::CreateBlob( mathEngine, CT_Float, weightsDesc );
+	result->CopyFrom( data.GetPtr() );
+	return result;
+}
+
+static const int DnnInt8WeightsVersion = 0;
+
+void CDnnInt8Weights::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( DnnInt8WeightsVersion );
+
+	archive.Serialize( inputRange );
+	if( archive.IsStoring() ) {
+		for( TBlobDim d = TBlobDim( 0 ); d < BD_Count; ++d ) {
+			archive << weightsDesc.DimSize( d );
+		}
+	} else if( archive.IsLoading() ) {
+		weightsDesc = CBlobDesc( CT_Float );
+		for( TBlobDim d = TBlobDim( 0 ); d < BD_Count; ++d ) {
+			int size = 0;
+			archive >> size;
+			weightsDesc.SetDimSize( d, size );
+		}
+	} else {
+		NeoAssert( false );
+	}
+	SerializeBlob( mathEngine, archive, quantizedWeights );
+	SerializeBlob( mathEngine, archive, scales );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void EnableInt8Calibration( CDnnLayerGraph& graph, bool enable )
+{
+	CArray<const char*> layerList;
+	graph.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CPtr<CBaseLayer> layer = graph.GetLayer( layerList[i] );
+		if( CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( layer.Ptr() ) ) {
+			fc->EnableInt8Calibration( enable );
+		} else if( CConvLayer* conv = dynamic_cast<CConvLayer*>( layer.Ptr() ) ) {
+			conv->EnableInt8Calibration( enable );
+		} else if( CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer.Ptr() ) ) {
+			EnableInt8Calibration( *composite, enable );
+		}
+	}
+}
+
+int QuantizeInt8( CDnnLayerGraph& graph )
+{
+	int result = 0;
+	CArray<const char*> layerList;
+	graph.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CPtr<CBaseLayer> layer = graph.GetLayer( layerList[i] );
+		if( CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( layer.Ptr() ) ) {
+			result += fc->QuantizeInt8() ? 1 : 0;
+		} else if( CConvLayer* conv = dynamic_cast<CConvLayer*>( layer.Ptr() ) ) {
+			result += conv->QuantizeInt8() ? 1 : 0;
+		} else if( CChannelwiseConvLayer* channelwise = dynamic_cast<CChannelwiseConvLayer*>( layer.Ptr() ) ) {
+			result += channelwise->QuantizeInt8() ? 1 : 0;
+		} else if( CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer.Ptr() ) ) {
+			result += QuantizeInt8( *composite );
+		}
+	}
+	return result;
+}
+
+} // namespace NeoML
@@ -0,0 +1,77 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <Dnn/DnnMappedFile.h>
+#include <NeoML/Dnn/Dnn.h>
+#include <NeoML/ArchiveFile.h>
+
+namespace NeoML {
+
+// The mapped file that is being loaded on the current thread
+static thread_local CDnnMappedFile* loadingFile = nullptr;
+
+CDnnMappedFile::CDnnMappedFile( const char* fileName ) :
+	file( fileName, true ),
+	archive( nullptr )
+{
+}
+
+CDnnMappedFile* CDnnMappedFile::GetLoading( const CArchive& archive )
+{
+	return loadingFile != nullptr && loadingFile->archive == &archive ? loadingFile : nullptr;
+}
+
+void* CDnnMappedFile::GetData( __int64 position, __int64 size ) const
+{
+	if( position < 0 || size < 0 || position + size > file.GetLength() ) {
+		return nullptr;
+	}
+	char* data = static_cast<char*>( file.GetWritableData() ) + position;
+	return reinterpret_cast<uintptr_t>( data ) % CpuExternalMemoryAlignment == 0 ? data : nullptr;
+}
+
+void CDnnMappedFile::Load( CArchive& _archive, CDnn& dnn )
+{
+	NeoAssert( _archive.IsLoading() );
+	NeoAssert( archive == nullptr );
+
+	CDnnMappedFile* prevLoadingFile = loadingFile;
+	archive = &_archive;
+	loadingFile = this;
+	try {
+		dnn.Serialize( _archive );
+	} catch( ... ) {
+		loadingFile = prevLoadingFile;
+		archive = nullptr;
+		throw;
+	}
+	loadingFile = prevLoadingFile;
+	archive = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void LoadDnnFromMappedFile( CDnn& dnn, const char* fileName )
+{
+	CPtr<CDnnMappedFile> mappedFile = FINE_DEBUG_NEW CDnnMappedFile( fileName );
+	CArchiveFile file( fileName, CArchive::SD_Loading );
+	CArchive archive( &file, CArchive::SD_Loading );
+	mappedFile->Load( archive, dnn );
+}
+
+} // namespace NeoML
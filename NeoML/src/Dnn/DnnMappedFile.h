@@ -0,0 +1,52 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <MemoryMappedFile.h>
+
+namespace NeoML {
+
+class CDnn;
+
+// A network file mapped into memory (see LoadDnnFromMappedFile)
+// While the network is being loaded, the blobs take their data directly from the mapped file
+// and keep a reference to it, so the file stays mapped while any of them exists
+class CDnnMappedFile : public IObject {
+public:
+	explicit CDnnMappedFile( const char* fileName );
+
+	// Gets the mapped file that is being loaded by the archive on the current thread
+	// Returns null if the archive does not read a mapped file
+	static CDnnMappedFile* GetLoading( const CArchive& archive );
+
+	// Gets the pointer to the data at the given position in the file
+	// Returns null if the data may not be used directly:
+	// the range is outside the file or its start is not aligned to CpuExternalMemoryAlignment
+	void* GetData( __int64 position, __int64 size ) const;
+
+	// Loads the network from the archive that reads this file from its beginning
+	void Load( CArchive& archive, CDnn& dnn );
+
+protected:
+	~CDnnMappedFile() override = default;
+
+private:
+	CMemoryMappedFile file; // the mapped file, the changed pages are not written to the file
+	const CArchive* archive; // the archive that is loading the file
+};
+
+} // namespace NeoML
@@ -152,6 +152,47 @@ void mapLayerPtrToId( CDnnLayerGraph& dnn, CMap<CBaseLayer*, CString>& result, c
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Utility functions for training
+
+// Creates the zero gradient history if it is empty: historyTypeCount blobs for each of the parameter blobs
+static void createGradientHistory( const CObjectArray<CDnnBlob>& paramDiffBlobs, int historyTypeCount,
+	CObjectArray<CDnnBlob>& gradientHistory )
+{
+	if( !gradientHistory.IsEmpty() ) {
+		return;
+	}
+	for( int j = 0; j < historyTypeCount; j++ ) {
+		for( int i = 0; i < paramDiffBlobs.Size(); ++i ) {
+			CDnnBlob* blob = paramDiffBlobs[i]->GetClone();
+			blob->Clear();
+			gradientHistory.Add( blob );
+		}
+	}
+}
+
+// Adds the layer parameters to the fused step tensors
+// The gradient history stores historyTypeCount blobs for each parameter blob: the first moment,
+// then the second moment, then the maximum of the second moment
+static void addFusedSolverTensors( const CObjectArray<CDnnBlob>& paramBlobs, const CObjectArray<CDnnBlob>& paramDiffBlobs,
+	CObjectArray<CDnnBlob>& gradientHistory, int historyTypeCount, CArray<CFusedSolverTensor>& tensors )
+{
+	createGradientHistory( paramDiffBlobs, historyTypeCount, gradientHistory );
+	for( int i = 0; i < paramBlobs.Size(); ++i ) {
+		CFusedSolverTensor& tensor = tensors.Append();
+		tensor.Param = paramBlobs[i]->GetData();
+		tensor.Diff = paramDiffBlobs[i]->GetData();
+		tensor.Size = paramBlobs[i]->GetDataSize();
+		tensor.Moment = gradientHistory[i]->GetData();
+		if( historyTypeCount > 1 ) {
+			tensor.SecondMoment = gradientHistory[i + paramBlobs.Size()]->GetData();
+		}
+		if( historyTypeCount > 2 ) {
+			tensor.SecondMomentMax = gradientHistory[i + 2 * paramBlobs.Size()]->GetData();
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 CDnnSolver::CDnnSolver( IMathEngine& _mathEngine ) :
@@ -159,7 +200,8 @@ CDnnSolver::CDnnSolver( IMathEngine& _mathEngine ) :
 	learningRate( 0.01f ),
 	regularizationL2( 0.f ),
 	regularizationL1( 0.f ),
-	maxGradientNorm( -1.f )
+	maxGradientNorm( -1.f ),
+	isFusedUpdateEnabled( true )
 {
 }
 
@@ -193,6 +235,7 @@ void CDnnSolver::Train()
 
 	CFloatHandleStackVar oneDivEpoch( mathEngine );
 
+	CArray<CLayerToTrain> layersToTrain;
 	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
 		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
 	{
@@ -215,12 +258,35 @@ void CDnnSolver::Train()
 
 		clipGradients( paramDiffBlobsSum.Sum );
 
-		// Train the layer based on the calculated diff data
-		TrainLayer( layer, layer->paramBlobs, paramDiffBlobsSum.Sum, layerToGradientHistory.GetOrCreateValue( layer ) );
+		CLayerToTrain& layerToTrain = layersToTrain.Append();
+		layerToTrain.Layer = layer;
+		layerToTrain.ParamBlobs = &layer->paramBlobs;
+		layerToTrain.ParamDiffBlobs = &paramDiffBlobsSum.Sum;
+		layerToTrain.LearningHistory = &layerToGradientHistory.GetOrCreateValue( layer );
+	}
+
+	// Train the layers based on the calculated diff data
+	if( !layersToTrain.IsEmpty() ) {
+		TrainLayers( layersToTrain );
+	}
+
+	// Clear the diff data
+	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
+	{
+		if( !layerToParamDiffBlobsSum.GetValue( pos ).Sum.IsEmpty() ) {
+			// The parameters of the layer have been changed
+			layerToParamDiffBlobsSum.GetKey( pos )->OnParamBlobsChanged();
+		}
+		layerToParamDiffBlobsSum.GetValue( pos ).Sum.Empty();
+		layerToParamDiffBlobsSum.GetValue( pos ).Count = 0;
+	}
+}
 
-		// Clear the diff data
-		paramDiffBlobsSum.Sum.Empty();
-		paramDiffBlobsSum.Count = 0;
+void CDnnSolver::TrainLayers( const CArray<CLayerToTrain>& layers )
+{
+	for( int i = 0; i < layers.Size(); i++ ) {
+		TrainLayer( layers[i].Layer, *layers[i].ParamBlobs, *layers[i].ParamDiffBlobs, *layers[i].LearningHistory );
 	}
 }
 
@@ -337,13 +403,7 @@ void CDnnSimpleGradientSolver::Serialize( CArchive& archive, CDnn& dnn )
 void CDnnSimpleGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 	const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory )
 {
-	if(gradientHistory.Size() == 0) {
-		for (int i = 0; i < paramDiffBlobs.Size(); ++i) {
-			CDnnBlob* blob = paramDiffBlobs[i]->GetClone();
-			blob->Clear();
-			gradientHistory.Add(blob);
-		}
-	}
+	createGradientHistory( paramDiffBlobs, 1, gradientHistory );
 
 	float rate = layer->GetBaseLearningRate() * GetLearningRate();
 	float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
@@ -392,6 +452,32 @@ void CDnnSimpleGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjec
 	}
 }
 
+void CDnnSimpleGradientSolver::TrainLayers( const CArray<CLayerToTrain>& layers )
+{
+	// The compatibility mode stores the moment differently, so it isn't fused
+	if( isInCompatibilityMode || !IsFusedUpdateUsed() ) {
+		CDnnSolver::TrainLayers( layers );
+		return;
+	}
+
+	CArray<CFusedSolverTensor> tensors;
+	for( int i = 0; i < layers.Size(); ++i ) {
+		const CBaseLayer* layer = layers[i].Layer;
+		const int firstTensor = tensors.Size();
+		addFusedSolverTensors( *layers[i].ParamBlobs, *layers[i].ParamDiffBlobs, *layers[i].LearningHistory, 1, tensors );
+
+		const float rate = layer->GetBaseLearningRate() * GetLearningRate();
+		const float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
+		const float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
+		for( int j = firstTensor; j < tensors.Size(); ++j ) {
+			tensors[j].Rate = rate;
+			tensors[j].L1 = max( regL1, 0.f );
+			tensors[j].L2 = max( regL2, 0.f );
+		}
+	}
+	MathEngine().FusedSgdStep( tensors.GetPtr(), tensors.Size(), momentDecayRate );
+}
+
 CDnnAdaptiveGradientSolver::CDnnAdaptiveGradientSolver( IMathEngine& mathEngine ) :
 	CDnnSolver( mathEngine ),
 	momentDecayRate(0.9f),
@@ -400,6 +486,7 @@ CDnnAdaptiveGradientSolver::CDnnAdaptiveGradientSolver( IMathEngine& mathEngine
 	secondMomentDecayRateN(1.f),
 	epsilon(1e-6f),
 	isAmsGradEnabled( false ),
+	isDecoupledWeightDecay( false ),
 	isInCompatibilityMode( false ),
 	tempVariables( CDnnBlob::CreateVector( mathEngine, CT_Float, TV_Count ) )
 {
@@ -412,11 +499,11 @@ void CDnnAdaptiveGradientSolver::EnableAmsGrad( bool enable )
 	isAmsGradEnabled = enable;
 }
 
-static const int DnnAdaptiveGradientSolver = 0;
+static const int DnnAdaptiveGradientSolver = 1;
 
 void CDnnAdaptiveGradientSolver::Serialize( CArchive& archive, CDnn& dnn )
 {
-	archive.SerializeVersion( DnnAdaptiveGradientSolver );
+	const int version = archive.SerializeVersion( DnnAdaptiveGradientSolver );
 	CDnnSolver::Serialize( archive, dnn );
 	archive.Serialize( momentDecayRate );
 	archive.Serialize( momentDecayRateN );
@@ -425,6 +512,11 @@ void CDnnAdaptiveGradientSolver::Serialize( CArchive& archive, CDnn& dnn )
 	archive.Serialize( epsilon );
 	archive.Serialize( isAmsGradEnabled );
 	archive.Serialize( isInCompatibilityMode );
+	if( version >= 1 ) {
+		archive.Serialize( isDecoupledWeightDecay );
+	} else {
+		isDecoupledWeightDecay = false;
+	}
 }
 
 void CDnnAdaptiveGradientSolver::OnReset()
@@ -444,17 +536,7 @@ void CDnnAdaptiveGradientSolver::OnTrain()
 void CDnnAdaptiveGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs, 
 	const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory )
 {
-	if(gradientHistory.Size() == 0) {
-		// Create blobs
-		int gradientHistoryTypeCount = IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default;
-		for( int j = 0; j < gradientHistoryTypeCount; j++ ) {
-			for(int i = 0; i < paramDiffBlobs.Size(); ++i) {
-				CDnnBlob* blob = paramDiffBlobs[i]->GetClone();
-				blob->Clear();
-				gradientHistory.Add( blob );
-			}
-		}
-	}
+	createGradientHistory( paramDiffBlobs, IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default, gradientHistory );
 
 	// Add regularization and add diffs to parameters
 	float rate = layer->GetBaseLearningRate() * GetLearningRate() * sqrtf(1 - secondMomentDecayRateN);
@@ -464,6 +546,12 @@ void CDnnAdaptiveGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 
 	float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
 	float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
+	// The decoupled weight decay doesn't use the moment correction
+	float weightDecay = 0;
+	if( isDecoupledWeightDecay ) {
+		weightDecay = max( layer->GetBaseLearningRate() * GetLearningRate() * regL2, 0.f );
+		regL2 = 0;
+	}
 
 	// Set the values of the variables
 	CFastArray<float, TV_Count> varValues;
@@ -478,6 +566,7 @@ void CDnnAdaptiveGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 	varValues[TV_L1Threshold] = regL1;
 	varValues[TV_L1Mult] = 1.f;
 	varValues[TV_EpsilonVar] = epsilon;
+	varValues[TV_OpWeightDecayVar] = 1 - weightDecay;
 
 	MathEngine().DataExchangeTyped<float>( tempVariables->GetData(), varValues.GetPtr(), TV_Count );
 
@@ -534,12 +623,52 @@ void CDnnAdaptiveGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 		// Divide the historical gradient by the square root
 		MathEngine().VectorEltwiseDivide(moment->GetData(), temporaryBlob->GetData(), 
 			temporaryBlob->GetData(), dataSize);
+		if( weightDecay > 0 ) {
+			// Decay the weights
+			MathEngine().VectorMultiply( paramBlobs[i]->GetData(), paramBlobs[i]->GetData(), dataSize,
+				tempVariables->GetData( {TV_OpWeightDecayVar} ) );
+		}
 		// Add the gradient
 		MathEngine().VectorMultiplyAndAdd(paramBlobs[i]->GetData(), temporaryBlob->GetData(),
 			paramBlobs[i]->GetData(), dataSize, tempVariables->GetData( {TV_RateVar} ));
 	}
 }
 
+void CDnnAdaptiveGradientSolver::TrainLayers( const CArray<CLayerToTrain>& layers )
+{
+	if( !IsFusedUpdateUsed() ) {
+		CDnnSolver::TrainLayers( layers );
+		return;
+	}
+
+	CArray<CFusedSolverTensor> tensors;
+	for( int i = 0; i < layers.Size(); ++i ) {
+		const CBaseLayer* layer = layers[i].Layer;
+		const int firstTensor = tensors.Size();
+		addFusedSolverTensors( *layers[i].ParamBlobs, *layers[i].ParamDiffBlobs, *layers[i].LearningHistory,
+			IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default, tensors );
+
+		const float layerRate = layer->GetBaseLearningRate() * GetLearningRate();
+		float rate = layerRate * sqrtf( 1 - secondMomentDecayRateN );
+		if( !isInCompatibilityMode ) {
+			rate /= ( 1 - momentDecayRateN );
+		}
+		const float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
+		const float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
+		for( int j = firstTensor; j < tensors.Size(); ++j ) {
+			tensors[j].Rate = rate;
+			tensors[j].L1 = max( regL1, 0.f );
+			if( isDecoupledWeightDecay ) {
+				tensors[j].WeightDecay = max( layerRate * regL2, 0.f );
+			} else {
+				tensors[j].L2 = max( regL2, 0.f );
+			}
+		}
+	}
+	MathEngine().FusedAdamStep( tensors.GetPtr(), tensors.Size(), momentDecayRate, secondMomentDecayRate, epsilon,
+		1.f, 0.f, 1.f );
+}
+
 CDnnNesterovGradientSolver::CDnnNesterovGradientSolver( IMathEngine& mathEngine ) :
 	CDnnSolver( mathEngine ),
 	momentDecayRate( 0.9f ),
@@ -597,17 +726,7 @@ void CDnnNesterovGradientSolver::OnTrain()
 void CDnnNesterovGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 	const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory )
 {
-	if(gradientHistory.Size() == 0) {
-		// Create blobs
-		int gradientHistoryTypeCount = IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default;
-		for( int j = 0; j < gradientHistoryTypeCount; j++ ) {
-			for(int i = 0; i < paramDiffBlobs.Size(); ++i) {
-				CDnnBlob* blob = paramDiffBlobs[i]->GetClone();
-				blob->Clear();
-				gradientHistory.Add( blob );
-			}
-		}
-	}
+	createGradientHistory( paramDiffBlobs, IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default, gradientHistory );
 
 	// Apply regularization and add diffs to the parameters
 	float rate = layer->GetBaseLearningRate() * GetLearningRate();
@@ -663,22 +782,24 @@ void CDnnNesterovGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 			tempVariables->GetData( {TV_MomentDecayRateVar}) );
 		MathEngine().VectorMultiplyAndAdd( moment->GetData(), paramDiffBlob->GetData(),
 			moment->GetData(), dataSize, tempVariables->GetData( {TV_OpMomentDecayRateVar} ) );
-		// Calculate the historical average squared gradient
-		MathEngine().VectorEltwiseMultiply( paramDiffBlob->GetData(), paramDiffBlob->GetData(),
-			temporaryBlob->GetData(), dataSize );
-		MathEngine().VectorMultiply( secondMoment->GetData(), secondMoment->GetData(), dataSize,
-			tempVariables->GetData( {TV_SecondMomentDecayRateVar} ) );
-		MathEngine().VectorMultiplyAndAdd( secondMoment->GetData(), temporaryBlob->GetData(),
-			secondMoment->GetData(), dataSize, tempVariables->GetData( {TV_OpSecondMomentDecayRateVar} ) );
 
 		// Calculate the auxiliary variables (notations taken from the reference paper)
 		// m with a dash
+		// It is calculated before the squared gradient, which may overwrite the regularized gradient in temporaryBlob
 		CFloatHandle mBar = mBarBlob->GetData();
 		MathEngine().VectorMultiply( paramDiffBlob->GetData(), mBar, dataSize,
 			tempVariables->GetData( {TV_MBarGradMultVar} ) );
 		MathEngine().VectorMultiplyAndAdd( mBar, moment->GetData(), mBar, dataSize,
 			tempVariables->GetData( {TV_MBarMomentMultVar} ) );
 
+		// Calculate the historical average squared gradient
+		MathEngine().VectorEltwiseMultiply( paramDiffBlob->GetData(), paramDiffBlob->GetData(),
+			temporaryBlob->GetData(), dataSize );
+		MathEngine().VectorMultiply( secondMoment->GetData(), secondMoment->GetData(), dataSize,
+			tempVariables->GetData( {TV_SecondMomentDecayRateVar} ) );
+		MathEngine().VectorMultiplyAndAdd( secondMoment->GetData(), temporaryBlob->GetData(),
+			secondMoment->GetData(), dataSize, tempVariables->GetData( {TV_OpSecondMomentDecayRateVar} ) );
+
 		// sqrt(n with a hat) + eps
 		if( IsAmsGradEnabled() ) {
 			// Update the maximum average
@@ -704,6 +825,35 @@ void CDnnNesterovGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 	}
 }
 
+void CDnnNesterovGradientSolver::TrainLayers( const CArray<CLayerToTrain>& layers )
+{
+	if( !IsFusedUpdateUsed() ) {
+		CDnnSolver::TrainLayers( layers );
+		return;
+	}
+
+	CArray<CFusedSolverTensor> tensors;
+	for( int i = 0; i < layers.Size(); ++i ) {
+		const CBaseLayer* layer = layers[i].Layer;
+		const int firstTensor = tensors.Size();
+		addFusedSolverTensors( *layers[i].ParamBlobs, *layers[i].ParamDiffBlobs, *layers[i].LearningHistory,
+			IsAmsGradEnabled() ? GHTC_AmsGrad : GHTC_Default, tensors );
+
+		const float rate = layer->GetBaseLearningRate() * GetLearningRate();
+		const float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
+		const float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
+		for( int j = firstTensor; j < tensors.Size(); ++j ) {
+			tensors[j].Rate = rate;
+			tensors[j].L1 = max( regL1, 0.f );
+			tensors[j].L2 = max( regL2, 0.f );
+		}
+	}
+	// The coefficients of m with a dash and n with a hat (notations taken from the reference paper)
+	MathEngine().FusedAdamStep( tensors.GetPtr(), tensors.Size(), momentDecayRate, secondMomentDecayRate, epsilon,
+		1 / ( 1 - secondMomentDecayRateN ), ( 1.f - muT ) / ( 1.f - productMuT ),
+		muTPlusOne / ( 1.f - productMuT * muTPlusOne ) );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 CDnnLambGradientSolver::CDnnLambGradientSolver( IMathEngine& mathEngine ) :
@@ -775,15 +925,7 @@ void CDnnLambGradientSolver::Serialize( CArchive& archive, CDnn& dnn )
 void CDnnLambGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 	const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory )
 {
-	if( gradientHistory.IsEmpty() ) {
-		for( int j = 0; j < 2; j++ ) {
-			for( int i = 0; i < paramDiffBlobs.Size(); ++i ) {
-				CDnnBlob* blob = paramDiffBlobs[i]->GetClone();
-				blob->Clear();
-				gradientHistory.Add( blob );
-			}
-		}
-	}
+	createGradientHistory( paramDiffBlobs, 2, gradientHistory );
 
 	const float rate = layer->GetBaseLearningRate() * GetLearningRate();
 	const float layerWeighDecay = GetL2Regularization() * layer->GetBaseL2RegularizationMult();
@@ -878,6 +1020,44 @@ void CDnnLambGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectA
 	}
 }
 
+void CDnnLambGradientSolver::TrainLayers( const CArray<CLayerToTrain>& layers )
+{
+	if( !IsFusedUpdateUsed() ) {
+		CDnnSolver::TrainLayers( layers );
+		return;
+	}
+
+	CArray<CFusedSolverTensor> tensors;
+	for( int i = 0; i < layers.Size(); ++i ) {
+		const CBaseLayer* layer = layers[i].Layer;
+		const int firstTensor = tensors.Size();
+		addFusedSolverTensors( *layers[i].ParamBlobs, *layers[i].ParamDiffBlobs, *layers[i].LearningHistory, 2, tensors );
+
+		const float rate = layer->GetBaseLearningRate() * GetLearningRate();
+		const float layerWeighDecay = GetL2Regularization() * layer->GetBaseL2RegularizationMult();
+		CHashTable<int> weightDecayParamIndexes;
+		getWeightDecayIndices( *layer, tensors.Size() - firstTensor, weightDecayParamIndexes );
+		for( int j = firstTensor; j < tensors.Size(); ++j ) {
+			tensors[j].Rate = rate;
+			if( weightDecayParamIndexes.Has( j - firstTensor ) && layerWeighDecay > 0 ) {
+				tensors[j].WeightDecay = layerWeighDecay;
+			}
+		}
+	}
+
+	CArray<float> diffSquaredNorms;
+	if( useNvLamb ) {
+		diffSquaredNorms.SetSize( tensors.Size() );
+	}
+	MathEngine().FusedLambStep( tensors.GetPtr(), tensors.Size(), momentDecayRate, secondMomentDecayRate, epsilon,
+		useNvLamb ? 1.0f / max( 1.0f, totalGradientNorm ) : 1.0f, useTrustRatio, weightDecayClip,
+		useNvLamb ? diffSquaredNorms.GetPtr() : nullptr );
+	// The squared gradient norms are used for calculation of L2-norm of the whole model on the next step
+	for( int i = 0; i < diffSquaredNorms.Size(); ++i ) {
+		layersGradientNormSquare.Add( diffSquaredNorms[i] );
+	}
+}
+
 // L2 norm of a vector
 float CDnnLambGradientSolver::calcL2Norm( const CConstFloatHandle& data, int dataSize ) const
 {
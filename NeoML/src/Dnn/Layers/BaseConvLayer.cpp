@@ -115,6 +115,7 @@ void CBaseConvLayer::SetFilterData(const CPtr<CDnnBlob>& newFilter)
 	} else {
 		Filter() = newFilter->GetCopy();
 	}
+	OnParamBlobsChanged();
 }
 
 CPtr<CDnnBlob> CBaseConvLayer::GetFreeTermData() const
@@ -184,6 +185,7 @@ void CBaseConvLayer::FilterLayerParams( float threshold )
 				paramBlobs[blobIndex]->GetDataSize(), threshold );
 		}
 	}
+	OnParamBlobsChanged();
 }
 
 static const int BaseConvLayerVersion = 2000;
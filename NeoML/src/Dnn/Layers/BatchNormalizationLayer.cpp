@@ -462,6 +462,18 @@ void CBatchNormalizationLayer::SetFinalParams(const CPtr<CDnnBlob>& _params)
 	isFinalParamDirty = false;
 }
 
+void CBatchNormalizationLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseLayer::TransferParamsBlob( dist );
+
+	// The statistics and the final parameters are stored outside of paramBlobs
+	// Without learning they are only read, so the layers may share them
+	CBatchNormalizationLayer* distBatchNorm = CheckCast<CBatchNormalizationLayer>( &dist );
+	distBatchNorm->finalParams = finalParams;
+	distBatchNorm->internalParams = internalParams;
+	distBatchNorm->isFinalParamDirty = isFinalParamDirty;
+}
+
 static const int BatchNormalizationLayerVersion = 2000;
 
 void CBatchNormalizationLayer::Serialize( CArchive& archive )
@@ -22,12 +22,18 @@ namespace NeoML {
 
 CChannelwiseConvLayer::CChannelwiseConvLayer( IMathEngine& mathEngine ) :
 	CBaseConvLayer( mathEngine, "CCnnChannelwiseConvLayer" ),
-	convDesc( 0 )
+	convDesc( 0 ),
+	int8Filter( mathEngine )
 {
 }
 
 CPtr<CDnnBlob> CChannelwiseConvLayer::GetFilterData() const
 {
+	if( int8Filter.IsQuantized() ) {
+		CPtr<CDnnBlob> filter = CDnnBlob::CreateBlob( MathEngine(), CT_Float, filterDesc() );
+		dequantizeFilter( filter->GetData() );
+		return filter;
+	}
 	if(Filter() == 0) {
 		return 0;
 	}
@@ -35,10 +41,17 @@ CPtr<CDnnBlob> CChannelwiseConvLayer::GetFilterData() const
 	return Filter()->GetCopy();
 }
 
+void CChannelwiseConvLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseConvLayer::TransferParamsBlob( dist );
+	int8Filter.ShareWith( CheckCast<CChannelwiseConvLayer>( &dist )->int8Filter );
+}
+
 void CChannelwiseConvLayer::SetFilterData(const CPtr<CDnnBlob>& newFilter)
 {
 	NeoAssert( newFilter == nullptr || newFilter->GetObjectCount() == 1 );
 	NeoAssert( newFilter == nullptr || newFilter->GetDepth() == 1 );
+	int8Filter.Reset();
 	CBaseConvLayer::SetFilterData(newFilter);
 	if( Filter() != 0 ) {
 		filterCount = Filter()->GetChannelsCount();
@@ -59,11 +72,14 @@ void CChannelwiseConvLayer::Reshape()
 		CheckArchitecture( filterHeight <= inputDescs[i].Height() + 2 * paddingHeight
 			&& filterWidth <= inputDescs[i].Width() + 2 * paddingWidth,
 			GetName(), "filter is bigger than input" );
-		CheckArchitecture( (Filter() == 0 || filterCount == inputDescs[i].Channels()),
+		CheckArchitecture( ( ( Filter() == 0 && !int8Filter.IsQuantized() ) || filterCount == inputDescs[i].Channels() ),
 			GetName(), "filter count is not equal to input channels count" );
 		CheckArchitecture( inputDescs[i].Depth() == 1, GetName(), "input depth is not equal to one" );
 
-		if( Filter() == 0 ) {
+		if( int8Filter.IsQuantized() ) {
+			NeoAssert( int8Filter.GetRowCount() == filterCount );
+			NeoAssert( int8Filter.GetRowSize() == filterHeight * filterWidth );
+		} else if( Filter() == 0 ) {
 			filterCount = inputDescs[i].Channels();
 			// Create the weights matrix
 			Filter() = CDnnBlob::Create2DImageBlob( MathEngine(), CT_Float, 1, 1, filterHeight, filterWidth,
@@ -106,6 +122,17 @@ void CChannelwiseConvLayer::RunOnce()
 	initConvDesc();
 
 	CConstFloatHandle freeTerm = FreeTerms()->GetData();
+	if( int8Filter.IsQuantized() ) {
+		CFloatHandleStackVar filter( MathEngine(), filterDesc().BlobSize() );
+		dequantizeFilter( filter.GetHandle() );
+		for( int i = 0; i < outputBlobs.Size(); ++i ) {
+			MathEngine().BlobChannelwiseConvolution( *convDesc,
+				inputBlobs[i]->GetData(), filter.GetHandle(),
+				IsZeroFreeTerm() ? 0 : &freeTerm, outputBlobs[i]->GetData() );
+		}
+		return;
+	}
+
 	for( int i = 0; i < outputBlobs.Size(); ++i ) {
 		MathEngine().BlobChannelwiseConvolution( *convDesc,
 			inputBlobs[i]->GetData(), Filter()->GetData(),
@@ -115,6 +142,7 @@ void CChannelwiseConvLayer::RunOnce()
 
 void CChannelwiseConvLayer::BackwardOnce()
 {
+	CheckArchitecture( !int8Filter.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	initConvDesc();
 
 	for( int i = 0; i < inputDiffBlobs.Size(); ++i ) {
@@ -126,6 +154,7 @@ void CChannelwiseConvLayer::BackwardOnce()
 
 void CChannelwiseConvLayer::LearnOnce()
 {
+	CheckArchitecture( !int8Filter.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	initConvDesc();
 
 	CFloatHandle freeTermDiff = FreeTermsDiff()->GetData();
@@ -135,12 +164,64 @@ void CChannelwiseConvLayer::LearnOnce()
 	}
 }
 
-static const int ChannelwiseConvLayerVersion = 2000;
+bool CChannelwiseConvLayer::QuantizeInt8()
+{
+	CheckArchitecture( MathEngine().GetType() == MET_Cpu, GetName(), "int8 quantization is supported only on CPU" );
+	if( int8Filter.IsQuantized() ) {
+		return true;
+	}
+	if( Filter() == 0 ) {
+		return false;
+	}
+
+	// The filter is stored as FilterHeight * FilterWidth * Channels; put the channels into the rows
+	CBlobDesc transposedDesc( CT_Float );
+	transposedDesc.SetDimSize( BD_BatchWidth, filterCount );
+	transposedDesc.SetDimSize( BD_Height, filterHeight );
+	transposedDesc.SetDimSize( BD_Width, filterWidth );
+	CPtr<CDnnBlob> transposedFilter = CDnnBlob::CreateBlob( MathEngine(), CT_Float, transposedDesc );
+	MathEngine().TransposeMatrix( 1, Filter()->GetData(), filterHeight * filterWidth, 1, filterCount, 1,
+		transposedFilter->GetData(), transposedFilter->GetDataSize() );
+
+	int8Filter.Quantize( *transposedFilter );
+	// Only the quantized filter is stored from now on
+	Filter() = 0;
+	return true;
+}
+
+// The description of the float filter, also when only the quantized filter is stored
+CBlobDesc CChannelwiseConvLayer::filterDesc() const
+{
+	if( Filter() != 0 ) {
+		return Filter()->GetDesc();
+	}
+	CBlobDesc desc( CT_Float );
+	desc.SetDimSize( BD_Height, filterHeight );
+	desc.SetDimSize( BD_Width, filterWidth );
+	desc.SetDimSize( BD_Channels, filterCount );
+	return desc;
+}
+
+// Restores the float filter from int8Filter
+void CChannelwiseConvLayer::dequantizeFilter( const CFloatHandle& filter ) const
+{
+	CPtr<CDnnBlob> transposedFilter = int8Filter.Dequantize();
+	MathEngine().TransposeMatrix( 1, transposedFilter->GetData(), filterCount, 1, filterHeight * filterWidth, 1,
+		filter, transposedFilter->GetDataSize() );
+}
+
+static const int ChannelwiseConvLayerVersion = 2001;
 
 void CChannelwiseConvLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( ChannelwiseConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( ChannelwiseConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseConvLayer::Serialize( archive );
+
+	if( version >= 2001 ) {
+		int8Filter.Serialize( archive );
+	} else if( archive.IsLoading() ) {
+		int8Filter.Reset();
+	}
 }
 
 void CChannelwiseConvLayer::initConvDesc()
@@ -148,7 +229,7 @@ void CChannelwiseConvLayer::initConvDesc()
 	if( convDesc == 0 ) {
 		convDesc = MathEngine().InitBlobChannelwiseConvolution( inputBlobs[0]->GetDesc(),
 			paddingHeight, paddingWidth, strideHeight, strideWidth,
-			Filter()->GetDesc(), &FreeTerms()->GetDesc(), outputBlobs[0]->GetDesc() );
+			filterDesc(), &FreeTerms()->GetDesc(), outputBlobs[0]->GetDesc() );
 	}
 }
 
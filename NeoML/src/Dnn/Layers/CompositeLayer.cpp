@@ -398,6 +398,18 @@ void CCompositeLayer::FilterLayerParams( float threshold )
 	}
 }
 
+void CCompositeLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseLayer::TransferParamsBlob( dist );
+
+	CCompositeLayer* distComposite = CheckCast<CCompositeLayer>( &dist );
+	NeoAssert( distComposite->layers.Size() == layers.Size() );
+	for( int i = 0; i < layers.Size(); ++i ) {
+		CBaseLayer* distLayer = distComposite->layerMap.Get( layers[i]->GetName() );
+		layers[i]->TransferParamsBlob( *distLayer );
+	}
+}
+
 void CCompositeLayer::SetInternalDnnParams()
 {
 	NeoAssert(internalDnn != 0);
@@ -21,9 +21,36 @@ limitations under the License.
 
 namespace NeoML {
 
+// The filter prepared for the convolution algorithm
+// The layers that share the parameters share this object, so the filter is prepared only once
+class CConvLayer::CPreparedFilter : public IObject {
+public:
+	// Gets the filter prepared for the descriptor, preparing it if needed
+	CPtr<CDnnBlob> Get( IMathEngine& mathEngine, const CConvolutionDesc& desc, int size, const CDnnBlob& filter );
+
+private:
+	CCriticalSection section;
+	CPtr<CDnnBlob> blob;
+};
+
+CPtr<CDnnBlob> CConvLayer::CPreparedFilter::Get( IMathEngine& mathEngine, const CConvolutionDesc& desc, int size,
+	const CDnnBlob& filter )
+{
+	CCriticalSectionLock lock( section );
+	if( blob == 0 || blob->GetDataSize() != size ) {
+		blob = CDnnBlob::CreateVector( mathEngine, CT_Float, size );
+		mathEngine.PrepareBlobConvolutionFilter( desc, filter.GetData(), blob->GetData() );
+	}
+	return blob;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
 CConvLayer::CConvLayer( IMathEngine& mathEngine ) :
 	CBaseConvLayer( mathEngine, "CCnnConvLayer" ),
-	convDesc( 0 )
+	convDesc( 0 ),
+	int8Filter( mathEngine ),
+	preparedFilter( FINE_DEBUG_NEW CPreparedFilter() )
 {
 }
 
@@ -37,7 +64,7 @@ void CConvLayer::initConvDesc()
 	if( convDesc == 0 ) {
 		convDesc = MathEngine().InitBlobConvolution( inputBlobs[0]->GetDesc(),
 			paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth,
-			Filter()->GetDesc(), outputBlobs[0]->GetDesc() );
+			int8Filter.IsQuantized() ? int8Filter.GetWeightsDesc() : Filter()->GetDesc(), outputBlobs[0]->GetDesc() );
 	}
 }
 void CConvLayer::destroyConvDesc()
@@ -74,7 +101,14 @@ void CConvLayer::Reshape()
 			&& filterWidth <= inputDescs[i].Width() + 2 * paddingWidth,
 			GetName(), "filter is bigger than input" );
 
-		if(Filter() == 0) {
+		if( int8Filter.IsQuantized() ) {
+			const CBlobDesc& filterDesc = int8Filter.GetWeightsDesc();
+			NeoAssert( filterDesc.ObjectCount() == filterCount );
+			NeoAssert( filterDesc.Height() == filterHeight );
+			NeoAssert( filterDesc.Width() == filterWidth );
+			NeoAssert( filterDesc.Depth() == inputDescs[i].Depth() );
+			NeoAssert( filterDesc.Channels() == inputDescs[i].Channels() );
+		} else if(Filter() == 0) {
 			// Create a weights matrix
 			Filter() = CDnnBlob::Create3DImageBlob( MathEngine(), CT_Float, 1, filterCount, filterHeight, filterWidth,
 				inputDescs[i].Depth(), inputDescs[i].Channels() );
@@ -113,14 +147,57 @@ void CConvLayer::RunOnce()
 	initConvDesc();
 
 	for( int i = 0; i < outputBlobs.Size(); ++i ) {
+		if( int8Filter.IsCalibrationEnabled() ) {
+			int8Filter.UpdateInputRange( *inputBlobs[i] );
+		}
+
 		CFloatHandle freeTerm = FreeTerms()->GetData();
-		MathEngine().BlobConvolution( *convDesc, inputBlobs[i]->GetData(),
-			Filter()->GetData(), &freeTerm, outputBlobs[i]->GetData() );
+		if( int8Filter.IsQuantized() ) {
+			MathEngine().BlobQuantizedConvolution( *convDesc, inputBlobs[i]->GetData(), int8Filter.GetInputScale(),
+				int8Filter.GetQuantizedWeights(), int8Filter.GetScales(), &freeTerm, outputBlobs[i]->GetData() );
+		} else if( const CDnnBlob* prepared = getPreparedFilter() ) {
+			const CConstFloatHandle constFreeTerm = freeTerm;
+			MathEngine().BlobConvolutionWithPreparedFilter( *convDesc, inputBlobs[i]->GetData(),
+				prepared->GetData(), &constFreeTerm, outputBlobs[i]->GetData() );
+		} else {
+			MathEngine().BlobConvolution( *convDesc, inputBlobs[i]->GetData(),
+				Filter()->GetData(), &freeTerm, outputBlobs[i]->GetData() );
+		}
+	}
+}
+
+// Gets the filter prepared for the current descriptor or null if the descriptor uses the original filter
+const CDnnBlob* CConvLayer::getPreparedFilter()
+{
+	const int size = MathEngine().GetBlobConvolutionPreparedFilterSize( *convDesc );
+	if( size == 0 ) {
+		return 0;
+	}
+	if( preparedFilterBlob == 0 || preparedFilterBlob->GetDataSize() != size ) {
+		preparedFilterBlob = preparedFilter->Get( MathEngine(), *convDesc, size, *Filter() );
 	}
+	return preparedFilterBlob.Ptr();
+}
+
+void CConvLayer::OnParamBlobsChanged()
+{
+	// The layers that shared the old prepared filter keep it
+	preparedFilter = FINE_DEBUG_NEW CPreparedFilter();
+	preparedFilterBlob = 0;
+}
+
+void CConvLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseConvLayer::TransferParamsBlob( dist );
+
+	CConvLayer* distConv = CheckCast<CConvLayer>( &dist );
+	distConv->preparedFilter = preparedFilter;
+	int8Filter.ShareWith( distConv->int8Filter );
 }
 
 void CConvLayer::BackwardOnce()
 {
+	CheckArchitecture( !int8Filter.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	initConvDesc();
 
 	for( int i = 0; i < inputDiffBlobs.Size(); ++i ) {
@@ -131,6 +208,7 @@ void CConvLayer::BackwardOnce()
 
 void CConvLayer::LearnOnce()
 {
+	CheckArchitecture( !int8Filter.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	initConvDesc();
 
 	CFloatHandle freeTermDiff = FreeTermsDiff()->GetData();
@@ -140,12 +218,50 @@ void CConvLayer::LearnOnce()
 	}
 }
 
-static const int ConvLayerVersion = 2000;
+CPtr<CDnnBlob> CConvLayer::GetFilterData() const
+{
+	if( int8Filter.IsQuantized() ) {
+		return int8Filter.Dequantize();
+	}
+	return CBaseConvLayer::GetFilterData();
+}
+
+void CConvLayer::SetFilterData( const CPtr<CDnnBlob>& newFilter )
+{
+	int8Filter.Reset();
+	CBaseConvLayer::SetFilterData( newFilter );
+}
+
+bool CConvLayer::QuantizeInt8()
+{
+	CheckArchitecture( MathEngine().GetType() == MET_Cpu, GetName(), "int8 quantization is supported only on CPU" );
+	if( int8Filter.IsQuantized() ) {
+		return true;
+	}
+	if( Filter() == 0 || int8Filter.GetInputRange() <= 0 ) {
+		return false;
+	}
+
+	int8Filter.Quantize( *Filter() );
+	int8Filter.EnableCalibration( false );
+	// Only the quantized filter is stored from now on
+	Filter() = 0;
+	OnParamBlobsChanged();
+	return true;
+}
+
+static const int ConvLayerVersion = 2001;
 
 void CConvLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( ConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( ConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseConvLayer::Serialize( archive );
+
+	if( version >= 2001 ) {
+		int8Filter.Serialize( archive );
+	} else if( archive.IsLoading() ) {
+		int8Filter.Reset();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
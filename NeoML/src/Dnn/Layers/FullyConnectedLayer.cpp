@@ -24,7 +24,8 @@ namespace NeoML {
 CFullyConnectedLayer::CFullyConnectedLayer( IMathEngine& mathEngine, const char* name ) :
 	CBaseLayer( mathEngine, name == nullptr ? "CCnnFullyConnectedLayer" : name, true ),
 	numberOfElements(0),
-	isZeroFreeTerm(false)
+	isZeroFreeTerm(false),
+	int8Weights( mathEngine )
 {
 	paramBlobs.SetSize(2);
 }
@@ -39,7 +40,12 @@ void CFullyConnectedLayer::Reshape()
 	CheckArchitecture( GetInputCount() == GetOutputCount(),
 		GetName(), "fully connected layer with different numbers of input and output" );
 	for(int i = 0; i < GetInputCount(); i++) {
-		if(Weights() == 0) {
+		if( int8Weights.IsQuantized() ) {
+			CheckArchitecture( int8Weights.GetRowCount() == numberOfElements,
+				GetName(), "weights number is not equal to number of elements" );
+			CheckArchitecture( int8Weights.GetRowSize() == inputDescs[i].ObjectSize(),
+				GetName(), "weights size mismatch" );
+		} else if(Weights() == 0) {
 			// Create a weights matrix
 			CBlobDesc weightsDesc = inputDescs[i];
 			weightsDesc.SetDimSize(BD_BatchLength, 1);
@@ -78,6 +84,19 @@ void CFullyConnectedLayer::RunOnce()
 	for( int i = 0; i < GetInputCount(); i++ ) {
 		CConstFloatHandle inputData = inputBlobs[i]->GetData();
 		CFloatHandle outputData = outputBlobs[i]->GetData();
+
+		if( int8Weights.IsCalibrationEnabled() ) {
+			int8Weights.UpdateInputRange( *inputBlobs[i] );
+		}
+
+		if( int8Weights.IsQuantized() ) {
+			CConstFloatHandle freeTermData = FreeTerms()->GetData();
+			MathEngine().MultiplyMatrixByTransposedQuantizedMatrix( inputData, inputBlobs[i]->GetObjectCount(),
+				inputBlobs[i]->GetObjectSize(), int8Weights.GetInputScale(), int8Weights.GetQuantizedWeights(),
+				int8Weights.GetScales(), numberOfElements, isZeroFreeTerm ? nullptr : &freeTermData, outputData );
+			continue;
+		}
+
 		CConstFloatHandle weightData = Weights()->GetData();
 
 		MathEngine().MultiplyMatrixByTransposedMatrix(inputData, inputBlobs[i]->GetObjectCount(),
@@ -94,6 +113,7 @@ void CFullyConnectedLayer::RunOnce()
 
 void CFullyConnectedLayer::BackwardOnce()
 {
+	CheckArchitecture( !int8Weights.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	for( int i = 0; i < outputDiffBlobs.Size(); i++ ) {
 		MathEngine().MultiplyMatrixByMatrix(1, outputDiffBlobs[i]->GetData(), inputBlobs[i]->GetObjectCount(),
 			outputDiffBlobs[i]->GetObjectSize(), Weights()->GetData(), Weights()->GetObjectSize(),
@@ -103,6 +123,7 @@ void CFullyConnectedLayer::BackwardOnce()
 
 void CFullyConnectedLayer::LearnOnce()
 {
+	CheckArchitecture( !int8Weights.IsQuantized(), GetName(), "int8 quantized layer supports only inference" );
 	for( int out = 0; out < outputDiffBlobs.Size(); out++ ) {
 		MathEngine().MultiplyTransposedMatrixByMatrixAndAdd(outputDiffBlobs[out]->GetData(),
 			outputDiffBlobs[out]->GetObjectCount(), numberOfElements, numberOfElements,
@@ -132,8 +153,17 @@ void CFullyConnectedLayer::SetNumberOfElements(int newNumberOfElements)
 	numberOfElements = newNumberOfElements;
 }
 
+void CFullyConnectedLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseLayer::TransferParamsBlob( dist );
+	int8Weights.ShareWith( CheckCast<CFullyConnectedLayer>( &dist )->int8Weights );
+}
+
 CPtr<CDnnBlob> CFullyConnectedLayer::GetWeightsData() const
 {
+	if( int8Weights.IsQuantized() ) {
+		return int8Weights.Dequantize();
+	}
 	if(Weights() == 0) {
 		return 0;
 	}
@@ -143,6 +173,7 @@ CPtr<CDnnBlob> CFullyConnectedLayer::GetWeightsData() const
 
 void CFullyConnectedLayer::SetWeightsData(const CDnnBlob* newWeights)
 {
+	int8Weights.Reset();
 	if(newWeights == 0) {
 		NeoAssert(Weights() == 0 || GetDnn() == 0);
 		Weights() = 0;
@@ -214,15 +245,37 @@ void CFullyConnectedLayer::ApplyBatchNormalization(CBatchNormalizationLayer& bat
 	}
 }
 
-static const int FullyConnectedLayerVersion = 2000;
+bool CFullyConnectedLayer::QuantizeInt8()
+{
+	CheckArchitecture( MathEngine().GetType() == MET_Cpu, GetName(), "int8 quantization is supported only on CPU" );
+	if( int8Weights.IsQuantized() ) {
+		return true;
+	}
+	if( Weights() == 0 || int8Weights.GetInputRange() <= 0 ) {
+		return false;
+	}
+
+	int8Weights.Quantize( *Weights() );
+	int8Weights.EnableCalibration( false );
+	// Only the quantized weights are stored from now on
+	Weights() = 0;
+	return true;
+}
+
+static const int FullyConnectedLayerVersion = 2001;
 
 void CFullyConnectedLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseLayer::Serialize( archive );
 
 	archive.Serialize( numberOfElements );
 	archive.Serialize( isZeroFreeTerm );
+	if( version >= 2001 ) {
+		int8Weights.Serialize( archive );
+	} else if( archive.IsLoading() ) {
+		int8Weights.Reset();
+	}
 
 	if( archive.IsLoading() ) {
 		// Converts the free terms blob into a new tensor with the length in the first dimension not Channels
@@ -25,7 +25,8 @@ limitations under the License.
 namespace NeoML {
 
 CGruLayer::CGruLayer( IMathEngine& mathEngine ) :
-	CRecurrentLayer( mathEngine, "CCnnGruLayer" )
+	CRecurrentLayer( mathEngine, "CCnnGruLayer" ),
+	isFusedInference( false )
 {
 	buildLayer();
 }
@@ -127,6 +128,75 @@ void CGruLayer::SetHiddenSize(int size)
 	mainBackLink->SetDimSize(BD_Channels, size);
 }
 
+void CGruLayer::RunOnce()
+{
+	if( canRunFused() ) {
+		runFused();
+	} else {
+		CRecurrentLayer::RunOnce();
+	}
+}
+
+// Checks if the fused implementation may be used instead of the internal network
+bool CGruLayer::canRunFused() const
+{
+	return isFusedInference && MathEngine().GetType() == MET_Cpu && IsWholeSequenceInference()
+		&& GetInputCount() == 1 && inputBlobs[0]->GetListSize() == 1
+		&& !mainLayer->IsInt8Quantized() && !gateLayer->IsInt8Quantized();
+}
+
+// Calculates the input part of a fully connected layer for all the steps at once
+// The layer works over the concatenation of the input and the previous output,
+// so only the first inputSize columns of its weights are used
+static CPtr<CDnnBlob> calculateGruInputPart( IMathEngine& mathEngine, const CDnnBlob& input,
+	const CFullyConnectedLayer& layer )
+{
+	const CDnnBlob& weights = *layer.GetWeights();
+	const int objectCount = input.GetObjectCount();
+	const int inputSize = input.GetObjectSize();
+	const int outputSize = weights.GetObjectCount();
+
+	CPtr<CDnnBlob> result = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, input.GetBatchLength(),
+		input.GetBatchWidth(), outputSize );
+	mathEngine.MultiplyMatrixByTransposedMatrix( input.GetData(), objectCount, inputSize, inputSize,
+		weights.GetData(), outputSize, weights.GetObjectSize(), result->GetData(), outputSize, result->GetDataSize() );
+	if( !layer.IsZeroFreeTerm() ) {
+		mathEngine.AddVectorToMatrixRows( 1, result->GetData(), result->GetData(), objectCount, outputSize,
+			layer.GetFreeTerms()->GetData() );
+	}
+	return result;
+}
+
+// Processes the whole sequence without the internal network
+void CGruLayer::runFused()
+{
+	const int hiddenSize = GetHiddenSize();
+	const int sequenceLength = inputBlobs[0]->GetBatchLength();
+	const int batchSize = inputBlobs[0]->GetBatchWidth();
+	const int inputSize = inputBlobs[0]->GetObjectSize();
+
+	// The recurrent parts of the weights are the last hiddenSize columns, they are used in place
+	const CDnnBlob* gateWeights = gateLayer->GetWeights();
+	const CDnnBlob* mainWeights = mainLayer->GetWeights();
+	const int weightsRowSize = inputSize + hiddenSize;
+	NeoPresume( gateWeights->GetObjectCount() == G_Count * hiddenSize && gateWeights->GetObjectSize() == weightsRowSize );
+	NeoPresume( mainWeights->GetObjectCount() == hiddenSize && mainWeights->GetObjectSize() == weightsRowSize );
+
+	CPtr<CDnnBlob> gateWx = calculateGruInputPart( MathEngine(), *inputBlobs[0], *gateLayer );
+	CPtr<CDnnBlob> mainWx = calculateGruInputPart( MathEngine(), *inputBlobs[0], *mainLayer );
+
+	// The back link keeps the result of the last step of the previous run, as in the internal network
+	// A reverse sequence always starts from zeros
+	CDnnBlob* prevOutput = mainBackLink->CaptureSink()->GetBlob();
+	NeoPresume( prevOutput->GetDataSize() == batchSize * hiddenSize );
+	MathEngine().GruRecurrent( IsReverseSequence(), sequenceLength, batchSize, hiddenSize,
+		gateWx->GetData(), mainWx->GetData(), gateWeights->GetData() + inputSize, mainWeights->GetData() + inputSize,
+		weightsRowSize, IsReverseSequence() ? CFloatHandle() : prevOutput->GetData(), outputBlobs[0]->GetData() );
+
+	const int lastStepOffset = ( IsReverseSequence() ? 0 : sequenceLength - 1 ) * batchSize * hiddenSize;
+	MathEngine().VectorCopy( prevOutput->GetData(), outputBlobs[0]->GetData() + lastStepOffset, batchSize * hiddenSize );
+}
+
 static const int GruLayerVersion = 2000;
 
 void CGruLayer::Serialize( CArchive& archive )
@@ -36,7 +36,8 @@ static const char* recurHiddenLayerName = "RecurHidden";
 CLstmLayer::CLstmLayer( IMathEngine& mathEngine ) :
 	CRecurrentLayer( mathEngine, "CCnnLstmLayer" ),
 	recurrentActivation( AF_Sigmoid ),
-	isInCompatibilityMode( false )
+	isInCompatibilityMode( false ),
+	isFusedInference( false )
 {
 	buildLayer(0);
 }
@@ -238,6 +239,70 @@ void CLstmLayer::SetCompatibilityMode( bool compatibilityMode )
 	ForceReshape();
 }
 
+void CLstmLayer::RunOnce()
+{
+	if( canRunFused() ) {
+		runFused();
+	} else {
+		CRecurrentLayer::RunOnce();
+	}
+}
+
+// Checks if the fused implementation may be used instead of the internal network
+bool CLstmLayer::canRunFused() const
+{
+	return isFusedInference && MathEngine().GetType() == MET_Cpu && IsWholeSequenceInference()
+		&& GetInputCount() == 1 && inputBlobs[0]->GetListSize() == 1
+		&& recurrentActivation == AF_Sigmoid && !isInCompatibilityMode
+		&& !inputHiddenLayer->IsInt8Quantized() && !recurHiddenLayer->IsInt8Quantized();
+}
+
+// Processes the whole sequence without the internal network
+// The dropout layers are skipped because they do nothing during inference
+void CLstmLayer::runFused()
+{
+	const int hiddenSize = GetHiddenSize();
+	const int gatesSize = G_Count * hiddenSize;
+	const int sequenceLength = inputBlobs[0]->GetBatchLength();
+	const int batchSize = inputBlobs[0]->GetBatchWidth();
+	const int objectCount = sequenceLength * batchSize;
+	const int inputSize = inputBlobs[0]->GetObjectSize();
+
+	const CDnnBlob* inputWeights = inputHiddenLayer->GetWeights();
+	const CDnnBlob* recurWeights = recurHiddenLayer->GetWeights();
+	NeoPresume( inputWeights->GetObjectCount() == gatesSize && inputWeights->GetObjectSize() == inputSize );
+	NeoPresume( recurWeights->GetObjectCount() == gatesSize && recurWeights->GetObjectSize() == hiddenSize );
+
+	// The input part of the gates is calculated for all the steps at once
+	CPtr<CDnnBlob> wx = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, sequenceLength, batchSize, gatesSize );
+	MathEngine().MultiplyMatrixByTransposedMatrix( inputBlobs[0]->GetData(), objectCount, inputSize, inputSize,
+		inputWeights->GetData(), gatesSize, inputSize, wx->GetData(), gatesSize, wx->GetDataSize() );
+	if( !inputHiddenLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, wx->GetData(), wx->GetData(), objectCount, gatesSize,
+			inputHiddenLayer->GetFreeTerms()->GetData() );
+	}
+	if( !recurHiddenLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, wx->GetData(), wx->GetData(), objectCount, gatesSize,
+			recurHiddenLayer->GetFreeTerms()->GetData() );
+	}
+
+	// The back links keep the result of the last step of the previous run, as in the internal network
+	// A reverse sequence always starts from zeros
+	CDnnBlob* prevOutput = mainBackLink->CaptureSink()->GetBlob();
+	CDnnBlob* prevState = stateBackLink->CaptureSink()->GetBlob();
+	NeoPresume( prevOutput->GetDataSize() == batchSize * hiddenSize );
+	NeoPresume( prevState->GetDataSize() == batchSize * hiddenSize );
+	MathEngine().LstmRecurrent( IsReverseSequence(), sequenceLength, batchSize, hiddenSize,
+		wx->GetData(), recurWeights->GetData(),
+		IsReverseSequence() ? CFloatHandle() : prevOutput->GetData(),
+		IsReverseSequence() ? CFloatHandle() : prevState->GetData(),
+		outputBlobs[0]->GetData(), outputBlobs[1]->GetData() );
+
+	const int lastStepOffset = ( IsReverseSequence() ? 0 : sequenceLength - 1 ) * batchSize * hiddenSize;
+	MathEngine().VectorCopy( prevOutput->GetData(), outputBlobs[0]->GetData() + lastStepOffset, batchSize * hiddenSize );
+	MathEngine().VectorCopy( prevState->GetData(), outputBlobs[1]->GetData() + lastStepOffset, batchSize * hiddenSize );
+}
+
 static const int LstmLayerVersion = 2001;
 
 void CLstmLayer::Serialize( CArchive& archive )
@@ -80,6 +80,18 @@ void CMultichannelLookupLayer::SetEmbeddings( CPtr<CDnnBlob>& data, int i, bool
 	}
 }
 
+void CMultichannelLookupLayer::TransferParamsBlob( CBaseLayer& dist ) const
+{
+	CBaseLayer::TransferParamsBlob( dist );
+
+	// The embeddings trained internally are stored outside of paramBlobs
+	CMultichannelLookupLayer* distLookup = CheckCast<CMultichannelLookupLayer>( &dist );
+	NeoAssert( distLookup->ownParams.Size() == ownParams.Size() );
+	for( int i = 0; i < ownParams.Size(); ++i ) {
+		distLookup->ownParams[i] = ownParams[i];
+	}
+}
+
 void CMultichannelLookupLayer::SetUseFrameworkLearning(bool _useFrameworkLearning)
 {
 	if(_useFrameworkLearning && !useFrameworkLearning) {
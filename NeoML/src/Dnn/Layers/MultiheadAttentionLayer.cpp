@@ -28,13 +28,24 @@ limitations under the License.
 
 namespace NeoML {
 
+// The multiplier of the mask before it is added to the attention matrix
+// The value is taken from the original realization
+static const float MaskMultiplier = -1e+9f;
+
+// The scaling factor of the attention matrix
+static float attentionScale( int hiddenSize )
+{
+	return static_cast<float>( 1.0 / sqrt( 1.0 * hiddenSize ) );
+}
+
 CMultiheadAttentionLayer::CMultiheadAttentionLayer( IMathEngine& mathEngine ) :
 	CCompositeLayer( mathEngine ),
 	headCount( 1 ),
 	hiddenSize( 8 ),
 	dropoutRate( -1 ),
 	useMask( false ),
-	outputSize( 8 )
+	outputSize( 8 ),
+	isFusedInference( false )
 {
 }
 
@@ -73,6 +84,12 @@ void CMultiheadAttentionLayer::SetOutputSize( int _outputSize )
 	outputSize = _outputSize;
 }
 
+void CMultiheadAttentionLayer::SetFusedInference( bool isFused )
+{
+	isFusedInference = isFused;
+	ForceReshape();
+}
+
 static const int MultiheadAttentionLayerVersion = 0;
 
 void CMultiheadAttentionLayer::Serialize( CArchive& archive )
@@ -93,6 +110,97 @@ void CMultiheadAttentionLayer::Reshape()
 	}
 
 	CCompositeLayer::Reshape();
+
+	fusedQ = 0;
+	fusedK = 0;
+	fusedV = 0;
+	fusedHeads = 0;
+	fusedMask = 0;
+	if( isFusedInference && MathEngine().GetType() == MET_Cpu && GetOutputCount() == 1 ) {
+		// [B, seq, 1, hiddenSize], the heads are laid out one after another
+		const int queryCount = inputDescs[I_Q].ObjectCount();
+		const int keyCount = inputDescs[I_K].ObjectCount();
+		fusedQ = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, queryCount, hiddenSize );
+		fusedK = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, keyCount, hiddenSize );
+		fusedV = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, keyCount, hiddenSize );
+		fusedHeads = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, queryCount, hiddenSize );
+		if( useMask ) {
+			fusedMask = CDnnBlob::CreateBlob( MathEngine(), CT_Float, inputDescs[I_Mask] );
+		}
+	}
+}
+
+void CMultiheadAttentionLayer::RunOnce()
+{
+	if( canRunFused() ) {
+		runFused();
+	} else {
+		CCompositeLayer::RunOnce();
+	}
+}
+
+// Checks if the fused implementation may be used instead of the internal network
+bool CMultiheadAttentionLayer::canRunFused()
+{
+	if( !isFusedInference || MathEngine().GetType() != MET_Cpu || GetDnn()->IsBackwardPerformed()
+		|| GetOutputCount() != 1 || fusedQ == 0 )
+	{
+		return false;
+	}
+	const char* const fcNames[] = { "Q", "K", "V", "Out.Dense" };
+	for( int i = 0; i < static_cast<int>( _countof( fcNames ) ); ++i ) {
+		if( CheckCast<CFullyConnectedLayer>( GetLayer( fcNames[i] ) )->IsInt8Quantized() ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Applies the internal fully connected layer to the objects of the input blob
+static void applyFullyConnected( const CFullyConnectedLayer& fc, const CDnnBlob& input, CDnnBlob& output )
+{
+	IMathEngine& mathEngine = input.GetMathEngine();
+	const int objectCount = input.GetObjectCount();
+	const int inputSize = input.GetObjectSize();
+	const int outputSize = fc.GetNumberOfElements();
+	NeoPresume( output.GetObjectCount() == objectCount && output.GetObjectSize() == outputSize );
+
+	mathEngine.MultiplyMatrixByTransposedMatrix( input.GetData(), objectCount, inputSize, inputSize,
+		fc.GetWeights()->GetData(), outputSize, inputSize, output.GetData(), outputSize, output.GetDataSize() );
+	if( !fc.IsZeroFreeTerm() ) {
+		mathEngine.AddVectorToMatrixRows( 1, output.GetData(), output.GetData(), objectCount, outputSize,
+			fc.GetFreeTerms()->GetData() );
+	}
+}
+
+// Calculates the layer output without the internal network
+void CMultiheadAttentionLayer::runFused()
+{
+	const int queryLength = inputBlobs[I_Q]->GetListSize();
+	const int keyLength = inputBlobs[I_K]->GetListSize();
+	const int batchSize = inputBlobs[I_Q]->GetObjectCount() / queryLength;
+	NeoPresume( inputBlobs[I_K]->GetObjectCount() == batchSize * keyLength );
+	NeoPresume( inputBlobs[I_V]->GetObjectCount() == batchSize * keyLength );
+
+	applyFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "Q" ) ), *inputBlobs[I_Q], *fusedQ );
+	applyFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "K" ) ), *inputBlobs[I_K], *fusedK );
+	applyFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "V" ) ), *inputBlobs[I_V], *fusedV );
+
+	if( useMask ) {
+		NeoPresume( inputBlobs[I_Mask]->GetDataSize() == queryLength * keyLength );
+		CFloatHandleStackVar multiplier( MathEngine() );
+		multiplier.SetValue( MaskMultiplier );
+		MathEngine().VectorMultiply( inputBlobs[I_Mask]->GetData(), fusedMask->GetData(), fusedMask->GetDataSize(),
+			multiplier );
+	}
+
+	// The heads are concatenated in the same order as in prepareOutput
+	MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, hiddenSize / headCount,
+		attentionScale( hiddenSize ), fusedQ->GetData(), fusedK->GetData(), fusedV->GetData(),
+		fusedMask == 0 ? CFloatHandle() : fusedMask->GetData(), fusedHeads->GetData() );
+
+	applyFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "Out.Dense" ) ), *fusedHeads,
+		*outputBlobs[O_Output] );
 }
 
 // Creates layer with new parameters
@@ -103,7 +211,7 @@ void CMultiheadAttentionLayer::create()
 	NeoAssert( hiddenSize % headCount == 0 );
 
 	// scaling factor
-	const float multiplier = static_cast<float>( 1.0 / sqrt( 1.0 * hiddenSize ) );
+	const float multiplier = attentionScale( hiddenSize );
 
 	// Applying W_Q, W_K and W_V to the corresponding inputs
 	// [B, seq_Q, 1, hiddenSize]
@@ -261,8 +369,7 @@ CBaseLayer* CMultiheadAttentionLayer::applyMask( CBaseLayer* layer )
 
 	CPtr<CLinearLayer> multiplierLayer = new CLinearLayer( MathEngine() );
 	multiplierLayer->SetName( GetName() + CString( ".Mask.MultiplyByConst" ) );
-	// The value is taken from the original realization
-	multiplierLayer->SetMultiplier( -1e+9 );
+	multiplierLayer->SetMultiplier( MaskMultiplier );
 	multiplierLayer->SetFreeTerm( 0 );
 	AddLayer( *multiplierLayer );
 	SetInputMapping( I_Mask, *multiplierLayer, 0 );
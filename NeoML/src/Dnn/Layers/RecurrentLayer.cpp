@@ -170,6 +170,11 @@ void CRecurrentLayer::SetInternalDnnParams()
 	}
 }
 
+bool CRecurrentLayer::IsWholeSequenceInference() const
+{
+	return !GetDnn()->IsRecurrentMode() && !GetDnn()->IsBackwardPerformed() && repeatCount == 1;
+}
+
 // Runs the forward pass of the internal network (overloaded in children)
 void CRecurrentLayer::RunInternalDnn()
 {
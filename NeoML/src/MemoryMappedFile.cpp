@@ -0,0 +1,195 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <MemoryMappedFile.h>
+
+#if FINE_PLATFORM( FINE_WINDOWS )
+#include <Windows.h>
+#elif FINE_PLATFORM( FINE_LINUX ) || FINE_PLATFORM( FINE_DARWIN ) || FINE_PLATFORM( FINE_IOS ) || FINE_PLATFORM( FINE_ANDROID )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#else
+#error Unknown platform
+#endif
+
+namespace NeoML {
+
+// Generates an exception with the last system error code if the condition is not fulfilled
+static inline void checkMappedFileError( bool condition, const CString& fileName )
+{
+	if( !condition ) {
+#if FINE_PLATFORM( FINE_WINDOWS )
+		const int errorCode = static_cast<int>( ::GetLastError() );
+#else
+		const int errorCode = errno;
+#endif
+#ifdef NEOML_USE_FINEOBJ
+		ThrowFileException( errorCode, fileName.CreateUnicodeString( CP_UTF8 ) );
+#else
+		ThrowFileException( errorCode, fileName );
+#endif
+	}
+}
+
+#if FINE_PLATFORM( FINE_WINDOWS )
+
+CMemoryMappedFile::CMemoryMappedFile() :
+	data( nullptr ),
+	length( 0 ),
+	isCopyOnWrite( false ),
+	file( INVALID_HANDLE_VALUE ),
+	mapping( nullptr )
+{
+}
+
+CMemoryMappedFile::CMemoryMappedFile( const char* _fileName, bool copyOnWrite ) :
+	data( nullptr ),
+	length( 0 ),
+	isCopyOnWrite( false ),
+	file( INVALID_HANDLE_VALUE ),
+	mapping( nullptr )
+{
+	Open( _fileName, copyOnWrite );
+}
+
+void CMemoryMappedFile::Open( const char* _fileName, bool copyOnWrite )
+{
+	NeoAssert( !IsOpen() );
+	try {
+		fileName = _fileName;
+		isCopyOnWrite = copyOnWrite;
+		file = ::CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr );
+		checkMappedFileError( file != INVALID_HANDLE_VALUE, fileName );
+		LARGE_INTEGER fileSize;
+		checkMappedFileError( ::GetFileSizeEx( file, &fileSize ) != 0, fileName );
+		length = fileSize.QuadPart;
+		NeoAssert( length > 0 );
+		mapping = ::CreateFileMappingA( file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr );
+		checkMappedFileError( mapping != nullptr, fileName );
+		data = ::MapViewOfFile( mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 );
+		checkMappedFileError( data != nullptr, fileName );
+	} catch( ... ) {
+		Close();
+		throw;
+	}
+}
+
+void CMemoryMappedFile::Close()
+{
+	if( data != nullptr ) {
+		::UnmapViewOfFile( data );
+		data = nullptr;
+	}
+	if( mapping != nullptr ) {
+		::CloseHandle( mapping );
+		mapping = nullptr;
+	}
+	if( file != INVALID_HANDLE_VALUE ) {
+		::CloseHandle( file );
+		file = INVALID_HANDLE_VALUE;
+	}
+	length = 0;
+	isCopyOnWrite = false;
+	fileName = CString();
+}
+
+void CMemoryMappedFile::Prefetch( __int64 /*offset*/, __int64 /*size*/ ) const
+{
+	// The system read-ahead is used
+}
+
+#else
+
+CMemoryMappedFile::CMemoryMappedFile() :
+	data( nullptr ),
+	length( 0 ),
+	isCopyOnWrite( false ),
+	file( -1 )
+{
+}
+
+CMemoryMappedFile::CMemoryMappedFile( const char* _fileName, bool copyOnWrite ) :
+	data( nullptr ),
+	length( 0 ),
+	isCopyOnWrite( false ),
+	file( -1 )
+{
+	Open( _fileName, copyOnWrite );
+}
+
+void CMemoryMappedFile::Open( const char* _fileName, bool copyOnWrite )
+{
+	NeoAssert( !IsOpen() );
+	try {
+		fileName = _fileName;
+		isCopyOnWrite = copyOnWrite;
+		file = open( fileName, O_RDONLY );
+		checkMappedFileError( file != -1, fileName );
+		struct stat fileStat;
+		checkMappedFileError( fstat( file, &fileStat ) == 0, fileName );
+		length = static_cast<__int64>( fileStat.st_size );
+		NeoAssert( length > 0 );
+		void* mappedData = copyOnWrite
+			? mmap( nullptr, static_cast<size_t>( length ), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 )
+			: mmap( nullptr, static_cast<size_t>( length ), PROT_READ, MAP_SHARED, file, 0 );
+		checkMappedFileError( mappedData != MAP_FAILED, fileName );
+		data = mappedData;
+	} catch( ... ) {
+		Close();
+		throw;
+	}
+}
+
+void CMemoryMappedFile::Close()
+{
+	if( data != nullptr ) {
+		munmap( const_cast<void*>( data ), static_cast<size_t>( length ) );
+		data = nullptr;
+	}
+	if( file != -1 ) {
+		close( file );
+		file = -1;
+	}
+	length = 0;
+	isCopyOnWrite = false;
+	fileName = CString();
+}
+
+void CMemoryMappedFile::Prefetch( __int64 offset, __int64 size ) const
+{
+	NeoAssert( IsOpen() );
+	NeoAssert( offset >= 0 && size >= 0 && offset + size <= length );
+	if( size == 0 ) {
+		return;
+	}
+
+	// The range should start on a page boundary
+	static const __int64 pageSize = static_cast<__int64>( sysconf( _SC_PAGESIZE ) );
+	const __int64 begin = offset - offset % pageSize;
+	// The errors are ignored as it is only a hint
+	madvise( static_cast<char*>( const_cast<void*>( data ) ) + begin, static_cast<size_t>( offset + size - begin ),
+		MADV_WILLNEED );
+}
+
+#endif
+
+} // namespace NeoML
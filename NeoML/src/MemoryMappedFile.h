@@ -0,0 +1,71 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+
+namespace NeoML {
+
+// A file mapped into memory for reading
+// The pages are loaded by the system on first access and may be evicted under memory pressure,
+// so the file may be larger than the available memory
+class CMemoryMappedFile {
+public:
+	CMemoryMappedFile();
+	// Opens the file and maps it into memory
+	// If copyOnWrite is true the mapped memory may be written to; the changed pages are copied
+	// and the changes are visible only to this process and are never written to the file
+	explicit CMemoryMappedFile( const char* fileName, bool copyOnWrite = false );
+	~CMemoryMappedFile() { Close(); }
+
+	// Checks if the file is open
+	bool IsOpen() const { return data != nullptr; }
+
+	// Opens the file and maps it into memory
+	void Open( const char* fileName, bool copyOnWrite = false );
+	// Unmaps and closes the file
+	void Close();
+
+	// The file name
+	const char* GetFileName() const { return fileName; }
+	// The file contents
+	const void* GetData() const { return data; }
+	// The file contents, if the file is mapped with copyOnWrite
+	void* GetWritableData() const { NeoPresume( isCopyOnWrite ); return const_cast<void*>( data ); }
+	// The file length
+	__int64 GetLength() const { return length; }
+
+	// Tells the system that the specified range of the file will be needed soon
+	// so that it can be read in the background
+	void Prefetch( __int64 offset, __int64 size ) const;
+
+private:
+	CString fileName; // the file name
+	const void* data; // the mapped file contents
+	__int64 length; // the file length
+	bool isCopyOnWrite; // the file is mapped with copyOnWrite
+#if FINE_PLATFORM( FINE_WINDOWS )
+	void* file; // the file handle
+	void* mapping; // the file mapping handle
+#else
+	int file; // the file descriptor
+#endif
+
+	CMemoryMappedFile( const CMemoryMappedFile& );
+	CMemoryMappedFile& operator=( const CMemoryMappedFile& );
+};
+
+} // namespace NeoML
@@ -19,6 +19,7 @@ limitations under the License.
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/TraditionalML/Model.h>
 #include <NeoML/TraditionalML/TrainingModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -29,14 +30,70 @@ IModel::~IModel()
 {
 }
 
+bool IModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+
+	const int curThreadCount = IsOmpRelevant( data.Height ) ? threadCount : 1;
+	CArray<bool> isSucceeded;
+	isSucceeded.Add( true, curThreadCount );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, index, count ) ) {
+			bool& threadSucceeded = isSucceeded[OmpGetThreadNum()];
+			CFloatVectorDesc row;
+			for( int i = index; i < index + count; i++ ) {
+				data.GetRow( i, row );
+				if( !Classify( row, results[i] ) ) {
+					threadSucceeded = false;
+				}
+			}
+		}
+	}
+
+	return isSucceeded.Find( false ) == NotFound;
+}
+
 IRegressionModel::~IRegressionModel()
 {
 }
 
+void IRegressionModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	results.SetSize( data.Height );
+
+	const int curThreadCount = IsOmpRelevant( data.Height ) ? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, index, count ) ) {
+			CFloatVectorDesc row;
+			for( int i = index; i < index + count; i++ ) {
+				data.GetRow( i, row );
+				results[i] = Predict( row );
+			}
+		}
+	}
+}
+
 IMultivariateRegressionModel::~IMultivariateRegressionModel()
 {
 }
 
+ITrainingModel* ITrainingModel::CreateCopy( int /*threadCount*/ ) const
+{
+	return nullptr;
+}
+
 ITrainingModel::~ITrainingModel()
 {
 }
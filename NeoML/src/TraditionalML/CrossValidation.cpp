@@ -19,12 +19,14 @@ limitations under the License.
 #include <NeoML/TraditionalML/CrossValidation.h>
 #include <NeoML/TraditionalML/CrossValidationSubProblem.h>
 #include <NeoML/TraditionalML/StratifiedCrossValidationSubProblem.h>
+#include <TrainingModelCopies.h>
 
 namespace NeoML {
 
 CCrossValidation::CCrossValidation( ITrainingModel& _trainingModel, const IProblem* _problem ) :
 	trainingModel( _trainingModel ),
-	problem( _problem )
+	problem( _problem ),
+	threadCount( 1 )
 {
 	NeoAssert( problem != 0 );
 }
@@ -41,8 +43,12 @@ void CCrossValidation::Execute( int partsCount, TScore score, CCrossValidationRe
 	result.ModelIndex.Empty();
 	result.ModelIndex.SetSize( problem->GetVectorCount() );
 	result.Success.Empty();
+	result.Models.SetSize( partsCount );
+	result.Success.SetSize( partsCount );
 
-	for( int i = 0; i < partsCount; i++ ) {
+	// Each thread takes the next part when it finishes the previous one
+	CTrainingModelCopies trainingModels( trainingModel, threadCount, partsCount );
+	trainingModels.Run( partsCount, [&]( ITrainingModel& partTrainingModel, int i ) {
 		// Choose the training subset
 		CPtr<ISubProblem> trainSubProblem;
 		if( stratified ) {
@@ -52,8 +58,8 @@ void CCrossValidation::Execute( int partsCount, TScore score, CCrossValidationRe
 		}
 
 		// Train the model
-		CPtr<IModel> model = trainingModel.Train( *trainSubProblem );
-		result.Models.Add( model );
+		CPtr<IModel> model = partTrainingModel.Train( *trainSubProblem );
+		result.Models[i] = model;
 
 		// Choose the testing subset
 		CPtr<ISubProblem> testSubProblem;
@@ -64,8 +70,9 @@ void CCrossValidation::Execute( int partsCount, TScore score, CCrossValidationRe
 		}
 
 		CFloatMatrixDesc testSubProblemMatrix = testSubProblem->GetMatrix();
-		
+
 		// Current model classification result to calculate the loss function
+		// The testing subsets do not intersect so the threads write to the different results
 		CArray<CClassificationResult> classificationResults;
 
 		for( int j = 0; j < testSubProblem->GetVectorCount(); j++ ) {
@@ -77,8 +84,8 @@ void CCrossValidation::Execute( int partsCount, TScore score, CCrossValidationRe
 			result.ModelIndex[testSubProblem->GetOriginalIndex( j )] = i;
 		}
 
-		result.Success.Add( score( classificationResults, testSubProblem ) );
-	}
+		result.Success[i] = score( classificationResults, testSubProblem );
+	} );
 }
 
 } // namespace NeoML
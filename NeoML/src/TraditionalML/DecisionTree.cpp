@@ -22,6 +22,8 @@ limitations under the License.
 #include <DecisionTreeNodeBase.h>
 #include <DecisionTreeClassificationModel.h>
 #include <DecisionTreeNodeClassificationStatistic.h>
+#include <DecisionTreeFastHistBuilder.h>
+#include <NeoMathEngine/OpenMP.h>
 #include <float.h>
 
 namespace NeoML {
@@ -32,6 +34,20 @@ IDecisionTreeModel::~IDecisionTreeModel()
 
 //---------------------------------------------------------------------------------------------------------
 
+// The best split of a node found from its statistics
+struct CDecisionTree::CSplit {
+	CArray<double> Predictions; // the class probabilities in the node
+	double MaxProbability; // the maximum of the probabilities
+	bool IsConst; // the node should be constant regardless of the features
+	// The best feature for splitting; NotFound if the node cannot be split
+	int FeatureIndex;
+	bool IsDiscrete;
+	CArray<double> Values;
+	double CriterionValue;
+
+	CSplit() : MaxProbability( 0 ), IsConst( false ), FeatureIndex( NotFound ), IsDiscrete( false ), CriterionValue( DBL_MAX ) {}
+};
+
 const int CDecisionTree::MaxClassifyNodesCacheSize;
 
 CDecisionTree::CDecisionTree( const CParams& _params, CRandom* _random ) :
@@ -51,12 +67,24 @@ CDecisionTree::CDecisionTree( const CParams& _params, CRandom* _random ) :
 	NeoAssert( params.MaxTreeDepth > 0 );
 	NeoAssert( params.MaxNodesCount > 1 );
 	NeoAssert( 0.00 <= params.ConstNodeThreshold && params.ConstNodeThreshold <= 1.0 );
+	NeoAssert( params.ThreadCount > 0 );
+	NeoAssert( params.MaxBins == 0 || params.MaxBins > 1 );
 }
 
 CDecisionTree::~CDecisionTree()
 {
 }
 
+ITrainingModel* CDecisionTree::CreateCopy( int threadCount ) const
+{
+	if( params.RandomSelectedFeaturesCount != NotFound ) {
+		return nullptr;
+	}
+	CParams copyParams = params;
+	copyParams.ThreadCount = threadCount;
+	return FINE_DEBUG_NEW CDecisionTree( copyParams );
+}
+
 CPtr<IModel> CDecisionTree::Train( const IProblem& problem )
 {
 	NeoAssert( problem.GetVectorCount() > 0 );
@@ -69,9 +97,15 @@ CPtr<IModel> CDecisionTree::Train( const IProblem& problem )
 		return COneVersusOne( *this ).Train( problem );
 	}
 
-	classificationProblem = &problem;
-	CPtr<CDecisionTreeClassificationModel> root =
-		dynamic_cast<CDecisionTreeClassificationModel*>( buildTree( problem.GetVectorCount() ).Ptr() );
+	CPtr<CDecisionTreeNodeBase> tree;
+	if( params.MaxBins > 0 ) {
+		CDecisionTreeFastHistBuilder builder( params, random, logStream );
+		tree = builder.Build( problem );
+	} else {
+		classificationProblem = &problem;
+		tree = buildTree( problem.GetVectorCount() );
+	}
+	CPtr<CDecisionTreeClassificationModel> root = dynamic_cast<CDecisionTreeClassificationModel*>( tree.Ptr() );
 
 	return root.Ptr();
 }
@@ -94,7 +128,7 @@ CPtr<CDecisionTreeNodeBase> CDecisionTree::buildTree( int vectorCount )
 		matrix.GetRow( i, desc );
 		rootStatistic->AddVector( i, desc );
 	}
-	rootStatistic->Finish();
+	rootStatistic->Finish( params.ThreadCount );
 
 	classifyNodesCache.Empty();
 	classifyNodesLevel.Empty();
@@ -107,7 +141,9 @@ CPtr<CDecisionTreeNodeBase> CDecisionTree::buildTree( int vectorCount )
 	statisticsCache.FreeBuffer();
 	statisticsCache.SetBufferSize( statisticsCacheSize );
 
-	split( *rootStatistic, 0 );
+	CSplit rootSplit;
+	findSplit( *rootStatistic, 0, params.ThreadCount, rootSplit );
+	split( *rootStatistic, rootSplit, 0 );
 	delete rootStatistic;
 
 	// Build the tree level by level
@@ -159,9 +195,24 @@ bool CDecisionTree::buildTreeLevel( const CFloatMatrixDesc& matrix, int level, C
 			}
 		}
 
-		// Split according to the statistics just gathered
-		for( int i = 0; i < statisticsCache.Size(); i++ ) {
-			if( split( *statisticsCache[i], level ) ) {
+		// Find the best splits according to the statistics just gathered
+		// The nodes are processed in parallel if there are enough of them, otherwise the features of each node are
+		const int nodeCount = statisticsCache.Size();
+		const bool isNodeParallel = nodeCount >= params.ThreadCount;
+		const int curThreadCount = isNodeParallel && IsOmpRelevant( nodeCount ) ? params.ThreadCount : 1;
+		CPointerArray<CSplit> splits;
+		splits.SetBufferSize( nodeCount );
+		for( int i = 0; i < nodeCount; i++ ) {
+			splits.Add( FINE_DEBUG_NEW CSplit() );
+		}
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int i = 0; i < nodeCount; i++ ) {
+			findSplit( *statisticsCache[i], level, isNodeParallel ? 1 : params.ThreadCount, *splits[i] );
+		}
+
+		// Split the nodes in the same order as in one thread, because the number of nodes is limited
+		for( int i = 0; i < nodeCount; i++ ) {
+			if( split( *statisticsCache[i], *splits[i], level ) ) {
 				result = true;
 			}
 		}
@@ -177,15 +228,18 @@ bool CDecisionTree::collectStatistics( const CFloatMatrixDesc& matrix, int level
 {
 	NeoAssert( level > 0 );
 	NeoAssert( root != 0 );
-	CMap<CDecisionTreeNodeBase*, int> nodesStatistics;
 
-	bool result = true;
 	const int matrixHeight = matrix.Height;
 
+	// Find the leaf node for each vector in the current tree
+	// Only the vectors that get into the unprocessed nodes of this level are needed
+	CArray<CDecisionTreeNodeBase*> leaves;
+	leaves.Add( nullptr, matrixHeight );
+	const int leafThreadCount = IsOmpRelevant( matrixHeight ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( leafThreadCount )
 	for( int i = 0; i < matrixHeight; i++ ) {
 		CFloatVectorDesc vector;
 		matrix.GetRow( i, vector );
-		// Find the leaf node for this vector in the current tree
 		CPtr<CDecisionTreeNodeBase> leaf;
 		int leafLevel = 0;
 		if( i < MaxClassifyNodesCacheSize ) {
@@ -197,13 +251,23 @@ bool CDecisionTree::collectStatistics( const CFloatMatrixDesc& matrix, int level
 			root->GetClassifyNode( vector, leaf, leafLevel );
 		}
 
-		if( leafLevel != level || leaf->GetType() != DTNT_Undefined ) {
+		if( leafLevel == level && leaf->GetType() == DTNT_Undefined ) {
+			leaves[i] = leaf;
+		}
+	}
+
+	// Create the statistics in the order of the vectors, as the features for them are selected randomly
+	CMap<CDecisionTreeNodeBase*, int> nodesStatistics;
+	CArray<int> vectorStatistics;
+	vectorStatistics.Add( NotFound, matrixHeight );
+	bool result = true;
+	for( int i = 0; i < matrixHeight; i++ ) {
+		if( leaves[i] == nullptr ) {
 			// This node belongs to another level or was already processed on the current level
 			continue;
 		}
 
-		TMapPosition pos = nodesStatistics.GetFirstPosition( leaf );
-		int nodeStatisticIndex = NotFound;
+		TMapPosition pos = nodesStatistics.GetFirstPosition( leaves[i] );
 		if( pos == NotFound ) {
 			const int curStatisticsCashSize = nodesStatistics.Size();
 			// No statistics object for this node, create one
@@ -212,30 +276,73 @@ bool CDecisionTree::collectStatistics( const CFloatMatrixDesc& matrix, int level
 				result = false;
 				continue;
 			}
-			nodeStatisticIndex = curStatisticsCashSize;
-			statisticsCache.Add( createStatistic( leaf ) );
-			nodesStatistics.Add( leaf, nodeStatisticIndex );
+			vectorStatistics[i] = curStatisticsCashSize;
+			statisticsCache.Add( createStatistic( leaves[i] ) );
+			nodesStatistics.Add( leaves[i], curStatisticsCashSize );
 		} else {
-			nodeStatisticIndex = nodesStatistics.GetValue( pos );
+			vectorStatistics[i] = nodesStatistics.GetValue( pos );
 		}
+	}
 
-		statisticsCache[nodeStatisticIndex]->AddVector( i, vector );
+	// The nodes are independent, so each thread adds the vectors to its own nodes
+	const int statisticsCount = statisticsCache.Size();
+	const int addThreadCount = IsOmpRelevant( statisticsCount, matrixHeight ) ? min( params.ThreadCount, statisticsCount ) : 1;
+	NEOML_OMP_NUM_THREADS( addThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( statisticsCount, index, count ) ) {
+			CFloatVectorDesc vector;
+			for( int i = 0; i < matrixHeight; i++ ) {
+				const int statisticIndex = vectorStatistics[i];
+				if( index <= statisticIndex && statisticIndex < index + count ) {
+					matrix.GetRow( i, vector );
+					statisticsCache[statisticIndex]->AddVector( i, vector );
+				}
+			}
+		}
 	}
 
-	for( int i = 0; i < statisticsCache.Size(); i++ ) {
-		statisticsCache[i]->Finish();
+	// The nodes are processed in parallel if there are enough of them, otherwise the features of each node are
+	const bool isNodeParallel = statisticsCount >= params.ThreadCount;
+	const int finishThreadCount = isNodeParallel && IsOmpRelevant( statisticsCount ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( finishThreadCount )
+	for( int i = 0; i < statisticsCount; i++ ) {
+		statisticsCache[i]->Finish( isNodeParallel ? 1 : params.ThreadCount );
 	}
 
 	return result;
 }
 
-// Splits the specified node according to the accumulated statistics
+// Finds the best split of the specified node according to the accumulated statistics
+// The features are checked in threadCount threads
+void CDecisionTree::findSplit( const CDecisionTreeNodeStatisticBase& nodeStatistics, int level, int threadCount,
+	CSplit& nodeSplit ) const
+{
+	nodeSplit.MaxProbability = nodeStatistics.GetPredictions( nodeSplit.Predictions );
+	// Create a constant node for too similar or too small sets
+	nodeSplit.IsConst = ( nodeSplit.Predictions.Size() > 1 && nodeSplit.MaxProbability >= params.ConstNodeThreshold )
+		|| nodeStatistics.GetVectorsCount() < params.MinSplitSize;
+	nodeSplit.FeatureIndex = NotFound;
+	if( nodeSplit.IsConst || level >= params.MaxTreeDepth ) {
+		return;
+	}
+
+	CParams splitParams = params;
+	splitParams.ThreadCount = threadCount;
+	if( !nodeStatistics.GetSplit( splitParams, nodeSplit.IsDiscrete, nodeSplit.FeatureIndex, nodeSplit.Values,
+		nodeSplit.CriterionValue ) )
+	{
+		nodeSplit.FeatureIndex = NotFound;
+	}
+}
+
+// Splits the specified node according to the best split found
 // Returns true if new nodes were created when splitting
-bool CDecisionTree::split( const CDecisionTreeNodeStatisticBase& nodeStatistics, int level ) const
+bool CDecisionTree::split( const CDecisionTreeNodeStatisticBase& nodeStatistics, CSplit& nodeSplit, int level ) const
 {
 	CDecisionTreeNodeBase& node = nodeStatistics.GetNode();
-	CArray<double> predictions;
-	const double maxProbability = nodeStatistics.GetPredictions( predictions );
+	CArray<double>& predictions = nodeSplit.Predictions;
 
 	if( logStream != 0 ) {
 		*logStream << "\nSplit node contains " << nodeStatistics.GetVectorsCount() << " vectors.\n";
@@ -245,9 +352,7 @@ bool CDecisionTree::split( const CDecisionTreeNodeStatisticBase& nodeStatistics,
 	}
 
 	// Create a constant node for too similar or too small sets
-	if( ( predictions.Size() > 1 && maxProbability >= params.ConstNodeThreshold )
-		|| nodeStatistics.GetVectorsCount() < params.MinSplitSize )
-	{
+	if( nodeSplit.IsConst ) {
 		if( logStream != 0 ) {
 			*logStream << "Split result: created const node.\n";
 		}
@@ -258,37 +363,33 @@ bool CDecisionTree::split( const CDecisionTreeNodeStatisticBase& nodeStatistics,
 		return false;
 	}
 
-	bool isBestFeatureDiscrete = false;
-	int bestFeature = NotFound;
-	CArray<double> bestSplitValues;
-	double bestCriterionValue = DBL_MAX;
-
-	if( nodeStatistics.GetSplit( params, isBestFeatureDiscrete, bestFeature, bestSplitValues, bestCriterionValue )
+	CArray<double>& bestSplitValues = nodeSplit.Values;
+	if( nodeSplit.FeatureIndex != NotFound
 		&& nodesCount + bestSplitValues.Size() <= params.MaxNodesCount
 		&& level < params.MaxTreeDepth )
 	{
 		// The new node is NOT a leaf
 
 		if( logStream != 0 ) {
-			*logStream << "Split result: splited by feature: " << bestFeature << " value = " << bestCriterionValue << "\n";
+			*logStream << "Split result: splited by feature: " << nodeSplit.FeatureIndex << " value = " << nodeSplit.CriterionValue << "\n";
 		}
 
 		nodesCount += bestSplitValues.Size();
 
-		if( isBestFeatureDiscrete ) {
+		if( nodeSplit.IsDiscrete ) {
 			CDecisionTreeDiscreteNodeInfo* info = FINE_DEBUG_NEW CDecisionTreeDiscreteNodeInfo();
 			node.SetInfo( info );
-			info->FeatureIndex = bestFeature;
+			info->FeatureIndex = nodeSplit.FeatureIndex;
 			bestSplitValues.MoveTo( info->Values );
 			predictions.MoveTo( info->Predictions );
-			info->Children.SetBufferSize( bestSplitValues.Size() );
+			info->Children.SetBufferSize( info->Values.Size() );
 			for( int i = 0; i < info->Values.Size(); i++ ) {
 				info->Children.Add( createNode() );
 			}
 		} else {
 			CDecisionTreeContinuousNodeInfo* info = FINE_DEBUG_NEW CDecisionTreeContinuousNodeInfo();
 			node.SetInfo( info );
-			info->FeatureIndex = bestFeature;
+			info->FeatureIndex = nodeSplit.FeatureIndex;
 			info->Threshold = bestSplitValues.First();
 			info->Child1 = createNode();
 			info->Child2 = createNode();
@@ -0,0 +1,491 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <DecisionTreeFastHistBuilder.h>
+#include <DecisionTreeClassificationModel.h>
+#include <GradientBoostFastHistProblem.h>
+#include <ProblemWrappers.h>
+#include <NeoMathEngine/OpenMP.h>
+#include <float.h>
+
+namespace NeoML {
+
+CDecisionTreeFastHistBuilder::CDecisionTreeFastHistBuilder( const CDecisionTree::CParams& _params, CRandom& _random,
+		CTextStream* _logStream ) :
+	params( _params ),
+	random( _random ),
+	logStream( _logStream ),
+	classCount( 0 ),
+	histSize( NotFound )
+{
+	NeoAssert( params.MaxBins > 1 );
+}
+
+CPtr<CDecisionTreeNodeBase> CDecisionTreeFastHistBuilder::Build( const IProblem& problem )
+{
+	if( logStream != 0 ) {
+		*logStream << "\nDecision tree histogram training started:\n";
+	}
+
+	const int vectorCount = problem.GetVectorCount();
+	const int featureCount = problem.GetFeatureCount();
+	classCount = problem.GetClassCount();
+
+	// Quantize all features of all vectors
+	CArray<int> usedVectors;
+	usedVectors.SetBufferSize( vectorCount );
+	classes.SetBufferSize( vectorCount );
+	weights.SetBufferSize( vectorCount );
+	for( int i = 0; i < vectorCount; i++ ) {
+		usedVectors.Add( i );
+		classes.Add( problem.GetClass( i ) );
+		weights.Add( problem.GetVectorWeight( i ) );
+	}
+	CArray<int> usedFeatures;
+	usedFeatures.SetBufferSize( featureCount );
+	for( int i = 0; i < featureCount; i++ ) {
+		usedFeatures.Add( i );
+	}
+	CPtr<CMultivariateRegressionOverClassification> regressionProblem =
+		FINE_DEBUG_NEW CMultivariateRegressionOverClassification( &problem );
+	CPtr<CGradientBoostFastHistProblem> histProblem = FINE_DEBUG_NEW CGradientBoostFastHistProblem( params.ThreadCount,
+		params.MaxBins, *regressionProblem, usedVectors, usedFeatures );
+	histSize = histProblem->GetFeaturePos().Last();
+
+	// Initialization
+	usedVectors.CopyTo( vectorSet );
+	histWeights.Empty();
+	histCounts.Empty();
+	freeHists.Empty();
+
+	// Creating the tree root
+	nodes.DeleteAll();
+	nodes.Add( FINE_DEBUG_NEW CNode( 0, 0, vectorCount, classCount ) );
+	nodes[0]->Node = FINE_DEBUG_NEW CDecisionTreeClassificationModel();
+	nodes[0]->HistPtr = allocHist();
+	buildHist( *histProblem, *nodes[0] );
+
+	// Building the tree using depth-first search, which needs less memory for histograms
+	nodeStack.Empty();
+	nodeStack.Add( 0 );
+
+	const CArray<int>& featureIndexes = histProblem->GetFeatureIndexes();
+	const CArray<float>& cuts = histProblem->GetFeatureCuts();
+	CArray<int> features;
+	while( !nodeStack.IsEmpty() ) {
+		const int node = nodeStack.Last();
+		nodeStack.DeleteLast();
+
+		CArray<double> predictions;
+		const double maxProbability = getPredictions( *nodes[node], predictions );
+		if( logStream != 0 ) {
+			*logStream << "\nSplit node contains " << nodes[node]->VectorSetSize << " vectors.\n";
+			for( int i = 0; i < predictions.Size(); i++ ) {
+				*logStream << "Class " << i << ": prediction = " << predictions[i] << " \n";
+			}
+		}
+
+		// Create a constant node for too similar or too small sets
+		int splitId = NotFound;
+		if( ( predictions.Size() <= 1 || maxProbability < params.ConstNodeThreshold )
+			&& nodes[node]->VectorSetSize >= params.MinSplitSize
+			&& nodes[node]->Level < params.MaxTreeDepth
+			&& nodes.Size() + 2 <= params.MaxNodesCount )
+		{
+			generateUsedFeatures( featureCount, features );
+			splitId = evaluateSplit( *histProblem, *nodes[node], features );
+		}
+
+		if( splitId == NotFound ) {
+			if( logStream != 0 ) {
+				*logStream << "Split result: created const node.\n";
+			}
+			CDecisionTreeConstNodeInfo* info = FINE_DEBUG_NEW CDecisionTreeConstNodeInfo();
+			predictions.MoveTo( info->Predictions );
+			nodes[node]->Node->SetInfo( info );
+			freeHist( nodes[node]->HistPtr );
+			nodes[node]->HistPtr = NotFound;
+			continue;
+		}
+
+		if( logStream != 0 ) {
+			*logStream << "Split result: splited by feature: " << featureIndexes[splitId]
+				<< " threshold = " << cuts[splitId] << "\n";
+		}
+
+		int leftNode = NotFound;
+		int rightNode = NotFound;
+		applySplit( *histProblem, node, splitId, leftNode, rightNode );
+
+		CDecisionTreeContinuousNodeInfo* info = FINE_DEBUG_NEW CDecisionTreeContinuousNodeInfo();
+		info->FeatureIndex = featureIndexes[splitId];
+		info->Threshold = cuts[splitId];
+		info->Child1 = nodes[leftNode]->Node;
+		info->Child2 = nodes[rightNode]->Node;
+		nodes[node]->Node->SetInfo( info );
+
+		nodeStack.Add( rightNode );
+		nodeStack.Add( leftNode );
+
+		// Building the smaller histogram and generating the other one by subtraction
+		const int smallNode = nodes[leftNode]->VectorSetSize < nodes[rightNode]->VectorSetSize ? leftNode : rightNode;
+		const int largeNode = smallNode == leftNode ? rightNode : leftNode;
+		nodes[smallNode]->HistPtr = allocHist();
+		buildHist( *histProblem, *nodes[smallNode] );
+		subHist( nodes[node]->HistPtr, nodes[smallNode]->HistPtr );
+		nodes[largeNode]->HistPtr = nodes[node]->HistPtr;
+		nodes[node]->HistPtr = NotFound;
+		const CArray<int>& smallCounts = nodes[smallNode]->Statistics.Counts();
+		const CArray<double>& smallWeights = nodes[smallNode]->Statistics.Weights();
+		for( int i = 0; i < classCount; i++ ) {
+			nodes[largeNode]->Statistics.AddVectorSet( nodes[node]->Statistics.Counts()[i], i,
+				nodes[node]->Statistics.Weights()[i] );
+			nodes[largeNode]->Statistics.SubVectorSet( smallCounts[i], i, smallWeights[i] );
+		}
+	}
+
+	if( logStream != 0 ) {
+		*logStream << "\nDecision tree histogram training finished\n";
+	}
+
+	CPtr<CDecisionTreeNodeBase> root = nodes[0]->Node;
+	nodes.DeleteAll();
+	vectorSet.FreeBuffer();
+	classes.FreeBuffer();
+	weights.FreeBuffer();
+	histWeights.FreeBuffer();
+	histCounts.FreeBuffer();
+	tempHistWeights.FreeBuffer();
+	tempHistCounts.FreeBuffer();
+	return root;
+}
+
+// Gets a free histogram
+// A histogram is identified by the pointer to its start in the histogram arrays
+int CDecisionTreeFastHistBuilder::allocHist()
+{
+	if( freeHists.IsEmpty() ) {
+		// The depth-first search needs no more histograms than the tree depth, so they are allocated on demand
+		const int result = histWeights.Size();
+		histWeights.Add( 0.0, histSize * classCount );
+		histCounts.Add( 0, histSize * classCount );
+		return result;
+	}
+
+	const int result = freeHists.Last();
+	freeHists.DeleteLast();
+	return result;
+}
+
+// Frees the unnecessary histogram
+void CDecisionTreeFastHistBuilder::freeHist( int ptr )
+{
+	if( ptr != NotFound ) {
+		freeHists.Add( ptr );
+	}
+}
+
+// Subtracts the second histogram from the first one
+void CDecisionTreeFastHistBuilder::subHist( int firstPtr, int secondPtr )
+{
+	const int size = histSize * classCount;
+	double* firstWeights = histWeights.GetPtr() + firstPtr;
+	const double* secondWeights = histWeights.GetPtr() + secondPtr;
+	int* firstCounts = histCounts.GetPtr() + firstPtr;
+	const int* secondCounts = histCounts.GetPtr() + secondPtr;
+	for( int i = 0; i < size; i++ ) {
+		firstWeights[i] -= secondWeights[i];
+		firstCounts[i] -= secondCounts[i];
+	}
+}
+
+// Builds the histogram on the vectors of the given node and calculates the node total statistics
+void CDecisionTreeFastHistBuilder::buildHist( const CGradientBoostFastHistProblem& problem, CNode& node )
+{
+	const int size = histSize * classCount;
+	double* nodeWeights = histWeights.GetPtr() + node.HistPtr;
+	int* nodeCounts = histCounts.GetPtr() + node.HistPtr;
+	for( int i = 0; i < size; i++ ) {
+		nodeWeights[i] = 0;
+		nodeCounts[i] = 0;
+	}
+	node.Statistics.Erase();
+
+	const int threadCount = IsOmpRelevant( node.VectorSetSize, static_cast<int64_t>( node.VectorSetSize ) * size ) ?
+		params.ThreadCount : 1;
+	if( threadCount > 1 ) {
+		// There are many vectors in the set, so each thread builds its own histogram and then they are merged
+		tempHistWeights.DeleteAll();
+		tempHistWeights.Add( 0.0, threadCount * size );
+		tempHistCounts.DeleteAll();
+		tempHistCounts.Add( 0, threadCount * size );
+
+		NEOML_OMP_NUM_THREADS( threadCount )
+		{
+			int index = 0;
+			int count = 0;
+			if( OmpGetTaskIndexAndCount( node.VectorSetSize, index, count ) ) {
+				const int threadNumber = OmpGetThreadNum();
+				double* threadWeights = tempHistWeights.GetPtr() + threadNumber * size;
+				int* threadCounts = tempHistCounts.GetPtr() + threadNumber * size;
+				for( int i = index; i < index + count; i++ ) {
+					const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+					const int* vectorData = problem.GetUsedVectorDataPtr( vectorIndex );
+					const int vectorDataSize = problem.GetUsedVectorDataSize( vectorIndex );
+					for( int j = 0; j < vectorDataSize; j++ ) {
+						const int pos = vectorData[j] * classCount + classes[vectorIndex];
+						threadWeights[pos] += weights[vectorIndex];
+						threadCounts[pos]++;
+					}
+				}
+			}
+		}
+
+		NEOML_OMP_FOR_NUM_THREADS( threadCount )
+		for( int i = 0; i < size; i++ ) {
+			for( int j = 0; j < threadCount; j++ ) {
+				nodeWeights[i] += tempHistWeights[j * size + i];
+				nodeCounts[i] += tempHistCounts[j * size + i];
+			}
+		}
+	} else {
+		for( int i = 0; i < node.VectorSetSize; i++ ) {
+			const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+			const int* vectorData = problem.GetUsedVectorDataPtr( vectorIndex );
+			const int vectorDataSize = problem.GetUsedVectorDataSize( vectorIndex );
+			for( int j = 0; j < vectorDataSize; j++ ) {
+				const int pos = vectorData[j] * classCount + classes[vectorIndex];
+				nodeWeights[pos] += weights[vectorIndex];
+				nodeCounts[pos]++;
+			}
+		}
+	}
+
+	for( int i = 0; i < node.VectorSetSize; i++ ) {
+		const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+		node.Statistics.AddVectorSet( 1, classes[vectorIndex], weights[vectorIndex] );
+	}
+
+	// Adding zero values, which are not present in the vector data
+	const CArray<int>& featurePos = problem.GetFeaturePos();
+	const CArray<int>& featureNullValueId = problem.GetFeatureNullValueId();
+	const CArray<double>& totalWeights = node.Statistics.Weights();
+	const CArray<int>& totalCounts = node.Statistics.Counts();
+	const int featureCount = problem.GetFeatureCount();
+	const int nullThreadCount = IsOmpRelevant( featureCount, static_cast<int64_t>( size ) ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( nullThreadCount )
+	for( int i = 0; i < featureCount; i++ ) {
+		const int nullPos = featureNullValueId[i] * classCount;
+		for( int c = 0; c < classCount; c++ ) {
+			double nullWeight = totalWeights[c];
+			int nullCount = totalCounts[c];
+			for( int j = featurePos[i]; j < featurePos[i + 1]; j++ ) {
+				nullWeight -= nodeWeights[j * classCount + c];
+				nullCount -= nodeCounts[j * classCount + c];
+			}
+			nodeWeights[nullPos + c] += nullWeight;
+			nodeCounts[nullPos + c] += nullCount;
+		}
+	}
+}
+
+// Finds the best bin to split the node after (the vectors in this and previous bins of the feature go to the left)
+// Returns NotFound if splitting is impossible
+int CDecisionTreeFastHistBuilder::evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node,
+	const CArray<int>& features ) const
+{
+	const CArray<int>& featurePos = problem.GetFeaturePos();
+	const double* nodeWeights = histWeights.GetPtr() + node.HistPtr;
+	const int* nodeCounts = histCounts.GetPtr() + node.HistPtr;
+	const CVectorSetClassificationStatistic& total = node.Statistics;
+	// The split is successful only if it gives a smaller criterion value than the whole set
+	const double criterionValue = total.CalcCriterion( params.SplitCriterion );
+
+	// Each thread looks for the best split among its features
+	const int featureCount = features.Size();
+	const int curThreadCount = IsOmpRelevant( featureCount, static_cast<int64_t>( histSize ) * classCount ) ?
+		params.ThreadCount : 1;
+	CArray<double> threadBestCriterionValues;
+	threadBestCriterionValues.Add( criterionValue, curThreadCount );
+	CArray<int> threadBestSplitIds;
+	threadBestSplitIds.Add( NotFound, curThreadCount );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( featureCount, index, count ) ) {
+			const int threadNumber = OmpGetThreadNum();
+			CVectorSetClassificationStatistic first( classCount );
+			for( int i = index; i < index + count; i++ ) {
+				first.Erase();
+				CVectorSetClassificationStatistic second( total );
+				// The last bin cannot be split after
+				const int lastId = featurePos[features[i] + 1] - 1;
+				for( int j = featurePos[features[i]]; j < lastId; j++ ) {
+					bool isEmpty = true;
+					for( int c = 0; c < classCount; c++ ) {
+						const int binCount = nodeCounts[j * classCount + c];
+						if( binCount != 0 ) {
+							first.AddVectorSet( binCount, c, nodeWeights[j * classCount + c] );
+							second.SubVectorSet( binCount, c, nodeWeights[j * classCount + c] );
+							isEmpty = false;
+						}
+					}
+					if( isEmpty ) {
+						// The same split as after the previous bin
+						continue;
+					}
+					if( first.TotalCount() < params.MinContinuousSubsetSize
+						|| first.TotalWeight() < total.TotalWeight() * params.MinContinuousSubsetPart )
+					{
+						continue;
+					}
+					if( second.TotalCount() < params.MinContinuousSubsetSize
+						|| second.TotalWeight() < total.TotalWeight() * params.MinContinuousSubsetPart )
+					{
+						break; // it can only decrease from here
+					}
+
+					const double value = ( first.CalcCriterion( params.SplitCriterion ) * first.TotalWeight()
+						+ second.CalcCriterion( params.SplitCriterion ) * second.TotalWeight() ) / total.TotalWeight();
+					if( threadBestCriterionValues[threadNumber] > value ) {
+						threadBestCriterionValues[threadNumber] = value;
+						threadBestSplitIds[threadNumber] = j;
+					}
+				}
+			}
+		}
+	}
+
+	// The threads process the features in ascending order so the result is the same as in one thread
+	double bestValue = criterionValue;
+	int result = NotFound;
+	for( int i = 0; i < curThreadCount; i++ ) {
+		if( threadBestSplitIds[i] != NotFound && bestValue > threadBestCriterionValues[i] ) {
+			bestValue = threadBestCriterionValues[i];
+			result = threadBestSplitIds[i];
+		}
+	}
+	return result;
+}
+
+// Splits the node vector set into two child nodes
+void CDecisionTreeFastHistBuilder::applySplit( const CGradientBoostFastHistProblem& problem, int node, int splitId,
+	int& leftNode, int& rightNode )
+{
+	NeoAssert( node >= 0 );
+
+	const CArray<int>& featureIndexes = problem.GetFeatureIndexes();
+	const CArray<int>& featureNullValueId = problem.GetFeatureNullValueId();
+
+	const int vectorPtr = nodes[node]->VectorSetPtr;
+	const int vectorCount = nodes[node]->VectorSetSize;
+	const int featureIndex = featureIndexes[splitId];
+	const int nextId = problem.GetFeaturePos()[featureIndex + 1] - 1;
+
+	// Determining to which subtree each vector belongs
+	const int curThreadCount = IsOmpRelevant( vectorCount ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int i = 0; i < vectorCount; i++ ) {
+		const int* vectorDataPtr = problem.GetUsedVectorDataPtr( vectorSet[vectorPtr + i] );
+		const int vectorDataSize = problem.GetUsedVectorDataSize( vectorSet[vectorPtr + i] );
+
+		const int pos = FindInsertionPoint<int, Ascending<int>, int>( nextId, vectorDataPtr, vectorDataSize );
+		int vectorFeatureId = NotFound; // the bin of the split feature value for this vector
+		if( pos == 0 || ( featureIndexes[vectorDataPtr[pos - 1]] != featureIndex ) ) {
+			// The vector contains no value of the split feature, therefore this value is 0
+			vectorFeatureId = featureNullValueId[featureIndex];
+		} else {
+			vectorFeatureId = vectorDataPtr[pos - 1];
+		}
+
+		if( vectorFeatureId <= splitId ) { // the value is smaller for the smaller bin
+			// The vector belongs to the left subtree
+			vectorSet[vectorPtr + i] = -( vectorSet[vectorPtr + i] + 1 );
+		} // To the right subtree otherwise (no action needed)
+	}
+
+	// Reordering the vectors of the node
+	int leftIndex = 0;
+	int rightIndex = vectorCount - 1;
+	while( leftIndex <= rightIndex ) {
+		if( vectorSet[vectorPtr + leftIndex] < 0 ) {
+			vectorSet[vectorPtr + leftIndex] = -vectorSet[vectorPtr + leftIndex] - 1;
+			leftIndex++;
+			continue;
+		}
+		if( vectorSet[vectorPtr + rightIndex] >= 0 ) {
+			rightIndex--;
+			continue;
+		}
+		FObj::swap( vectorSet[vectorPtr + leftIndex], vectorSet[vectorPtr + rightIndex] );
+	}
+
+	NeoAssert( leftIndex > 0 );
+	NeoAssert( vectorCount - leftIndex > 0 );
+
+	// Creating the child nodes
+	const int level = nodes[node]->Level + 1;
+	nodes.Add( FINE_DEBUG_NEW CNode( level, vectorPtr, leftIndex, classCount ) );
+	leftNode = nodes.Size() - 1;
+	nodes[leftNode]->Node = FINE_DEBUG_NEW CDecisionTreeClassificationModel();
+
+	nodes.Add( FINE_DEBUG_NEW CNode( level, vectorPtr + leftIndex, vectorCount - leftIndex, classCount ) );
+	rightNode = nodes.Size() - 1;
+	nodes[rightNode]->Node = FINE_DEBUG_NEW CDecisionTreeClassificationModel();
+}
+
+// Generates the array of features used for a node
+void CDecisionTreeFastHistBuilder::generateUsedFeatures( int featureCount, CArray<int>& features ) const
+{
+	features.Empty();
+	features.SetBufferSize( featureCount );
+	for( int i = 0; i < featureCount; i++ ) {
+		features.Add( i );
+	}
+
+	if( params.RandomSelectedFeaturesCount != NotFound ) {
+		NeoAssert( 0 < params.RandomSelectedFeaturesCount );
+		NeoAssert( params.RandomSelectedFeaturesCount < featureCount );
+		for( int i = 0; i < params.RandomSelectedFeaturesCount; i++ ) {
+			// Pick a random number from [i, featureCount - 1] range
+			const int index = random.UniformInt( i, featureCount - 1 );
+			swap( features[i], features[index] );
+		}
+		features.SetSize( params.RandomSelectedFeaturesCount );
+	}
+}
+
+// Calculates the class probabilities in the node; returns the maximum one
+double CDecisionTreeFastHistBuilder::getPredictions( const CNode& node, CArray<double>& predictions ) const
+{
+	const CArray<double>& classWeights = node.Statistics.Weights();
+	predictions.SetBufferSize( classWeights.Size() );
+	double maxProbability = 0;
+	for( int i = 0; i < classWeights.Size(); i++ ) {
+		const double probability = classWeights[i] / node.Statistics.TotalWeight();
+		predictions.Add( probability );
+		if( probability > maxProbability ) {
+			maxProbability = probability;
+		}
+	}
+	return maxProbability;
+}
+
+} // namespace NeoML
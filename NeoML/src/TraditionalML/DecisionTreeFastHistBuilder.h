@@ -0,0 +1,78 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/TraditionalML/DecisionTree.h>
+#include <DecisionTreeNodeClassificationStatistic.h>
+
+namespace NeoML {
+
+class CGradientBoostFastHistProblem;
+
+// Builds a decision tree over the quantized feature values (see CDecisionTree::CParams::MaxBins)
+// The feature values are replaced by the numbers of their histogram bins, as in the gradient boosting FastHist mode
+// The split search only accumulates the class statistics of the bins;
+// the histogram of the larger child is obtained by subtracting the smaller child's one from the parent's
+class CDecisionTreeFastHistBuilder {
+public:
+	CDecisionTreeFastHistBuilder( const CDecisionTree::CParams& params, CRandom& random, CTextStream* logStream );
+
+	// Builds the tree
+	CPtr<CDecisionTreeNodeBase> Build( const IProblem& problem );
+
+private:
+	// A node of the tree being built
+	struct CNode {
+		int Level; // the node level
+		int VectorSetPtr; // the pointer to the start of the node vector set in the vectorSet array
+		int VectorSetSize; // the number of vectors in the node vector set
+		int HistPtr; // the pointer to the node histogram in the histogram arrays
+		CVectorSetClassificationStatistic Statistics; // the total statistics of the node vectors
+		CPtr<CDecisionTreeNodeBase> Node; // the tree node
+
+		CNode( int level, int vectorSetPtr, int vectorSetSize, int classCount ) :
+			Level( level ), VectorSetPtr( vectorSetPtr ), VectorSetSize( vectorSetSize ), HistPtr( NotFound ),
+			Statistics( classCount ) {}
+	};
+
+	const CDecisionTree::CParams params; // the classification parameters
+	CRandom& random; // the random numbers generator
+	CTextStream* const logStream; // the logging stream
+	int classCount; // the number of classes
+	int histSize; // the number of bins in a histogram
+	CPointerArray<CNode> nodes; // the tree nodes
+	CArray<int> nodeStack; // the stack of the nodes to be processed
+	CArray<int> vectorSet; // the vector sets of the nodes
+	CArray<int> classes; // the classes of the vectors
+	CArray<double> weights; // the weights of the vectors
+	// The histograms: the bins of all features one after another, the class statistics for each bin
+	CArray<double> histWeights; // the vector weights
+	CArray<int> histCounts; // the number of vectors
+	CArray<int> freeHists; // the free histograms
+	CArray<double> tempHistWeights; // the per-thread histograms
+	CArray<int> tempHistCounts;
+
+	int allocHist();
+	void freeHist( int ptr );
+	void subHist( int firstPtr, int secondPtr );
+	void buildHist( const CGradientBoostFastHistProblem& problem, CNode& node );
+	int evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node, const CArray<int>& features ) const;
+	void applySplit( const CGradientBoostFastHistProblem& problem, int node, int splitId, int& leftNode, int& rightNode );
+	void generateUsedFeatures( int featureCount, CArray<int>& features ) const;
+	double getPredictions( const CNode& node, CArray<double>& predictions ) const;
+};
+
+} // namespace NeoML
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <DecisionTreeNodeClassificationStatistic.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -59,13 +60,18 @@ void CClassificationStatistics::AddVector( int index, const CFloatVectorDesc& ve
 	totalStatistics.AddVectorSet( 1, classIndex, weight );
 }
 
-void CClassificationStatistics::Finish()
+void CClassificationStatistics::Finish( int threadCount )
 {
 	// We need also to add zero values for the features
 	const CArray<double>& totalWeights = totalStatistics.Weights();
 	const CArray<int>& totalCounts = totalStatistics.Counts();
 
-	for( int i = 0; i < usedFeatures.Size(); i++ ) {
+	// Each feature has its own intervals so the features may be processed independently
+	const int featureCount = usedFeatures.Size();
+	const int curThreadCount = IsOmpRelevant( featureCount, static_cast<int64_t>( featureCount ) * GetVectorsCount() )
+		? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int i = 0; i < featureCount; i++ ) {
 		const CArray<double>& weights = featureStatistics[i].Weights();
 		const CArray<int>& counts = featureStatistics[i].Counts();
 
@@ -101,21 +107,47 @@ bool CClassificationStatistics::GetSplit( CDecisionTree::CParams param,
 	criterionValue = totalStatistics.CalcCriterion( param.SplitCriterion );
 	featureIndex = NotFound;
 
-	CArray<double> splitValues;
-	for( int i = 0; i < discretizationIntervals.Size(); i++ ) {
-		double splitCriterionValue = 0;
-		const bool isDiscreteFeature = problem->IsDiscreteFeature( usedFeatures[i] );
-		if( isDiscreteFeature ) { 
-			splitCriterionValue = calcDiscreteSplitCriterion( param, discretizationIntervals[i], totalStatistics, splitValues );
-		} else {
-			splitCriterionValue = calcContinuousSplitCriterion( param, discretizationIntervals[i], totalStatistics, splitValues );
+	// Each thread looks for the best split among its features
+	const int featureCount = discretizationIntervals.Size();
+	const int curThreadCount = IsOmpRelevant( featureCount ) ? param.ThreadCount : 1;
+	CArray<int> threadBestFeatures;
+	threadBestFeatures.Add( NotFound, curThreadCount );
+	CArray<double> threadBestCriterionValues;
+	threadBestCriterionValues.Add( criterionValue, curThreadCount );
+	CArray<CArray<double>> threadBestSplitValues;
+	threadBestSplitValues.SetSize( curThreadCount );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( featureCount, index, count ) ) {
+			const int threadNumber = OmpGetThreadNum();
+			CArray<double> splitValues;
+			for( int i = index; i < index + count; i++ ) {
+				double splitCriterionValue = 0;
+				if( problem->IsDiscreteFeature( usedFeatures[i] ) ) {
+					splitCriterionValue = calcDiscreteSplitCriterion( param, discretizationIntervals[i], totalStatistics, splitValues );
+				} else {
+					splitCriterionValue = calcContinuousSplitCriterion( param, discretizationIntervals[i], totalStatistics, splitValues );
+				}
+
+				if( threadBestCriterionValues[threadNumber] > splitCriterionValue ) { // the split with a better criterion value is found
+					threadBestCriterionValues[threadNumber] = splitCriterionValue;
+					threadBestFeatures[threadNumber] = i;
+					splitValues.CopyTo( threadBestSplitValues[threadNumber] );
+				}
+			}
 		}
+	}
 
-		if( criterionValue > splitCriterionValue ) { // the split with a better criterion value is found
-			criterionValue = splitCriterionValue;
-			featureIndex = usedFeatures[i];
-			isDiscrete = isDiscreteFeature;
-			splitValues.CopyTo( values );
+	// The threads process the features in ascending order so the result is the same as in one thread
+	for( int i = 0; i < curThreadCount; i++ ) {
+		if( threadBestFeatures[i] != NotFound && criterionValue > threadBestCriterionValues[i] ) {
+			criterionValue = threadBestCriterionValues[i];
+			featureIndex = usedFeatures[threadBestFeatures[i]];
+			isDiscrete = problem->IsDiscreteFeature( featureIndex );
+			threadBestSplitValues[i].CopyTo( values );
 		}
 	}
 
@@ -136,7 +136,7 @@ public:
 
 	// CDecisionTreeNodeStatisticBase interface methods
 	virtual void AddVector( int index, const CFloatVectorDesc& vector );
-	virtual void Finish();
+	virtual void Finish( int threadCount );
 	virtual size_t GetSize() const;
 	virtual bool GetSplit( CDecisionTree::CParams param,
 		bool& isDiscrete, int& featureIndex, CArray<double>& values, double& criterioValue ) const;
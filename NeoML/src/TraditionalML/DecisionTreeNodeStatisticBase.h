@@ -28,7 +28,8 @@ public:
 	virtual void AddVector( int index, const CFloatVectorDesc& vector ) = 0;
 
 	// Finishes accumulating data
-	virtual void Finish() = 0;
+	// The features are processed in threadCount threads
+	virtual void Finish( int threadCount ) = 0;
 
 	// Retrieves the size of accumulated data
 	virtual size_t GetSize() const = 0;
@@ -37,6 +38,7 @@ public:
 	// Returns false if splitting is not possible
 	// featureIndex is the index of the feature by which the node will split
 	// values contains the feature values defining the split
+	// The features are checked in param.ThreadCount threads
 	virtual bool GetSplit( CDecisionTree::CParams param,
 		bool& isDiscrete, int& featureIndex, CArray<double>& values, double& criterioValue ) const = 0;
 
@@ -43,64 +43,160 @@ IRegressionTreeNode::~IRegressionTreeNode()
 {
 }
 
-// Loss function interface
-class IGradientBoostingLossFunction : public virtual IObject {
+IGradientBoostingLossFunction::~IGradientBoostingLossFunction()
+{
+}
+
+IGradientBoostProblemParts::~IGradientBoostProblemParts()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// The problem parts without the vectors with zero weight, as they are seen during training
+class CNotNullWeightsProblemParts : public IGradientBoostProblemParts {
 public:
-	// Calculates function gradient
-	virtual void CalcGradientAndHessian( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
-		CArray< CArray<double> >& gradient, CArray< CArray<double> >& hessian ) const = 0;
+	explicit CNotNullWeightsProblemParts( const IGradientBoostProblemParts* _parts ) : parts( _parts ) {}
+
+	// IGradientBoostProblemParts interface methods
+	int GetPartCount() const override { return parts->GetPartCount(); }
+	CPtr<const IMultivariateRegressionProblem> GetPart( int index ) const override
+		{ return FINE_DEBUG_NEW CMultivariateRegressionProblemNotNullWeightsView( parts->GetPart( index ) ); }
 
-	// Calculates loss
-	virtual double CalcLossMean( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers ) const = 0;
+private:
+	const CPtr<const IGradientBoostProblemParts> parts;
 };
 
 //------------------------------------------------------------------------------------------------------------
 
+// The exponent and the logarithm for the loss functions
+// They do not call the library functions and have no branches, so the loops over the predictions are vectorized
+// The relative error is within a few units of the last place
+
+static inline unsigned __int64 getDoubleBits( double value )
+{
+	unsigned __int64 bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	return bits;
+}
+
+static inline double getDoubleFromBits( unsigned __int64 bits )
+{
+	double value;
+	memcpy( &value, &bits, sizeof( value ) );
+	return value;
+}
+
+// ln2 split into the high part exactly multiplied by the small integers and the rest
+static const double Ln2High = 6.93147180369123816490e-01;
+static const double Ln2Low = 1.90821492927058770002e-10;
+// 2^52 + 2^51: adding it to a double rounds it to an integer stored in the lowest bits of the mantissa
+static const double RoundingShift = 6755399441055744.0;
+
+// Calculates exp( x ) for x <= 700; the results smaller than the smallest normal double are replaced by zero
+static inline double vectorExp( double x )
+{
+	// exp( x ) = 2^n * exp( r ), where n = round( x / ln2 ) and |r| <= ln2 / 2
+	const double shifted = x * 1.44269504088896340736 + RoundingShift;
+	const double n = shifted - RoundingShift;
+	const double r = ( x - n * Ln2High ) - n * Ln2Low;
+	// The Taylor series up to r^12 / 12!
+	double result = 1.0 / 479001600;
+	result = result * r + 1.0 / 39916800;
+	result = result * r + 1.0 / 3628800;
+	result = result * r + 1.0 / 362880;
+	result = result * r + 1.0 / 40320;
+	result = result * r + 1.0 / 5040;
+	result = result * r + 1.0 / 720;
+	result = result * r + 1.0 / 120;
+	result = result * r + 1.0 / 24;
+	result = result * r + 1.0 / 6;
+	result = result * r + 0.5;
+	result = result * r + 1.0;
+	result = result * r + 1.0;
+	// 2^n is built from the exponent bits; the negative exponent (underflow) is masked out instead of a comparison
+	// that prevents the vectorization
+	const unsigned __int64 exponent = getDoubleBits( shifted ) - getDoubleBits( RoundingShift ) + 1023;
+	const unsigned __int64 normalMask = ( exponent >> 63 ) - 1;
+	return result * getDoubleFromBits( ( exponent << 52 ) & normalMask );
+}
+
+// Calculates log( x ) for a positive normal x
+static inline double vectorLog( double x )
+{
+	// log( x ) = k * ln2 + log( z ), where z is in [sqrt( 1/2 ), sqrt( 2 ))
+	// The exponent is shifted by 1023 so that the unsigned operations could be used
+	const unsigned __int64 bits = getDoubleBits( x );
+	const unsigned __int64 shiftedBits = bits - 0x3fe6a09e667f3bcdULL + ( 1023ULL << 52 ); // 0x3fe6... is sqrt( 1/2 )
+	const unsigned __int64 biasedK = shiftedBits >> 52;
+	const double z = getDoubleFromBits( bits - ( ( biasedK - 1023 ) << 52 ) );
+	// k is converted to double by adding to 2^52
+	const double k = getDoubleFromBits( biasedK | 0x4330000000000000ULL ) - ( 4503599627370496.0 + 1023 );
+	// log( z ) = 2 * atanh( s ), where s = ( z - 1 ) / ( z + 1 ) and |s| < 0.172
+	const double s = ( z - 1.0 ) / ( z + 1.0 );
+	const double s2 = s * s;
+	double series = 1.0 / 19;
+	series = series * s2 + 1.0 / 17;
+	series = series * s2 + 1.0 / 15;
+	series = series * s2 + 1.0 / 13;
+	series = series * s2 + 1.0 / 11;
+	series = series * s2 + 1.0 / 9;
+	series = series * s2 + 1.0 / 7;
+	series = series * s2 + 1.0 / 5;
+	series = series * s2 + 1.0 / 3;
+	return k * Ln2High + ( k * Ln2Low + 2 * s + 2 * s * s2 * series );
+}
+
+// The loops below are split so that each of them is vectorized:
+// the compiler does not vectorize a loop where the result of a floating-point comparison is used in the calculations
+
+// The number of loss values calculated before adding them up; the order of the summation is kept
+static const int LossSumBufferSize = 256;
+
+//------------------------------------------------------------------------------------------------------------
+
 // Binomial loss function
 class CGradientBoostingBinomialLossFunction : public IGradientBoostingLossFunction {
 public:
 	// IGradientBoostingLossFunction interface methods
-	void CalcGradientAndHessian( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
-		CArray< CArray<double> >& gradient, CArray< CArray<double> >& hessian ) const override;
-
-	double CalcLossMean( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers ) const override;
+	void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const override;
+	double CalcLossSum( const double* predicts, const double* answers, int size ) const override;
 };
 
-void CGradientBoostingBinomialLossFunction::CalcGradientAndHessian( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers, CArray< CArray<double> >& gradients, CArray< CArray<double> >& hessians ) const
+void CGradientBoostingBinomialLossFunction::CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+	double* gradients, double* hessians ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	gradients.SetSize( predicts.Size() );
-	hessians.SetSize( predicts.Size() );
-
-	for( int i = 0; i < predicts.Size(); i++ ) {
-		gradients[i].SetSize( predicts[i].Size() );
-		hessians[i].SetSize( predicts[i].Size() );
-		for( int j = 0; j < predicts[i].Size(); j++ ) {
-			const double pred = 1.0f / ( 1.0f + exp( min( -predicts[i][j], MaxExpArgument ) ) );
-			gradients[i][j] = static_cast<double>( pred - answers[i][j] );
-			hessians[i][j] = static_cast<double>( max( pred * ( 1.0 - pred ), 1e-16 ) );
-		}
+	for( int i = 0; i < size; i++ ) {
+		gradients[i] = min( -predicts[i], MaxExpArgument );
+	}
+	for( int i = 0; i < size; i++ ) {
+		const double pred = 1.0 / ( 1.0 + vectorExp( gradients[i] ) );
+		gradients[i] = pred - answers[i];
+		hessians[i] = pred * ( 1.0 - pred );
+	}
+	for( int i = 0; i < size; i++ ) {
+		hessians[i] = max( hessians[i], 1e-16 );
 	}
 }
 
-double CGradientBoostingBinomialLossFunction::CalcLossMean( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers ) const
+double CGradientBoostingBinomialLossFunction::CalcLossSum( const double* predicts, const double* answers, int size ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	double overallSum = 0;
-	auto getMean = []( double sum, int n ) { return n != 0 ? sum / static_cast<double>( n ) : 0; };
-	for( int i = 0; i < predicts.Size(); ++i ) {
-		double sum = 0;
-		for( int j = 0; j < predicts[i].Size(); ++j ) {
-			sum += log( 1 + exp( min( -predicts[i][j], MaxExpArgument ) ) ) - predicts[i][j] * answers[i][j]; 
+	double sum = 0;
+	double losses[LossSumBufferSize];
+	for( int start = 0; start < size; start += LossSumBufferSize ) {
+		const int count = min( LossSumBufferSize, size - start );
+		for( int i = 0; i < count; i++ ) {
+			losses[i] = min( -predicts[start + i], MaxExpArgument );
+		}
+		for( int i = 0; i < count; i++ ) {
+			losses[i] = vectorLog( 1 + vectorExp( losses[i] ) ) - predicts[start + i] * answers[start + i];
+		}
+		for( int i = 0; i < count; i++ ) {
+			sum += losses[i];
 		}
-		overallSum += getMean( sum, predicts[i].Size() );
 	}
-
-	return getMean( overallSum, predicts.Size() );
+	return sum;
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -109,48 +205,42 @@ double CGradientBoostingBinomialLossFunction::CalcLossMean( const CArray< CArray
 class CGradientBoostingExponentialLossFunction : public IGradientBoostingLossFunction {
 public:
 	// IGradientBoostingLossFunction interface methods
-	void CalcGradientAndHessian( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
-		CArray< CArray<double> >& gradient, CArray< CArray<double> >& hessian ) const override;
-
-	double CalcLossMean( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers ) const override;
+	void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const override;
+	double CalcLossSum( const double* predicts, const double* answers, int size ) const override;
 };
 
-void CGradientBoostingExponentialLossFunction::CalcGradientAndHessian( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers, CArray< CArray<double> >& gradients, CArray< CArray<double> >& hessians ) const
+void CGradientBoostingExponentialLossFunction::CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+	double* gradients, double* hessians ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	gradients.SetSize( predicts.Size() );
-	hessians.SetSize( predicts.Size() );
-
-	for( int i = 0; i < predicts.Size(); i++ ) {
-		gradients[i].SetSize( predicts[i].Size() );
-		hessians[i].SetSize( predicts[i].Size() );
-		for( int j = 0; j < predicts[i].Size(); j++ ) {
-			const double temp = -( 2 * answers[i][j] - 1 );
-			const double tempExp = exp( min( temp * predicts[i][j], MaxExpArgument ) );
-			gradients[i][j] = static_cast<double>( temp * tempExp );
-			hessians[i][j] = static_cast<double>( temp * temp * tempExp );
-		}
+	for( int i = 0; i < size; i++ ) {
+		gradients[i] = min( -( 2 * answers[i] - 1 ) * predicts[i], MaxExpArgument );
+	}
+	for( int i = 0; i < size; i++ ) {
+		const double temp = -( 2 * answers[i] - 1 );
+		const double tempExp = vectorExp( gradients[i] );
+		gradients[i] = temp * tempExp;
+		hessians[i] = temp * temp * tempExp;
 	}
 }
 
-double CGradientBoostingExponentialLossFunction::CalcLossMean( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers ) const
+double CGradientBoostingExponentialLossFunction::CalcLossSum( const double* predicts, const double* answers, int size ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	double overallSum = 0;
-	auto getMean = []( double sum, int n ) { return n != 0 ? sum / static_cast<double>( n ) : 0; };
-	for( int i = 0; i < predicts.Size(); ++i ) {
-		double sum = 0;
-		for( int j = 0; j < predicts[i].Size(); ++j ) {
-			sum += exp( min( ( 1.0 - 2.0 * answers[i][j] ) * predicts[i][j], MaxExpArgument ) );
+	double sum = 0;
+	double losses[LossSumBufferSize];
+	for( int start = 0; start < size; start += LossSumBufferSize ) {
+		const int count = min( LossSumBufferSize, size - start );
+		for( int i = 0; i < count; i++ ) {
+			losses[i] = min( ( 1.0 - 2.0 * answers[start + i] ) * predicts[start + i], MaxExpArgument );
+		}
+		for( int i = 0; i < count; i++ ) {
+			losses[i] = vectorExp( losses[i] );
+		}
+		for( int i = 0; i < count; i++ ) {
+			sum += losses[i];
 		}
-		overallSum += getMean( sum, predicts[i].Size() );
 	}
-
-	return getMean( overallSum, predicts.Size() );
+	return sum;
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -159,54 +249,31 @@ double CGradientBoostingExponentialLossFunction::CalcLossMean( const CArray< CAr
 class CGradientBoostingSquaredHinge : public IGradientBoostingLossFunction {
 public:
 	// IGradientBoostingLossFunction interface methods
-	void CalcGradientAndHessian( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
-		CArray< CArray<double> >& gradient, CArray< CArray<double> >& hessian ) const override;
-
-	double CalcLossMean( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers ) const override;
+	void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const override;
+	double CalcLossSum( const double* predicts, const double* answers, int size ) const override;
 };
 
-void CGradientBoostingSquaredHinge::CalcGradientAndHessian( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers, CArray< CArray<double> >& gradients, CArray< CArray<double> >& hessians ) const
+void CGradientBoostingSquaredHinge::CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+	double* gradients, double* hessians ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	gradients.SetSize( predicts.Size() );
-	hessians.SetSize( predicts.Size() );
-
-	for( int i = 0; i < predicts.Size(); i++ ) {
-		gradients[i].SetSize( predicts[i].Size() );
-		hessians[i].SetSize( predicts[i].Size() );
-		for( int j = 0; j < predicts[i].Size(); j++ ) {
-			const double t = -( 2 * answers[i][j] - 1 );
-
-			if( t * predicts[i][j] < 1 ) {
-				gradients[i][j] = static_cast<double>( 2 * t * ( t * predicts[i][j] - 1 ) );
-				hessians[i][j] = static_cast<double>( 2 * t * t );
-			} else {
-				gradients[i][j] = 0.0;
-				hessians[i][j] = 1e-16;
-			}
-		}
+	for( int i = 0; i < size; i++ ) {
+		const double t = -( 2 * answers[i] - 1 );
+		// Without branches, so that the loop could be vectorized
+		const bool isActive = t * predicts[i] < 1;
+		gradients[i] = isActive ? 2 * t * ( t * predicts[i] - 1 ) : 0.0;
+		hessians[i] = isActive ? 2 * t * t : 1e-16;
 	}
 }
 
-double CGradientBoostingSquaredHinge::CalcLossMean( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers ) const
+double CGradientBoostingSquaredHinge::CalcLossSum( const double* predicts, const double* answers, int size ) const
 {
-	NeoAssert( predicts.Size() == answers.Size() );
-
-	double overallSum = 0;
-	auto getMean = []( double sum, int n ) { return n != 0 ? sum / static_cast<double>( n ) : 0; };
-	for( int i = 0; i < predicts.Size(); ++i ) {
-		double sum = 0;
-		for( int j = 0; j < predicts[i].Size(); ++j ) {
-			const double base = max( 0.0, 1.0 - ( 2.0 * answers[i][j] - 1.0 ) * predicts[i][j] );
-			sum += base * base;
-		}
-		overallSum += getMean( sum, predicts[i].Size() );
+	double sum = 0;
+	for( int i = 0; i < size; i++ ) {
+		const double base = max( 0.0, 1.0 - ( 2.0 * answers[i] - 1.0 ) * predicts[i] );
+		sum += base * base;
 	}
-
-	return getMean( overallSum, predicts.Size() );
+	return sum;
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -215,14 +282,40 @@ double CGradientBoostingSquaredHinge::CalcLossMean( const CArray< CArray<double>
 class CGradientBoostingSquareLoss : public IGradientBoostingLossFunction {
 public:
 	// IGradientBoostingLossFunction interface methods
-	void CalcGradientAndHessian( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
-		CArray< CArray<double> >& gradient, CArray< CArray<double> >& hessian ) const override;
-
-	double CalcLossMean( const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers ) const override;
+	void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const override;
+	double CalcLossSum( const double* predicts, const double* answers, int size ) const override;
 };
 
-void CGradientBoostingSquareLoss::CalcGradientAndHessian( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers, CArray< CArray<double> >& gradients, CArray< CArray<double> >& hessians ) const
+void CGradientBoostingSquareLoss::CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+	double* gradients, double* hessians ) const
+{
+	for( int i = 0; i < size; i++ ) {
+		gradients[i] = predicts[i] - answers[i];
+		hessians[i] = 1.0;
+	}
+}
+
+double CGradientBoostingSquareLoss::CalcLossSum( const double* predicts, const double* answers, int size ) const
+{
+	double sum = 0;
+	for( int i = 0; i < size; i++ ) {
+		const double diff = answers[i] - predicts[i];
+		sum += diff * diff / 2.0;
+	}
+	return sum;
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// The number of values processed by a loss function call
+// Each thread processes whole blocks, so the loss sum does not depend on the number of threads
+static const int LossBlockSize = 16 * 1024;
+
+// Calculates the loss gradients and hessians for all the predictions
+static void calcGradientAndHessian( const IGradientBoostingLossFunction& lossFunction, int threadCount,
+	const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers,
+	CArray< CArray<double> >& gradients, CArray< CArray<double> >& hessians )
 {
 	NeoAssert( predicts.Size() == answers.Size() );
 
@@ -230,29 +323,56 @@ void CGradientBoostingSquareLoss::CalcGradientAndHessian( const CArray< CArray<d
 	hessians.SetSize( predicts.Size() );
 
 	for( int i = 0; i < predicts.Size(); i++ ) {
-		gradients[i].SetSize( predicts[i].Size() );
-		hessians[i].SetSize( predicts[i].Size() );
-		for( int j = 0; j < predicts[i].Size(); j++ ) {
-			gradients[i][j] = static_cast<double>( predicts[i][j] - answers[i][j] );
-			hessians[i][j] = static_cast<double>( 1.0 );
+		const int size = predicts[i].Size();
+		NeoAssert( answers[i].Size() == size );
+		gradients[i].SetSize( size );
+		hessians[i].SetSize( size );
+
+		const double* predictsPtr = predicts[i].GetPtr();
+		const double* answersPtr = answers[i].GetPtr();
+		double* gradientsPtr = gradients[i].GetPtr();
+		double* hessiansPtr = hessians[i].GetPtr();
+		const int blockCount = ( size + LossBlockSize - 1 ) / LossBlockSize;
+		const int curThreadCount = IsOmpRelevant( blockCount ) ? threadCount : 1;
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int block = 0; block < blockCount; block++ ) {
+			const int start = block * LossBlockSize;
+			lossFunction.CalcGradientAndHessian( predictsPtr + start, answersPtr + start, min( LossBlockSize, size - start ),
+				gradientsPtr + start, hessiansPtr + start );
 		}
 	}
 }
 
-double CGradientBoostingSquareLoss::CalcLossMean( const CArray< CArray<double> >& predicts,
-	const CArray< CArray<double> >& answers ) const
+// Calculates the loss mean over all the predictions
+static double calcLossMean( const IGradientBoostingLossFunction& lossFunction, int threadCount,
+	const CArray< CArray<double> >& predicts, const CArray< CArray<double> >& answers )
 {
 	NeoAssert( predicts.Size() == answers.Size() );
 
 	double overallSum = 0;
 	auto getMean = []( double sum, int n ) { return n != 0 ? sum / static_cast<double>( n ) : 0; };
+	CArray<double> blockSums;
 	for( int i = 0; i < predicts.Size(); ++i ) {
+		const int size = predicts[i].Size();
+		NeoAssert( answers[i].Size() == size );
+
+		const double* predictsPtr = predicts[i].GetPtr();
+		const double* answersPtr = answers[i].GetPtr();
+		const int blockCount = ( size + LossBlockSize - 1 ) / LossBlockSize;
+		blockSums.SetSize( blockCount );
+		const int curThreadCount = IsOmpRelevant( blockCount ) ? threadCount : 1;
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int block = 0; block < blockCount; block++ ) {
+			const int start = block * LossBlockSize;
+			blockSums[block] = lossFunction.CalcLossSum( predictsPtr + start, answersPtr + start,
+				min( LossBlockSize, size - start ) );
+		}
+
 		double sum = 0;
-		for( int j = 0; j < predicts[i].Size(); ++j ) {
-			const double diff = answers[i][j] - predicts[i][j];
-			sum += diff * diff / 2.0;
+		for( int block = 0; block < blockCount; block++ ) {
+			sum += blockSums[block];
 		}
-		overallSum += getMean( sum, predicts[i].Size() );
+		overallSum += getMean( sum, size );
 	}
 
 	return getMean( overallSum, predicts.Size() );
@@ -304,16 +424,20 @@ static void generateRandomArray( CRandom& random, int n, int k, CArray<int>& res
 CGradientBoost::CGradientBoost( const CParams& _params ) :
 	params( processParams( _params ) ),
 	logStream( 0 ),
-	loss( 0 )
+	loss( 0 ),
+	bestIterationsCount( 0 )
 {
 	NeoAssert( params.IterationsCount > 0 );
 	NeoAssert( 0 <= params.Subsample && params.Subsample <= 1 );
 	NeoAssert( 0 <= params.Subfeature && params.Subfeature <= 1 );
 	NeoAssert( params.MaxTreeDepth >= 0 );
 	NeoAssert( params.MaxNodesCount >= 0 || params.MaxNodesCount == NotFound );
+	NeoAssert( params.MaxLeavesCount > 1 || params.MaxLeavesCount == NotFound );
+	NeoAssert( params.MaxHistCount > 1 || params.MaxHistCount == NotFound );
 	NeoAssert( params.PruneCriterionValue >= 0 );
 	NeoAssert( params.ThreadCount > 0 );
 	NeoAssert( params.MinSubsetWeight >= 0 );
+	NeoAssert( params.EarlyStoppingPatience >= 0 );
 }
 
 CGradientBoost::~CGradientBoost()
@@ -343,6 +467,16 @@ CPtr<IRegressionModel> CGradientBoost::TrainRegression( const IRegressionProblem
 	return CheckCast<IRegressionModel>( train( multivariate, createLossFunction() ) );
 }
 
+ITrainingModel* CGradientBoost::CreateCopy( int threadCount ) const
+{
+	if( params.Random != nullptr ) {
+		return nullptr;
+	}
+	CParams copyParams = params;
+	copyParams.ThreadCount = threadCount;
+	return FINE_DEBUG_NEW CGradientBoost( copyParams );
+}
+
 CPtr<IModel> CGradientBoost::Train( const IProblem& problem )
 {
 	if( logStream != nullptr ) {
@@ -359,6 +493,58 @@ CPtr<IModel> CGradientBoost::Train( const IProblem& problem )
 	return CheckCast<IModel>( train( multivariate, createLossFunction() ) );
 }
 
+void CGradientBoost::WriteBinnedData( const IProblem& problem, const char* fileName ) const
+{
+	// Only the vectors and their weights are binned, so the class values do not matter
+	CPtr<const IMultivariateRegressionProblem> multivariate =
+		FINE_DEBUG_NEW CMultivariateRegressionOverClassification( &problem );
+	WriteBinnedData( *multivariate, fileName );
+}
+
+void CGradientBoost::WriteBinnedData( const IRegressionProblem& problem, const char* fileName ) const
+{
+	CPtr<const IMultivariateRegressionProblem> multivariate =
+		FINE_DEBUG_NEW CMultivariateRegressionOverUnivariate( &problem );
+	WriteBinnedData( *multivariate, fileName );
+}
+
+void CGradientBoost::WriteBinnedData( const IMultivariateRegressionProblem& problem, const char* fileName ) const
+{
+	CPtr<const IGradientBoostProblemParts> parts = FINE_DEBUG_NEW CGradientBoostSingleProblemParts( &problem );
+	WriteBinnedData( *parts, fileName );
+}
+
+void CGradientBoost::WriteBinnedData( const IGradientBoostProblemParts& _parts, const char* fileName ) const
+{
+	CPtr<const IGradientBoostProblemParts> parts = FINE_DEBUG_NEW CNotNullWeightsProblemParts( &_parts );
+	CGradientBoostFastHistProblem::WriteBinnedData( params.ThreadCount, params.MaxBins, *parts, fileName );
+}
+
+void CGradientBoost::SetValidationProblem( const IProblem* problem )
+{
+	if( problem == nullptr ) {
+		validationProblem.Release();
+	} else if( problem->GetClassCount() == 2 ) {
+		validationProblem = FINE_DEBUG_NEW CMultivariateRegressionOverBinaryClassification( problem );
+	} else {
+		validationProblem = FINE_DEBUG_NEW CMultivariateRegressionOverClassification( problem );
+	}
+}
+
+void CGradientBoost::SetValidationProblem( const IRegressionProblem* problem )
+{
+	if( problem == nullptr ) {
+		validationProblem.Release();
+	} else {
+		validationProblem = FINE_DEBUG_NEW CMultivariateRegressionOverUnivariate( problem );
+	}
+}
+
+void CGradientBoost::SetValidationProblem( const IMultivariateRegressionProblem* problem )
+{
+	validationProblem = problem;
+}
+
 // Trains a model
 CPtr<IObject> CGradientBoost::train(
 	const IMultivariateRegressionProblem* _problem,
@@ -373,6 +559,14 @@ CPtr<IObject> CGradientBoost::train(
 	initialize( problem->GetValueSize(), problem->GetVectorCount(),
 		problem->GetFeatureCount(), models );
 
+	validationLoss.DeleteAll();
+	bestIterationsCount = 0;
+	if( validationProblem != nullptr ) {
+		NeoAssert( validationProblem->GetValueSize() == problem->GetValueSize() );
+		NeoAssert( validationProblem->GetFeatureCount() == problem->GetFeatureCount() );
+		initializeValidation( *validationProblem );
+	}
+
 	try {
 		// Create a tree builder
 		createTreeBuilder( problem );
@@ -387,20 +581,51 @@ CPtr<IObject> CGradientBoost::train(
 			CObjectArray<IRegressionTreeNode> curIterationModels; // a new model for multi-class classification
 			executeStep( *lossFunction, problem, models, curIterationModels );
 
+			const int prevStep = models[0].Size();
 			for( int j = 0; j < curIterationModels.Size(); j++ ) {
 				models[j].Add( curIterationModels[j] );
 			}
+
+			if( validationProblem != nullptr ) {
+				validationLoss.Add( updateValidationPredictions( *lossFunction, models, prevStep ) );
+				if( logStream != nullptr ) {
+					*logStream << "Validation loss = " << validationLoss.Last() << "\n";
+				}
+				if( bestIterationsCount == 0 || validationLoss.Last() < validationLoss[bestIterationsCount - 1] ) {
+					bestIterationsCount = i + 1;
+				} else if( params.EarlyStoppingPatience > 0 && i + 1 - bestIterationsCount >= params.EarlyStoppingPatience ) {
+					if( logStream != nullptr ) {
+						*logStream << "\nEarly stopping: the best iteration is " << bestIterationsCount - 1 << "\n";
+					}
+					break;
+				}
+			}
 		}
+
+		if( validationProblem != nullptr && params.EarlyStoppingPatience > 0 && models[0].Size() > bestIterationsCount ) {
+			// Remove the trees after the best iteration
+			for( int i = 0; i < models.Size(); i++ ) {
+				models[i].SetSize( bestIterationsCount );
+			}
+			// The cached predictions contain the removed trees
+			for( int i = 0; i < predictCache.Size(); i++ ) {
+				for( int j = 0; j < predictCache[i].Size(); j++ ) {
+					predictCache[i][j].Step = 0;
+					predictCache[i][j].Value = 0;
+				}
+			}
+		}
+
+		// Calculate the last loss values
+		// The binned data may be needed for the predictions, so the tree builder is still alive
+		buildFullPredictions( *problem, models );
+		loss = calcLossMean( *lossFunction, params.ThreadCount, predicts, answers );
 	} catch( ... ) {
 		destroyTreeBuilder(); // return to the initial state
 		throw;
 	}
 	destroyTreeBuilder();
 
-	// Calculate the last loss values
-	buildFullPredictions( *problem, models );
-	loss = lossFunction->CalcLossMean( predicts, answers );
-
 	return createOutputRepresentation(
 		models, params.TreeBuilder == GBTB_MultiFull || params.TreeBuilder == GBTB_MultiFastHist ? problem->GetValueSize() : 1 );
 }
@@ -443,6 +668,8 @@ void CGradientBoost::createTreeBuilder( const IMultivariateRegressionProblem* pr
 			builderParams.MaxNodesCount = params.MaxNodesCount;
 			builderParams.PruneCriterionValue = params.PruneCriterionValue;
 			builderParams.MaxBins = params.MaxBins;
+			builderParams.MaxLeavesCount = params.MaxLeavesCount;
+			builderParams.MaxHistCount = params.MaxHistCount;
 			builderParams.MinSubsetWeight = params.MinSubsetWeight;
 			builderParams.DenseTreeBoostCoefficient = params.DenseTreeBoostCoefficient;
 			if( params.TreeBuilder == GBTB_MultiFastHist ) {
@@ -450,8 +677,15 @@ void CGradientBoost::createTreeBuilder( const IMultivariateRegressionProblem* pr
 			} else {
 				fastHistSingleClassTreeBuilder = FINE_DEBUG_NEW CGradientBoostFastHistTreeBuilder<CGradientBoostStatisticsSingle>( builderParams, logStream, 1 );
 			}
-			fastHistProblem = FINE_DEBUG_NEW CGradientBoostFastHistProblem( params.ThreadCount, params.MaxBins,
-				*problem, usedVectors, usedFeatures );
+			if( binnedDataFileName == CString() ) {
+				fastHistProblem = FINE_DEBUG_NEW CGradientBoostFastHistProblem( params.ThreadCount, params.MaxBins,
+					*problem, usedVectors, usedFeatures );
+			} else {
+				fastHistProblem = FINE_DEBUG_NEW CGradientBoostFastHistProblem( binnedDataFileName, usedVectors, usedFeatures );
+				// The file should be written for the same problem
+				NeoAssert( fastHistProblem->GetVectorCount() == problem->GetVectorCount() );
+				NeoAssert( fastHistProblem->GetFeatureCount() == problem->GetFeatureCount() );
+			}
 			break;
 		}
 		default:
@@ -486,6 +720,9 @@ CPtr<IGradientBoostingLossFunction> CGradientBoost::createLossFunction() const
 		case LF_L2:
 			return FINE_DEBUG_NEW CGradientBoostingSquareLoss();
 			break;
+		case LF_Custom:
+			NeoAssert( params.CustomLossFunction != nullptr );
+			return params.CustomLossFunction;
 		default:
 			NeoAssert( false );
 			return 0;
@@ -576,7 +813,7 @@ void CGradientBoost::executeStep( IGradientBoostingLossFunction& lossFunction,
 
 	// The vectors in the regression value are partial derivatives of the loss function
 	// The tree built for this problem will decrease the loss function value
-	lossFunction.CalcGradientAndHessian( predicts, answers, gradients, hessians );
+	calcGradientAndHessian( lossFunction, params.ThreadCount, predicts, answers, gradients, hessians );
 
 	// Add the vector weights and calculate the total
 	CArray<double> gradientsSum;
@@ -640,14 +877,16 @@ void CGradientBoost::executeStep( IGradientBoostingLossFunction& lossFunction,
 void CGradientBoost::buildPredictions( const IMultivariateRegressionProblem& problem, const CArray<CGradientBoostEnsemble>& models, int curStep )
 {
 	CFloatMatrixDesc matrix = problem.GetMatrix();
-	NeoAssert( matrix.Height == problem.GetVectorCount() );
-	NeoAssert( matrix.Width == problem.GetFeatureCount() );
 
 	CArray<CFastArray<double, 1>> predictions;
 	predictions.SetSize( params.ThreadCount );
 	for( int i = 0; i < predictions.Size(); i++ ) {
 		predictions[i].SetSize( problem.GetValueSize() );
 	}
+	CArray< CArray<int> > indexesBuffers;
+	indexesBuffers.SetSize( params.ThreadCount );
+	CArray< CArray<float> > valuesBuffers;
+	valuesBuffers.SetSize( params.ThreadCount );
 
 	NEOML_OMP_NUM_THREADS( params.ThreadCount )
 	{
@@ -659,7 +898,7 @@ void CGradientBoost::buildPredictions( const IMultivariateRegressionProblem& pro
 				const int usedVector = usedVectors[index];
 				const CFloatVector value = problem.GetValue( usedVectors[index] );
 				CFloatVectorDesc vector;
-				matrix.GetRow( usedVector, vector );
+				getTrainingVector( matrix, usedVector, indexesBuffers[threadNum], valuesBuffers[threadNum], vector );
 
 				if( params.TreeBuilder == GBTB_MultiFull || params.TreeBuilder == GBTB_MultiFastHist ) {
 					CGradientBoostModel::PredictRaw( models[0], predictCache[0][usedVector].Step,
@@ -685,12 +924,23 @@ void CGradientBoost::buildPredictions( const IMultivariateRegressionProblem& pro
 	}
 }
 
+// Gets the training vector
+// The vectors are read from the binned data file if it is used, so the problem matrix is not needed
+void CGradientBoost::getTrainingVector( const CFloatMatrixDesc& matrix, int index, CArray<int>& indexesBuffer,
+	CArray<float>& valuesBuffer, CFloatVectorDesc& vector ) const
+{
+	if( fastHistProblem != nullptr && fastHistProblem->IsBinnedDataFile() ) {
+		fastHistProblem->GetBinnedVector( index, indexesBuffer, valuesBuffer, vector );
+	} else {
+		NeoAssert( index < matrix.Height );
+		matrix.GetRow( index, vector );
+	}
+}
+
 // Fills the prediction cache with the values of the full problem
 void CGradientBoost::buildFullPredictions( const IMultivariateRegressionProblem& problem, const CArray<CGradientBoostEnsemble>& models )
 {
 	CFloatMatrixDesc matrix = problem.GetMatrix();
-	NeoAssert( matrix.Height == problem.GetVectorCount() );
-	NeoAssert( matrix.Width == problem.GetFeatureCount() );
 
 	for( int i = 0; i < predicts.Size(); i++ ) {
 		predicts[i].SetSize( problem.GetVectorCount() );
@@ -702,6 +952,11 @@ void CGradientBoost::buildFullPredictions( const IMultivariateRegressionProblem&
 		predictions[i].SetSize( problem.GetValueSize() );
 	}
 
+	CArray< CArray<int> > indexesBuffers;
+	indexesBuffers.SetSize( params.ThreadCount );
+	CArray< CArray<float> > valuesBuffers;
+	valuesBuffers.SetSize( params.ThreadCount );
+
 	int step = models[0].Size();
 	NEOML_OMP_NUM_THREADS( params.ThreadCount )
 	{
@@ -712,7 +967,7 @@ void CGradientBoost::buildFullPredictions( const IMultivariateRegressionProblem&
 			for( int i = 0; i < count; i++ ) {
 				const CFloatVector value = problem.GetValue( index );
 				CFloatVectorDesc vector;
-				matrix.GetRow( index, vector );
+				getTrainingVector( matrix, index, indexesBuffers[threadNum], valuesBuffers[threadNum], vector );
 
 				if( params.TreeBuilder == GBTB_MultiFull || params.TreeBuilder == GBTB_MultiFastHist ){
 					CGradientBoostModel::PredictRaw( models[0], predictCache[0][index].Step,
@@ -738,6 +993,74 @@ void CGradientBoost::buildFullPredictions( const IMultivariateRegressionProblem&
 	}
 }
 
+// Initializes the validation predictions and answers
+void CGradientBoost::initializeValidation( const IMultivariateRegressionProblem& problem )
+{
+	const int vectorCount = problem.GetVectorCount();
+	validationPredicts.SetSize( problem.GetValueSize() );
+	validationAnswers.SetSize( problem.GetValueSize() );
+	for( int i = 0; i < validationPredicts.Size(); i++ ) {
+		validationPredicts[i].DeleteAll();
+		validationPredicts[i].Add( 0, vectorCount );
+		validationAnswers[i].SetSize( vectorCount );
+	}
+
+	for( int i = 0; i < vectorCount; i++ ) {
+		const CFloatVector value = problem.GetValue( i );
+		for( int j = 0; j < problem.GetValueSize(); j++ ) {
+			validationAnswers[j][i] = value[j];
+		}
+	}
+}
+
+// Adds the predictions of the trees built since prevStep to the validation predictions
+// Returns the validation loss mean
+double CGradientBoost::updateValidationPredictions( const IGradientBoostingLossFunction& lossFunction,
+	const CArray<CGradientBoostEnsemble>& models, int prevStep )
+{
+	CFloatMatrixDesc matrix = validationProblem->GetMatrix();
+	NeoAssert( matrix.Height == validationProblem->GetVectorCount() );
+	NeoAssert( matrix.Width == validationProblem->GetFeatureCount() );
+
+	const int valueSize = validationProblem->GetValueSize();
+	CArray<CFastArray<double, 1>> predictions;
+	predictions.SetSize( params.ThreadCount );
+	for( int i = 0; i < predictions.Size(); i++ ) {
+		predictions[i].SetSize( valueSize );
+	}
+
+	NEOML_OMP_NUM_THREADS( params.ThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		int threadNum = OmpGetThreadNum();
+		if( OmpGetTaskIndexAndCount( matrix.Height, index, count ) ) {
+			for( int i = 0; i < count; i++ ) {
+				CFloatVectorDesc vector;
+				matrix.GetRow( index, vector );
+
+				if( params.TreeBuilder == GBTB_MultiFull || params.TreeBuilder == GBTB_MultiFastHist ) {
+					CGradientBoostModel::PredictRaw( models[0], prevStep, params.LearningRate, vector, predictions[threadNum] );
+				} else {
+					CFastArray<double, 1> pred;
+					pred.SetSize( 1 );
+					for( int j = 0; j < valueSize; j++ ) {
+						CGradientBoostModel::PredictRaw( models[j], prevStep, params.LearningRate, vector, pred );
+						predictions[threadNum][j] = pred[0];
+					}
+				}
+
+				for( int j = 0; j < valueSize; j++ ) {
+					validationPredicts[j][index] += predictions[threadNum][j];
+				}
+				index++;
+			}
+		}
+	}
+
+	return calcLossMean( lossFunction, params.ThreadCount, validationPredicts, validationAnswers );
+}
+
 // Creates model represetation requested in params.
 CPtr<IObject> CGradientBoost::createOutputRepresentation(
 	CArray<CGradientBoostEnsemble>& models, int predictionSize )
@@ -17,32 +17,89 @@ limitations under the License.
 #pragma hdrstop
 
 #include <GradientBoostFastHistProblem.h>
+#include <NeoML/ArchiveFile.h>
 #include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
+// The binned data file signature and version
+static const int BinnedDataSignature = 0x44424D4E;
+static const int BinnedDataVersion = 0;
+
+// The binned data file header
+// It is followed by featurePos, featureIndexes, cuts, nullValueIds, vector data and vector pointers arrays
+struct CBinnedDataHeader {
+	int Signature; // BinnedDataSignature
+	int Version; // BinnedDataVersion
+	int VectorCount; // the number of vectors
+	int FeatureCount; // the number of features
+	int IdCount; // the total number of histogram bins
+	int Reserved;
+	__int64 ElementCount; // the total number of identifiers in the vector data
+	__int64 VectorDataOffset; // the offset of the vector data
+	__int64 VectorPtrOffset; // the offset of the pointers to the vector data
+};
+
+// When writing the binned data, the feature values are collected for no more than this number of elements at a time
+static const __int64 BinnedDataMaxBlockElementCount = 64 * Megabyte;
+
 CGradientBoostFastHistProblem::CGradientBoostFastHistProblem( int threadCount, int maxBins,
 		const IMultivariateRegressionProblem& baseProblem,
 		const CArray<int>& _usedVectors, const CArray<int>& _usedFeatures ) :
 	usedVectors( _usedVectors ),
-	usedFeatures( _usedFeatures )
+	usedFeatures( _usedFeatures ),
+	vectorCount( baseProblem.GetVectorCount() ),
+	vectorData( nullptr ),
+	vectorPtr( nullptr )
 {
 	CFloatMatrixDesc matrix = baseProblem.GetMatrix();
 	NeoAssert( matrix.Height == baseProblem.GetVectorCount() );
 	NeoAssert( matrix.Width == baseProblem.GetFeatureCount() );
 	// Initialize features data
-	initializeFeatureInfo( threadCount, maxBins, matrix, baseProblem );
+	CPtr<const IGradientBoostProblemParts> parts = FINE_DEBUG_NEW CGradientBoostSingleProblemParts( &baseProblem );
+	initializeFeatureInfo( threadCount, maxBins, *parts, NotFound );
 
 	// Build vector data
 	buildVectorData( matrix );
 }
 
+CGradientBoostFastHistProblem::CGradientBoostFastHistProblem( const char* binnedDataFileName,
+		const CArray<int>& _usedVectors, const CArray<int>& _usedFeatures ) :
+	usedVectors( _usedVectors ),
+	usedFeatures( _usedFeatures ),
+	vectorCount( 0 ),
+	vectorData( nullptr ),
+	vectorPtr( nullptr )
+{
+	loadBinnedData( binnedDataFileName );
+}
+
+CGradientBoostFastHistProblem::CGradientBoostFastHistProblem( const CArray<int>& _usedVectors,
+		const CArray<int>& _usedFeatures ) :
+	usedVectors( _usedVectors ),
+	usedFeatures( _usedFeatures ),
+	vectorCount( 0 ),
+	vectorData( nullptr ),
+	vectorPtr( nullptr )
+{
+}
+
+void CGradientBoostFastHistProblem::WriteBinnedData( int threadCount, int maxBins,
+	const IGradientBoostProblemParts& parts, const char* fileName )
+{
+	CArray<int> noVectors;
+	CArray<int> noFeatures;
+	CPtr<CGradientBoostFastHistProblem> problem = FINE_DEBUG_NEW CGradientBoostFastHistProblem( noVectors, noFeatures );
+	problem->initializeFeatureInfo( threadCount, maxBins, parts, BinnedDataMaxBlockElementCount );
+	problem->writeBinnedData( parts, fileName );
+}
+
 const int* CGradientBoostFastHistProblem::GetUsedVectorDataPtr( int index ) const
 {
 	NeoAssert( index >= 0 );
 	NeoAssert( index < usedVectors.Size() );
 
-	return vectorData.GetPtr() + vectorPtr[usedVectors[index]];
+	return vectorData + vectorPtr[usedVectors[index]];
 }
 
 int CGradientBoostFastHistProblem::GetUsedVectorDataSize( int index ) const
@@ -50,15 +107,128 @@ int CGradientBoostFastHistProblem::GetUsedVectorDataSize( int index ) const
 	NeoAssert( index >= 0 );
 	NeoAssert( index < usedVectors.Size() );
 
-	return vectorPtr[usedVectors[index] + 1] - vectorPtr[usedVectors[index]];
+	return static_cast<int>( vectorPtr[usedVectors[index] + 1] - vectorPtr[usedVectors[index]] );
+}
+
+void CGradientBoostFastHistProblem::GetBinnedVector( int index, CArray<int>& indexesBuffer, CArray<float>& valuesBuffer,
+	CFloatVectorDesc& vector ) const
+{
+	NeoAssert( index >= 0 );
+	NeoAssert( index < vectorCount );
+
+	// The identifiers go in the order of the features, so the indexes are sorted
+	const int* ids = vectorData + vectorPtr[index];
+	const int size = static_cast<int>( vectorPtr[index + 1] - vectorPtr[index] );
+	indexesBuffer.SetSize( size );
+	valuesBuffer.SetSize( size );
+	for( int i = 0; i < size; i++ ) {
+		indexesBuffer[i] = featureIndexes[ids[i]];
+		valuesBuffer[i] = cuts[ids[i]];
+	}
+
+	vector.Size = size;
+	vector.Indexes = indexesBuffer.GetPtr();
+	vector.Values = valuesBuffer.GetPtr();
+}
+
+void CGradientBoostFastHistProblem::PrefetchUsedVectorData( const int* indexes, int count ) const
+{
+	if( !binnedDataFile.IsOpen() ) {
+		return;
+	}
+
+	// The data of the close vectors is requested in one range
+	const __int64 maxGap = 16 * 1024;
+	const __int64 dataOffset = reinterpret_cast<const char*>( vectorData )
+		- static_cast<const char*>( binnedDataFile.GetData() );
+	__int64 begin = 0;
+	__int64 end = NotFound;
+	for( int i = 0; i < count; i++ ) {
+		const int index = usedVectors[indexes[i]];
+		const __int64 vectorBegin = dataOffset + vectorPtr[index] * sizeof( int );
+		const __int64 vectorEnd = dataOffset + vectorPtr[index + 1] * sizeof( int );
+		if( end != NotFound && vectorBegin <= end + maxGap && vectorEnd + maxGap >= begin ) {
+			begin = min( begin, vectorBegin );
+			end = max( end, vectorEnd );
+			continue;
+		}
+		if( end != NotFound ) {
+			binnedDataFile.Prefetch( begin, end - begin );
+		}
+		begin = vectorBegin;
+		end = vectorEnd;
+	}
+	if( end != NotFound ) {
+		binnedDataFile.Prefetch( begin, end - begin );
+	}
 }
 
 // Initializes the feature values
-void CGradientBoostFastHistProblem::initializeFeatureInfo( int threadCount, int maxBins, const CFloatMatrixDesc& matrix,
-	const IMultivariateRegressionProblem& baseProblem )
+// The values are collected for the blocks of features with no more than maxBlockElementCount non-zero elements
+// NotFound means that all features are processed at once
+void CGradientBoostFastHistProblem::initializeFeatureInfo( int threadCount, int maxBins,
+	const IGradientBoostProblemParts& parts, __int64 maxBlockElementCount )
 {
-	const int vectorCount = baseProblem.GetVectorCount();
-	const int featureCount = baseProblem.GetFeatureCount();
+	NeoAssert( parts.GetPartCount() > 0 );
+	const int featureCount = parts.GetPart( 0 )->GetFeatureCount();
+
+	featurePos.Empty();
+	featureIndexes.Empty();
+	cuts.Empty();
+	nullValueIds.Empty();
+
+	if( maxBlockElementCount == NotFound ) {
+		vectorCount = parts.GetPart( 0 )->GetVectorCount();
+		NeoAssert( parts.GetPartCount() == 1 );
+		addFeatureInfo( threadCount, maxBins, parts, 0, featureCount );
+	} else {
+		// Count the vectors and the non-zero elements of each feature
+		vectorCount = 0;
+		CArray<__int64> featureElementCounts;
+		featureElementCounts.Add( 0, featureCount );
+		for( int partIndex = 0; partIndex < parts.GetPartCount(); partIndex++ ) {
+			CPtr<const IMultivariateRegressionProblem> part = parts.GetPart( partIndex );
+			CFloatMatrixDesc matrix = part->GetMatrix();
+			NeoAssert( part->GetFeatureCount() == featureCount );
+			NeoAssert( matrix.Height == part->GetVectorCount() );
+			NeoAssert( matrix.Width == featureCount );
+			// The binned data file is limited to INT_MAX vectors
+			NeoAssert( vectorCount <= INT_MAX - matrix.Height );
+			vectorCount += matrix.Height;
+			for( int i = 0; i < matrix.Height; i++ ) {
+				CFloatVectorDesc vector;
+				matrix.GetRow( i, vector );
+				for( int j = 0; j < vector.Size; j++ ) {
+					if( vector.Values[j] != 0.0 ) {
+						featureElementCounts[vector.Indexes == nullptr ? j : vector.Indexes[j]]++;
+					}
+				}
+			}
+		}
+
+		int firstFeature = 0;
+		while( firstFeature < featureCount ) {
+			int lastFeature = firstFeature + 1;
+			__int64 blockElementCount = featureElementCounts[firstFeature];
+			while( lastFeature < featureCount
+				&& blockElementCount + featureElementCounts[lastFeature] <= maxBlockElementCount )
+			{
+				blockElementCount += featureElementCounts[lastFeature];
+				lastFeature++;
+			}
+			addFeatureInfo( threadCount, maxBins, parts, firstFeature, lastFeature );
+			firstFeature = lastFeature;
+		}
+	}
+
+	featurePos.Add( cuts.Size() );
+}
+
+// Adds the histogram bins for the features from the [firstFeature, lastFeature) range
+void CGradientBoostFastHistProblem::addFeatureInfo( int threadCount, int maxBins, const IGradientBoostProblemParts& parts,
+	int firstFeature, int lastFeature )
+{
+	const int featureCount = lastFeature - firstFeature;
 
 	CArray< CArray<CFeatureValue> > featureValues; // the values of all features
 	featureValues.SetSize( featureCount );
@@ -66,36 +236,39 @@ void CGradientBoostFastHistProblem::initializeFeatureInfo( int threadCount, int
 	CArray<double> featureWeights; // total weight of all vectors for which the current feature is not 0
 	featureWeights.Add( 0.0, featureCount );
 	double totalWeight = 0.0; // total weight of all vectors
-	int totalElementCount = 0; // total number of non-zero elements
 
 	// Adding the non-zero values
-	for( int i = 0; i < vectorCount; i++ ) {
-		CFloatVectorDesc vector;
-		matrix.GetRow( i, vector );
-		const double vectorWeight = baseProblem.GetVectorWeight( i );
-
-		for( int j = 0; j < vector.Size; j++ ) {
-			if( vector.Values[j] != 0.0 ) {
-				++totalElementCount;
-				const int index = vector.Indexes == nullptr ? j : vector.Indexes[j];
-				if( featureValues[index].IsEmpty()
-					|| featureValues[index].Last().Value != vector.Values[j] )
-				{
-					CFeatureValue newValue;
-					newValue.Value = vector.Values[j];
-					newValue.Weight = vectorWeight;
-					featureValues[index].Add( newValue );
-				} else {
-					featureValues[index].Last().Weight += vectorWeight;
+	for( int partIndex = 0; partIndex < parts.GetPartCount(); partIndex++ ) {
+		CPtr<const IMultivariateRegressionProblem> part = parts.GetPart( partIndex );
+		CFloatMatrixDesc matrix = part->GetMatrix();
+		for( int i = 0; i < matrix.Height; i++ ) {
+			CFloatVectorDesc vector;
+			matrix.GetRow( i, vector );
+			const double vectorWeight = part->GetVectorWeight( i );
+
+			for( int j = 0; j < vector.Size; j++ ) {
+				if( vector.Values[j] != 0.0 ) {
+					const int index = ( vector.Indexes == nullptr ? j : vector.Indexes[j] ) - firstFeature;
+					if( index < 0 || index >= featureCount ) {
+						continue;
+					}
+					if( featureValues[index].IsEmpty()
+						|| featureValues[index].Last().Value != vector.Values[j] )
+					{
+						CFeatureValue newValue;
+						newValue.Value = vector.Values[j];
+						newValue.Weight = vectorWeight;
+						featureValues[index].Add( newValue );
+					} else {
+						featureValues[index].Last().Weight += vectorWeight;
+					}
+					featureWeights[index] += vectorWeight;
 				}
-				featureWeights[index] += vectorWeight;
 			}
+			totalWeight += vectorWeight;
 		}
-		totalWeight += vectorWeight;
 	}
 
-	vectorData.SetBufferSize( totalElementCount );
-
 	// Adding the zero values
 	for( int i = 0; i < featureValues.Size(); i++ ) {
 		CFeatureValue newValue;
@@ -123,23 +296,19 @@ void CGradientBoostFastHistProblem::initializeFeatureInfo( int threadCount, int
 	compressFeatureValues( threadCount, maxBins, totalWeight, featureValues );
 
 	// Initializing the internal arrays
-	nullValueIds.Add( NotFound, featureValues.Size() );
-	featurePos.SetBufferSize( featureValues.Size() );
-	int curPos = 0;
 	for( int i = 0; i < featureValues.Size(); i++ ) {
-		featurePos.Add( curPos );
-		featureIndexes.Add( i, featureValues[i].Size() );
-		curPos += featureValues[i].Size();
+		featurePos.Add( cuts.Size() );
+		featureIndexes.Add( firstFeature + i, featureValues[i].Size() );
+		nullValueIds.Add( NotFound );
 
 		for( int j = 0; j < featureValues[i].Size(); j++ ) {
 			const float next = j + 1 == featureValues[i].Size() ? featureValues[i][j].Value : featureValues[i][j + 1].Value;
 			cuts.Add( ( featureValues[i][j].Value + next ) / 2 );
-			if( nullValueIds[i] == NotFound && 0 <= cuts.Last() ) {
-				nullValueIds[i] = cuts.Size() - 1;
+			if( nullValueIds.Last() == NotFound && 0 <= cuts.Last() ) {
+				nullValueIds.Last() = cuts.Size() - 1;
 			}
 		}
 	}
-	featurePos.Add( curPos );
 }
 
 // Compresses the values of each feature so that there are no more than maxBins different values
@@ -185,35 +354,141 @@ void CGradientBoostFastHistProblem::compressFeatureValues( int threadCount, int
 	}
 }
 
+// Gets the identifiers of the non-zero feature values of the vector
+void CGradientBoostFastHistProblem::getVectorData( const CFloatVectorDesc& vector, CArray<int>& data ) const
+{
+	data.Empty();
+	for( int j = 0; j < vector.Size; j++ ) {
+		if( vector.Values[j] != 0.0 ) {
+			const int index = vector.Indexes == nullptr ? j : vector.Indexes[j];
+			const float* valuePtr = cuts.GetPtr() + featurePos[index]; // the pointer to this feature values
+			int valueCount = featurePos[index + 1] - featurePos[index]; // the number of different values for the feature
+			// Now we get the bin into which the current value falls
+			int pos = FindInsertionPoint<float, Ascending<float>, float>( vector.Values[j], valuePtr, valueCount );
+			if( pos > 0 && *(valuePtr + pos - 1) == vector.Values[j] ) {
+				pos--;
+			}
+			data.Add( featurePos[index] + pos );
+		}
+	}
+}
+
 // Builds an array with vector data
 void CGradientBoostFastHistProblem::buildVectorData( const CFloatMatrixDesc& matrix )
 {
-	const int vectorCount = matrix.Height;
-	
-	vectorPtr.SetBufferSize( vectorCount + 1 );
-	int curVectorPtr = 0;
+	vectorPtrBuffer.SetBufferSize( vectorCount + 1 );
+	CArray<int> data;
 	for( int i = 0; i < vectorCount; i++ ) {
-		vectorPtr.Add( curVectorPtr );
+		vectorPtrBuffer.Add( vectorDataBuffer.Size() );
 		CFloatVectorDesc vector;
 		matrix.GetRow( i, vector );
+		getVectorData( vector, data );
+		// The binned data kept in memory is limited to INT_MAX elements; use a binned data file for the larger problems
+		NeoAssert( vectorDataBuffer.Size() <= INT_MAX - data.Size() );
+		vectorDataBuffer.Add( data );
+	}
+	vectorPtrBuffer.Add( vectorDataBuffer.Size() );
 
-		for( int j = 0; j < vector.Size; j++ ) {
-			if( vector.Values[j] != 0.0 ) {
-				++curVectorPtr;
-				const int index = vector.Indexes == nullptr ? j : vector.Indexes[j];
-				float* valuePtr = cuts.GetPtr() + featurePos[index]; // the pointer to this feature values
-				int valueCount = featurePos[index + 1] - featurePos[index]; // the number of different values for the feature
-				// Now we get the bin into which the current value falls
-				int pos = FindInsertionPoint<float, Ascending<float>, float>( vector.Values[j], valuePtr, valueCount );
-				if( pos > 0 && *(valuePtr + pos - 1) == vector.Values[j] ) {
-					pos--;
-				}
-				vectorData.Add( featurePos[index] + pos );
+	vectorData = vectorDataBuffer.GetPtr();
+	vectorPtr = vectorPtrBuffer.GetPtr();
+}
+
+// Writes the binned data to a file
+// The vector data is written vector by vector
+void CGradientBoostFastHistProblem::writeBinnedData( const IGradientBoostProblemParts& parts, const char* fileName ) const
+{
+	CBinnedDataHeader header;
+	header.Signature = BinnedDataSignature;
+	header.Version = BinnedDataVersion;
+	header.VectorCount = vectorCount;
+	header.FeatureCount = nullValueIds.Size();
+	header.IdCount = cuts.Size();
+	header.Reserved = 0;
+	header.ElementCount = 0;
+	header.VectorDataOffset = sizeof( CBinnedDataHeader )
+		+ ( featurePos.Size() + featureIndexes.Size() + cuts.Size() + nullValueIds.Size() ) * sizeof( int );
+	header.VectorPtrOffset = 0;
+
+	CArchiveFile file( fileName, CArchive::SD_Storing );
+	file.Write( &header, sizeof( header ) );
+	file.Write( featurePos.GetPtr(), featurePos.Size() * sizeof( int ) );
+	file.Write( featureIndexes.GetPtr(), featureIndexes.Size() * sizeof( int ) );
+	file.Write( cuts.GetPtr(), cuts.Size() * sizeof( float ) );
+	file.Write( nullValueIds.GetPtr(), nullValueIds.Size() * sizeof( int ) );
+
+	CArray<__int64> ptrs;
+	ptrs.SetBufferSize( vectorCount + 1 );
+	CArray<int> data;
+	for( int partIndex = 0; partIndex < parts.GetPartCount(); partIndex++ ) {
+		CPtr<const IMultivariateRegressionProblem> part = parts.GetPart( partIndex );
+		CFloatMatrixDesc matrix = part->GetMatrix();
+		for( int i = 0; i < matrix.Height; i++ ) {
+			ptrs.Add( header.ElementCount );
+			CFloatVectorDesc vector;
+			matrix.GetRow( i, vector );
+			getVectorData( vector, data );
+			if( !data.IsEmpty() ) {
+				file.Write( data.GetPtr(), data.Size() * sizeof( int ) );
 			}
+			header.ElementCount += data.Size();
 		}
 	}
+	// The parts should be the same each time
+	NeoAssert( ptrs.Size() == vectorCount );
+	ptrs.Add( header.ElementCount );
+
+	// The pointers are aligned to their size
+	header.VectorPtrOffset = header.VectorDataOffset + header.ElementCount * sizeof( int );
+	if( header.VectorPtrOffset % sizeof( __int64 ) != 0 ) {
+		const int padding = 0;
+		file.Write( &padding, sizeof( padding ) );
+		header.VectorPtrOffset += sizeof( padding );
+	}
+	file.Write( ptrs.GetPtr(), ptrs.Size() * sizeof( __int64 ) );
 
-	vectorPtr.Add( curVectorPtr );
+	file.Seek( 0, CBaseFile::begin );
+	file.Write( &header, sizeof( header ) );
+	file.Close();
+}
+
+// Maps the binned data file and reads the feature information from it
+void CGradientBoostFastHistProblem::loadBinnedData( const char* fileName )
+{
+	binnedDataFile.Open( fileName );
+	const char* data = static_cast<const char*>( binnedDataFile.GetData() );
+	const __int64 length = binnedDataFile.GetLength();
+
+	check( length >= static_cast<__int64>( sizeof( CBinnedDataHeader ) ), ERR_BAD_ARCHIVE, fileName );
+	const CBinnedDataHeader& header = *reinterpret_cast<const CBinnedDataHeader*>( data );
+	check( header.Signature == BinnedDataSignature, ERR_BAD_ARCHIVE, fileName );
+	check( header.Version == BinnedDataVersion, ERR_BAD_ARCHIVE_VERSION, fileName );
+	check( header.VectorCount > 0 && header.FeatureCount > 0 && header.IdCount >= header.FeatureCount
+		&& header.ElementCount >= 0, ERR_BAD_ARCHIVE, fileName );
+	check( header.VectorDataOffset == static_cast<__int64>( sizeof( CBinnedDataHeader )
+		+ ( 2 * header.FeatureCount + 1 + 2 * header.IdCount ) * sizeof( int ) ), ERR_BAD_ARCHIVE, fileName );
+	check( header.VectorPtrOffset >= header.VectorDataOffset + header.ElementCount * static_cast<__int64>( sizeof( int ) )
+		&& header.VectorPtrOffset % sizeof( __int64 ) == 0
+		&& header.VectorPtrOffset + ( header.VectorCount + 1 ) * static_cast<__int64>( sizeof( __int64 ) ) <= length,
+		ERR_BAD_ARCHIVE, fileName );
+
+	vectorCount = header.VectorCount;
+	const int* metadata = reinterpret_cast<const int*>( data + sizeof( CBinnedDataHeader ) );
+	featurePos.SetSize( header.FeatureCount + 1 );
+	memcpy( featurePos.GetPtr(), metadata, featurePos.Size() * sizeof( int ) );
+	metadata += featurePos.Size();
+	featureIndexes.SetSize( header.IdCount );
+	memcpy( featureIndexes.GetPtr(), metadata, featureIndexes.Size() * sizeof( int ) );
+	metadata += featureIndexes.Size();
+	cuts.SetSize( header.IdCount );
+	memcpy( cuts.GetPtr(), metadata, cuts.Size() * sizeof( float ) );
+	metadata += cuts.Size();
+	nullValueIds.SetSize( header.FeatureCount );
+	memcpy( nullValueIds.GetPtr(), metadata, nullValueIds.Size() * sizeof( int ) );
+	check( featurePos.First() == 0 && featurePos.Last() == header.IdCount, ERR_BAD_ARCHIVE, fileName );
+
+	vectorData = reinterpret_cast<const int*>( data + header.VectorDataOffset );
+	vectorPtr = reinterpret_cast<const __int64*>( data + header.VectorPtrOffset );
+	check( vectorPtr[0] == 0 && vectorPtr[vectorCount] == header.ElementCount, ERR_BAD_ARCHIVE, fileName );
 }
 
 } // namespace NeoML
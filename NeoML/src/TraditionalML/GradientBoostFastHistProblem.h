@@ -16,9 +16,25 @@ limitations under the License.
 #pragma once
 
 #include <NeoML/TraditionalML/Problem.h>
+#include <NeoML/TraditionalML/GradientBoost.h>
+#include <MemoryMappedFile.h>
 
 namespace NeoML {
 
+// The problem as the only part
+class CGradientBoostSingleProblemParts : public IGradientBoostProblemParts {
+public:
+	explicit CGradientBoostSingleProblemParts( const IMultivariateRegressionProblem* _problem ) : problem( _problem ) {}
+
+	// IGradientBoostProblemParts interface methods
+	int GetPartCount() const override { return 1; }
+	CPtr<const IMultivariateRegressionProblem> GetPart( int index ) const override
+		{ NeoAssert( index == 0 ); return problem; }
+
+private:
+	const CPtr<const IMultivariateRegressionProblem> problem;
+};
+
 // The subproblem for building a tree with gradient boosting
 // The original vectors are transformed into vectors of unique integer identifiers
 // The identifier is the number of the histogram bin to which the feature value corresponds
@@ -28,13 +44,37 @@ public:
 	CGradientBoostFastHistProblem( int threadCount, int maxBins,
 		const IMultivariateRegressionProblem& baseProblem,
 		const CArray<int>& usedVectors, const CArray<int>& usedFeatures );
+	// Builds a subproblem from the binned data file written by WriteBinnedData
+	// The vector data is not loaded into memory but read from the mapped file on demand
+	CGradientBoostFastHistProblem( const char* binnedDataFileName,
+		const CArray<int>& usedVectors, const CArray<int>& usedFeatures );
+
+	// Writes the binned data of the problem loaded by parts to a file
+	// The feature values are collected for a block of features at a time and the vector data is written
+	// as soon as it is calculated, so neither the problem nor the binned data set has to fit into memory
+	// The vectors with zero weight are skipped, as in training
+	static void WriteBinnedData( int threadCount, int maxBins, const IGradientBoostProblemParts& parts,
+		const char* fileName );
 
+	// Checks if the vector data is read from the binned data file
+	bool IsBinnedDataFile() const { return binnedDataFile.IsOpen(); }
+	// Gets the vector with the feature values replaced by the cut values of their bins
+	// The trees built on this problem give the same predictions for it as for the original vector
+	// The vector data is kept in the given buffers
+	void GetBinnedVector( int index, CArray<int>& indexesBuffer, CArray<float>& valuesBuffer,
+		CFloatVectorDesc& vector ) const;
+
+	// Gets the total number of vectors in the data
+	int GetVectorCount() const { return vectorCount; }
 	// Gets the number of vectors used
 	int GetUsedVectorCount() const { return usedVectors.Size(); }
 	// Gets the pointer to the vector data
 	const int* GetUsedVectorDataPtr( int index ) const;
 	// Gets the size of the vector data
 	int GetUsedVectorDataSize( int index ) const;
+	// Tells that the data of the given used vectors will be needed soon
+	// Has effect only if the data is read from a file
+	void PrefetchUsedVectorData( const int* indexes, int count ) const;
 
 	// Gets the number of features
 	int GetFeatureCount() const { return nullValueIds.Size(); }
@@ -73,14 +113,25 @@ private:
 	CArray<int> featureIndexes; // the indices of the feature to which the identifier belongs
 	CArray<float> cuts; // the cut values for histograms
 	CArray<int> nullValueIds; // the identifiers of the zero feature values
-	CArray<int> vectorData; // the vector data
-	CArray<int> vectorPtr; // the pointers to the data of the given vector
+	int vectorCount; // the total number of vectors
+	const int* vectorData; // the vector data
+	const __int64* vectorPtr; // the pointers to the data of the given vector
+	CArray<int> vectorDataBuffer; // the vector data if it is kept in memory
+	CArray<__int64> vectorPtrBuffer; // the pointers to the vector data if it is kept in memory
+	CMemoryMappedFile binnedDataFile; // the binned data file if the vector data is read from it
+
+	CGradientBoostFastHistProblem( const CArray<int>& usedVectors, const CArray<int>& usedFeatures );
 
-	void initializeFeatureInfo( int threadCount, int maxBins, const CFloatMatrixDesc& matrix,
-		const IMultivariateRegressionProblem& baseProblem );
+	void initializeFeatureInfo( int threadCount, int maxBins, const IGradientBoostProblemParts& parts,
+		__int64 maxBlockElementCount );
+	void addFeatureInfo( int threadCount, int maxBins, const IGradientBoostProblemParts& parts,
+		int firstFeature, int lastFeature );
 	void compressFeatureValues( int threadCount, int maxBins, double totalWeight,
 		CArray< CArray<CFeatureValue> >& featureValues );
+	void getVectorData( const CFloatVectorDesc& vector, CArray<int>& data ) const;
 	void buildVectorData( const CFloatMatrixDesc& matrix );
+	void writeBinnedData( const IGradientBoostProblemParts& parts, const char* fileName ) const;
+	void loadBinnedData( const char* fileName );
 };
 
 } // namespace NeoML
@@ -27,10 +27,14 @@ CGradientBoostFastHistTreeBuilder<T>::CGradientBoostFastHistTreeBuilder( const C
 	params( _params ),
 	logStream( _logStream ),
 	predictionSize( _predictionSize  ),
-	histSize( NotFound )
+	histSize( NotFound ),
+	maxHistCount( NotFound ),
+	histUseTime( 0 )
 {
 	NeoAssert( params.MaxTreeDepth > 0 );
 	NeoAssert( params.MaxNodesCount > 0 || params.MaxNodesCount == NotFound );
+	NeoAssert( params.MaxLeavesCount > 1 || params.MaxLeavesCount == NotFound );
+	NeoAssert( params.MaxHistCount > 1 || params.MaxHistCount == NotFound );
 	NeoAssert( abs( params.MinSubsetHessian ) > 0 );
 	NeoAssert( params.ThreadCount > 0 );
 	NeoAssert( params.MaxBins > 1 );
@@ -57,8 +61,31 @@ CPtr<CRegressionTree> CGradientBoostFastHistTreeBuilder<T>::Build( const CGradie
 	buildHist( problem, root, gradients, hessians, weights, root.Statistics );
 	nodes.Empty();
 	nodes.Add( root );
+	useHist( root.HistPtr, 0 );
 
-	// Building the tree using depth-first search, which needs less memory for histograms
+	if( params.MaxLeavesCount == NotFound ) {
+		buildDepthFirst( problem, gradients, hessians, weights );
+	} else {
+		buildLeafWise( problem, gradients, hessians, weights );
+	}
+
+	if( logStream != 0 ) {
+		*logStream << L"\nGradient boost float problem tree building finished:\n";
+	}
+
+	// Pruning
+	if( params.PruneCriterionValue != 0 ) {
+		prune( 0 );
+	}
+
+	return buildTree( 0, problem.GetFeatureIndexes(), problem.GetFeatureCuts() ).Ptr();
+}
+
+// Builds the tree from the root using depth-first search, which needs less memory for histograms
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::buildDepthFirst( const CGradientBoostFastHistProblem& problem,
+	const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights )
+{
 	nodeStack.Empty();
 	nodeStack.Add( 0 );
 
@@ -70,7 +97,8 @@ CPtr<CRegressionTree> CGradientBoostFastHistTreeBuilder<T>::Build( const CGradie
 		nodeStack.DeleteLast();
 
 		// Calculating the best identifier for the split
-		nodes[node].SplitFeatureId = evaluateSplit( problem, nodes[node] );
+		double gain = 0;
+		nodes[node].SplitFeatureId = evaluateSplit( problem, nodes[node], gain );
 		if( nodes[node].SplitFeatureId != NotFound ) {
 			// The split is possible
 			if( logStream != 0 ) {
@@ -88,22 +116,7 @@ CPtr<CRegressionTree> CGradientBoostFastHistTreeBuilder<T>::Build( const CGradie
 			nodeStack.Add( leftNode );
 			nodes[node].Right = rightNode;
 			nodeStack.Add( rightNode );
-			// Building the smaller histogram and generating the other one by substraction
-			if( nodes[leftNode].VectorSetSize < nodes[rightNode].VectorSetSize ) {
-				nodes[leftNode].HistPtr = allocHist();
-				buildHist( problem, nodes[leftNode], gradients, hessians, weights, nodes[leftNode].Statistics );
-				subHist( nodes[node].HistPtr, nodes[leftNode].HistPtr );
-				nodes[rightNode].HistPtr = nodes[node].HistPtr;
-				nodes[rightNode].Statistics = nodes[node].Statistics;
-				nodes[rightNode].Statistics.Sub( nodes[leftNode].Statistics );
-			} else {
-				nodes[rightNode].HistPtr = allocHist();
-				buildHist( problem, nodes[rightNode], gradients, hessians, weights, nodes[rightNode].Statistics );
-				subHist( nodes[node].HistPtr, nodes[rightNode].HistPtr );
-				nodes[leftNode].HistPtr = nodes[node].HistPtr;
-				nodes[leftNode].Statistics = nodes[node].Statistics;
-				nodes[leftNode].Statistics.Sub( nodes[rightNode].Statistics );
-			}
+			buildChildHists( problem, node, leftNode, rightNode, gradients, hessians, weights );
 		} else {
 			// The node could not be split
 			if( logStream != 0 ) {
@@ -114,19 +127,67 @@ CPtr<CRegressionTree> CGradientBoostFastHistTreeBuilder<T>::Build( const CGradie
 			freeHist( nodes[node].HistPtr );
 			nodes[node].HistPtr = NotFound;
 		}
-		
 	}
+}
 
-	if( logStream != 0 ) {
-		*logStream << L"\nGradient boost float problem tree building finished:\n";
-	}
+// Builds the tree from the root splitting the leaf with the largest gain first, until MaxLeavesCount leaves are created
+// Such a tree reaches the same loss with fewer nodes than the one built depth-first
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::buildLeafWise( const CGradientBoostFastHistProblem& problem,
+	const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights )
+{
+	leafQueue.Reset();
+	addLeafCandidate( problem, 0 );
 
-	// Pruning
-	if( params.PruneCriterionValue != 0 ) {
-		prune( 0 );
+	const CArray<int>& featureIndexes = problem.GetFeatureIndexes();
+	const CArray<float>& cuts = problem.GetFeatureCuts();
+	int leavesCount = 1;
+	CLeafCandidate candidate;
+	while( leavesCount < params.MaxLeavesCount
+		&& ( params.MaxNodesCount == NotFound || nodes.Size() + 2 <= params.MaxNodesCount )
+		&& leafQueue.Pop( candidate ) )
+	{
+		const int node = candidate.Node;
+		nodes[node].SplitFeatureId = candidate.SplitFeatureId;
+		if( logStream != 0 ) {
+			*logStream << L"Split result: index = " << featureIndexes[nodes[node].SplitFeatureId]
+				<< L" threshold = " << cuts[nodes[node].SplitFeatureId]
+				<< L", criterion = " << nodes[node].Statistics.CalcCriterion( params.L1RegFactor, params.L2RegFactor )
+				<< L", gain = " << candidate.Gain
+				<< L" \n";
+		}
+
+		int leftNode = NotFound;
+		int rightNode = NotFound;
+		applySplit( problem, node, leftNode, rightNode );
+		nodes[node].Left = leftNode;
+		nodes[node].Right = rightNode;
+		buildChildHists( problem, node, leftNode, rightNode, gradients, hessians, weights );
+		leavesCount++;
+
+		addLeafCandidate( problem, leftNode );
+		addLeafCandidate( problem, rightNode );
 	}
+}
 
-	return buildTree( 0, featureIndexes, cuts ).Ptr();
+// Finds the best split of the leaf and puts it into the queue of the leaves to be split
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::addLeafCandidate( const CGradientBoostFastHistProblem& problem, int node )
+{
+	double gain = 0;
+	const int splitFeatureId = evaluateSplit( problem, nodes[node], gain );
+	if( splitFeatureId != NotFound ) {
+		leafQueue.Push( CLeafCandidate( gain, node, splitFeatureId ) );
+	} else {
+		// The node could not be split
+		if( logStream != 0 ) {
+			*logStream << L"Split result: created const node.\t\t"
+				<< L"criterion = " << nodes[node].Statistics.CalcCriterion( params.L1RegFactor, params.L2RegFactor )
+				<< L" \n";
+		}
+		freeHist( nodes[node].HistPtr );
+		nodes[node].HistPtr = NotFound;
+	}
 }
 
 // Initializes the array of node vector sets
@@ -159,31 +220,72 @@ void CGradientBoostFastHistTreeBuilder<T>::initHistData( const CGradientBoostFas
 		}
 	}
 
-	// The histogram size of tree depth + 1 is sufficient
-	histStats.Add( T( predictionSize ), histSize * ( params.MaxTreeDepth + 1 ) );
-	freeHists.Empty();
-	for( int i = 0; i <= params.MaxTreeDepth; i++ ) {
-		freeHists.Add( i * histSize ); // a histogram is identified by the pointer to its start in the histData array
+	histNodes.DeleteAll();
+	histLastUse.DeleteAll();
+	histUseTime = 0;
+	freeHists.DeleteAll();
+	histStats.DeleteAll();
+	if( params.MaxLeavesCount == NotFound ) {
+		// The histogram size of tree depth + 1 is sufficient
+		maxHistCount = params.MaxTreeDepth + 1;
+		histStats.Add( T( predictionSize ), histSize * maxHistCount );
+		histNodes.Add( NotFound, maxHistCount );
+		histLastUse.Add( 0, maxHistCount );
+		for( int i = 0; i < maxHistCount; i++ ) {
+			freeHists.Add( i * histSize );
+		}
+	} else {
+		// A histogram is kept for each leaf that may be split, the pool grows on demand
+		maxHistCount = params.MaxHistCount;
 	}
 }
 
 // Gets a free histogram 
-// A histogram is identified by the pointer to its start in the histData array
+// If the pool is full, the least recently used histogram is evicted from its node
 template<class T>
 int CGradientBoostFastHistTreeBuilder<T>::allocHist()
 {
-	NeoAssert( !freeHists.IsEmpty() );
+	if( !freeHists.IsEmpty() ) {
+		const int result = freeHists.Last();
+		freeHists.DeleteLast();
+		return result;
+	}
 
-	int result = freeHists.Last();
-	freeHists.DeleteLast();
-	return result;
+	const int histCount = histNodes.Size();
+	if( maxHistCount == NotFound || histCount < maxHistCount ) {
+		histStats.Add( T( predictionSize ), histSize );
+		histNodes.Add( NotFound );
+		histLastUse.Add( 0 );
+		return histCount * histSize;
+	}
+
+	int evicted = NotFound;
+	for( int i = 0; i < histCount; i++ ) {
+		if( histNodes[i] != NotFound && ( evicted == NotFound || histLastUse[i] < histLastUse[evicted] ) ) {
+			evicted = i;
+		}
+	}
+	NeoAssert( evicted != NotFound );
+	nodes[histNodes[evicted]].HistPtr = NotFound;
+	histNodes[evicted] = NotFound;
+	return evicted * histSize;
+}
+
+// Marks the histogram as belonging to the node
+// The histogram may be evicted from the node by allocHist
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::useHist( int ptr, int node )
+{
+	const int index = ptr / histSize;
+	histNodes[index] = node;
+	histLastUse[index] = ++histUseTime;
 }
 
 // Free the unnecessary histogram
-// A histogram is identified by the pointer to its start in the histData array
 template<class T>
 void CGradientBoostFastHistTreeBuilder<T>::freeHist( int ptr )
 {
+	histNodes[ptr / histSize] = NotFound;
 	freeHists.Add( ptr );
 }
 
@@ -196,6 +298,39 @@ void CGradientBoostFastHistTreeBuilder<T>::subHist( int firstPtr, int secondPtr
 	}
 }
 
+// Builds the histograms of the child nodes after the split
+// The histogram of the smaller child is built on its vectors and the other one is obtained by subtracting it from the parent's
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::buildChildHists( const CGradientBoostFastHistProblem& problem,
+	int node, int leftNode, int rightNode,
+	const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights )
+{
+	const int smallNode = nodes[leftNode].VectorSetSize < nodes[rightNode].VectorSetSize ? leftNode : rightNode;
+	const int largeNode = smallNode == leftNode ? rightNode : leftNode;
+
+	const int parentHistPtr = nodes[node].HistPtr;
+	nodes[node].HistPtr = NotFound;
+	if( parentHistPtr != NotFound ) {
+		// The parent histogram may not be evicted while it is used
+		histNodes[parentHistPtr / histSize] = NotFound;
+	}
+
+	nodes[smallNode].HistPtr = allocHist();
+	buildHist( problem, nodes[smallNode], gradients, hessians, weights, nodes[smallNode].Statistics );
+	useHist( nodes[smallNode].HistPtr, smallNode );
+	if( parentHistPtr != NotFound ) {
+		subHist( parentHistPtr, nodes[smallNode].HistPtr );
+		nodes[largeNode].HistPtr = parentHistPtr;
+		nodes[largeNode].Statistics = nodes[node].Statistics;
+		nodes[largeNode].Statistics.Sub( nodes[smallNode].Statistics );
+	} else {
+		// The parent histogram has been evicted from the pool, so the other histogram is built on its vectors as well
+		nodes[largeNode].HistPtr = allocHist();
+		buildHist( problem, nodes[largeNode], gradients, hessians, weights, nodes[largeNode].Statistics );
+	}
+	useHist( nodes[largeNode].HistPtr, largeNode );
+}
+
 // Build a histogram on the vectors of the given node
 template<class T>
 void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHistProblem& problem, const CNode& node,
@@ -223,17 +358,25 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 			tempHistStats[i].Erase();
 		}
 
-		NEOML_OMP_NUM_THREADS(params.ThreadCount)
-		{
-			const int threadNumber = OmpGetThreadNum();
-			NeoAssert( threadNumber < params.ThreadCount );
-			int i = threadNumber;
-			while( i < node.VectorSetSize ) {
-				const int vectorIndex = vectorSet[node.VectorSetPtr + i];
-				addVectorToHist( problem.GetUsedVectorDataPtr( vectorIndex ), problem.GetUsedVectorDataSize( vectorIndex ),
-					gradients, hessians, weights, tempHistStats.GetPtr() + histSize * threadNumber, vectorIndex );
-				results[threadNumber].Add( gradients, hessians, weights, vectorIndex );
-				i += params.ThreadCount;
+		// The vectors are processed in blocks so that the data of the next block could be prefetched
+		// The block size is a multiple of the number of threads, so each thread processes the same vectors
+		const int blockSize = PrefetchBlockSize * params.ThreadCount;
+		prefetchVectorData( problem, node, 0, blockSize );
+		for( int blockStart = 0; blockStart < node.VectorSetSize; blockStart += blockSize ) {
+			prefetchVectorData( problem, node, blockStart + blockSize, blockSize );
+			const int blockEnd = min( blockStart + blockSize, node.VectorSetSize );
+			NEOML_OMP_NUM_THREADS(params.ThreadCount)
+			{
+				const int threadNumber = OmpGetThreadNum();
+				NeoAssert( threadNumber < params.ThreadCount );
+				int i = blockStart + threadNumber;
+				while( i < blockEnd ) {
+					const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+					addVectorToHist( problem.GetUsedVectorDataPtr( vectorIndex ), problem.GetUsedVectorDataSize( vectorIndex ),
+						gradients, hessians, weights, tempHistStats.GetPtr() + histSize * threadNumber, vectorIndex );
+					results[threadNumber].Add( gradients, hessians, weights, vectorIndex );
+					i += params.ThreadCount;
+				}
 			}
 		}
 
@@ -252,6 +395,9 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 	} else {
 		// There are few vectors in the set, build the histogram using only one thread
 		for( int i = 0; i < node.VectorSetSize; i++ ) {
+			if( i % PrefetchBlockSize == 0 ) {
+				prefetchVectorData( problem, node, i, PrefetchBlockSize );
+			}
 			const int vectorIndex = vectorSet[node.VectorSetPtr + i];
 			addVectorToHist( problem.GetUsedVectorDataPtr( vectorIndex ), problem.GetUsedVectorDataSize( vectorIndex ),
 				gradients, hessians, weights, histStatsPtr, vectorIndex );
@@ -276,6 +422,17 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 	}
 }
 
+// Tells the problem that the data of the node vectors from the given range will be needed soon
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::prefetchVectorData( const CGradientBoostFastHistProblem& problem,
+	const CNode& node, int start, int count ) const
+{
+	if( start < node.VectorSetSize ) {
+		problem.PrefetchUsedVectorData( vectorSet.GetPtr() + node.VectorSetPtr + start,
+			min( count, node.VectorSetSize - start ) );
+	}
+}
+
 // Adds a vector to the histogram
 template<class T>
 void CGradientBoostFastHistTreeBuilder<T>::addVectorToHist( const int* vectorPtr, int vectorSize,
@@ -292,20 +449,24 @@ void CGradientBoostFastHistTreeBuilder<T>::addVectorToHist( const int* vectorPtr
 	}
 }
 
-// Calculates the optimal feature value for splitting the node
+// Calculates the optimal feature value for splitting the node and the criterion gain of such split
 // Returns NotFound if splitting is impossible
 template<class T>
-int CGradientBoostFastHistTreeBuilder<T>::evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node ) const
+int CGradientBoostFastHistTreeBuilder<T>::evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node,
+	double& gain ) const
 {
+	gain = 0;
 	if( ( params.MaxNodesCount != NotFound && nodes.Size() + 2 > params.MaxNodesCount )
 	    || ( node.Level >= params.MaxTreeDepth ) ) {
 		// The nodes limit has been reached
 		return NotFound;
 	}
+	NeoPresume( node.HistPtr != NotFound );
 
 	const CArray<int>& usedFeatures = problem.GetUsedFeatures();
 	const CArray<int>& featurePos = problem.GetFeaturePos();
-	double bestValue = node.Statistics.CalcCriterion( params.L1RegFactor, params.L2RegFactor );
+	const double nodeValue = node.Statistics.CalcCriterion( params.L1RegFactor, params.L2RegFactor );
+	double bestValue = nodeValue;
 	const T* histStatsPtr = histStats.GetPtr() + node.HistPtr;
 
 	// Initializing the search results for each thread
@@ -363,6 +524,9 @@ int CGradientBoostFastHistTreeBuilder<T>::evaluateSplit( const CGradientBoostFas
 			result = threadBestFeature;
 		}
 	}
+	if( result != NotFound ) {
+		gain = bestValue - nodeValue;
+	}
 	return result;
 }
 
@@ -35,6 +35,8 @@ struct CGradientBoostFastHistTreeBuilderParams {
 	float PruneCriterionValue; // the value of criterion difference when the nodes should be merged (set to 0 to never merge)
 	int MaxNodesCount; // the maximum number of nodes in a tree (set to NotFound == -1 for no limitation)
 	int MaxBins; // the maximum histogram size for a feature
+	int MaxLeavesCount; // the maximum number of leaves for the leaf-wise growth (set to NotFound == -1 to grow depth-first)
+	int MaxHistCount; // the maximum number of histograms kept for the leaf-wise growth (set to NotFound == -1 for no limitation)
 	float MinSubsetWeight; // the minimum subtree weight
 	float DenseTreeBoostCoefficient; // the dense tree boost coefficient 
 };
@@ -53,6 +55,9 @@ protected:
 	virtual ~CGradientBoostFastHistTreeBuilder() {} // delete prohibited
 
 private:
+	// The number of vectors per thread for which the data is prefetched at once
+	static const int PrefetchBlockSize = 16 * 1024;
+
 	const CGradientBoostFastHistTreeBuilderParams params; // classifier parameters
 	CTextStream* const logStream; // the logging stream
 
@@ -79,13 +84,39 @@ private:
 		{}
 	};
 
+	// A leaf that may be split during the leaf-wise growth
+	struct CLeafCandidate {
+		double Gain; // the criterion gain of the best split
+		int Node; // the leaf node
+		int SplitFeatureId; // the identifier of the feature value for the best split
+
+		CLeafCandidate() : Gain( 0 ), Node( NotFound ), SplitFeatureId( NotFound ) {}
+		CLeafCandidate( double gain, int node, int splitFeatureId ) : Gain( gain ), Node( node ), SplitFeatureId( splitFeatureId ) {}
+	};
+
+	// The candidates comparer: the leaf with the largest gain has the highest priority
+	// The earlier created leaf wins in case of equal gains so that the result does not depend on the queue order
+	class CLeafCandidateGainAscending {
+	public:
+		bool Predicate( const CLeafCandidate& first, const CLeafCandidate& second ) const
+			{ return first.Gain < second.Gain || ( first.Gain == second.Gain && first.Node > second.Node ); }
+	};
+
 	int predictionSize; // size of prediction value in leaves
 	int histSize; // histogram size
 	CArray<CNode> nodes; // the final tree nodes
 	CArray<int> nodeStack; // the stack used to build the tree using depth-first search
+	// The leaves to be split during the leaf-wise growth
+	CPriorityQueue<CArray<CLeafCandidate>, CLeafCandidateGainAscending> leafQueue;
 	CArray<int> vectorSet; // the array that stores the vector sets for the nodes
+	// The histograms pool
+	// A histogram is identified by the pointer to its start in the histStats array
+	int maxHistCount; // the maximum number of histograms in the pool (NotFound for no limitation)
 	CArray<int> freeHists; // free histograms list
 	CArray<T> histStats; // the array for storing histograms
+	CArray<int> histNodes; // the node that owns each histogram (NotFound if the histogram may not be evicted)
+	CArray<int> histLastUse; // the time of the last use of each histogram
+	int histUseTime; // the current time for histLastUse
 	CArray<int> idPos; // the identifier positions in the current histogram
 	CArray<T> tempHistStats; // a temporary array for building histograms
 
@@ -93,17 +124,26 @@ private:
 	mutable CArray<double> splitGainsByThreadBuffer;
 	mutable CArray<int> splitIdsBuffer;
 
+	void buildDepthFirst( const CGradientBoostFastHistProblem& problem,
+		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights );
+	void buildLeafWise( const CGradientBoostFastHistProblem& problem,
+		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights );
+	void addLeafCandidate( const CGradientBoostFastHistProblem& problem, int node );
 	void initVectorSet( int size );
 	void initHistData( const CGradientBoostFastHistProblem& problem );
 	int allocHist();
+	void useHist( int ptr, int node );
 	void freeHist( int ptr );
 	void subHist( int firstPtr, int secondPtr );
+	void buildChildHists( const CGradientBoostFastHistProblem& problem, int node, int leftNode, int rightNode,
+		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights );
 	void buildHist( const CGradientBoostFastHistProblem& problem, const CNode& node,
 		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
 		T& stats );
+	void prefetchVectorData( const CGradientBoostFastHistProblem& problem, const CNode& node, int start, int count ) const;
 	void addVectorToHist( const int* vectorPtr, int vectorSize, const CArray<typename T::Type>& gradients, 
 		const CArray<typename T::Type>& hessians, const CArray<double>& weights, T* stats, int vectorIndex );
-	int evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node ) const;
+	int evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node, double& gain ) const;
 	void applySplit( const CGradientBoostFastHistProblem& problem, int node, int& leftNode, int& rightNode );
 	bool prune( int node );
 	CPtr<CLinkedRegressionTree> buildTree( int node, const CArray<int>& featureIndexes, const CArray<float>& cuts ) const;
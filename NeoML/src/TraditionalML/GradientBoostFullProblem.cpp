@@ -67,20 +67,22 @@ void CGradientBoostFullProblem::Update()
 	featurePos.Empty();
 	featurePos.Add( NotFound, usedFeatures.Size() );
 
-	int curDataSize = 0;
-	int curBinaryDataSize = 0;
+	__int64 curDataSize = 0;
+	__int64 curBinaryDataSize = 0;
 	for( int i = 0; i < usedFeatures.Size(); i++ ) {
 		if( isUsedFeatureBinary[i] ) {
-			featurePos[i] = curBinaryDataSize;
+			featurePos[i] = static_cast<int>( curBinaryDataSize );
 			curBinaryDataSize += featureValueCount[i];
 		} else {
-			featurePos[i] = curDataSize;
+			featurePos[i] = static_cast<int>( curDataSize );
 			curDataSize += featureValueCount[i];
 		}
+		// All the values are kept in memory arrays; use the FastHist builders for the larger problems
+		NeoAssert( curDataSize <= INT_MAX && curBinaryDataSize <= INT_MAX );
 	}
 
-	featureValues.SetSize( curDataSize );
-	binaryFeatureValues.SetSize( curBinaryDataSize );
+	featureValues.SetSize( static_cast<int>( curDataSize ) );
+	binaryFeatureValues.SetSize( static_cast<int>( curBinaryDataSize ) );
 
 	CArray<int> curFeaturePos;
 	featurePos.CopyTo( curFeaturePos );
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <GradientBoostModel.h>
 #include <CompactRegressionTree.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -52,6 +53,52 @@ bool CGradientBoostModel::Classify( const CFloatVectorDesc& data, CClassificatio
 	return classify( predictions, result );
 }
 
+// The number of rows processed together by the batch methods
+static const int PredictBatchBlockSize = 64;
+
+bool CGradientBoostModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	if( valueSize > 1 ) {
+		// The multi-class trees are applied row by row
+		return IModel::ClassifyBatch( data, results, threadCount );
+	}
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+
+	const int ensembleCount = ensembles.Size();
+	const int blockCount = ( data.Height + PredictBatchBlockSize - 1 ) / PredictBatchBlockSize;
+	const int curThreadCount = IsOmpRelevant( blockCount ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int block = 0; block < blockCount; block++ ) {
+		const int firstRow = block * PredictBatchBlockSize;
+		const int rowCount = min( PredictBatchBlockSize, data.Height - firstRow );
+		CFloatVectorDesc rows[PredictBatchBlockSize];
+		for( int i = 0; i < rowCount; i++ ) {
+			data.GetRow( firstRow + i, rows[i] );
+		}
+
+		CArray<double> blockPredictions;
+		blockPredictions.SetSize( ensembleCount * PredictBatchBlockSize );
+		for( int i = 0; i < ensembleCount; i++ ) {
+			predictRawBlock( ensembles[i], rows, rowCount, blockPredictions.GetPtr() + i * PredictBatchBlockSize );
+		}
+
+		CFastArray<double, 1> predictions;
+		for( int i = 0; i < rowCount; i++ ) {
+			predictions.SetSize( ensembleCount );
+			for( int j = 0; j < ensembleCount; j++ ) {
+				predictions[j] = blockPredictions[j * PredictBatchBlockSize + i];
+			}
+			classify( predictions, results[firstRow + i] );
+		}
+	}
+	return true;
+}
+
 void CGradientBoostModel::Serialize( CArchive& archive )
 {
 #ifdef NEOML_USE_FINEOBJ
@@ -243,6 +290,27 @@ double CGradientBoostModel::Predict( const CFloatVectorDesc& data ) const
 	return predictions[0];
 }
 
+void CGradientBoostModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	NeoAssert( ensembles.Size() == 1 && valueSize == 1 );
+	NeoAssert( threadCount > 0 );
+
+	results.SetSize( data.Height );
+
+	const int blockCount = ( data.Height + PredictBatchBlockSize - 1 ) / PredictBatchBlockSize;
+	const int curThreadCount = IsOmpRelevant( blockCount ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int block = 0; block < blockCount; block++ ) {
+		const int firstRow = block * PredictBatchBlockSize;
+		const int rowCount = min( PredictBatchBlockSize, data.Height - firstRow );
+		CFloatVectorDesc rows[PredictBatchBlockSize];
+		for( int i = 0; i < rowCount; i++ ) {
+			data.GetRow( firstRow + i, rows[i] );
+		}
+		predictRawBlock( ensembles.First(), rows, rowCount, results.GetPtr() + firstRow );
+	}
+}
+
 // IMultivariateRegressionModel interface method
 CFloatVector CGradientBoostModel::MultivariatePredict( const CFloatVectorDesc& data ) const
 {
@@ -269,6 +337,25 @@ CFloatVector CGradientBoostModel::MultivariatePredict( const CFloatVectorDesc& d
 	return result;
 }
 
+// Gets the predictions of an ensemble of single-value trees for a block of rows
+// Each tree is applied to all the rows before moving on to the next one, so that the tree stays in cache
+void CGradientBoostModel::predictRawBlock( const CGradientBoostEnsemble& ensemble, const CFloatVectorDesc* rows,
+	int rowCount, double* predictions ) const
+{
+	for( int i = 0; i < rowCount; i++ ) {
+		predictions[i] = 0;
+	}
+	for( int treeIndex = 0; treeIndex < ensemble.Size(); treeIndex++ ) {
+		const CRegressionTree* tree = static_cast<const CRegressionTree*>( ensemble[treeIndex].Ptr() );
+		for( int i = 0; i < rowCount; i++ ) {
+			predictions[i] += tree->Predict( rows[i] );
+		}
+	}
+	for( int i = 0; i < rowCount; i++ ) {
+		predictions[i] *= learningRate;
+	}
+}
+
 // Performs classification
 bool CGradientBoostModel::classify( CFastArray<double, 1>& predictions, CClassificationResult& result ) const
 {
@@ -39,6 +39,7 @@ public:
 	// IModel interface methods
 	int GetClassCount() const override { return ( valueSize == 1 && ensembles.Size() == 1 ) ? 2 : valueSize * ensembles.Size(); }
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const override;
 	void Serialize( CArchive& archive ) override;
 
 	// IGradientBoostModel inteface methods
@@ -53,6 +54,7 @@ public:
 
 	// IRegressionModel interface methods
 	double Predict( const CFloatVectorDesc& data ) const override;
+	void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const override;
 
 	// IMultivariateRegressionModel interface methods
 	CFloatVector MultivariatePredict( const CFloatVectorDesc& data ) const override;
@@ -64,6 +66,8 @@ private:
 	int valueSize; // the value size of each model, if valueSize > 1 then ensemble consists of multiclass trees
 
 	bool classify( CFastArray<double, 1>& predictions, CClassificationResult& result ) const;
+	void predictRawBlock( const CGradientBoostEnsemble& ensemble, const CFloatVectorDesc* rows, int rowCount,
+		double* predictions ) const;
 	double probability( double prediction ) const;
 };
 
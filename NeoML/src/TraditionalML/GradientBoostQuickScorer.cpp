@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <NeoML/TraditionalML/GradientBoostQuickScorer.h>
 #include <GradientBoostQSEnsemble.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -56,6 +57,7 @@ public:
 	// IGradientBoostQSModel interface methods
 	int GetClassCount() const override { return ensembles.Size() == 1 ? 2 : ensembles.Size(); };
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const override;
 
 	// IGradientBoostQSModel interface methods
 	bool ClassifyEx( const CSparseFloatVector& data, CArray<CClassificationResult>& results ) const override;
@@ -63,6 +65,7 @@ public:
 
 	// IRegressionModel interface method
 	double Predict( const CFloatVectorDesc& data ) const override;
+	void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const override;
 
 	// General methods
 	double GetLearningRate() const override { return learningRate; };
@@ -76,6 +79,7 @@ private:
 	bool classify( double prediction, CClassificationResult& result ) const;
 	bool classify( CArray<double>& predictions, CClassificationResult& result ) const;
 	double probability( double prediction ) const;
+	void predictBatch( const CFloatMatrixDesc& data, int threadCount, CArray<double>& predictions ) const;
 };
 
 REGISTER_NEOML_MODEL( CGradientBoostQSModel, GradientBoostQSModelName )
@@ -118,6 +122,45 @@ bool CGradientBoostQSModel::Classify( const CFloatVectorDesc& data, CClassificat
 	return classify( predictions, result );
 }
 
+bool CGradientBoostQSModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	CArray<double> predictions;
+	predictBatch( data, threadCount, predictions );
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+
+	const int ensembleCount = ensembles.Size();
+	const int curThreadCount = IsOmpRelevant( data.Height ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int i = 0; i < data.Height; i++ ) {
+		if( GetClassCount() == 2 ) {
+			classify( predictions[i] * learningRate, results[i] );
+		} else {
+			CArray<double> rowPredictions;
+			rowPredictions.SetSize( ensembleCount );
+			for( int j = 0; j < ensembleCount; j++ ) {
+				rowPredictions[j] = predictions[i * ensembleCount + j];
+			}
+			classify( rowPredictions, results[i] );
+		}
+	}
+	return true;
+}
+
+void CGradientBoostQSModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	CArray<double> predictions;
+	predictBatch( data, threadCount, predictions );
+
+	results.SetSize( data.Height );
+	const int ensembleCount = ensembles.Size();
+	for( int i = 0; i < data.Height; i++ ) {
+		results[i] = predictions[i * ensembleCount] * learningRate;
+	}
+}
+
 bool CGradientBoostQSModel::ClassifyEx( const CSparseFloatVector& data, CArray<CClassificationResult>& results ) const
 {
 	return ClassifyEx( data.GetDesc(), results );
@@ -170,6 +213,37 @@ void CGradientBoostQSModel::Serialize( CArchive& archive )
 	archive.SerializeEnum( lossFunction );
 }
 
+// The number of rows given to one thread at a time by predictBatch
+static const int QSPredictBatchBlockSize = 256;
+
+// Calculates the raw predictions of all the ensembles for all the rows
+// predictions[i * ensembles.Size() + j] is the prediction of the j-th ensemble for the i-th row
+// The rows are scored one by one: checking each node for several rows at once (V-QuickScorer) has turned out slower
+// without wide vector registers, as the node loop then stops only when the condition fails for all the rows
+void CGradientBoostQSModel::predictBatch( const CFloatMatrixDesc& data, int threadCount, CArray<double>& predictions ) const
+{
+	NeoAssert( threadCount > 0 );
+	NeoAssert( !ensembles.IsEmpty() );
+
+	const int ensembleCount = ensembles.Size();
+	predictions.SetSize( data.Height * ensembleCount );
+
+	const int blockCount = ( data.Height + QSPredictBatchBlockSize - 1 ) / QSPredictBatchBlockSize;
+	const int curThreadCount = IsOmpRelevant( blockCount ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int block = 0; block < blockCount; block++ ) {
+		const int firstRow = block * QSPredictBatchBlockSize;
+		const int lastRow = min( firstRow + QSPredictBatchBlockSize, data.Height );
+		for( int i = firstRow; i < lastRow; i++ ) {
+			CFloatVectorDesc row;
+			data.GetRow( i, row );
+			for( int j = 0; j < ensembleCount; j++ ) {
+				predictions[i * ensembleCount + j] = ensembles[j]->Predict( row );
+			}
+		}
+	}
+}
+
 // Performs binary classification
 bool CGradientBoostQSModel::classify( double prediction, CClassificationResult& result ) const
 {
@@ -17,15 +17,50 @@ limitations under the License.
 #pragma hdrstop
 
 #include <NeoML/TraditionalML/HierarchicalClustering.h>
+#include <NeoMathEngine/OpenMP.h>
 #include <float.h>
 
 namespace NeoML {
 
+// Sorts the merges by distance, keeping the order of the merges with equal distances
+class CMergeDistanceAscending {
+public:
+	explicit CMergeDistanceAscending( const CArray<float>& _distances ) : distances( _distances ) {}
+
+	bool Predicate( int first, int second ) const
+		{ return distances[first] < distances[second] || ( distances[first] == distances[second] && first < second ); }
+	bool IsEqual( int first, int second ) const { return first == second; }
+	void Swap( int& first, int& second ) const { swap( first, second ); }
+
+private:
+	const CArray<float>& distances;
+};
+
+// Finds the set of the initial cluster
+static int findClusterSet( CArray<int>& parents, int cluster )
+{
+	int root = cluster;
+	while( parents[root] != root ) {
+		root = parents[root];
+	}
+	while( parents[cluster] != root ) {
+		const int next = parents[cluster];
+		parents[cluster] = root;
+		cluster = next;
+	}
+	return root;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
 CHierarchicalClustering::CHierarchicalClustering( const CArray<CClusterCenter>& clustersCenters, const CParam& _params ) :
 	params( _params ),
 	log( 0 )
 {
 	NeoAssert( params.MinClustersCount > 0 );
+	NeoAssert( params.Linkage >= 0 && params.Linkage < L_Count );
+	NeoAssert( params.Linkage != L_Ward || params.DistanceType == DF_Euclid );
+	NeoAssert( params.ThreadCount > 0 );
 	clustersCenters.CopyTo( initialClusters );
 }
 
@@ -34,6 +69,9 @@ CHierarchicalClustering::CHierarchicalClustering( const CParam& _params ) :
 	log( 0 )
 {
 	NeoAssert( params.MinClustersCount > 0 );
+	NeoAssert( params.Linkage >= 0 && params.Linkage < L_Count );
+	NeoAssert( params.Linkage != L_Ward || params.DistanceType == DF_Euclid );
+	NeoAssert( params.ThreadCount > 0 );
 }
 
 bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResult& result )
@@ -63,36 +101,8 @@ bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResu
 		}
 	}
 
-	bool success = false;
-	const int initialClustersCount = clusters.Size();
-	while( true ) {
-		if( log != 0 ) {
-			*log << "\n[Step " << initialClustersCount - clusters.Size() << "]\n";
-		}
-
-		if( clusters.Size() <= params.MinClustersCount ) {
-			break;
-		}
-
-		int first = NotFound;
-		int second = NotFound;
-		findNearestClusters( first, second );
-
-		if( log != 0 ) {
-			*log << "Distance: " << distances[first][second] << "\n";
-		}
-
-		if( distances[first][second] > params.MaxClustersDistance ) {
-			success = true;
-			break;
-		}
-
-		if( log != 0 ) {
-			*log << "Merge clusters (" << first << ") and (" << second << ") distance - " << distances[first][second] << "\n";
-		}
-
-		mergeClusters( matrix, weights, first, second );
-	}
+	const bool success = params.Linkage == L_Centroid ? clusterizeCentroid( matrix, weights )
+		: clusterizeLinkage( matrix, weights );
 
 	result.ClusterCount = clusters.Size();
 	result.Data.SetSize( data->GetVectorCount() );
@@ -107,6 +117,9 @@ bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResu
 		result.Clusters.Add( clusters[i]->GetCenter() );
 	}
 
+	distances.DeleteAll();
+	nearestClusters.DeleteAll();
+
 	if( log != 0 ) {
 		if( success ) {
 			*log << "\nSuccessful!\n";
@@ -124,15 +137,19 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 	const int vectorsCount = matrix.Height;
 
 	// Define the initial cluster set
+	clusters.DeleteAll();
+	clusterWeights.DeleteAll();
 	if( initialClusters.IsEmpty() ) {
 		// Each element is a cluster
 		clusters.SetBufferSize( vectorsCount );
+		clusterWeights.SetBufferSize( vectorsCount );
 		for( int i = 0; i < vectorsCount; i++ ) {
 			CFloatVectorDesc desc;
 			matrix.GetRow( i, desc );
 			CFloatVector mean( matrix.Width, desc );
 			clusters.Add( FINE_DEBUG_NEW CCommonCluster( CClusterCenter( mean ) ) );
 			clusters.Last()->Add( i, desc, weights[i] );
+			clusterWeights.Add( weights[i] );
 		}
 	} else {
 		// The initial cluster centers have been specified directly
@@ -140,6 +157,7 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 		for( int i = 0; i < initialClusters.Size(); i++ ) {
 			clusters.Add( FINE_DEBUG_NEW CCommonCluster( initialClusters[i] ) );
 		}
+		clusterWeights.Add( 0., clusters.Size() );
 
 		// Each element of the original data set is put into the nearest cluster
 		for( int i = 0; i < vectorsCount; i++ ) {
@@ -158,6 +176,7 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 
 			NeoAssert( nearestCluster == i );
 			clusters[nearestCluster]->Add( i, desc, weights[i] );
+			clusterWeights[nearestCluster] += weights[i];
 		}
 
 		for( int i = 0; i < clusters.Size(); i++ ) {
@@ -168,13 +187,104 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 	NeoAssert( !clusters.IsEmpty() );
 
 	// Initialize the cluster distance matrix
+	// The rows get shorter towards the end, so they are distributed among the threads one by one
+	const int clustersCount = clusters.Size();
 	distances.DeleteAll();
-	distances.Add( CFloatVector( clusters.Size() ), clusters.Size() );
-	for( int i = 0; i < clusters.Size(); i++ ) {
-		for( int j = i + 1; j < clusters.Size(); j++ ) {
-			distances[i].SetAt( j, static_cast<float>( clusters[i]->CalcDistance( *clusters[j], params.DistanceType ) ) );
+	distances.SetSize( clustersCount );
+	const int curThreadCount = IsOmpRelevant( clustersCount, static_cast<int64_t>( clustersCount ) * clustersCount / 2 )
+		? params.ThreadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		const int threadNumber = OmpGetThreadNum();
+		const int threadCount = OmpGetThreadCount();
+		for( int i = threadNumber; i < clustersCount; i += threadCount ) {
+			CArray<float>& row = distances[i];
+			row.SetSize( clustersCount - i - 1 );
+			for( int j = i + 1; j < clustersCount; j++ ) {
+				row[j - i - 1] = static_cast<float>( clusters[i]->CalcDistance( *clusters[j], params.DistanceType ) );
+			}
+		}
+	}
+}
+
+// Gets the distance between two clusters
+inline float CHierarchicalClustering::getDistance( int first, int second ) const
+{
+	NeoPresume( first != second );
+	if( first > second ) {
+		swap( first, second );
+	}
+	return distances[first][second - first - 1];
+}
+
+// Sets the distance between two clusters
+inline void CHierarchicalClustering::setDistance( int first, int second, float distance )
+{
+	NeoPresume( first != second );
+	if( first > second ) {
+		swap( first, second );
+	}
+	distances[first][second - first - 1] = distance;
+}
+
+// Merges the clusters with the closest centers until the stop criterion is met
+bool CHierarchicalClustering::clusterizeCentroid( const CFloatMatrixDesc& matrix, const CArray<double>& weights )
+{
+	// The nearest neighbors of all clusters
+	nearestClusters.SetSize( clusters.Size() );
+	const int curThreadCount = IsOmpRelevant( clusters.Size(), static_cast<int64_t>( clusters.Size() ) * clusters.Size() / 2 )
+		? params.ThreadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		const int threadNumber = OmpGetThreadNum();
+		const int threadCount = OmpGetThreadCount();
+		for( int i = threadNumber; i < clusters.Size(); i += threadCount ) {
+			findNearestCluster( i );
+		}
+	}
+
+	const int initialClustersCount = clusters.Size();
+	while( true ) {
+		if( log != 0 ) {
+			*log << "\n[Step " << initialClustersCount - clusters.Size() << "]\n";
+		}
+
+		if( clusters.Size() <= params.MinClustersCount ) {
+			return false;
+		}
+
+		int first = NotFound;
+		int second = NotFound;
+		findNearestClusters( first, second );
+		const float distance = getDistance( first, second );
+
+		if( log != 0 ) {
+			*log << "Distance: " << distance << "\n";
+		}
+
+		if( distance > params.MaxClustersDistance ) {
+			return true;
+		}
+
+		if( log != 0 ) {
+			*log << "Merge clusters (" << first << ") and (" << second << ") distance - " << distance << "\n";
+		}
+
+		mergeClusters( matrix, weights, first, second );
+	}
+}
+
+// Finds the nearest of the clusters with larger indices (the first one if there are several)
+void CHierarchicalClustering::findNearestCluster( int cluster )
+{
+	const float* row = distances[cluster].GetPtr();
+	int nearest = NotFound;
+	for( int j = cluster + 1; j < clusters.Size(); j++ ) {
+		if( nearest == NotFound || row[j - cluster - 1] < row[nearest - cluster - 1] ) {
+			nearest = j;
 		}
 	}
+	nearestClusters[cluster] = nearest;
 }
 
 // Finds the two closest clusters
@@ -183,13 +293,11 @@ void CHierarchicalClustering::findNearestClusters( int& first, int& second ) con
 	NeoAssert( clusters.Size() > 1 );
 
 	first = 0;
-	second = 1;
-	for( int i = 0; i < clusters.Size(); i++ ) {
-		for( int j = i + 1; j < clusters.Size(); j++ ) {
-			if( distances[i][j] < distances[first][second] ) {
-				first = i;
-				second = j;
-			}
+	second = nearestClusters[0];
+	for( int i = 1; i < clusters.Size() - 1; i++ ) {
+		if( getDistance( i, nearestClusters[i] ) < getDistance( first, second ) ) {
+			first = i;
+			second = nearestClusters[i];
 		}
 	}
 }
@@ -208,34 +316,58 @@ void CHierarchicalClustering::mergeClusters( const CFloatMatrixDesc& matrix, con
 	}
 
 	// Move all elements of the second cluster into the first
-	CArray<int> secondClustersElements;
-	clusters[second]->GetAllElements( secondClustersElements );
-	for( int i = 0; i < secondClustersElements.Size(); i++ ) {
-		CFloatVectorDesc desc;
-		matrix.GetRow( secondClustersElements[i], desc );
-		clusters[first]->Add( secondClustersElements[i], desc, weights[secondClustersElements[i]] );
-	}
+	addClusterElements( matrix, weights, first, second );
 	clusters[first]->RecalcCenter();
 
 	// Switch the second cluster with the last; now we can calculate the cluster distance matrix in linear time
 	const int last = clusters.Size() - 1;
 	clusters[second] = clusters[last];
-	distances[second] = distances[last];
+	clusterWeights[second] = clusterWeights[last];
 	for( int i = 0; i < second; i++ ) {
-		distances[i].SetAt( second, distances[i][last] );
+		setDistance( i, second, getDistance( i, last ) );
 	}
 	for( int i = second + 1; i < last; i++ ) {
-		distances[second].SetAt( i, distances[i][last] );
+		setDistance( second, i, getDistance( i, last ) );
 	}
+	const int curThreadCount = IsOmpRelevant( last, static_cast<int64_t>( last ) * matrix.Width ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
 	for( int i = 0; i < last; i++ ) {
-		const double distance = clusters[first]->CalcDistance( *clusters[i], params.DistanceType );
-		if( i < first ) {
-			distances[i].SetAt( first, static_cast<float>( distance ) );
-		} else {
-			distances[first].SetAt( i, static_cast<float>( distance ) );
+		if( i != first ) {
+			setDistance( first, i, static_cast<float>( clusters[first]->CalcDistance( *clusters[i], params.DistanceType ) ) );
 		}
 	}
 	clusters.SetSize( last );
+	clusterWeights.SetSize( last );
+	distances[last].FreeBuffer();
+
+	// Update the nearest neighbors
+	// Only the distances to the first and second clusters have changed,
+	// so the other neighbors are checked against these two
+	CArray<int> changedClusters;
+	for( int i = 0; i < last; i++ ) {
+		const int nearest = nearestClusters[i];
+		if( i == first || i == second || nearest == first || nearest == second || nearest == last ) {
+			changedClusters.Add( i );
+		} else {
+			for( int j = 0; j < 2; j++ ) {
+				const int cluster = j == 0 ? first : second;
+				if( cluster > i && cluster < last ) {
+					const float distance = getDistance( i, cluster );
+					const float nearestDistance = getDistance( i, nearestClusters[i] );
+					if( distance < nearestDistance || ( distance == nearestDistance && cluster < nearestClusters[i] ) ) {
+						nearestClusters[i] = cluster;
+					}
+				}
+			}
+		}
+	}
+	const int curNearestThreadCount = IsOmpRelevant( changedClusters.Size(),
+		static_cast<int64_t>( changedClusters.Size() ) * last ) ? params.ThreadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curNearestThreadCount )
+	for( int i = 0; i < changedClusters.Size(); i++ ) {
+		findNearestCluster( changedClusters[i] );
+	}
+	nearestClusters.SetSize( last );
 
 	if( log != 0 ) {
 		*log << "Result:\n";
@@ -243,4 +375,204 @@ void CHierarchicalClustering::mergeClusters( const CFloatMatrixDesc& matrix, con
 	}
 }
 
+// Merges the clusters using the linkage distance until the stop criterion is met
+// The whole merge tree is built first with the nearest-neighbor chain algorithm,
+// then the merges are applied in the order of increasing distance
+bool CHierarchicalClustering::clusterizeLinkage( const CFloatMatrixDesc& matrix, const CArray<double>& weights )
+{
+	const int initialClustersCount = clusters.Size();
+	CArray<CMerge> merges;
+	buildDendrogram( merges );
+	distances.DeleteAll();
+
+	CArray<float> mergeDistances;
+	CArray<int> mergeOrder;
+	mergeDistances.SetBufferSize( merges.Size() );
+	mergeOrder.SetBufferSize( merges.Size() );
+	for( int i = 0; i < merges.Size(); i++ ) {
+		mergeDistances.Add( merges[i].Distance );
+		mergeOrder.Add( i );
+	}
+	CMergeDistanceAscending comparator( mergeDistances );
+	mergeOrder.QuickSort( &comparator );
+
+	// Each set is identified by one of its initial clusters
+	CArray<int> parents;
+	parents.SetBufferSize( initialClustersCount );
+	for( int i = 0; i < initialClustersCount; i++ ) {
+		parents.Add( i );
+	}
+
+	bool success = false;
+	int clustersCount = initialClustersCount;
+	for( int step = 0; ; step++ ) {
+		if( log != 0 ) {
+			*log << "\n[Step " << step << "]\n";
+		}
+
+		if( clustersCount <= params.MinClustersCount ) {
+			break;
+		}
+
+		const CMerge& merge = merges[mergeOrder[step]];
+		if( log != 0 ) {
+			*log << "Distance: " << merge.Distance << "\n";
+		}
+
+		if( merge.Distance > params.MaxClustersDistance ) {
+			success = true;
+			break;
+		}
+
+		if( log != 0 ) {
+			*log << "Merge clusters (" << merge.First << ") and (" << merge.Second << ") distance - "
+				<< merge.Distance << "\n";
+		}
+
+		const int firstSet = findClusterSet( parents, merge.First );
+		const int secondSet = findClusterSet( parents, merge.Second );
+		NeoAssert( firstSet != secondSet );
+		parents[max( firstSet, secondSet )] = min( firstSet, secondSet );
+		clustersCount--;
+	}
+
+	// Build the resulting clusters; each one is put at the place of its initial cluster with the smallest index
+	CArray<int> resultClusters;
+	resultClusters.Add( NotFound, initialClustersCount );
+	int resultCount = 0;
+	for( int i = 0; i < initialClustersCount; i++ ) {
+		const int set = findClusterSet( parents, i );
+		if( set == i ) {
+			resultClusters[i] = resultCount;
+			clusters[resultCount] = clusters[i];
+			resultCount++;
+		} else {
+			addClusterElements( matrix, weights, resultClusters[set], i );
+		}
+	}
+	NeoAssert( resultCount == clustersCount );
+	clusters.SetSize( resultCount );
+	clusterWeights.DeleteAll();
+	for( int i = 0; i < clusters.Size(); i++ ) {
+		clusters[i]->RecalcCenter();
+	}
+
+	if( log != 0 ) {
+		*log << "Result:\n";
+		for( int i = 0; i < clusters.Size(); i++ ) {
+			*log << *clusters[i] << "\n";
+		}
+	}
+	return success;
+}
+
+// Builds the full merge tree using the nearest-neighbor chain algorithm
+// The merged cluster takes the place of the one with the smaller index
+void CHierarchicalClustering::buildDendrogram( CArray<CMerge>& merges )
+{
+	const int clustersCount = clusters.Size();
+	merges.DeleteAll();
+	merges.SetBufferSize( clustersCount - 1 );
+
+	CArray<bool> isActive;
+	isActive.Add( true, clustersCount );
+	CArray<int> chain;
+	int firstActive = 0;
+	while( merges.Size() < clustersCount - 1 ) {
+		if( chain.IsEmpty() ) {
+			while( !isActive[firstActive] ) {
+				firstActive++;
+			}
+			chain.Add( firstActive );
+		}
+
+		// Grow the chain until two clusters are the nearest neighbors of each other
+		// The previous cluster in the chain is preferred in case of ties so that the chain always stops
+		int current = NotFound;
+		int nearest = NotFound;
+		float nearestDistance = 0;
+		while( true ) {
+			current = chain.Last();
+			const int previous = chain.Size() > 1 ? chain[chain.Size() - 2] : NotFound;
+			nearest = previous;
+			nearestDistance = previous == NotFound ? 0 : getDistance( current, previous );
+			for( int i = 0; i < clustersCount; i++ ) {
+				if( i != current && isActive[i] ) {
+					const float distance = getDistance( current, i );
+					if( nearest == NotFound || distance < nearestDistance ) {
+						nearest = i;
+						nearestDistance = distance;
+					}
+				}
+			}
+			if( nearest == previous ) {
+				break;
+			}
+			chain.Add( nearest );
+		}
+		chain.SetSize( chain.Size() - 2 );
+
+		const int first = min( current, nearest );
+		const int second = max( current, nearest );
+		merges.Add( CMerge( first, second, nearestDistance ) );
+
+		// Update the distances to the merged cluster
+		isActive[second] = false;
+		for( int i = 0; i < clustersCount; i++ ) {
+			if( i != first && isActive[i] ) {
+				setDistance( first, i, calcLinkageDistance( clusterWeights[first], clusterWeights[second], clusterWeights[i],
+					getDistance( first, i ), getDistance( second, i ), nearestDistance ) );
+			}
+		}
+		clusterWeights[first] += clusterWeights[second];
+		distances[second].FreeBuffer();
+	}
+}
+
+// Calculates the distance from the other cluster to the union of the first and second clusters (Lance-Williams formula)
+float CHierarchicalClustering::calcLinkageDistance( double firstWeight, double secondWeight, double otherWeight,
+	float firstDistance, float secondDistance, float distance ) const
+{
+	switch( params.Linkage ) {
+		case L_Single:
+			return min( firstDistance, secondDistance );
+		case L_Complete:
+			return max( firstDistance, secondDistance );
+		case L_Average:
+		{
+			const double totalWeight = firstWeight + secondWeight;
+			if( totalWeight <= 0 ) {
+				return ( firstDistance + secondDistance ) / 2;
+			}
+			return static_cast<float>( ( firstWeight * firstDistance + secondWeight * secondDistance ) / totalWeight );
+		}
+		case L_Ward:
+		{
+			const double totalWeight = firstWeight + secondWeight + otherWeight;
+			if( totalWeight <= 0 ) {
+				return ( firstDistance + secondDistance ) / 2;
+			}
+			return static_cast<float>( ( ( firstWeight + otherWeight ) * firstDistance
+				+ ( secondWeight + otherWeight ) * secondDistance - otherWeight * distance ) / totalWeight );
+		}
+		case L_Centroid:
+		default:
+			NeoAssert( false );
+	}
+	return 0;
+}
+
+// Moves all elements of the source cluster into the target one; the target center is not recalculated
+void CHierarchicalClustering::addClusterElements( const CFloatMatrixDesc& matrix, const CArray<double>& weights,
+	int target, int source )
+{
+	CArray<int> sourceElements;
+	clusters[source]->GetAllElements( sourceElements );
+	for( int i = 0; i < sourceElements.Size(); i++ ) {
+		CFloatVectorDesc desc;
+		matrix.GetRow( sourceElements[i], desc );
+		clusters[target]->Add( sourceElements[i], desc, weights[sourceElements[i]] );
+	}
+}
+
 } // namespace NeoML
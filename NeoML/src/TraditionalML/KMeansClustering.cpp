@@ -37,7 +37,7 @@ static CPtr<CDnnBlob> createDataBlob( IMathEngine& mathEngine, const CFloatMatri
 	CPtr<CDnnBlob> result = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, vectorCount, featureCount );
 	CFloatHandle currData = result->GetData();
 	for( int row = 0; row < data.Height; ++row ) {
-		mathEngine.DataExchangeTyped( currData, data.Values + data.PointerB[row], featureCount );
+		mathEngine.DataExchangeTyped( currData, data.Values + data.GetRowBegin( row ), featureCount );
 		currData += featureCount;
 	}
 	return result;
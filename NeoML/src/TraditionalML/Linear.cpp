@@ -110,6 +110,13 @@ CPtr<IRegressionModel> CLinear::TrainRegression( const IRegressionProblem& probl
 	return FINE_DEBUG_NEW CLinearBinaryModel( plane, sigmoidCoefficients );
 }
 
+ITrainingModel* CLinear::CreateCopy( int threadCount ) const
+{
+	CParams copyParams = params;
+	copyParams.ThreadCount = threadCount;
+	return FINE_DEBUG_NEW CLinear( copyParams );
+}
+
 CPtr<IModel> CLinear::Train( const IProblem& trainingClassificationData )
 {
 	if( trainingClassificationData.GetClassCount() > 2 ) {
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <LinearBinaryModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -37,6 +38,22 @@ bool CLinearBinaryModel::Classify( const CFloatVectorDesc& data, CClassification
 	return classify( distance, result );
 }
 
+bool CLinearBinaryModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	CArray<double> distances;
+	PredictBatch( data, distances, threadCount );
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+	const int curThreadCount = IsOmpRelevant( data.Height ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int i = 0; i < data.Height; i++ ) {
+		classify( distances[i], results[i] );
+	}
+	return true;
+}
+
 // Calculates classification result from the distance to the separating plane
 bool CLinearBinaryModel::classify( double distance, CClassificationResult& result ) const
 {
@@ -76,4 +93,26 @@ double CLinearBinaryModel::Predict( const CFloatVectorDesc& data ) const
 	return LinearFunction( plane, data );
 }
 
+// Multiplies the matrix by the plane (the last plane element is the free term)
+void CLinearBinaryModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	results.SetSize( data.Height );
+
+	const int curThreadCount = IsOmpRelevant( data.Height, static_cast<int64_t>( data.Height ) * data.Width ) ? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, index, count ) ) {
+			CFloatVectorDesc row;
+			for( int i = index; i < index + count; i++ ) {
+				data.GetRow( i, row );
+				results[i] = LinearFunction( plane, row );
+			}
+		}
+	}
+}
+
 } // namespace NeoML
@@ -31,6 +31,7 @@ public:
 	// IModel interface methods
 	int GetClassCount() const override { return 2; }
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const override;
 	void Serialize( CArchive& archive ) override;
 
 	// ILinearBinaryModel interface methods
@@ -39,6 +40,7 @@ public:
 
 	// IRegressionModel interface method
 	double Predict( const CFloatVectorDesc& data ) const override;
+	void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const override;
 
 protected:
 	virtual ~CLinearBinaryModel() {} // delete prohibited
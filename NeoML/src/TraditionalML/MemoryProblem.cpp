@@ -39,7 +39,7 @@ void CVectorData::Serialize( CArchive& archive )
 
 //------------------------------------------------------------------------------------------------------------
 
-CMemoryProblem::CMemoryProblem( int _featureCount, int _classCount, int rowsBufferSize, int elementsBufferSize ) :
+CMemoryProblem::CMemoryProblem( int _featureCount, int _classCount, int rowsBufferSize, __int64 elementsBufferSize ) :
 	matrix( _featureCount, rowsBufferSize, elementsBufferSize ),
 	classCount( _classCount ),
 	featureCount( _featureCount )
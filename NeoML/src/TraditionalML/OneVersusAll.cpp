@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <NeoML/TraditionalML/OneVersusAll.h>
 #include <OneVersusAllModel.h>
+#include <TrainingModelCopies.h>
 
 namespace NeoML {
 
@@ -54,7 +55,8 @@ inline COneVersusAllTrainingData::COneVersusAllTrainingData( const IProblem* _da
 
 COneVersusAll::COneVersusAll( ITrainingModel& _baseBinaryClassifier ) :
 	baseBinaryClassifier( _baseBinaryClassifier ),
-	logStream( 0 )
+	logStream( 0 ),
+	threadCount( 1 )
 {
 }
 
@@ -64,11 +66,16 @@ CPtr<IModel> COneVersusAll::Train( const IProblem& trainingClassificationData )
 		*logStream << "\nOne versus all training started:\n";
 	}
 
+	const int classCount = trainingClassificationData.GetClassCount();
 	CObjectArray<IModel> etalons;
-	for( int i = 0; i < trainingClassificationData.GetClassCount(); i++ ) {
+	etalons.SetSize( classCount );
+
+	// Each thread takes the next class when it finishes the previous one
+	CTrainingModelCopies trainingModels( baseBinaryClassifier, threadCount, classCount );
+	trainingModels.Run( classCount, [&]( ITrainingModel& trainingModel, int i ) {
 		CPtr<IProblem> trainingData = FINE_DEBUG_NEW COneVersusAllTrainingData( &trainingClassificationData, i );
-		etalons.Add( baseBinaryClassifier.Train( *trainingData ) );
-	}
+		etalons[i] = trainingModel.Train( *trainingData );
+	} );
 
 	if( logStream != 0 ) {
 		*logStream << "\nOne versus all training finished\n";
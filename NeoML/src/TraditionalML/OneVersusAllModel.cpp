@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <OneVersusAllModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -36,31 +37,39 @@ int COneVersusAllModel::GetClassCount() const
 	return classifiers.Size();
 }
 
-bool COneVersusAllModel::ClassifyEx( const CFloatVectorDesc& data,
-	COneVersusAllClassificationResult& result ) const
+// Fills the result from the probabilities returned by the binary classifiers
+// Returns the sum of these probabilities
+static double fillResult( const double* probability, int classCount, CClassificationResult& result )
 {
-	CArray<double> probability;
-	result.SigmoidSum = 0.0;
+	double sigmoidSum = 0.0;
 	int preferedClass = 0;
-
-	for( int i = 0; i < classifiers.Size(); i++ ) {
-		CClassificationResult curResult;
-		NeoAssert( classifiers[i]->Classify( data, curResult ) );
-		const double curClassProbability = curResult.Probabilities[0].GetValue();
-		probability.Add( curClassProbability );
-		result.SigmoidSum += curClassProbability;
-
-		if( curClassProbability > probability[preferedClass] ) {
+	for( int i = 0; i < classCount; i++ ) {
+		sigmoidSum += probability[i];
+		if( probability[i] > probability[preferedClass] ) {
 			preferedClass = i;
 		}
 	}
 
 	result.ExceptionProbability = CClassificationProbability( 0 );
 	result.PreferredClass = preferedClass;
-	result.Probabilities.SetSize( probability.Size() );
-	for( int i = 0; i < probability.Size(); i++ ) {
-		result.Probabilities[i] = CClassificationProbability( probability[i] / result.SigmoidSum );
+	result.Probabilities.SetSize( classCount );
+	for( int i = 0; i < classCount; i++ ) {
+		result.Probabilities[i] = CClassificationProbability( probability[i] / sigmoidSum );
 	}
+	return sigmoidSum;
+}
+
+bool COneVersusAllModel::ClassifyEx( const CFloatVectorDesc& data,
+	COneVersusAllClassificationResult& result ) const
+{
+	CArray<double> probability;
+	for( int i = 0; i < classifiers.Size(); i++ ) {
+		CClassificationResult curResult;
+		NeoAssert( classifiers[i]->Classify( data, curResult ) );
+		probability.Add( curResult.Probabilities[0].GetValue() );
+	}
+
+	result.SigmoidSum = fillResult( probability.GetPtr(), probability.Size(), result );
 	return true;
 }
 
@@ -86,6 +95,41 @@ bool COneVersusAllModel::Classify( const CFloatVectorDesc& data, CClassification
 	return true;
 }
 
+// The number of rows passed to the binary classifiers at once by ClassifyBatch
+static const int ClassifyBatchChunkSize = 4096;
+
+bool COneVersusAllModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+
+	const int classCount = classifiers.Size();
+	CArray<double> probability; // the probabilities of the rows of the chunk, classCount per row
+	CArray<CClassificationResult> binaryResults;
+	for( int firstRow = 0; firstRow < data.Height; firstRow += ClassifyBatchChunkSize ) {
+		const int rowCount = min( ClassifyBatchChunkSize, data.Height - firstRow );
+		const CFloatMatrixDesc chunk = data.GetRows( firstRow, rowCount );
+
+		probability.SetSize( rowCount * classCount );
+		for( int i = 0; i < classCount; i++ ) {
+			NeoAssert( classifiers[i]->ClassifyBatch( chunk, binaryResults, threadCount ) );
+			for( int j = 0; j < rowCount; j++ ) {
+				probability[j * classCount + i] = binaryResults[j].Probabilities[0].GetValue();
+			}
+		}
+
+		const int curThreadCount = IsOmpRelevant( rowCount ) ? threadCount : 1;
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int j = 0; j < rowCount; j++ ) {
+			fillResult( probability.GetPtr() + j * classCount, classCount, results[firstRow + j] );
+		}
+	}
+	return true;
+}
+
 void COneVersusAllModel::Serialize( CArchive& archive )
 {
 #ifdef NEOML_USE_FINEOBJ
@@ -31,6 +31,7 @@ public:
 	// IModel interface methods
 	int GetClassCount() const override;
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const override;
 	void Serialize( CArchive& archive ) override;
 
 	// IOneVersusAllModel interface methods
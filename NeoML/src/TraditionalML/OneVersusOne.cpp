@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <NeoML/TraditionalML/OneVersusOne.h>
 #include <OneVersusOneModel.h>
+#include <TrainingModelCopies.h>
 
 namespace NeoML {
 
@@ -43,6 +44,8 @@ private:
 	CFloatMatrixDesc desc; // matrix descriptor
 	CArray<int> rowStart; // row starts in matrix
 	CArray<int> rowEnd; // row ends in matrix
+	CArray<__int64> rowStart64; // row starts in matrix if it uses 64-bit indices
+	CArray<__int64> rowEnd64; // row ends in matrix if it uses 64-bit indices
 	CArray<int> vectorIndices; // indices of vectors in base problem
 };
 
@@ -61,13 +64,23 @@ COneVersusOneTrainingData::COneVersusOneTrainingData( const IProblem& data, int
 		const int currClass = baseProblem->GetClass( vecIndex );
 		if( currClass == firstClass || currClass == secondClass ) {
 			desc.Height++;
-			rowStart.Add( baseDesc.PointerB[vecIndex] );
-			rowEnd.Add( baseDesc.PointerE[vecIndex] );
+			if( baseDesc.Is64Bit() ) {
+				rowStart64.Add( baseDesc.PointerB64[vecIndex] );
+				rowEnd64.Add( baseDesc.PointerE64[vecIndex] );
+			} else {
+				rowStart.Add( baseDesc.PointerB[vecIndex] );
+				rowEnd.Add( baseDesc.PointerE[vecIndex] );
+			}
 			vectorIndices.Add( vecIndex );
 		}
 	}
-	desc.PointerB = rowStart.GetPtr();
-	desc.PointerE = rowEnd.GetPtr();
+	if( baseDesc.Is64Bit() ) {
+		desc.PointerB64 = rowStart64.GetPtr();
+		desc.PointerE64 = rowEnd64.GetPtr();
+	} else {
+		desc.PointerB = rowStart.GetPtr();
+		desc.PointerE = rowEnd.GetPtr();
+	}
 }
 
 int COneVersusOneTrainingData::GetClass( int index ) const
@@ -81,7 +94,8 @@ int COneVersusOneTrainingData::GetClass( int index ) const
 
 COneVersusOne::COneVersusOne( ITrainingModel& _baseClassifier ) :
 	baseClassifier( _baseClassifier ),
-	log( nullptr )
+	log( nullptr ),
+	threadCount( 1 )
 {
 }
 
@@ -91,15 +105,27 @@ CPtr<IModel> COneVersusOne::Train( const IProblem& trainingData )
 		*log << "\nOne versus one traning started:\n";
 	}
 
-	CObjectArray<IModel> classifiers;
 	const int classCount = trainingData.GetClassCount();
+	CArray<int> firstClasses;
+	CArray<int> secondClasses;
 	for( int firstClass = 0; firstClass < classCount - 1; ++firstClass ) {
 		for( int secondClass = firstClass + 1; secondClass < classCount; ++secondClass ) {
-			CPtr<IProblem> subproblem = FINE_DEBUG_NEW COneVersusOneTrainingData( trainingData, firstClass, secondClass );
-			classifiers.Add( baseClassifier.Train( *subproblem ) );
+			firstClasses.Add( firstClass );
+			secondClasses.Add( secondClass );
 		}
 	}
 
+	const int pairCount = firstClasses.Size();
+	CObjectArray<IModel> classifiers;
+	classifiers.SetSize( pairCount );
+
+	// Each thread takes the next pair of classes when it finishes the previous one
+	CTrainingModelCopies trainingModels( baseClassifier, threadCount, pairCount );
+	trainingModels.Run( pairCount, [&]( ITrainingModel& trainingModel, int i ) {
+		CPtr<IProblem> subproblem = FINE_DEBUG_NEW COneVersusOneTrainingData( trainingData, firstClasses[i], secondClasses[i] );
+		classifiers[i] = trainingModel.Train( *subproblem );
+	} );
+
 	if( log != nullptr ) {
 		*log << "\nOne versus one training finished\n";
 	}
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <OneVersusOneModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -131,16 +132,9 @@ static void findProb( const CArray<CArray<float>>& pred, CArray<float>& prob )
 	}
 }
 
-//---------------------------------------------------------------------------------------------------------
-
-COneVersusOneModel::COneVersusOneModel( CObjectArray<IModel>& _classifiers ) :
-	classCount( getClassCount( _classifiers.Size() ) )
-{
-	NeoAssert( !_classifiers.IsEmpty() );
-	_classifiers.MoveTo( classifiers );
-}
-
-bool COneVersusOneModel::Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const
+// Calculates the result from the probabilities returned by the binary classifiers
+// binaryProbabilities contains the probabilities of the first and the second class for each of the classifiers
+static void calcResult( const float* binaryProbabilities, int classCount, CClassificationResult& result )
 {
 	CArray<CArray<float>> pred;
 	pred.SetSize( classCount );
@@ -151,17 +145,16 @@ bool COneVersusOneModel::Classify( const CFloatVectorDesc& data, CClassification
 	int classifierIndex = 0;
 	for( int i = 0; i < classCount - 1; ++i ) {
 		for( int j = i + 1; j < classCount; ++j ) {
-			CClassificationResult subresult;
-			NeoAssert( classifiers[classifierIndex++]->Classify( data, subresult ) );
-			NeoPresume( subresult.Probabilities.Size() == 2 );
-			pred[i][j] = static_cast<float>( subresult.Probabilities[0].GetValue() );
-			pred[j][i] = static_cast<float>( subresult.Probabilities[1].GetValue() );
+			pred[i][j] = binaryProbabilities[2 * classifierIndex];
+			pred[j][i] = binaryProbabilities[2 * classifierIndex + 1];
+			classifierIndex++;
 		}
 	}
 
 	CArray<float> prob;
 	findProb( pred, prob );
 	result.ExceptionProbability = CClassificationProbability( 0 );
+	result.Probabilities.DeleteAll();
 	result.Probabilities.SetBufferSize( classCount );
 	result.PreferredClass = 0;
 	for( int i = 0; i < classCount; ++i ) {
@@ -170,7 +163,69 @@ bool COneVersusOneModel::Classify( const CFloatVectorDesc& data, CClassification
 			result.PreferredClass = i;
 		}
 	}
+}
+
+//---------------------------------------------------------------------------------------------------------
 
+COneVersusOneModel::COneVersusOneModel( CObjectArray<IModel>& _classifiers ) :
+	classCount( getClassCount( _classifiers.Size() ) )
+{
+	NeoAssert( !_classifiers.IsEmpty() );
+	_classifiers.MoveTo( classifiers );
+}
+
+bool COneVersusOneModel::Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const
+{
+	CArray<float> binaryProbabilities;
+	binaryProbabilities.SetSize( 2 * classifiers.Size() );
+	for( int i = 0; i < classifiers.Size(); ++i ) {
+		CClassificationResult subresult;
+		NeoAssert( classifiers[i]->Classify( data, subresult ) );
+		NeoPresume( subresult.Probabilities.Size() == 2 );
+		binaryProbabilities[2 * i] = static_cast<float>( subresult.Probabilities[0].GetValue() );
+		binaryProbabilities[2 * i + 1] = static_cast<float>( subresult.Probabilities[1].GetValue() );
+	}
+
+	calcResult( binaryProbabilities.GetPtr(), classCount, result );
+	return true;
+}
+
+// The number of rows passed to the binary classifiers at once by ClassifyBatch
+static const int ClassifyBatchChunkSize = 4096;
+
+bool COneVersusOneModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+
+	const int classifierCount = classifiers.Size();
+	// The probabilities for the rows of the chunk, 2 * classifierCount per row
+	CArray<float> binaryProbabilities;
+	CArray<CClassificationResult> binaryResults;
+	for( int firstRow = 0; firstRow < data.Height; firstRow += ClassifyBatchChunkSize ) {
+		const int rowCount = min( ClassifyBatchChunkSize, data.Height - firstRow );
+		const CFloatMatrixDesc chunk = data.GetRows( firstRow, rowCount );
+
+		binaryProbabilities.SetSize( 2 * classifierCount * rowCount );
+		for( int i = 0; i < classifierCount; ++i ) {
+			NeoAssert( classifiers[i]->ClassifyBatch( chunk, binaryResults, threadCount ) );
+			for( int j = 0; j < rowCount; ++j ) {
+				NeoPresume( binaryResults[j].Probabilities.Size() == 2 );
+				float* rowProbabilities = binaryProbabilities.GetPtr() + 2 * ( j * classifierCount + i );
+				rowProbabilities[0] = static_cast<float>( binaryResults[j].Probabilities[0].GetValue() );
+				rowProbabilities[1] = static_cast<float>( binaryResults[j].Probabilities[1].GetValue() );
+			}
+		}
+
+		const int curThreadCount = IsOmpRelevant( rowCount ) ? threadCount : 1;
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int j = 0; j < rowCount; ++j ) {
+			calcResult( binaryProbabilities.GetPtr() + 2 * j * classifierCount, classCount, results[firstRow + j] );
+		}
+	}
 	return true;
 }
 
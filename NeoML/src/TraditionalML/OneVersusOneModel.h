@@ -33,6 +33,7 @@ public:
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
 	bool Classify( const CFloatVector& data, CClassificationResult& result ) const override
 		{ return Classify( data.GetDesc(), result ); }
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const override;
 	void Serialize( CArchive& archive ) override;
 
 protected:
@@ -136,10 +136,17 @@ CNotNullWeightsView<TProblem>::CNotNullWeightsView( const TProblem* problem ) :
 		ViewMatrixDesc.Height -= nullWeightElementsCount;
 		if( nullWeightElementsCount > 0 && ViewMatrixDesc.Height > 0 ) {
 			// we are going to remap some elements, so let's create our own arrays of pointers
-			pointerB.SetSize( ViewMatrixDesc.Height );
-			pointerE.SetSize( ViewMatrixDesc.Height );
-			ViewMatrixDesc.PointerB = pointerB.GetPtr();
-			ViewMatrixDesc.PointerE = pointerE.GetPtr();
+			if( ViewMatrixDesc.Is64Bit() ) {
+				pointerB64.SetSize( ViewMatrixDesc.Height );
+				pointerE64.SetSize( ViewMatrixDesc.Height );
+				ViewMatrixDesc.PointerB64 = pointerB64.GetPtr();
+				ViewMatrixDesc.PointerE64 = pointerE64.GetPtr();
+			} else {
+				pointerB.SetSize( ViewMatrixDesc.Height );
+				pointerE.SetSize( ViewMatrixDesc.Height );
+				ViewMatrixDesc.PointerB = pointerB.GetPtr();
+				ViewMatrixDesc.PointerE = pointerE.GetPtr();
+			}
 
 			nullWeightElementsCount = 0 ;
 			notNullWeightElementsIndices.SetBufferSize( ViewMatrixDesc.Height );
@@ -149,8 +156,13 @@ CNotNullWeightsView<TProblem>::CNotNullWeightsView( const TProblem* problem ) :
 					++nullWeightElementsCount;
 				} else {
 					notNullWeightElementsIndices.Add( iScanned );
-					ViewMatrixDesc.PointerB[i] = problem->GetMatrix().PointerB[iScanned];
-					ViewMatrixDesc.PointerE[i] = problem->GetMatrix().PointerE[iScanned];
+					if( ViewMatrixDesc.Is64Bit() ) {
+						ViewMatrixDesc.PointerB64[i] = problem->GetMatrix().PointerB64[iScanned];
+						ViewMatrixDesc.PointerE64[i] = problem->GetMatrix().PointerE64[iScanned];
+					} else {
+						ViewMatrixDesc.PointerB[i] = problem->GetMatrix().PointerB[iScanned];
+						ViewMatrixDesc.PointerE[i] = problem->GetMatrix().PointerE[iScanned];
+					}
 					++i;
 				}
 			}
@@ -137,6 +137,8 @@ private:
 	int nullWeightElementsCount;
 	CArray<int> pointerB;
 	CArray<int> pointerE;
+	CArray<__int64> pointerB64;
+	CArray<__int64> pointerE64;
 };
 
 template<class TProblem>
@@ -23,6 +23,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <SMOptimizer.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -185,9 +186,10 @@ void CKernelCache::SwapIndices( int i, int j )
 }
 
 // The kernel matrix CKernelMatrix(i, j) = K(i, j) * y_i * y_j
+// The missing parts of the columns are calculated by several threads
 class CKernelMatrix {
 public:
-	CKernelMatrix( const IProblem& data, const CSvmKernel& kernel, int cacheSize );
+	CKernelMatrix( const IProblem& data, const CSvmKernel& kernel, int cacheSize, int threadCount );
 
 	// Gets the pointer to a column
 	const float* GetColumn( int i, int len ) const;
@@ -200,6 +202,8 @@ public:
 
 private:
 	CSvmKernel kernel; // the SVM kernel
+	const int threadCount; // the number of threads used to calculate the columns
+	const int featureCount; // the number of features
 	mutable CKernelCache cache; // the columns cache
 	CArray<CFloatVectorDesc> matrix; // the problem data
 	CFloatVectorDesc* x; // raw pointer to data
@@ -209,8 +213,10 @@ private:
 	double* d; // raw pointer to diagonal
 };
 
-CKernelMatrix::CKernelMatrix( const IProblem& data, const CSvmKernel& kernel, int cacheSize ) :
+CKernelMatrix::CKernelMatrix( const IProblem& data, const CSvmKernel& kernel, int cacheSize, int _threadCount ) :
 	kernel(kernel), 
+	threadCount( _threadCount ),
+	featureCount( data.GetFeatureCount() ),
 	cache( data.GetVectorCount(), cacheSize * (1<<20) )
 {
 	matrix.SetSize( data.GetVectorCount() );
@@ -220,11 +226,17 @@ CKernelMatrix::CKernelMatrix( const IProblem& data, const CSvmKernel& kernel, in
 	diagonal.SetSize( data.GetVectorCount() );
 	d = diagonal.GetPtr();
 	// Calculate the matrix diagonal and fill the matrix with sparse vector descs
+	const CFloatMatrixDesc desc = data.GetMatrix();
 	for( int i = 0; i < diagonal.Size(); i++ ) {
-		auto& x_i = x[i];
 		y[i] = static_cast<float>( data.GetBinaryClass( i ) );
-		data.GetMatrix().GetRow( i, x_i );
-		d[i] = kernel.Calculate( x_i, x_i );
+		desc.GetRow( i, x[i] );
+	}
+	const int vectorCount = diagonal.Size();
+	const int curThreadCount = IsOmpRelevant( vectorCount, static_cast<int64_t>( vectorCount ) * featureCount )
+		? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int i = 0; i < vectorCount; i++ ) {
+		d[i] = kernel.Calculate( x[i], x[i] );
 	}
 }
 
@@ -246,17 +258,14 @@ const float* CKernelMatrix::GetColumn( int i, int len ) const
 			}
 		};
 
-		// set diagonal element if it's needed
-		if( i >= start && i < len ) {
-			for( int j = start; j < i; ++j ) {
-				calcData( j );
-			}
-			column[i] = static_cast<float>( d[i] );
-			for( int j = i+1; j < len; ++j ) {
-				calcData( j );
-			}
-		} else {
-			for( int j = start; j < len; ++j ) {
+		// Only the cache entry of the i column has been changed, so the others may be read from several threads
+		const int curThreadCount = IsOmpRelevant( len - start, static_cast<int64_t>( len - start ) * featureCount )
+			? threadCount : 1;
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int j = start; j < len; ++j ) {
+			if( j == i ) {
+				column[i] = static_cast<float>( d[i] );
+			} else {
 				calcData( j );
 			}
 		}
@@ -275,13 +284,14 @@ void CKernelMatrix::SwapIndices( int i, int j )
 //---------------------------------------------------------------------------------------------------
 
 CSMOptimizer::CSMOptimizer(const CSvmKernel& kernel, const IProblem& _data,
-		int _maxIter, double _errorWeight, double _tolerance, bool _doShrinking, int cacheSize) :
+		int _maxIter, double _errorWeight, double _tolerance, bool _doShrinking, int _threadCount, int cacheSize) :
 	data( &_data ),
 	maxIter( _maxIter ),
 	errorWeight( _errorWeight ),
 	tolerance( _tolerance ),
 	doShrinking( _doShrinking ),
-	kernelMatrix( FINE_DEBUG_NEW CKernelMatrix( _data, kernel, cacheSize ) ),
+	threadCount( _threadCount ),
+	kernelMatrix( FINE_DEBUG_NEW CKernelMatrix( _data, kernel, cacheSize, _threadCount ) ),
 	log( nullptr ),
 	vectorCount( data->GetVectorCount() ),
 	y( kernelMatrix->GetBinaryClasses() ),
@@ -292,6 +302,13 @@ CSMOptimizer::CSMOptimizer(const CSvmKernel& kernel, const IProblem& _data,
 		weightsMultErrorWeightArray.Add( data->GetVectorWeight( i ) * errorWeight );
 	}
 	weightsMultErrorWeight = weightsMultErrorWeightArray.GetPtr();
+
+	NeoAssert( threadCount > 0 );
+	threadGMax.SetSize( threadCount );
+	threadGMax2.SetSize( threadCount );
+	threadGMaxIdx.SetSize( threadCount );
+	threadObjDiffMin.SetSize( threadCount );
+	threadGMinIdx.SetSize( threadCount );
 }
 
 CSMOptimizer::~CSMOptimizer() 
@@ -385,27 +402,50 @@ void CSMOptimizer::Optimize( CArray<double>& _alpha, float& freeTerm )
 // j: minimizes the decrease of obj value
 //  (if quadratic coefficient <= 0, replace it with tau)
 //  -y_j*grad(f)_j < -y_i*grad(f)_i, j in I_low(\alpha)
-bool CSMOptimizer::findMaxViolatingIndices( int& outI, int& outJ ) const
+bool CSMOptimizer::findMaxViolatingIndices( int& outI, int& outJ )
 {
-	double gMax = -Inf;
-	double gMax2 = -Inf;
-	int gMaxIdx = -1;
-	int gMinIdx = -1;
-	double objDiffMin = Inf;
-
-	for( int i = 0; i < activeSize; ++i) {
-		if( y[i] == 1 ) {
-			if( alphaStatus[i] != AS_UpperBound ) {
-				if( -g[i] >= gMax ) {
-					gMax = -g[i];
-					gMaxIdx = i;
+	// Each thread looks through its own part of the active set
+	// The results are combined in the order of the parts, so the same indices are chosen for any number of threads
+	const int curThreadCount = getCurThreadCount( activeSize );
+	for( int t = 0; t < curThreadCount; ++t ) {
+		threadGMax[t] = -Inf;
+		threadGMaxIdx[t] = -1;
+	}
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		double gMax = -Inf;
+		int gMaxIdx = -1;
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( activeSize, index, count ) ) {
+			for( int i = index; i < index + count; ++i ) {
+				if( y[i] == 1 ) {
+					if( alphaStatus[i] != AS_UpperBound ) {
+						if( -g[i] >= gMax ) {
+							gMax = -g[i];
+							gMaxIdx = i;
+						}
+					}
+				} else if( alphaStatus[i] != AS_LowerBound ) {
+					if(g[i] >= gMax) {
+						gMax = g[i];
+						gMaxIdx = i;
+					}
 				}
 			}
-		} else if( alphaStatus[i] != AS_LowerBound ) {
-			if(g[i] >= gMax) {
-				gMax = g[i];
-				gMaxIdx = i;
-			}
+		}
+		const int threadNumber = OmpGetThreadNum();
+		threadGMax[threadNumber] = gMax;
+		threadGMaxIdx[threadNumber] = gMaxIdx;
+	}
+
+	double gMax = -Inf;
+	int gMaxIdx = -1;
+	for( int t = 0; t < curThreadCount; ++t ) {
+		if( threadGMaxIdx[t] != -1 && threadGMax[t] >= gMax ) {
+			gMax = threadGMax[t];
+			gMaxIdx = threadGMaxIdx[t];
 		}
 	}
 
@@ -416,33 +456,64 @@ bool CSMOptimizer::findMaxViolatingIndices( int& outI, int& outJ ) const
 	const float* q_i = kernelMatrix->GetColumn( gMaxIdx, activeSize );
 	double y_i = y[gMaxIdx];
 	double qD_i = matrixDiagonal[gMaxIdx];
-	auto updateMinParams = [&]( double gradDiff, double multiplier, int j ) {
-		if( gradDiff > 0) {
-			double quadCoef = qD_i + matrixDiagonal[j] + multiplier * y_i * q_i[j];
-			if( quadCoef <= 0 ) {
-				quadCoef = Tau;
-			}
-			double objDiff = -( gradDiff * gradDiff ) / quadCoef;
-			if( objDiff <= objDiffMin ) {
-				gMinIdx = j;
-				objDiffMin = objDiff;
+	for( int t = 0; t < curThreadCount; ++t ) {
+		threadGMax2[t] = -Inf;
+		threadObjDiffMin[t] = Inf;
+		threadGMinIdx[t] = -1;
+	}
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		double gMax2 = -Inf;
+		int gMinIdx = -1;
+		double objDiffMin = Inf;
+		auto updateMinParams = [&]( double gradDiff, double multiplier, int j ) {
+			if( gradDiff > 0) {
+				double quadCoef = qD_i + matrixDiagonal[j] + multiplier * y_i * q_i[j];
+				if( quadCoef <= 0 ) {
+					quadCoef = Tau;
+				}
+				double objDiff = -( gradDiff * gradDiff ) / quadCoef;
+				if( objDiff <= objDiffMin ) {
+					gMinIdx = j;
+					objDiffMin = objDiff;
+				}
 			}
-		}
-	};
+		};
 
-	for( int j = 0; j < activeSize; ++j ) {
-		if( y[j] == 1 ) {
-			if( alphaStatus[j] != AS_LowerBound ) {
-				updateMinParams( gMax + g[j], -2, j );
-				if( g[j] >= gMax2 ) {
-					gMax2 = g[j];
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( activeSize, index, count ) ) {
+			for( int j = index; j < index + count; ++j ) {
+				if( y[j] == 1 ) {
+					if( alphaStatus[j] != AS_LowerBound ) {
+						updateMinParams( gMax + g[j], -2, j );
+						if( g[j] >= gMax2 ) {
+							gMax2 = g[j];
+						}
+					}
+				} else if( alphaStatus[j] != AS_UpperBound ) {
+					updateMinParams( gMax - g[j], 2, j );
+					if( -g[j] >= gMax2 ) {
+						gMax2 = -g[j];
+					}
 				}
 			}
-		} else if( alphaStatus[j] != AS_UpperBound ) {
-			updateMinParams( gMax - g[j], 2, j );
-			if( -g[j] >= gMax2 ) {
-				gMax2 = -g[j];
-			}
+		}
+		const int threadNumber = OmpGetThreadNum();
+		threadGMax2[threadNumber] = gMax2;
+		threadObjDiffMin[threadNumber] = objDiffMin;
+		threadGMinIdx[threadNumber] = gMinIdx;
+	}
+
+	double gMax2 = -Inf;
+	int gMinIdx = -1;
+	double objDiffMin = Inf;
+	for( int t = 0; t < curThreadCount; ++t ) {
+		gMax2 = max( gMax2, threadGMax2[t] );
+		if( threadGMinIdx[t] != -1 && threadObjDiffMin[t] <= objDiffMin ) {
+			gMinIdx = threadGMinIdx[t];
+			objDiffMin = threadObjDiffMin[t];
 		}
 	}
 
@@ -455,6 +526,12 @@ bool CSMOptimizer::findMaxViolatingIndices( int& outI, int& outJ ) const
 	return true;
 }
 
+// Gets the number of threads worth using for the loop over the specified number of vectors
+inline int CSMOptimizer::getCurThreadCount( int taskCount ) const
+{
+	return IsOmpRelevant( taskCount, taskCount ) ? threadCount : 1;
+}
+
 // Optimizes the target function by changing the alpha_i and alpha_j coefficient
 // The optimal values are calculated analytically
 void CSMOptimizer::optimizeIndices( int i, int j )
@@ -534,6 +611,8 @@ void CSMOptimizer::optimizeIndices( int i, int j )
 	// Modify the g
 	double deltaAlpha_i = alpha[i] - oldAlpha_i;
 	double deltaAlpha_j = alpha[j] - oldAlpha_j;
+	const int curThreadCount = getCurThreadCount( activeSize );
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
 	for(int k = 0; k < activeSize; k++) {
 		g[k] += q_i[k] * deltaAlpha_i + q_j[k] * deltaAlpha_j;
 	}
@@ -555,11 +634,14 @@ void CSMOptimizer::updateAlphaStatusAndGradient0( int i )
 	bool isUB = alphaStatus[i] == AS_UpperBound;
 	if( wasUB != isUB ) {
 		auto q_i = kernelMatrix->GetColumn( i, vectorCount );
+		const int curThreadCount = getCurThreadCount( vectorCount );
 		if( wasUB ) {
+			NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
 			for( int j = 0; j < vectorCount; ++j ) {
 				g0[j] -= c_i * q_i[j];
 			}
 		} else {
+			NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
 			for( int j = 0; j < vectorCount; ++j ) {
 				g0[j] += c_i * q_i[j];
 			}
@@ -604,6 +686,8 @@ void CSMOptimizer::reconstructGradient()
 			if( alphaStatus[i] == AS_Free ) {
 				auto q_i = kernelMatrix->GetColumn( i, vectorCount );
 				double alpha_i = alpha[i];
+				const int curThreadCount = getCurThreadCount( vectorCount - activeSize );
+				NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
 				for( int j = activeSize; j < vectorCount; ++j ) {
 					g[j] += alpha_i * q_i[j];
 				}
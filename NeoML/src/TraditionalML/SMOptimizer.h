@@ -44,9 +44,10 @@ public:
 	// kernel is the SVM kernel function
 	// data contains the training set
 	// tolerance is the required precision
+	// threadCount is the number of threads used to calculate the kernel columns and update the gradient
 	// cacheSize is the cache size in MB
 	CSMOptimizer(const CSvmKernel& kernel, const IProblem& data, int maxIter, double errorWeight, double tolerance,
-		bool doShrinking, int cacheSize = 200);
+		bool doShrinking, int threadCount = 1, int cacheSize = 200);
 	~CSMOptimizer();
 
 	// Calculates the optimal multipliers for the support vectors
@@ -71,6 +72,7 @@ private:
 	const double errorWeight; // the error weight relative to the regularizer (the relative weight of the data set)
 	const double tolerance; // the stop criterion
 	bool doShrinking; // do shrinking or not
+	const int threadCount; // the number of processing threads used
 	CKernelMatrix* kernelMatrix; // the kernel matrix
 	CTextStream* log; // the logging stream
 
@@ -93,8 +95,15 @@ private:
 	int* activeSet; // active set raw pointer array
 	int activeSize; // number of vector that are being optimized in this moment
 	bool isShrunk; // whether the problem was shrunk or not
-
-	bool findMaxViolatingIndices( int& outI, int& outJ ) const;
+	// The working set selection results of each thread
+	CArray<double> threadGMax;
+	CArray<double> threadGMax2;
+	CArray<int> threadGMaxIdx;
+	CArray<double> threadObjDiffMin;
+	CArray<int> threadGMinIdx;
+
+	bool findMaxViolatingIndices( int& outI, int& outJ );
+	int getCurThreadCount( int taskCount ) const;
 	void optimizeIndices( int i, int j );
 	void updateAlphaStatusAndGradient0( int i );
 	void reconstructGradient();
@@ -24,10 +24,29 @@ CFloatMatrixDesc CFloatMatrixDesc::Empty;
 const int CSparseFloatMatrix::InitialRowsBufferSize;
 const int CSparseFloatMatrix::InitialElementsBufferSize;
 const int CSparseFloatMatrix::MaxRowsCount;
-const int CSparseFloatMatrix::MaxElementsCount;
+const __int64 CSparseFloatMatrix::MaxElementsCount;
 
-CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( int height, int width, int elementCount,
-	int rowsBufferSize, int elementsBufferSize )
+// Calculates the number of elements a sparse matrix needs to store the given matrix
+static __int64 getElementCount( const CFloatMatrixDesc& desc )
+{
+	__int64 elementCount = 0;
+	for( int i = 0; i < desc.Height; ++i ) {
+		CFloatVectorDesc row = desc.GetRow( i );
+		if( desc.Columns == nullptr ) {
+			for( int j = 0; j < row.Size; ++j ) {
+				if( row.Values[j] != 0 ) {
+					++elementCount;
+				}
+			}
+		} else {
+			elementCount += row.Size;
+		}
+	}
+	return elementCount;
+}
+
+CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( int height, int width, __int64 elementCount,
+	int rowsBufferSize, __int64 elementsBufferSize )
 {
 	NeoAssert( height >= 0 && width >= 0 && elementCount >= 0 );
 	NeoAssert( rowsBufferSize >= 0 && elementsBufferSize >= 0 );
@@ -36,74 +55,87 @@ CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( int height,
 	BeginPointersBuf.SetBufferSize( rowsBufferSize );
 	EndPointersBuf.SetBufferSize( rowsBufferSize );
 
-	elementsBufferSize = max( elementCount, max( elementsBufferSize, InitialElementsBufferSize ) );
+	elementsBufferSize = max( elementCount, max( elementsBufferSize, static_cast<__int64>( InitialElementsBufferSize ) ) );
 	ColumnsBuf.SetBufferSize( elementsBufferSize );
 	ValuesBuf.SetBufferSize( elementsBufferSize );
 
 	Desc.Height = height;
 	Desc.Width = width;
-	Desc.Columns = ColumnsBuf.GetBufferPtr();
-	Desc.Values = ValuesBuf.GetBufferPtr();
-	Desc.PointerB = BeginPointersBuf.GetBufferPtr();
-	Desc.PointerE = EndPointersBuf.GetBufferPtr();
+	UpdateDesc();
+	if( elementCount > INT_MAX ) {
+		ConvertTo64Bit();
+	}
 }
 
-CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( const CFloatMatrixDesc& desc )
+CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( const CFloatMatrixDesc& desc ) :
+	CSparseFloatMatrixBody( 0, desc.Width, 0, desc.Height, getElementCount( desc ) )
 {
-	NeoAssert( desc.Height >= 0 && desc.Width >= 0 );
-
-	int rowsBufferSize = max( desc.Height, InitialRowsBufferSize );
-	BeginPointersBuf.SetBufferSize( rowsBufferSize );
-	EndPointersBuf.SetBufferSize( rowsBufferSize );
-	int elementCount = 0;
-	if( desc.Columns == nullptr ) {
-		for( int i = 0; i < desc.Height; ++i ) {
-			BeginPointersBuf.Add( elementCount );
-			for( int pos = desc.PointerB[i]; pos < desc.PointerE[i]; ++pos ) {
-				if( desc.Values[pos] != 0 ) {
-					++elementCount;
-				}
-			}
-			EndPointersBuf.Add( elementCount );
-		}
-	} else {
-		for( int i = 0; i < desc.Height; ++i ) {
-			BeginPointersBuf.Add( elementCount );
-			elementCount += desc.PointerE[i] - desc.PointerB[i];
-			EndPointersBuf.Add( elementCount );
-		}
-	}
-	int elementsBufferSize = max( elementCount, InitialElementsBufferSize );
-	ColumnsBuf.SetBufferSize( elementsBufferSize );
-	ValuesBuf.SetBufferSize( elementsBufferSize );
-	if( desc.Columns == nullptr ) {
-		for( int i = 0; i < desc.Height; ++i ) {
-			for( int pos = desc.PointerB[i], j = 0; pos < desc.PointerE[i]; ++pos, ++j ) {
-				if( desc.Values[pos] != 0 ) {
+	for( int i = 0; i < desc.Height; ++i ) {
+		CFloatVectorDesc row = desc.GetRow( i );
+		const __int64 begin = ValuesBuf.Size();
+		if( desc.Columns == nullptr ) {
+			for( int j = 0; j < row.Size; ++j ) {
+				if( row.Values[j] != 0 ) {
 					ColumnsBuf.Add( j );
-					ValuesBuf.Add( desc.Values[pos] );
+					ValuesBuf.Add( row.Values[j] );
 				}
 			}
+		} else {
+			ColumnsBuf.SetSize( begin + row.Size );
+			ValuesBuf.SetSize( begin + row.Size );
+			::memcpy( ColumnsBuf.GetBufferPtr() + begin, row.Indexes, row.Size * sizeof( int ) );
+			::memcpy( ValuesBuf.GetBufferPtr() + begin, row.Values, row.Size * sizeof( float ) );
 		}
-	} else {
-		ColumnsBuf.SetSize( elementCount );
-		ValuesBuf.SetSize( elementCount );
-		elementCount = 0;
-		for( int i = 0; i < desc.Height; ++i ) {
-			CFloatVectorDesc vec = desc.GetRow( i );
-			::memcpy( ColumnsBuf.GetBufferPtr() + elementCount, vec.Indexes, vec.Size * sizeof( int ) );
-			::memcpy( ValuesBuf.GetBufferPtr() + elementCount, vec.Values, vec.Size * sizeof( float ) );
-			elementCount += vec.Size;
-		}
-		NeoPresume( elementCount == ValuesBuf.Size() );
+		AddRowPointers( begin, ValuesBuf.Size() );
 	}
-
 	Desc.Height = desc.Height;
-	Desc.Width = desc.Width;
+	UpdateDesc();
+}
+
+void CSparseFloatMatrix::CSparseFloatMatrixBody::ConvertTo64Bit()
+{
+	NeoPresume( !Is64Bit() );
+	BeginPointersBuf64.SetBufferSize( BeginPointersBuf.BufferSize() );
+	EndPointersBuf64.SetBufferSize( EndPointersBuf.BufferSize() );
+	for( int i = 0; i < BeginPointersBuf.Size(); ++i ) {
+		BeginPointersBuf64.Add( BeginPointersBuf[i] );
+		EndPointersBuf64.Add( EndPointersBuf[i] );
+	}
+	BeginPointersBuf.FreeBuffer();
+	EndPointersBuf.FreeBuffer();
+	Desc.PointerB = nullptr;
+	Desc.PointerE = nullptr;
+	Desc.PointerB64 = BeginPointersBuf64.GetBufferPtr();
+	UpdateDesc();
+}
+
+void CSparseFloatMatrix::CSparseFloatMatrixBody::UpdateDesc()
+{
 	Desc.Columns = ColumnsBuf.GetBufferPtr();
 	Desc.Values = ValuesBuf.GetBufferPtr();
-	Desc.PointerB = BeginPointersBuf.GetBufferPtr();
-	Desc.PointerE = EndPointersBuf.GetBufferPtr();
+	if( Is64Bit() ) {
+		Desc.PointerB64 = BeginPointersBuf64.GetBufferPtr();
+		Desc.PointerE64 = EndPointersBuf64.GetBufferPtr();
+	} else {
+		Desc.PointerB = BeginPointersBuf.GetBufferPtr();
+		Desc.PointerE = EndPointersBuf.GetBufferPtr();
+	}
+}
+
+void CSparseFloatMatrix::CSparseFloatMatrixBody::AddRowPointers( __int64 begin, __int64 end )
+{
+	NeoPresume( begin <= end );
+	if( !Is64Bit() && end > INT_MAX ) {
+		ConvertTo64Bit();
+	}
+	if( Is64Bit() ) {
+		BeginPointersBuf64.Add( begin );
+		EndPointersBuf64.Add( end );
+	} else {
+		BeginPointersBuf.Add( static_cast<int>( begin ) );
+		EndPointersBuf.Add( static_cast<int>( end ) );
+	}
+	UpdateDesc();
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -111,7 +143,7 @@ CSparseFloatMatrix::CSparseFloatMatrixBody::CSparseFloatMatrixBody( const CFloat
 const int sparseSignature = -1;
 const int denseSignature = -2;
 
-CSparseFloatMatrix::CSparseFloatMatrix( int width, int rowsBufferSize, int elementsBufferSize ) :
+CSparseFloatMatrix::CSparseFloatMatrix( int width, int rowsBufferSize, __int64 elementsBufferSize ) :
 	body( FINE_DEBUG_NEW CSparseFloatMatrixBody( 0, width, 0, rowsBufferSize, elementsBufferSize ) )
 {
 }
@@ -137,7 +169,7 @@ void CSparseFloatMatrix::GrowInRows( int newRowsBufferSize )
 	copyOnWriteAndGrow( newRowsBufferSize, 0 );
 }
 
-void CSparseFloatMatrix::GrowInElements( int newElementsBufferSize )
+void CSparseFloatMatrix::GrowInElements( __int64 newElementsBufferSize )
 {
 	copyOnWriteAndGrow( 0, newElementsBufferSize );
 }
@@ -158,7 +190,7 @@ void CSparseFloatMatrix::AddRow( const CFloatVectorDesc& row )
 		}
 	}
 	int newHeight = 1;
-	int newElementCount = size;
+	__int64 newElementCount = size;
 	if( body != nullptr ) {
 		NeoAssert( body->Desc.Height <= MaxRowsCount - 1 );
 		NeoAssert( body->ValuesBuf.Size() <= MaxElementsCount - size );
@@ -171,7 +203,7 @@ void CSparseFloatMatrix::AddRow( const CFloatVectorDesc& row )
 	body->Desc.Height = newHeight;
 	body->Desc.Width = max( body->Desc.Width, row.Indexes == nullptr ? row.Size : row.Indexes[row.Size - 1] + 1 );
 
-	body->BeginPointersBuf.Add( body->ValuesBuf.Size() );
+	const __int64 begin = body->ValuesBuf.Size();
 	if( row.Indexes == nullptr ) {
 		NeoAssert( row.Size == 0 || row.Values != nullptr );
 		for( int i = 0; i < row.Size; ++i ) {
@@ -184,10 +216,10 @@ void CSparseFloatMatrix::AddRow( const CFloatVectorDesc& row )
 		NeoAssert( row.Values != nullptr );
 		body->ColumnsBuf.SetSize( newElementCount );
 		body->ValuesBuf.SetSize( newElementCount );
-		::memcpy( body->ColumnsBuf.GetBufferPtr() + newElementCount - size, row.Indexes, row.Size * sizeof( int ) );
-		::memcpy( body->ValuesBuf.GetBufferPtr() + newElementCount - size, row.Values, row.Size * sizeof( float ) );
+		::memcpy( body->ColumnsBuf.GetBufferPtr() + begin, row.Indexes, row.Size * sizeof( int ) );
+		::memcpy( body->ValuesBuf.GetBufferPtr() + begin, row.Values, row.Size * sizeof( float ) );
 	}
-	body->EndPointersBuf.Add( body->ValuesBuf.Size() );
+	body->AddRowPointers( begin, body->ValuesBuf.Size() );
 }
 
 CFloatVectorDesc CSparseFloatMatrix::GetRow( int index ) const
@@ -206,11 +238,18 @@ void CSparseFloatMatrix::GetRow( int index, CFloatVectorDesc& result ) const
 
 void CSparseFloatMatrix::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( 0 );
+	const int version = archive.SerializeVersion( 1 );
 
 	if( archive.IsLoading() ) {
-		int elementCount = 0;
-		archive >> elementCount;
+		__int64 elementCount = 0;
+		if( version >= 1 ) {
+			archive >> elementCount;
+		} else {
+			int elementCount32 = 0;
+			archive >> elementCount32;
+			elementCount = elementCount32;
+		}
+		check( elementCount >= 0, ERR_BAD_ARCHIVE, archive.Name() );
 		if( elementCount == 0 ) {
 			body = nullptr;
 			return;
@@ -219,11 +258,11 @@ void CSparseFloatMatrix::Serialize( CArchive& archive )
 		int width = 0;
 		archive >> height;
 		archive >> width;
+		check( height >= 0 && width >= 0, ERR_BAD_ARCHIVE, archive.Name() );
 
-		int elementIndex = 0;
-		CPtr<CSparseFloatMatrixBody> newBody = FINE_DEBUG_NEW CSparseFloatMatrixBody( height, width, elementCount, height, elementCount );
+		CPtr<CSparseFloatMatrixBody> newBody = FINE_DEBUG_NEW CSparseFloatMatrixBody( 0, width, 0, height, elementCount );
 		for( int row = 0; row < height; row++ ) {
-			newBody->Desc.PointerB[row] = elementIndex;
+			const __int64 begin = newBody->ValuesBuf.Size();
 			int sign = archive.ReadSmallValue();
 			check( sign == denseSignature || sign == sparseSignature, ERR_BAD_ARCHIVE, archive.Name() );
 
@@ -235,10 +274,11 @@ void CSparseFloatMatrix::Serialize( CArchive& archive )
 					check( false, ERR_BAD_ARCHIVE, archive.Name() );
 				}
 
-				for( int i = 0; i < size; i++ ) {
-					archive >> newBody->Desc.Columns[elementIndex];
-					archive >> newBody->Desc.Values[elementIndex];
-					elementIndex++;
+				newBody->ColumnsBuf.SetSize( begin + size );
+				newBody->ValuesBuf.SetSize( begin + size );
+				for( __int64 i = begin; i < begin + size; i++ ) {
+					archive >> newBody->ColumnsBuf.GetBufferPtr()[i];
+					archive >> newBody->ValuesBuf.GetBufferPtr()[i];
 				}
 			} else {
 				int size = 0;
@@ -249,18 +289,18 @@ void CSparseFloatMatrix::Serialize( CArchive& archive )
 					float value;
 					archive >> value;
 					if( value != 0.f ) {
-						newBody->Desc.Columns[elementIndex] = i;
-						newBody->Desc.Values[elementIndex] = value;
-						elementIndex += 1;
+						newBody->ColumnsBuf.Add( i );
+						newBody->ValuesBuf.Add( value );
 					}
 				}
 			}
-			newBody->Desc.PointerE[row] = elementIndex;
+			newBody->AddRowPointers( begin, newBody->ValuesBuf.Size() );
 		}
+		newBody->Desc.Height = height;
 		body = newBody;
 	} else if( archive.IsStoring() ) {
 		if( body == nullptr ) {
-			archive << static_cast<int>( 0 );
+			archive << static_cast<__int64>( 0 );
 			return;
 		}
 		archive << body->ValuesBuf.Size();
@@ -310,7 +350,7 @@ void CSparseFloatMatrix::Serialize( CArchive& archive )
 
 // duplicate like CopyOnWrite but with the preset buffers' sizes
 CSparseFloatMatrix::CSparseFloatMatrixBody* CSparseFloatMatrix::copyOnWriteAndGrow( int rowsBufferSize,
-	int elementsBufferSize )
+	__int64 elementsBufferSize )
 {
 	NeoAssert( rowsBufferSize >= 0 && elementsBufferSize >= 0 );
 
@@ -325,18 +365,26 @@ CSparseFloatMatrix::CSparseFloatMatrixBody* CSparseFloatMatrix::copyOnWriteAndGr
 			oldBody->ValuesBuf.Size(), rowsBufferSize, elementsBufferSize );
 		oldBody->ColumnsBuf.CopyTo( body->ColumnsBuf );
 		oldBody->ValuesBuf.CopyTo( body->ValuesBuf );
-		oldBody->BeginPointersBuf.CopyTo( body->BeginPointersBuf );
-		oldBody->EndPointersBuf.CopyTo( body->EndPointersBuf );		
+		if( oldBody->Is64Bit() ) {
+			NeoPresume( body->Is64Bit() );
+			oldBody->BeginPointersBuf64.CopyTo( body->BeginPointersBuf64 );
+			oldBody->EndPointersBuf64.CopyTo( body->EndPointersBuf64 );
+		} else {
+			oldBody->BeginPointersBuf.CopyTo( body->BeginPointersBuf );
+			oldBody->EndPointersBuf.CopyTo( body->EndPointersBuf );
+		}
+	} else if( body->Is64Bit() ) {
+		body->BeginPointersBuf64.Grow( rowsBufferSize );
+		body->EndPointersBuf64.Grow( rowsBufferSize );
+		body->ColumnsBuf.Grow( elementsBufferSize );
+		body->ValuesBuf.Grow( elementsBufferSize );
 	} else {
 		body->BeginPointersBuf.Grow( rowsBufferSize );
 		body->EndPointersBuf.Grow( rowsBufferSize );
 		body->ColumnsBuf.Grow( elementsBufferSize );
 		body->ValuesBuf.Grow( elementsBufferSize );
-		body->Desc.PointerB = body->BeginPointersBuf.GetBufferPtr();
-		body->Desc.PointerE = body->EndPointersBuf.GetBufferPtr();
-		body->Desc.Columns = body->ColumnsBuf.GetBufferPtr();
-		body->Desc.Values = body->ValuesBuf.GetBufferPtr();
 	}
+	body->UpdateDesc();
 	return body.Ptr();
 }
 
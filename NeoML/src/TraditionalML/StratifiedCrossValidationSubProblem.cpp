@@ -42,20 +42,31 @@ CStratifiedCrossValidationSubProblem::CStratifiedCrossValidationSubProblem( cons
 	}
 
 	CFloatMatrixDesc baseMatrix = problem->GetMatrix();
-	pointerB.SetSize( vectorsCount );
-	pointerE.SetSize( vectorsCount );
-	for( int i = 0; i < vectorsCount; i++ ) {
-		int index = translateIndex( i );
-		pointerB[i] = baseMatrix.PointerB[index];
-		pointerE[i] = baseMatrix.PointerE[index];
-	}
-
 	matrix.Height = vectorsCount;
 	matrix.Width = baseMatrix.Width;
 	matrix.Columns = baseMatrix.Columns;
 	matrix.Values = baseMatrix.Values;
-	matrix.PointerB = pointerB.GetPtr();
-	matrix.PointerE = pointerE.GetPtr();
+	if( baseMatrix.Is64Bit() ) {
+		pointerB64.SetSize( vectorsCount );
+		pointerE64.SetSize( vectorsCount );
+		for( int i = 0; i < vectorsCount; i++ ) {
+			int index = translateIndex( i );
+			pointerB64[i] = baseMatrix.PointerB64[index];
+			pointerE64[i] = baseMatrix.PointerE64[index];
+		}
+		matrix.PointerB64 = pointerB64.GetPtr();
+		matrix.PointerE64 = pointerE64.GetPtr();
+	} else {
+		pointerB.SetSize( vectorsCount );
+		pointerE.SetSize( vectorsCount );
+		for( int i = 0; i < vectorsCount; i++ ) {
+			int index = translateIndex( i );
+			pointerB[i] = baseMatrix.PointerB[index];
+			pointerE[i] = baseMatrix.PointerE[index];
+		}
+		matrix.PointerB = pointerB.GetPtr();
+		matrix.PointerE = pointerE.GetPtr();
+	}
 }
 
 // Creates partsCount lists with each containing the list of objects of one part
@@ -33,6 +33,13 @@ CSvm::CSvm( const CParams& _params ) :
 {
 }
 
+ITrainingModel* CSvm::CreateCopy( int threadCount ) const
+{
+	CParams copyParams = params;
+	copyParams.ThreadCount = threadCount;
+	return FINE_DEBUG_NEW CSvm( copyParams );
+}
+
 CPtr<IModel> CSvm::Train( const IProblem& problem )
 {
 	if( problem.GetClassCount() > 2 ) {
@@ -52,7 +59,7 @@ CPtr<IModel> CSvm::Train( const IProblem& problem )
 	CSvmKernel kernel( params.KernelType, params.Degree, params.Gamma, params.Coeff0 );
 
 	CSMOptimizer optimizer( kernel, problem, params.MaxIterations, params.ErrorWeight, params.Tolerance,
-		params.DoShrinking );
+		params.DoShrinking, params.ThreadCount );
 	if( log != nullptr ) {
 		optimizer.SetLog( log );
 	}
@@ -17,9 +17,18 @@ limitations under the License.
 #pragma hdrstop
 
 #include <SvmBinaryModel.h>
+#include <NeoMathEngine/OpenMP.h>
+#include <NeoMathEngine/NeoMathEngine.h>
+#include <NeoML/Dnn/Dnn.h>
 
 namespace NeoML {
 
+// The maximum number of elements in the dense support vector matrix built by the batch classification
+static const int MaxDenseVectorsSize = 16 * 1024 * 1024;
+// The maximum number of elements in the blocks of the input rows and of the kernel values
+// processed at once by the batch classification with the dense support vectors
+static const int KernelBufferSize = 1024 * 1024;
+
 ISvmBinaryModel::~ISvmBinaryModel()
 {
 }
@@ -29,7 +38,8 @@ REGISTER_NEOML_MODEL( CSvmBinaryModel, SvmBinaryModelName )
 CSvmBinaryModel::CSvmBinaryModel( const CSvmKernel& _kernel, const IProblem& problem, const CArray<double>& _alpha,
 		double _freeTerm ) :
 	kernel( _kernel ),
-	freeTerm( _freeTerm )
+	freeTerm( _freeTerm ),
+	useDenseVectors( false )
 {
 	CFloatVectorDesc desc;
 	CFloatMatrixDesc problemMatrix = problem.GetMatrix();
@@ -52,6 +62,7 @@ CSvmBinaryModel::CSvmBinaryModel( const CSvmKernel& _kernel, const IProblem& pro
 			matrix.AddRow( desc );
 		}
 	}
+	packVectors();
 }
 
 bool CSvmBinaryModel::Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const
@@ -62,7 +73,230 @@ bool CSvmBinaryModel::Classify( const CFloatVectorDesc& data, CClassificationRes
 		matrix.GetRow( i, desc );
 		value += alpha[i] * kernel.Calculate( data, desc );
 	}
+	return classify( value, result );
+}
+
+bool CSvmBinaryModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+
+	if( kernel.KernelType() != CSvmKernel::KT_Linear ) {
+		if( squaredNorms.IsEmpty() ) {
+			return IModel::ClassifyBatch( data, results, threadCount );
+		}
+		results.DeleteAll();
+		results.SetSize( data.Height );
+		if( useDenseVectors ) {
+			classifyDenseVectorsBatch( data, results, threadCount );
+		} else {
+			classifySparseVectorsBatch( data, results, threadCount );
+		}
+		return true;
+	}
+
+	// With the linear kernel the support vectors may be folded into one plane,
+	// so that each row needs one dot product instead of one per support vector
+	CArray<double> plane;
+	plane.Add( 0.0, max( matrix.GetWidth(), data.Width ) );
+	CFloatVectorDesc desc;
+	for( int i = 0; i < alpha.Size(); i++ ) {
+		matrix.GetRow( i, desc );
+		for( int j = 0; j < desc.Size; j++ ) {
+			plane[desc.Indexes == nullptr ? j : desc.Indexes[j]] += alpha[i] * desc.Values[j];
+		}
+	}
+
+	results.DeleteAll();
+	results.SetSize( data.Height );
+	const int curThreadCount = IsOmpRelevant( data.Height, static_cast<int64_t>( data.Height ) * data.Width ) ? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, index, count ) ) {
+			CFloatVectorDesc row;
+			for( int i = index; i < index + count; i++ ) {
+				data.GetRow( i, row );
+				double value = freeTerm;
+				for( int j = 0; j < row.Size; j++ ) {
+					value += plane[row.Indexes == nullptr ? j : row.Indexes[j]] * row.Values[j];
+				}
+				classify( value, results[i] );
+			}
+		}
+	}
+	return true;
+}
+
+// Prepares the support vectors for the batch classification
+// The dense format is used if at least half of the elements are non-zero
+void CSvmBinaryModel::packVectors()
+{
+	useDenseVectors = false;
+	squaredNorms.DeleteAll();
+	if( kernel.KernelType() == CSvmKernel::KT_Linear || alpha.IsEmpty() ) {
+		return;
+	}
+
+	const CFloatMatrixDesc desc = matrix.GetDesc();
+	const __int64 elementCount = desc.GetRowEnd( desc.Height - 1 ) - desc.GetRowBegin( 0 );
+	const __int64 denseSize = static_cast<__int64>( desc.Height ) * desc.Width;
+	useDenseVectors = denseSize <= MaxDenseVectorsSize && 2 * elementCount >= denseSize;
+
+	squaredNorms.SetSize( desc.Height );
+	CFloatVectorDesc row;
+	for( int i = 0; i < desc.Height; i++ ) {
+		desc.GetRow( i, row );
+		double squaredNorm = 0;
+		for( int j = 0; j < row.Size; j++ ) {
+			squaredNorm += static_cast<double>( row.Values[j] ) * row.Values[j];
+		}
+		squaredNorms[i] = squaredNorm;
+	}
+}
+
+// Writes the row into the dense buffer of the given width and returns its squared norm
+// The features missing from the support vectors do not change the dot products and are skipped
+static double setDenseRow( const CFloatVectorDesc& row, int width, float* buffer )
+{
+	double squaredNorm = 0;
+	for( int j = 0; j < row.Size; j++ ) {
+		const int index = row.Indexes == nullptr ? j : row.Indexes[j];
+		if( index < width ) {
+			buffer[index] = row.Values[j];
+		}
+		squaredNorm += static_cast<double>( row.Values[j] ) * row.Values[j];
+	}
+	return squaredNorm;
+}
+
+// Classifies the data with a non-linear kernel and the dense support vectors
+// The dot products of the input rows and the support vectors are calculated by the math engine
+// as a product of matrices, then the kernel is calculated from them
+// The support vectors are converted to the dense format for the duration of the call only
+void CSvmBinaryModel::classifyDenseVectorsBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	const CFloatMatrixDesc vectorsDesc = matrix.GetDesc();
+	const int vectorCount = vectorsDesc.Height;
+	const int width = vectorsDesc.Width;
+	NeoAssert( vectorCount == alpha.Size() );
+
+	// Each thread uses the single-thread engine for its blocks
+	IMathEngine& mathEngine = GetSingleThreadCpuMathEngine();
+	const int vectorsSize = vectorCount * width;
+	CFloatHandleVar vectors( mathEngine, vectorsSize );
+	float* vectorsData = static_cast<float*>( mathEngine.GetBuffer( vectors.GetHandle(), 0,
+		vectorsSize * sizeof( float ), false ) );
+	::memset( vectorsData, 0, vectorsSize * sizeof( float ) );
+	CFloatVectorDesc row;
+	for( int k = 0; k < vectorCount; k++ ) {
+		vectorsDesc.GetRow( k, row );
+		setDenseRow( row, width, vectorsData + k * width );
+	}
+	mathEngine.ReleaseBuffer( vectors.GetHandle(), vectorsData, true );
+
+	// Both the block of the input rows and its products with the support vectors fit into KernelBufferSize
+	const int blockSize = max( 1, min( KernelBufferSize / max( width, vectorCount ),
+		( data.Height + threadCount - 1 ) / threadCount ) );
+	const int blockCount = ( data.Height + blockSize - 1 ) / blockSize;
+	const int curThreadCount = IsOmpRelevant( blockCount, static_cast<int64_t>( data.Height ) * vectorsSize )
+		? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int firstBlock = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( blockCount, firstBlock, count ) ) {
+			CFloatHandleStackVar block( mathEngine, blockSize * width );
+			CFloatHandleStackVar products( mathEngine, blockSize * vectorCount );
+			CArray<double> blockSquaredNorms;
+			blockSquaredNorms.SetSize( blockSize );
+			CFloatVectorDesc dataRow;
+			for( int b = firstBlock; b < firstBlock + count; b++ ) {
+				const int blockStart = b * blockSize;
+				const int curBlockSize = min( blockSize, data.Height - blockStart );
+
+				float* blockData = static_cast<float*>( mathEngine.GetBuffer( block.GetHandle(), 0,
+					curBlockSize * width * sizeof( float ), false ) );
+				::memset( blockData, 0, curBlockSize * width * sizeof( float ) );
+				for( int i = 0; i < curBlockSize; i++ ) {
+					data.GetRow( blockStart + i, dataRow );
+					blockSquaredNorms[i] = setDenseRow( dataRow, width, blockData + i * width );
+				}
+				mathEngine.ReleaseBuffer( block.GetHandle(), blockData, true );
+
+				mathEngine.MultiplyMatrixByTransposedMatrix( block.GetHandle(), curBlockSize, width, width,
+					vectors.GetHandle(), vectorCount, width, products.GetHandle(), vectorCount, curBlockSize * vectorCount );
+
+				const float* productsData = static_cast<const float*>( mathEngine.GetBuffer( products.GetHandle(), 0,
+					curBlockSize * vectorCount * sizeof( float ), true ) );
+				for( int i = 0; i < curBlockSize; i++ ) {
+					const float* rowProducts = productsData + i * vectorCount;
+					double value = freeTerm;
+					for( int k = 0; k < vectorCount; k++ ) {
+						value += alpha[k] * kernel.CalculateByDotProduct( rowProducts[k], blockSquaredNorms[i],
+							squaredNorms[k] );
+					}
+					classify( value, results[blockStart + i] );
+				}
+				mathEngine.ReleaseBuffer( products.GetHandle(), const_cast<float*>( productsData ), false );
+			}
+		}
+	}
+}
+
+// Classifies the data with a non-linear kernel and the sparse support vectors
+// Each input row is written into a dense buffer of one row, then the dot products are calculated
+// over the non-zero elements of the support vectors; the input data is never converted as a whole
+void CSvmBinaryModel::classifySparseVectorsBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	const CFloatMatrixDesc vectorsDesc = matrix.GetDesc();
+	const int vectorCount = vectorsDesc.Height;
+	const int width = vectorsDesc.Width;
+	NeoAssert( vectorCount == alpha.Size() );
+
+	const __int64 elementCount = vectorsDesc.GetRowEnd( vectorCount - 1 ) - vectorsDesc.GetRowBegin( 0 );
+	const int curThreadCount = IsOmpRelevant( data.Height, data.Height * elementCount ) ? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int index = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, index, count ) ) {
+			CArray<float> buffer;
+			buffer.Add( 0.f, width );
+			CFloatVectorDesc row;
+			CFloatVectorDesc vector;
+			for( int i = index; i < index + count; i++ ) {
+				data.GetRow( i, row );
+				const double squaredNorm = setDenseRow( row, width, buffer.GetPtr() );
 
+				double value = freeTerm;
+				for( int k = 0; k < vectorCount; k++ ) {
+					vectorsDesc.GetRow( k, vector );
+					double product = 0;
+					for( int j = 0; j < vector.Size; j++ ) {
+						product += static_cast<double>( buffer[vector.Indexes[j]] ) * vector.Values[j];
+					}
+					value += alpha[k] * kernel.CalculateByDotProduct( product, squaredNorm, squaredNorms[k] );
+				}
+				classify( value, results[i] );
+
+				for( int j = 0; j < row.Size; j++ ) {
+					const int column = row.Indexes == nullptr ? j : row.Indexes[j];
+					if( column < width ) {
+						buffer[column] = 0.f;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Calculates the classification result from the value of the decision function
+bool CSvmBinaryModel::classify( double value, CClassificationResult& result ) const
+{
 	const double probability = 1 / ( 1 + exp( value ) );
 	result.ExceptionProbability = CClassificationProbability( 0 );
 	result.Probabilities.SetSize( 2 );
@@ -106,6 +340,7 @@ void CSvmBinaryModel::Serialize( CArchive& archive )
 			}
 			archive >> alpha;
 		}
+		packVectors();
 	} else {
 		NeoAssert( false );
 	}
@@ -22,7 +22,7 @@ namespace NeoML {
 // The binary SVM classifier
 class CSvmBinaryModel : public ISvmBinaryModel {
 public:
-	CSvmBinaryModel() : freeTerm( 0 ) {}
+	CSvmBinaryModel() : freeTerm( 0 ), useDenseVectors( false ) {}
 	CSvmBinaryModel( const CSvmKernel& kernel, const IProblem& problem, const CArray<double>& alpha, double freeTerm );
 
 	// For serialization
@@ -31,6 +31,7 @@ public:
 	// IModel interface methods
 	virtual int GetClassCount() const { return 2; }
 	virtual bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const;
+	virtual bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const;
 	virtual void Serialize( CArchive& archive );
 
 	// ISvmBinaryModel interface methods
@@ -47,6 +48,16 @@ private:
 	double freeTerm; // the free term
 	CSparseFloatMatrix matrix; // the support vectors
 	CArray<double> alpha; // the coefficients
+	// The batch classification with a non-linear kernel:
+	bool useDenseVectors; // the support vectors are converted to the dense format for the matrix multiplication
+	CArray<double> squaredNorms; // the squared norms of the support vectors; empty if the batch classification is not used
+
+	void packVectors();
+	void classifyDenseVectorsBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount ) const;
+	void classifySparseVectorsBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount ) const;
+	bool classify( double value, CClassificationResult& result ) const;
 };
 
 } // namespace NeoML
@@ -0,0 +1,58 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TrainingModelCopies.h>
+
+namespace NeoML {
+
+CTrainingModelCopies::CTrainingModelCopies( ITrainingModel& baseModel, int threadCount, int taskCount ) :
+	isCopied( false )
+{
+	NeoAssert( threadCount > 0 );
+
+	// The parallel region of a training inside the parallel region of the copies would get one thread
+	// so each parallel training uses one thread
+	const int parallelCount = min( taskCount, threadCount );
+	if( parallelCount > 1 ) {
+		isCopied = true;
+		for( int i = 0; i < parallelCount; i++ ) {
+			ITrainingModel* copy = baseModel.CreateCopy( 1 );
+			if( copy == nullptr ) {
+				NeoAssert( models.IsEmpty() );
+				isCopied = false;
+				break;
+			}
+			models.Add( copy );
+		}
+	}
+
+	if( !isCopied ) {
+		models.Add( &baseModel );
+	}
+}
+
+CTrainingModelCopies::~CTrainingModelCopies()
+{
+	if( isCopied ) {
+		for( int i = 0; i < models.Size(); i++ ) {
+			delete models[i];
+		}
+	}
+}
+
+} // namespace NeoML
@@ -0,0 +1,80 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/TraditionalML/TrainingModel.h>
+#include <NeoMathEngine/OpenMP.h>
+#include <atomic>
+#include <exception>
+#include <vector>
+
+namespace NeoML {
+
+// The training models used to train several independent models at the same time
+// The threads are split between the models trained in parallel: the nested parallel regions are not used,
+// so every parallel training gets its own single-thread copy of the base training model
+// If the base training model may not be copied, it is the only one and the models are trained one after another
+class CTrainingModelCopies {
+public:
+	// taskCount is the number of the models to be trained
+	CTrainingModelCopies( ITrainingModel& baseModel, int threadCount, int taskCount );
+	~CTrainingModelCopies();
+
+	// The number of the models that may be trained in parallel
+	int Size() const { return models.Size(); }
+	ITrainingModel& operator[]( int index ) const { return *models[index]; }
+
+	// Calls task( trainingModel, index ) for every index from 0 to taskCount - 1
+	// Each parallel training takes the next index when it finishes the previous one
+	// If a task throws, the other trainings stop after their current tasks and the exception is rethrown
+	template<typename TTask>
+	void Run( int taskCount, const TTask& task ) const;
+
+private:
+	CArray<ITrainingModel*> models;
+	bool isCopied; // the models are owned by this object
+
+	CTrainingModelCopies( const CTrainingModelCopies& );
+	CTrainingModelCopies& operator=( const CTrainingModelCopies& );
+};
+
+template<typename TTask>
+inline void CTrainingModelCopies::Run( int taskCount, const TTask& task ) const
+{
+	std::atomic<int> nextTask( 0 );
+	// An exception may not leave the parallel region
+	std::vector<std::exception_ptr> errors( models.Size() );
+	NEOML_OMP_NUM_THREADS( models.Size() )
+	{
+		const int threadNumber = OmpGetThreadNum();
+		try {
+			for( int i = nextTask++; i < taskCount; i = nextTask++ ) {
+				task( *models[threadNumber], i );
+			}
+		} catch( ... ) {
+			errors[threadNumber] = std::current_exception();
+			nextTask = taskCount;
+		}
+	}
+
+	for( const std::exception_ptr& error : errors ) {
+		if( error != nullptr ) {
+			std::rethrow_exception( error );
+		}
+	}
+}
+
+} // namespace NeoML
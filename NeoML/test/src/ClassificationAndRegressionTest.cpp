@@ -25,9 +25,63 @@ using namespace NeoMLTest;
 //---------------------------------------------------------------------------------------------------------------------
 // Common functions
 
+// Checks that the classification results are the same
+void TestSameResult( const CClassificationResult& expected, const CClassificationResult& result )
+{
+	ASSERT_EQ( expected.PreferredClass, result.PreferredClass );
+	ASSERT_EQ( expected.Probabilities.Size(), result.Probabilities.Size() );
+	for( int i = 0; i < expected.Probabilities.Size(); i++ ) {
+		const double expectedValue = expected.Probabilities[i].GetValue();
+		if( std::isnan( expectedValue ) ) {
+			// Some of the models return 0 / 0 if no class fits
+			ASSERT_TRUE( std::isnan( result.Probabilities[i].GetValue() ) );
+		} else {
+			ASSERT_NEAR( expectedValue, result.Probabilities[i].GetValue(), 1e-6 );
+		}
+	}
+}
+
+// Checks that the batch classification gives the same results as the classification of each vector
+void TestClassifyBatch( const IModel* model, const CClassificationRandomProblem* testData )
+{
+	CArray<CClassificationResult> results;
+	ASSERT_TRUE( model->ClassifyBatch( testData->GetMatrix(), results, 4 ) );
+	ASSERT_EQ( testData->GetVectorCount(), results.Size() );
+
+	for( int i = 0; i < testData->GetVectorCount(); i++ ) {
+		CClassificationResult result;
+		ASSERT_TRUE( model->Classify( testData->GetVector( i ), result ) );
+		TestSameResult( result, results[i] );
+	}
+}
+
+// Checks that the batch prediction gives the same results as the prediction on each vector
+void TestPredictBatch( const IRegressionModel* model, const CFloatMatrixDesc& matrix )
+{
+	CArray<double> results;
+	model->PredictBatch( matrix, results, 4 );
+	ASSERT_EQ( matrix.Height, results.Size() );
+
+	for( int i = 0; i < matrix.Height; i++ ) {
+		ASSERT_DOUBLE_EQ( model->Predict( matrix.GetRow( i ) ), results[i] );
+	}
+
+	// A range of rows that is not aligned to the blocks processed together
+	const CFloatMatrixDesc rows = matrix.GetRows( 3, matrix.Height - 8 );
+	model->PredictBatch( rows, results, 3 );
+	ASSERT_EQ( rows.Height, results.Size() );
+	for( int i = 0; i < rows.Height; i++ ) {
+		ASSERT_DOUBLE_EQ( model->Predict( rows.GetRow( i ) ), results[i] );
+	}
+}
+
 void TestClassificationResult( const IModel* modelDense, const IModel* modelSparse,
 	const CClassificationRandomProblem* testDataDense, const CClassificationRandomProblem* testDataSparse )
 {
+	TestClassifyBatch( modelDense, testDataDense );
+	TestClassifyBatch( modelDense, testDataSparse );
+	TestClassifyBatch( modelSparse, testDataSparse );
+
 	for( int i = 0; i < testDataSparse->GetVectorCount(); i++ ) {
 		CClassificationResult result1;
 		CClassificationResult result2;
@@ -45,6 +99,18 @@ void TestClassificationResult( const IModel* modelDense, const IModel* modelSpar
 	}
 }
 
+// Checks that the models give the same results
+void TestSameClassification( const IModel* expected, const IModel* model, const CClassificationRandomProblem* testData )
+{
+	for( int i = 0; i < testData->GetVectorCount(); i++ ) {
+		CClassificationResult expectedResult;
+		CClassificationResult result;
+		ASSERT_TRUE( expected->Classify( testData->GetVector( i ), expectedResult ) );
+		ASSERT_TRUE( model->Classify( testData->GetVector( i ), result ) );
+		TestSameResult( expectedResult, result );
+	}
+}
+
 void CrossValidate( int PartsCount, ITrainingModel& trainingModel, const IProblem* dense, const IProblem* sparse )
 {
 	CCrossValidation CrossValidation( trainingModel, dense );
@@ -185,6 +251,8 @@ protected:
 
 	void TestBinaryRegressionResult() const
 	{
+		TestPredictBatch( ModelDense, DenseBinaryTestData->GetMatrix() );
+		TestPredictBatch( ModelSparse, SparseBinaryTestData->GetMatrix() );
 		for( int i = 0; i < SparseBinaryTestData->GetVectorCount(); i++ ) {
 			double result1 = ModelDense->Predict( DenseBinaryTestData->GetVector( i ) );
 			double result2 = ModelDense->Predict( SparseBinaryTestData->GetVector( i ) );
@@ -319,6 +387,113 @@ TEST_F( RandomBinaryClassification4000x20, SvmRbf )
 	TestBinaryClassificationResult();
 }
 
+// Checks the batch classification of an SVM model with a non-linear kernel against the classification of each vector
+// The batch classification with the dense support vectors calculates the dot products in single precision
+static void testSvmClassifyBatch( const IModel& model, const CFloatMatrixDesc& data )
+{
+	CArray<CClassificationResult> results;
+	ASSERT_TRUE( model.ClassifyBatch( data, results, 4 ) );
+	ASSERT_EQ( data.Height, results.Size() );
+	for( int i = 0; i < data.Height; i++ ) {
+		CClassificationResult result;
+		ASSERT_TRUE( model.Classify( data.GetRow( i ), result ) );
+		ASSERT_EQ( result.Probabilities.Size(), results[i].Probabilities.Size() );
+		for( int j = 0; j < result.Probabilities.Size(); j++ ) {
+			ASSERT_NEAR( result.Probabilities[j].GetValue(), results[i].Probabilities[j].GetValue(), 1e-4 );
+		}
+	}
+}
+
+TEST_F( RandomBinaryClassification4000x20, SvmPoly )
+{
+	CSvm::CParams params( CSvmKernel::KT_Poly );
+	params.Degree = 2;
+	params.Gamma = 0.1;
+	CSvm svmPoly( params );
+	CPtr<IModel> model = svmPoly.Train( *DenseRandomBinaryProblem );
+
+	testSvmClassifyBatch( *model, DenseBinaryTestData->GetMatrix() );
+	testSvmClassifyBatch( *model, SparseBinaryTestData->GetMatrix() );
+}
+
+TEST_F( RandomBinaryClassification4000x20, SvmRbfClassifyBatch )
+{
+	CSvm::CParams params( CSvmKernel::KT_RBF );
+	CSvm svmRbf( params );
+	CPtr<IModel> model = svmRbf.Train( *SparseRandomBinaryProblem );
+
+	testSvmClassifyBatch( *model, DenseBinaryTestData->GetMatrix() );
+	testSvmClassifyBatch( *model, SparseBinaryTestData->GetMatrix() );
+	// A range of rows that is not aligned to the blocks processed together
+	testSvmClassifyBatch( *model, SparseBinaryTestData->GetMatrix().GetRows( 3, SparseBinaryTestData->GetVectorCount() - 8 ) );
+}
+
+TEST_F( RandomBinaryClassification4000x20, SvmSigmoidClassifyBatch )
+{
+	CSvm::CParams params( CSvmKernel::KT_Sigmoid );
+	params.Gamma = 0.01;
+	CSvm svmSigmoid( params );
+	CPtr<IModel> model = svmSigmoid.Train( *DenseRandomBinaryProblem );
+
+	testSvmClassifyBatch( *model, DenseBinaryTestData->GetMatrix() );
+	testSvmClassifyBatch( *model, SparseBinaryTestData->GetMatrix() );
+}
+
+// The support vectors with few non-zero elements are processed in the sparse format
+TEST( CSvmBinaryModelTest, SparseVectorsClassifyBatch )
+{
+	const int featureCount = 300;
+	const int vectorCount = 600;
+	const int nonZeroCount = 10;
+	CRandom random( 0x5f1 );
+	CPtr<CMemoryProblem> trainProblem = new CMemoryProblem( featureCount, 2 );
+	CPtr<CMemoryProblem> testProblem = new CMemoryProblem( featureCount, 2 );
+	for( int i = 0; i < 2 * vectorCount; i++ ) {
+		CSparseFloatVector vector;
+		for( int j = 0; j < nonZeroCount; j++ ) {
+			vector.SetAt( random.UniformInt( 0, featureCount - 1 ), static_cast<float>( random.Uniform( -1, 1 ) ) );
+		}
+		// The class depends on the first half of the features
+		double sum = 0;
+		const CFloatVectorDesc desc = vector.GetDesc();
+		for( int j = 0; j < desc.Size; j++ ) {
+			sum += desc.Indexes[j] < featureCount / 2 ? desc.Values[j] : 0;
+		}
+		( i < vectorCount ? trainProblem : testProblem )->Add( desc, sum > 0 ? 1 : 0 );
+	}
+
+	const CSvmKernel::TKernelType kernels[] = { CSvmKernel::KT_RBF, CSvmKernel::KT_Poly, CSvmKernel::KT_Sigmoid };
+	for( CSvmKernel::TKernelType kernel : kernels ) {
+		CSvm::CParams params( kernel );
+		params.Gamma = 0.1;
+		params.Degree = 2;
+		CSvm svm( params );
+		CPtr<IModel> model = svm.Train( *trainProblem );
+		ASSERT_TRUE( model != nullptr );
+		// Make sure the support vectors are sparse enough for the sparse format
+		CPtr<ISvmBinaryModel> svmModel = CheckCast<ISvmBinaryModel>( model.Ptr() );
+		const CSparseFloatMatrix vectors = svmModel->GetVectors();
+		ASSERT_LT( 2 * vectors.GetElementCount(), static_cast<__int64>( vectors.GetHeight() ) * featureCount );
+
+		testSvmClassifyBatch( *model, testProblem->GetMatrix() );
+	}
+}
+
+TEST_F( RandomBinaryClassification4000x20, SvmRbfMultiThread )
+{
+	CSvm::CParams params( CSvmKernel::KT_RBF );
+	CSvm svmRbf( params );
+	CPtr<IModel> model = svmRbf.Train( *SparseRandomBinaryProblem );
+
+	params.ThreadCount = 4;
+	CSvm multiThreadSvmRbf( params );
+	TrainBinary( multiThreadSvmRbf );
+	TestBinaryClassificationResult();
+
+	// The optimization goes the same way regardless of the number of threads
+	TestSameClassification( model, ModelSparse, SparseBinaryTestData );
+}
+
 TEST_F( RandomBinaryClassification4000x20, DecisionTree )
 {
 	CDecisionTree::CParams param;
@@ -327,6 +502,36 @@ TEST_F( RandomBinaryClassification4000x20, DecisionTree )
 	TestBinaryClassificationResult();
 }
 
+TEST_F( RandomBinaryClassification4000x20, DecisionTreeMultiThread )
+{
+	CDecisionTree::CParams param;
+	CDecisionTree decisionTree( param );
+	CPtr<IModel> model = decisionTree.Train( *SparseRandomBinaryProblem );
+
+	param.ThreadCount = 4;
+	CDecisionTree multiThreadDecisionTree( param );
+	TrainBinary( multiThreadDecisionTree );
+	TestBinaryClassificationResult();
+
+	// The tree is the same regardless of the number of threads
+	TestSameClassification( model, ModelSparse, SparseBinaryTestData );
+}
+
+TEST_F( RandomBinaryClassification4000x20, DecisionTreeFastHist )
+{
+	CDecisionTree::CParams param;
+	param.MaxBins = 32;
+	CDecisionTree decisionTree( param );
+	TrainBinary( decisionTree );
+	TestBinaryClassificationResult();
+
+	CPtr<IDecisionTreeModel> tree = CheckCast<IDecisionTreeModel>( ModelSparse );
+	CDecisionTreeNodeInfo info;
+	tree->GetNodeInfo( info );
+	EXPECT_EQ( DTNT_Continuous, info.Type );
+	EXPECT_EQ( 2, tree->GetChildrenCount() );
+}
+
 TEST_F( RandomMultiClassification2000x20, GBTB_Full )
 {
 	CRandom random( 0 );
@@ -348,6 +553,174 @@ TEST_F( RandomMultiClassification2000x20, GBTB_FastHist )
 	TestMultiClassificationResult();
 }
 
+// The classification problem split into parts by rows
+class CClassificationProblemParts : public IGradientBoostProblemParts {
+public:
+	CClassificationProblemParts( const IProblem* _problem, int _partCount ) : problem( _problem ), partCount( _partCount ) {}
+
+	int GetPartCount() const override { return partCount; }
+	CPtr<const IMultivariateRegressionProblem> GetPart( int index ) const override;
+
+private:
+	// A part of the problem
+	class CPart : public IMultivariateRegressionProblem {
+	public:
+		CPart( const IProblem* _problem, int _first, int _count ) : problem( _problem ), first( _first ), count( _count ) {}
+
+		int GetFeatureCount() const override { return problem->GetFeatureCount(); }
+		int GetVectorCount() const override { return count; }
+		CFloatMatrixDesc GetMatrix() const override { return problem->GetMatrix().GetRows( first, count ); }
+		double GetVectorWeight( int index ) const override { return problem->GetVectorWeight( first + index ); }
+		int GetValueSize() const override { return 1; }
+		CFloatVector GetValue( int index ) const override
+			{ return CFloatVector( 1, static_cast<float>( problem->GetClass( first + index ) ) ); }
+
+	private:
+		const CPtr<const IProblem> problem;
+		const int first;
+		const int count;
+	};
+
+	const CPtr<const IProblem> problem;
+	const int partCount;
+};
+
+CPtr<const IMultivariateRegressionProblem> CClassificationProblemParts::GetPart( int index ) const
+{
+	const int first = problem->GetVectorCount() * index / partCount;
+	const int last = problem->GetVectorCount() * ( index + 1 ) / partCount;
+	return new CPart( problem, first, last - first );
+}
+
+// The classification problem that has no vector data, only the classes and the weights
+class CProblemWithoutVectors : public IProblem {
+public:
+	explicit CProblemWithoutVectors( const IProblem* _problem ) : problem( _problem ) {}
+
+	int GetClassCount() const override { return problem->GetClassCount(); }
+	int GetFeatureCount() const override { return problem->GetFeatureCount(); }
+	bool IsDiscreteFeature( int index ) const override { return problem->IsDiscreteFeature( index ); }
+	int GetVectorCount() const override { return problem->GetVectorCount(); }
+	int GetClass( int index ) const override { return problem->GetClass( index ); }
+	CFloatMatrixDesc GetMatrix() const override;
+	double GetVectorWeight( int index ) const override { return problem->GetVectorWeight( index ); }
+
+private:
+	const CPtr<const IProblem> problem;
+};
+
+CFloatMatrixDesc CProblemWithoutVectors::GetMatrix() const
+{
+	CFloatMatrixDesc matrix;
+	matrix.Height = problem->GetVectorCount();
+	matrix.Width = problem->GetFeatureCount();
+	return matrix;
+}
+
+TEST_F( RandomMultiClassification2000x20, GBTB_FastHistBinnedData )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 10;
+	params.TreeBuilder = GBTB_FastHist;
+	CGradientBoost boosting( params );
+	CPtr<IModel> expected = boosting.Train( *SparseRandomMultiProblem );
+	const double expectedLoss = boosting.GetLastLossMean();
+
+	const CString fileName = GetTestTempFilePath( "GradientBoostBinnedData.bin" );
+	CPtr<CClassificationProblemParts> parts = new CClassificationProblemParts( DenseRandomMultiProblem, 3 );
+	boosting.WriteBinnedData( *parts, fileName );
+	boosting.SetBinnedDataFile( fileName );
+	random.Reset( 0 );
+	// The vectors are read only from the binned data file
+	CPtr<CProblemWithoutVectors> problem = new CProblemWithoutVectors( DenseRandomMultiProblem );
+	CPtr<IModel> model = boosting.Train( *problem );
+	::remove( fileName );
+
+	// The model is the same as if the data were binned in memory
+	TestSameClassification( expected, model, SparseMultiTestData );
+	TestSameClassification( expected, model, DenseMultiTestData );
+	EXPECT_NEAR( expectedLoss, boosting.GetLastLossMean(), 1e-6 );
+}
+
+TEST_F( RandomMultiClassification2000x20, GBEarlyStopping )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 100;
+	params.EarlyStoppingPatience = 5;
+	CGradientBoost boosting( params );
+	boosting.SetValidationProblem( DenseMultiTestData );
+	CPtr<IModel> model = boosting.Train( *DenseRandomMultiProblem );
+
+	const CArray<double>& validationLoss = boosting.GetValidationLoss();
+	const int bestIterationsCount = boosting.GetBestIterationsCount();
+	ASSERT_LT( 0, bestIterationsCount );
+	ASSERT_LT( validationLoss.Size(), params.IterationsCount );
+	ASSERT_EQ( bestIterationsCount + params.EarlyStoppingPatience, validationLoss.Size() );
+	for( int i = 0; i < validationLoss.Size(); i++ ) {
+		ASSERT_LE( validationLoss[bestIterationsCount - 1], validationLoss[i] );
+	}
+	const CArray<CGradientBoostEnsemble>& ensembles = CheckCast<IGradientBoostModel>( model )->GetEnsemble();
+	for( int i = 0; i < ensembles.Size(); i++ ) {
+		ASSERT_EQ( bestIterationsCount, ensembles[i].Size() );
+	}
+
+	// The model is the same as the one trained for the best number of iterations
+	random.Reset( 0 );
+	params.IterationsCount = bestIterationsCount;
+	params.EarlyStoppingPatience = 0;
+	CGradientBoost expectedBoosting( params );
+	expectedBoosting.SetValidationProblem( DenseMultiTestData );
+	CPtr<IModel> expected = expectedBoosting.Train( *DenseRandomMultiProblem );
+	TestSameClassification( expected, model, DenseMultiTestData );
+	ASSERT_DOUBLE_EQ( expectedBoosting.GetLastLossMean(), boosting.GetLastLossMean() );
+
+	// The validation loss of the same iterations does not depend on the early stopping
+	const CArray<double>& expectedValidationLoss = expectedBoosting.GetValidationLoss();
+	ASSERT_EQ( bestIterationsCount, expectedValidationLoss.Size() );
+	for( int i = 0; i < bestIterationsCount; i++ ) {
+		ASSERT_DOUBLE_EQ( validationLoss[i], expectedValidationLoss[i] );
+	}
+}
+
+// Gets the number of leaves in a tree
+static int getLeavesCount( const IRegressionTreeNode& node )
+{
+	CPtr<const IRegressionTreeNode> left = node.GetLeftChild();
+	if( left == nullptr ) {
+		return 1;
+	}
+	return getLeavesCount( *left ) + getLeavesCount( *node.GetRightChild() );
+}
+
+TEST_F( RandomMultiClassification2000x20, GBTB_FastHistLeafWise )
+{
+	const int maxLeavesCount = 8;
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 10;
+	params.TreeBuilder = GBTB_FastHist;
+	params.MaxLeavesCount = maxLeavesCount;
+	TrainMultiGradientBoost( params );
+	TestMultiClassificationResult();
+
+	const CArray<CGradientBoostEnsemble>& ensembles = CheckCast<IGradientBoostModel>( ModelDense )->GetEnsemble();
+	for( int i = 0; i < ensembles.Size(); i++ ) {
+		for( int j = 0; j < ensembles[i].Size(); j++ ) {
+			ASSERT_GE( maxLeavesCount, getLeavesCount( *ensembles[i][j] ) );
+		}
+	}
+
+	// The histograms evicted from the pool are rebuilt
+	params.MaxHistCount = 2;
+	TrainMultiGradientBoost( params );
+	TestMultiClassificationResult();
+}
+
 TEST_F( RandomMultiClassification2000x20, GBTB_MultiFull )
 {
 	CRandom random( 0 );
@@ -454,6 +827,44 @@ TEST_F( RandomMultiClassification2000x20, OneVsAllDecisionTree )
 	TestClassificationResult( ModelSparse, modelImplicitSparse, DenseMultiTestData, SparseMultiTestData );
 }
 
+TEST_F( RandomMultiClassification2000x20, DecisionTreeFastHistMultiThread )
+{
+	CDecisionTree::CParams param;
+	param.MaxBins = 64;
+	param.ThreadCount = 4;
+	CDecisionTree decisionTree( param );
+	TrainMulti( decisionTree );
+	TestMultiClassificationResult();
+}
+
+TEST_F( RandomMultiClassification2000x20, OneVsAllLinearMultiThread )
+{
+	CLinear linear( EF_SquaredHinge );
+	COneVersusAll ovaLinear( linear );
+	CPtr<IModel> model = ovaLinear.Train( *DenseRandomMultiProblem );
+
+	ovaLinear.SetThreadCount( 4 );
+	TrainMulti( ovaLinear );
+	TestMultiClassificationResult();
+	TestSameClassification( model, ModelDense, DenseMultiTestData );
+}
+
+// The training model that always fails
+class CFailingTrainingModel : public ITrainingModel {
+public:
+	CPtr<IModel> Train( const IProblem& ) override { throw std::runtime_error( "training failed" ); }
+	ITrainingModel* CreateCopy( int ) const override { return new CFailingTrainingModel(); }
+};
+
+TEST_F( RandomMultiClassification2000x20, OneVsAllMultiThreadException )
+{
+	CFailingTrainingModel failing;
+	COneVersusAll ova( failing );
+	ova.SetThreadCount( 4 );
+	// The exception thrown by a parallel training reaches the caller
+	EXPECT_THROW( ova.Train( *DenseRandomMultiProblem ), std::runtime_error );
+}
+
 TEST_F( RandomMultiClassification2000x20, OneVsOneLinear )
 {
 	CLinear::CParams params( EF_SquaredHinge );
@@ -511,6 +922,19 @@ TEST_F( RandomMultiClassification2000x20, OneVsOneDecisionTree )
 	TestClassificationResult( ModelSparse, modelImplicitSparse, DenseMultiTestData, SparseMultiTestData );
 }
 
+TEST_F( RandomMultiClassification2000x20, OneVsOneDecisionTreeMultiThread )
+{
+	CDecisionTree::CParams param;
+	CDecisionTree decisionTree( param );
+	COneVersusOne ovoDecisionTree( decisionTree );
+	CPtr<IModel> model = ovoDecisionTree.Train( *SparseRandomMultiProblem );
+
+	ovoDecisionTree.SetThreadCount( 4 );
+	TrainMulti( ovoDecisionTree );
+	TestMultiClassificationResult();
+	TestSameClassification( model, ModelSparse, SparseMultiTestData );
+}
+
 TEST_F( RandomBinaryClassification4000x20, CrossValidationLinear )
 {
 	CLinear linear( EF_SquaredHinge );
@@ -536,6 +960,29 @@ TEST_F( RandomBinaryClassification4000x20, CrossValidationDecisionTree )
 	CrossValidate( 10, decisionTree, DenseRandomBinaryProblem, SparseRandomBinaryProblem );
 }
 
+TEST_F( RandomBinaryClassification4000x20, CrossValidationMultiThread )
+{
+	CLinear linear( EF_SquaredHinge );
+	CCrossValidation crossValidation( linear, DenseRandomBinaryProblem );
+	CCrossValidationResult expected;
+	crossValidation.Execute( 10, AccuracyScore, expected, true );
+
+	crossValidation.SetThreadCount( 4 );
+	CCrossValidationResult result;
+	crossValidation.Execute( 10, AccuracyScore, result, true );
+
+	ASSERT_EQ( expected.Models.Size(), result.Models.Size() );
+	for( int i = 0; i < expected.Models.Size(); i++ ) {
+		ASSERT_DOUBLE_EQ( expected.Success[i], result.Success[i] );
+		TestSameClassification( expected.Models[i], result.Models[i], DenseBinaryTestData );
+	}
+	ASSERT_EQ( expected.Results.Size(), result.Results.Size() );
+	for( int i = 0; i < expected.Results.Size(); i++ ) {
+		ASSERT_EQ( expected.ModelIndex[i], result.ModelIndex[i] );
+		ASSERT_EQ( expected.Results[i].PreferredClass, result.Results[i].PreferredClass );
+	}
+}
+
 // Test regression
 TEST_F( RandomBinaryRegression4000x20, Linear )
 {
@@ -558,6 +1005,8 @@ TEST_F( RandomBinaryRegression4000x20, Linear )
 	GTEST_LOG_( INFO ) << "Sparse train time: " << GetTickCount() - begin;
 	ASSERT_TRUE( model2 != nullptr );
 
+	TestPredictBatch( model, denseBinaryTestData->GetMatrix() );
+	TestPredictBatch( model2, sparseBinaryTestData->GetMatrix() );
 	for( int i = 0; i < sparseBinaryTestData->GetVectorCount(); i++ ) {
 		double result1 = model->Predict( denseBinaryTestData->GetVector( i ) );
 		double result2 = model->Predict( sparseBinaryTestData->GetVector( i ) );
@@ -592,6 +1041,52 @@ TEST_F( RandomBinaryGBRegression4000x20, FastHist )
 	TestBinaryRegressionResult();
 }
 
+// The quadratic loss function implemented outside of the library
+class CCustomSquareLoss : public IGradientBoostingLossFunction {
+public:
+	void CalcGradientAndHessian( const double* predicts, const double* answers, int size,
+		double* gradients, double* hessians ) const override
+	{
+		for( int i = 0; i < size; i++ ) {
+			gradients[i] = predicts[i] - answers[i];
+			hessians[i] = 1.0;
+		}
+	}
+
+	double CalcLossSum( const double* predicts, const double* answers, int size ) const override
+	{
+		double sum = 0;
+		for( int i = 0; i < size; i++ ) {
+			sum += ( answers[i] - predicts[i] ) * ( answers[i] - predicts[i] ) / 2.0;
+		}
+		return sum;
+	}
+};
+
+TEST_F( RandomBinaryGBRegression4000x20, CustomLossFunction )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 10;
+	params.LossFunction = CGradientBoost::LF_L2;
+	TrainBinaryGradientBoost( params );
+	CPtr<IRegressionModel> expected = ModelDense;
+
+	CPtr<CCustomSquareLoss> lossFunction = new CCustomSquareLoss();
+	random.Reset( 0 );
+	params.LossFunction = CGradientBoost::LF_Custom;
+	params.CustomLossFunction = lossFunction;
+	TrainBinaryGradientBoost( params );
+	TestBinaryRegressionResult();
+
+	// The custom function gives the same ensemble as the built-in one
+	for( int i = 0; i < DenseBinaryTestData->GetVectorCount(); i++ ) {
+		ASSERT_DOUBLE_EQ( expected->Predict( DenseBinaryTestData->GetVector( i ) ),
+			ModelDense->Predict( DenseBinaryTestData->GetVector( i ) ) );
+	}
+}
+
 // GB multi tree builders
 TEST_F( RandomMultiGBRegression2000x20, Full )
 {
@@ -164,6 +164,40 @@ static void hierarchicalClustering( IClusteringData* data, CClusteringResult& re
 	hierarchical.Clusterize( data, result );
 }
 
+static void hierarchicalLinkageClustering( IClusteringData* data, CClusteringResult& result,
+	CHierarchicalClustering::TLinkage linkage )
+{
+	CHierarchicalClustering::CParam params;
+	params.DistanceType = DF_Euclid;
+	params.MinClustersCount = 2;
+	params.MaxClustersDistance = 50;
+	params.Linkage = linkage;
+	params.ThreadCount = 4;
+
+	CHierarchicalClustering hierarchical( params );
+	hierarchical.Clusterize( data, result );
+}
+
+static void hierarchicalSingleClustering( IClusteringData* data, CClusteringResult& result )
+{
+	hierarchicalLinkageClustering( data, result, CHierarchicalClustering::L_Single );
+}
+
+static void hierarchicalAverageClustering( IClusteringData* data, CClusteringResult& result )
+{
+	hierarchicalLinkageClustering( data, result, CHierarchicalClustering::L_Average );
+}
+
+static void hierarchicalCompleteClustering( IClusteringData* data, CClusteringResult& result )
+{
+	hierarchicalLinkageClustering( data, result, CHierarchicalClustering::L_Complete );
+}
+
+static void hierarchicalWardClustering( IClusteringData* data, CClusteringResult& result )
+{
+	hierarchicalLinkageClustering( data, result, CHierarchicalClustering::L_Ward );
+}
+
 static void isoDataClustering( IClusteringData* data, CClusteringResult& result )
 {
 	CIsoDataClustering::CParam params;
@@ -364,6 +398,10 @@ TEST_F( CClusteringTest, PrecalcHierarchical )
 	expectedResult.Clusters[1].Norm = 1.273450;
 
 	precalcTestImpl( hierarchicalClustering, expectedResult );
+	// The same clusters are found with the other linkages
+	precalcTestImpl( hierarchicalAverageClustering, expectedResult );
+	precalcTestImpl( hierarchicalCompleteClustering, expectedResult );
+	precalcTestImpl( hierarchicalWardClustering, expectedResult );
 }
 
 TEST_F( CClusteringTest, PrecalcIsoData )
@@ -413,5 +451,6 @@ TEST_F( CClusteringTest, PrecalcKmeans )
 }
 
 INSTANTIATE_TEST_CASE_P( CClusteringTestInstantiation, CClusteringTest,
-	::testing::Values( firstComeClustering, hierarchicalClustering,
+	::testing::Values( firstComeClustering, hierarchicalClustering, hierarchicalSingleClustering,
+		hierarchicalAverageClustering, hierarchicalCompleteClustering, hierarchicalWardClustering,
 		isoDataClustering, kmeansElkanClustering, kmeansLloydClustering ) );
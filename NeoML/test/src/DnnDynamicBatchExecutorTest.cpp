@@ -0,0 +1,96 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+#include <thread>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> createBatchExecutorTestInput( IMathEngine& mathEngine, int seed, int batchWidth )
+{
+	CRandom random( seed );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, batchWidth, 7 );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+TEST( CDnnDynamicBatchExecutorTest, MergesRequests )
+{
+	IMathEngine& mathEngine = MathEngine();
+
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+	CSourceLayer* source = Source( dnn, "source" );
+	Sink( FullyConnected( 3 )( Relu()( FullyConnected( 16 )( source ) ) ), "sink" );
+	// Initialize the weights
+	source->SetBlob( createBatchExecutorTestInput( mathEngine, 0, 1 ) );
+	dnn.RunOnce();
+
+	CArray<CString> sources = { "source" };
+	CArray<CString> sinks = { "sink" };
+
+	const int threadCount = 4;
+	const int requestCount = 20;
+	CArray<CArray<float>> results;
+	results.SetSize( threadCount * requestCount );
+	{
+		CDnnDynamicBatchExecutor executor( dnn, sources, sinks, 8, 5 );
+		std::vector<std::thread> threads;
+		for( int t = 0; t < threadCount; ++t ) {
+			threads.emplace_back( [&, t]() {
+				for( int r = 0; r < requestCount; ++r ) {
+					const int id = t * requestCount + r;
+					CObjectArray<CDnnBlob> inputs;
+					inputs.Add( createBatchExecutorTestInput( mathEngine, id + 1, 1 + id % 2 ) );
+					CObjectArray<CDnnBlob> outputs;
+					executor.Run( inputs, outputs );
+					ASSERT_EQ( 1, outputs.Size() );
+					ASSERT_EQ( 1 + id % 2, outputs[0]->GetBatchWidth() );
+					results[id].SetSize( outputs[0]->GetDataSize() );
+					outputs[0]->CopyTo( results[id].GetPtr() );
+				}
+			} );
+		}
+		for( std::thread& thread : threads ) {
+			thread.join();
+		}
+		EXPECT_EQ( threadCount * requestCount, executor.GetProcessedRequestCount() );
+		EXPECT_LE( executor.GetProcessedBatchCount(), executor.GetProcessedRequestCount() );
+	}
+
+	// The network is free again after the executor is destroyed
+	for( int id = 0; id < results.Size(); ++id ) {
+		source->SetBlob( createBatchExecutorTestInput( mathEngine, id + 1, 1 + id % 2 ) );
+		dnn.RunOnce();
+		CPtr<CDnnBlob> expected = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob();
+		CArray<float> expectedData;
+		expectedData.SetSize( expected->GetDataSize() );
+		expected->CopyTo( expectedData.GetPtr() );
+		ASSERT_EQ( expectedData.Size(), results[id].Size() );
+		for( int i = 0; i < expectedData.Size(); ++i ) {
+			EXPECT_NEAR( expectedData[i], results[id][i], 1e-4f ) << id << " " << i;
+		}
+	}
+}
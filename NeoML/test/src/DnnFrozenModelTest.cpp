@@ -0,0 +1,234 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> createFrozenModelTestInput( IMathEngine& mathEngine )
+{
+	CRandom random( 0x1234 );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 3, 2, 5 );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+static void getSinkData( CDnn& dnn, CArray<float>& result )
+{
+	CPtr<CDnnBlob> output = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob();
+	result.SetSize( output->GetDataSize() );
+	output->CopyTo( result.GetPtr() );
+}
+
+// Gets the position in the file where the weights of the fully connected layer are stored
+// and the pointer to the weights data of the loaded layer
+static void getFcWeightsLocation( const CArray<char>& fileData, const CFullyConnectedLayer& layer,
+	const CFullyConnectedLayer& loadedLayer, __int64& filePosition, const char*& data, __int64& dataSize )
+{
+	CArray<float> weights;
+	weights.SetSize( layer.GetWeights()->GetDataSize() );
+	layer.GetWeights()->CopyTo( weights.GetPtr() );
+	const char* weightsBytes = reinterpret_cast<const char*>( weights.GetPtr() );
+	dataSize = weights.Size() * static_cast<__int64>( sizeof( float ) );
+	const char* found = std::search( fileData.GetPtr(), fileData.GetPtr() + fileData.Size(),
+		weightsBytes, weightsBytes + dataSize );
+	filePosition = found - fileData.GetPtr();
+
+	const CDnnBlob* loadedWeights = loadedLayer.GetWeights();
+	IMathEngine& mathEngine = loadedWeights->GetMathEngine();
+	data = static_cast<const char*>( mathEngine.GetBuffer( loadedWeights->GetData(), 0, static_cast<size_t>( dataSize ), false ) );
+	mathEngine.ReleaseBuffer( loadedWeights->GetData(), const_cast<char*>( data ), false );
+}
+
+TEST( CDnnFrozenModelTest, SharedParamsInference )
+{
+	IMathEngine& mathEngine = MathEngine();
+
+	// The reference network: fully connected layers, batch normalization and a composite LSTM layer
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+	CSourceLayer* source = Source( dnn, "source" );
+	CBaseLayer* fc = FullyConnected( 8 )( source );
+	CBatchNormalizationLayer* batchNorm = BatchNormalization( true )( fc );
+	CBaseLayer* lstm = Lstm( 6, 0.f )( Relu()( batchNorm ) );
+	Sink( FullyConnected( 4 )( lstm ), "sink" );
+
+	// The final parameters of batch normalization are stored outside of the trainable parameters
+	CPtr<CDnnBlob> finalParams = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, 2, 8 );
+	CArray<float> finalParamsData;
+	finalParamsData.SetSize( finalParams->GetDataSize() );
+	for( int i = 0; i < finalParamsData.Size(); ++i ) {
+		finalParamsData[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	finalParams->CopyFrom( finalParamsData.GetPtr() );
+	batchNorm->SetFinalParams( finalParams );
+
+	source->SetBlob( createFrozenModelTestInput( mathEngine ) );
+	dnn.RunOnce();
+	CArray<float> expected;
+	getSinkData( dnn, expected );
+
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	file.SeekToBegin();
+	CArchive archive( &file, CArchive::SD_Loading );
+	CPtr<CDnnFrozenModel> model = new CDnnFrozenModel( mathEngine, archive );
+	archive.Close();
+
+	size_t expectedParamsSize = 0;
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		expectedParamsSize += dnn.GetLayer( layerList[i] )->GetTrainableParametersSize();
+	}
+	EXPECT_EQ( expectedParamsSize, model->GetTrainableParametersSize() );
+
+	const int threadCount = 4;
+	CObjectArray<CDnnInferenceContext> contexts;
+	for( int i = 0; i < threadCount; ++i ) {
+		contexts.Add( model->CreateContext() );
+	}
+
+	CArray<CArray<float>> results;
+	results.SetSize( threadCount );
+	std::vector<std::thread> threads;
+	for( int i = 0; i < threadCount; ++i ) {
+		threads.emplace_back( [&contexts, &results, i]() {
+			CDnn& contextDnn = contexts[i]->Dnn();
+			CheckCast<CSourceLayer>( contextDnn.GetLayer( "source" ) )->SetBlob(
+				createFrozenModelTestInput( contextDnn.GetMathEngine() ) );
+			for( int run = 0; run < 10; ++run ) {
+				contextDnn.RunOnce();
+			}
+			getSinkData( contextDnn, results[i] );
+		} );
+	}
+	for( std::thread& thread : threads ) {
+		thread.join();
+	}
+
+	for( int i = 0; i < threadCount; ++i ) {
+		ASSERT_EQ( expected.Size(), results[i].Size() );
+		for( int j = 0; j < expected.Size(); ++j ) {
+			EXPECT_NEAR( expected[j], results[i][j], 1e-4f ) << i << " " << j;
+		}
+	}
+}
+
+TEST( CDnnFrozenModelTest, MappedFileInference )
+{
+	IMathEngine& mathEngine = MathEngine();
+
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+	CSourceLayer* source = Source( dnn, "source" );
+	CBaseLayer* fc = FullyConnected( 8 )( source );
+	CBaseLayer* lstm = Lstm( 6, 0.f )( Relu()( fc ) );
+	CBaseLayer* lastFc = FullyConnected( 4 )( lstm );
+	Sink( lastFc, "sink" );
+
+	source->SetBlob( createFrozenModelTestInput( mathEngine ) );
+	dnn.RunOnce();
+	CArray<float> expected;
+	getSinkData( dnn, expected );
+
+	const CString fileName = GetTestTempFilePath( "DnnFrozenModelMapped.dnn" );
+	{
+		CArchiveFile file( fileName, CArchive::SD_Storing, GetPlatformEnv() );
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+
+	{
+		CPtr<CDnnFrozenModel> model = new CDnnFrozenModel( mathEngine, fileName );
+		CPtr<CDnnInferenceContext> context = model->CreateContext();
+		CDnn& contextDnn = context->Dnn();
+		CheckCast<CSourceLayer>( contextDnn.GetLayer( "source" ) )->SetBlob( createFrozenModelTestInput( mathEngine ) );
+		contextDnn.RunOnce();
+		CArray<float> result;
+		getSinkData( contextDnn, result );
+		ASSERT_EQ( expected.Size(), result.Size() );
+		for( int i = 0; i < expected.Size(); ++i ) {
+			EXPECT_NEAR( expected[i], result[i], 1e-4f ) << i;
+		}
+	}
+
+	{
+		// The parameters of the network loaded from a mapped file may be changed, the file stays the same
+		CRandom loadedRandom( 42 );
+		CDnn loaded( loadedRandom, mathEngine );
+		LoadDnnFromMappedFile( loaded, fileName );
+		CFullyConnectedLayer* loadedFc = CheckCast<CFullyConnectedLayer>( loaded.GetLayer( fc->GetName() ) );
+		CPtr<CDnnBlob> weights = loadedFc->GetWeightsData();
+		weights->Fill( 0.5f );
+		loadedFc->SetWeightsData( weights );
+		CheckCast<CSourceLayer>( loaded.GetLayer( "source" ) )->SetBlob( createFrozenModelTestInput( mathEngine ) );
+		loaded.RunOnce();
+	}
+
+	{
+		CRandom loadedRandom( 42 );
+		CDnn loaded( loadedRandom, mathEngine );
+		LoadDnnFromMappedFile( loaded, fileName );
+		CheckCast<CSourceLayer>( loaded.GetLayer( "source" ) )->SetBlob( createFrozenModelTestInput( mathEngine ) );
+		loaded.RunOnce();
+		CArray<float> result;
+		getSinkData( loaded, result );
+		ASSERT_EQ( expected.Size(), result.Size() );
+		for( int i = 0; i < expected.Size(); ++i ) {
+			EXPECT_NEAR( expected[i], result[i], 1e-4f ) << i;
+		}
+
+		if( mathEngine.GetType() == MET_Cpu ) {
+			// The weights are not copied: both layers point into the same mapping of the whole file
+			CArray<char> fileData;
+			{
+				CArchiveFile file( fileName, CArchive::SD_Loading, GetPlatformEnv() );
+				fileData.SetSize( static_cast<int>( file.GetLength() ) );
+				file.Read( fileData.GetPtr(), fileData.Size() );
+			}
+			__int64 fcPosition = 0;
+			const char* fcData = nullptr;
+			__int64 fcSize = 0;
+			getFcWeightsLocation( fileData, *CheckCast<CFullyConnectedLayer>( fc ),
+				*CheckCast<CFullyConnectedLayer>( loaded.GetLayer( fc->GetName() ) ), fcPosition, fcData, fcSize );
+			__int64 lastFcPosition = 0;
+			const char* lastFcData = nullptr;
+			__int64 lastFcSize = 0;
+			getFcWeightsLocation( fileData, *CheckCast<CFullyConnectedLayer>( lastFc ),
+				*CheckCast<CFullyConnectedLayer>( loaded.GetLayer( lastFc->GetName() ) ), lastFcPosition, lastFcData, lastFcSize );
+			ASSERT_LE( fcPosition + fcSize, fileData.Size() );
+			ASSERT_LE( lastFcPosition + lastFcSize, fileData.Size() );
+			// The data of both layers lies inside the range that starts at the same address and has the length of the file
+			EXPECT_EQ( fcData - fcPosition, lastFcData - lastFcPosition );
+		}
+	}
+	::remove( fileName );
+}
@@ -0,0 +1,111 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> createFusedAttentionTestBlob( IMathEngine& mathEngine, int batchWidth, int listSize,
+	int channels, CRandom& random )
+{
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateListBlob( mathEngine, CT_Float, 1, batchWidth, listSize, channels );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+static void runFusedAttentionTestDnn( CDnn& dnn, int seed, CArray<float>& result )
+{
+	CRandom random( seed );
+	IMathEngine& mathEngine = dnn.GetMathEngine();
+	CheckCast<CSourceLayer>( dnn.GetLayer( "q" ) )->SetBlob( createFusedAttentionTestBlob( mathEngine, 2, 5, 6, random ) );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "k" ) )->SetBlob( createFusedAttentionTestBlob( mathEngine, 2, 7, 6, random ) );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "v" ) )->SetBlob( createFusedAttentionTestBlob( mathEngine, 2, 7, 4, random ) );
+	if( dnn.HasLayer( "mask" ) ) {
+		// 1 excludes the key from the attention
+		CPtr<CDnnBlob> mask = CDnnBlob::Create2DImageBlob( mathEngine, CT_Float, 1, 1, 1, 5, 7 );
+		CArray<float> maskData;
+		maskData.SetSize( mask->GetDataSize() );
+		for( int i = 0; i < maskData.Size(); ++i ) {
+			maskData[i] = random.Next() % 3 == 0 ? 1.f : 0.f;
+		}
+		mask->CopyFrom( maskData.GetPtr() );
+		CheckCast<CSourceLayer>( dnn.GetLayer( "mask" ) )->SetBlob( mask );
+	}
+	dnn.RunOnce();
+	CPtr<CDnnBlob> output = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob();
+	result.SetSize( output->GetDataSize() );
+	output->CopyTo( result.GetPtr() );
+}
+
+TEST( CDnnFusedAttentionTest, MultiheadAttention )
+{
+	IMathEngine& mathEngine = MathEngine();
+	if( mathEngine.GetType() != MET_Cpu ) {
+		return;
+	}
+
+	for( int useMask = 0; useMask < 2; ++useMask ) {
+		CRandom random( 42 );
+		CDnn dnn( random, mathEngine );
+		CPtr<CMultiheadAttentionLayer> attention = new CMultiheadAttentionLayer( mathEngine );
+		attention->SetName( "attention" );
+		attention->SetHeadCount( 2 );
+		attention->SetHiddenSize( 8 );
+		attention->SetOutputSize( 3 );
+		attention->SetDropoutRate( 0.1f );
+		attention->SetUseMask( useMask != 0 );
+		attention->Connect( 0, *Source( dnn, "q" ) );
+		attention->Connect( 1, *Source( dnn, "k" ) );
+		attention->Connect( 2, *Source( dnn, "v" ) );
+		if( useMask != 0 ) {
+			attention->Connect( 3, *Source( dnn, "mask" ) );
+		}
+		dnn.AddLayer( *attention );
+		Sink( attention.Ptr(), "sink" );
+
+		// The internal layers are created on the first run; non-zero free terms are set after that
+		CArray<float> result;
+		runFusedAttentionTestDnn( dnn, 1, result );
+		const char* const fcNames[] = { "Q", "K", "V", "Out.Dense" };
+		for( int i = 0; i < static_cast<int>( _countof( fcNames ) ); ++i ) {
+			CFullyConnectedLayer* fc = CheckCast<CFullyConnectedLayer>( attention->GetLayer( fcNames[i] ) );
+			CPtr<CDnnBlob> freeTerm = CDnnBlob::CreateVector( mathEngine, CT_Float, fc->GetNumberOfElements() );
+			freeTerm->Fill( 0.1f * ( i + 1 ) );
+			fc->SetFreeTermData( freeTerm );
+		}
+
+		for( int seed = 1; seed <= 3; ++seed ) {
+			attention->SetFusedInference( false );
+			CArray<float> expected;
+			runFusedAttentionTestDnn( dnn, seed, expected );
+
+			attention->SetFusedInference( true );
+			runFusedAttentionTestDnn( dnn, seed, result );
+			ASSERT_EQ( expected.Size(), result.Size() );
+			for( int i = 0; i < expected.Size(); ++i ) {
+				EXPECT_NEAR( expected[i], result[i], 1e-4f );
+			}
+		}
+	}
+}
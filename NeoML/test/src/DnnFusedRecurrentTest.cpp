@@ -0,0 +1,128 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static const int FusedRecurrentTestRunCount = 3;
+
+static CPtr<CDnnBlob> createFusedRecurrentTestInput( IMathEngine& mathEngine, int seed )
+{
+	CRandom random( seed );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 7, 3, 5 );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+// Runs the network several times in a row, so that the state is passed between the runs
+static void runFusedRecurrentTestDnn( CDnn& dnn, const CArray<CString>& sinkNames, CArray<float>& result )
+{
+	dnn.RestartSequence();
+	result.DeleteAll();
+	for( int run = 0; run < FusedRecurrentTestRunCount; ++run ) {
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob(
+			createFusedRecurrentTestInput( dnn.GetMathEngine(), run + 1 ) );
+		dnn.RunOnce();
+		for( int i = 0; i < sinkNames.Size(); ++i ) {
+			CPtr<CDnnBlob> output = CheckCast<CSinkLayer>( dnn.GetLayer( sinkNames[i] ) )->GetBlob();
+			const int offset = result.Size();
+			result.SetSize( offset + output->GetDataSize() );
+			output->CopyTo( result.GetPtr() + offset );
+		}
+	}
+}
+
+static void checkFusedRecurrentResult( const CArray<float>& expected, const CArray<float>& result )
+{
+	ASSERT_EQ( expected.Size(), result.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i], result[i], 1e-4f );
+	}
+}
+
+TEST( CDnnFusedRecurrentTest, Lstm )
+{
+	IMathEngine& mathEngine = MathEngine();
+	if( mathEngine.GetType() != MET_Cpu ) {
+		return;
+	}
+
+	for( int reverse = 0; reverse < 2; ++reverse ) {
+		CRandom random( 42 );
+		CDnn dnn( random, mathEngine );
+		CSourceLayer* source = Source( dnn, "source" );
+		CLstmLayer* lstm = Lstm( 6, 0.1f )( source );
+		lstm->SetReverseSequence( reverse != 0 );
+		// Non-zero free terms for both fully connected layers
+		CPtr<CDnnBlob> inputFreeTerm = CDnnBlob::CreateVector( mathEngine, CT_Float, 4 * 6 );
+		inputFreeTerm->Fill( 0.1f );
+		lstm->SetInputFreeTermData( inputFreeTerm );
+		CPtr<CDnnBlob> recurFreeTerm = CDnnBlob::CreateVector( mathEngine, CT_Float, 4 * 6 );
+		recurFreeTerm->Fill( -0.2f );
+		lstm->SetRecurFreeTermData( recurFreeTerm );
+		Sink( CDnnLayerLink( lstm, 0 ), "output" );
+		Sink( CDnnLayerLink( lstm, 1 ), "state" );
+
+		CArray<CString> sinkNames;
+		sinkNames.Add( "output" );
+		sinkNames.Add( "state" );
+
+		CArray<float> expected;
+		runFusedRecurrentTestDnn( dnn, sinkNames, expected );
+
+		lstm->SetFusedInference( true );
+		CArray<float> result;
+		runFusedRecurrentTestDnn( dnn, sinkNames, result );
+		checkFusedRecurrentResult( expected, result );
+	}
+}
+
+TEST( CDnnFusedRecurrentTest, Gru )
+{
+	IMathEngine& mathEngine = MathEngine();
+	if( mathEngine.GetType() != MET_Cpu ) {
+		return;
+	}
+
+	for( int reverse = 0; reverse < 2; ++reverse ) {
+		CRandom random( 42 );
+		CDnn dnn( random, mathEngine );
+		CSourceLayer* source = Source( dnn, "source" );
+		CGruLayer* gru = Gru( 6 )( source );
+		gru->SetReverseSequence( reverse != 0 );
+		Sink( gru, "output" );
+
+		CArray<CString> sinkNames;
+		sinkNames.Add( "output" );
+
+		CArray<float> expected;
+		runFusedRecurrentTestDnn( dnn, sinkNames, expected );
+
+		gru->SetFusedInference( true );
+		CArray<float> result;
+		runFusedRecurrentTestDnn( dnn, sinkNames, result );
+		checkFusedRecurrentResult( expected, result );
+	}
+}
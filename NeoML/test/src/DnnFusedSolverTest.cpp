@@ -0,0 +1,215 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+typedef CPtr<CDnnSolver> ( *TCreateFusedSolverTestSolver )( IMathEngine& mathEngine );
+
+static CPtr<CDnnBlob> createFusedSolverTestBlob( IMathEngine& mathEngine, int batchWidth, int channels, CRandom& random )
+{
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, batchWidth, channels );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+// Trains a network of several fully connected layers of different sizes and returns all its weights
+static void trainFusedSolverTestDnn( TCreateFusedSolverTestSolver createSolver, bool isFused, CArray<float>& weights )
+{
+	IMathEngine& mathEngine = MathEngine();
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+
+	CPtr<CSourceLayer> source = Source( dnn, "source" );
+	CPtr<CSourceLayer> target = Source( dnn, "target" );
+	// The second layer has more parameters than a fused step processes in one block
+	CPtr<CFullyConnectedLayer> fc1 = FullyConnected( 150 )( "fc1", source.Ptr() );
+	CPtr<CFullyConnectedLayer> fc2 = FullyConnected( 130 )( "fc2", fc1.Ptr() );
+	CPtr<CFullyConnectedLayer> fc3 = FullyConnected( 3 )( "fc3", fc2.Ptr() );
+	EuclideanLoss()( "loss", fc3.Ptr(), target.Ptr() );
+	fc1->SetBaseLearningRate( 0.5f );
+	fc2->SetBaseL1RegularizationMult( 2.f );
+	fc3->SetBaseL2RegularizationMult( 0.5f );
+
+	CPtr<CDnnSolver> solver = createSolver( mathEngine );
+	solver->EnableFusedUpdate( isFused );
+	dnn.SetSolver( solver );
+
+	CRandom dataRandom( 7 );
+	for( int step = 0; step < 5; ++step ) {
+		source->SetBlob( createFusedSolverTestBlob( mathEngine, 4, 20, dataRandom ) );
+		target->SetBlob( createFusedSolverTestBlob( mathEngine, 4, 3, dataRandom ) );
+		dnn.RunAndLearnOnce();
+	}
+
+	weights.DeleteAll();
+	const CFullyConnectedLayer* const layers[] = { fc1, fc2, fc3 };
+	for( int i = 0; i < static_cast<int>( _countof( layers ) ); ++i ) {
+		const CPtr<CDnnBlob> params[] = { layers[i]->GetWeightsData(), layers[i]->GetFreeTermData() };
+		for( int j = 0; j < static_cast<int>( _countof( params ) ); ++j ) {
+			const int offset = weights.Size();
+			weights.SetSize( offset + params[j]->GetDataSize() );
+			params[j]->CopyTo( weights.GetPtr() + offset );
+		}
+	}
+}
+
+static void checkFusedSolver( TCreateFusedSolverTestSolver createSolver )
+{
+	CArray<float> expected;
+	trainFusedSolverTestDnn( createSolver, false, expected );
+	CArray<float> result;
+	trainFusedSolverTestDnn( createSolver, true, result );
+	ASSERT_EQ( expected.Size(), result.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		ASSERT_NEAR( expected[i], result[i], 1e-4f ) << i;
+	}
+}
+
+TEST( CDnnFusedSolverTest, SimpleGradient )
+{
+	if( MathEngine().GetType() != MET_Cpu && MathEngine().GetType() != MET_Cuda ) {
+		return;
+	}
+
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnSimpleGradientSolver> solver = new CDnnSimpleGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.05f );
+		solver->SetL1Regularization( 0.01f );
+		solver->SetL2Regularization( 0.01f );
+		return solver.Ptr();
+	} );
+}
+
+TEST( CDnnFusedSolverTest, AdaptiveGradient )
+{
+	if( MathEngine().GetType() != MET_Cpu && MathEngine().GetType() != MET_Cuda ) {
+		return;
+	}
+
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL2Regularization( 0.01f );
+		return solver.Ptr();
+	} );
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL1Regularization( 0.001f );
+		solver->EnableAmsGrad( true );
+		return solver.Ptr();
+	} );
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL2Regularization( 0.1f );
+		solver->SetDecoupledWeightDecay( true );
+		return solver.Ptr();
+	} );
+}
+
+TEST( CDnnFusedSolverTest, NesterovGradient )
+{
+	if( MathEngine().GetType() != MET_Cpu && MathEngine().GetType() != MET_Cuda ) {
+		return;
+	}
+
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnNesterovGradientSolver> solver = new CDnnNesterovGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL2Regularization( 0.01f );
+		return solver.Ptr();
+	} );
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnNesterovGradientSolver> solver = new CDnnNesterovGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL1Regularization( 0.001f );
+		solver->EnableAmsGrad( true );
+		return solver.Ptr();
+	} );
+}
+
+TEST( CDnnFusedSolverTest, LambGradient )
+{
+	if( MathEngine().GetType() != MET_Cpu && MathEngine().GetType() != MET_Cuda ) {
+		return;
+	}
+
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnLambGradientSolver> solver = new CDnnLambGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL2Regularization( 0.1f );
+		solver->ExcludeBiasParamLayers();
+		return solver.Ptr();
+	} );
+	checkFusedSolver( []( IMathEngine& mathEngine ) -> CPtr<CDnnSolver> {
+		CPtr<CDnnLambGradientSolver> solver = new CDnnLambGradientSolver( mathEngine );
+		solver->SetLearningRate( 0.01f );
+		solver->SetL2Regularization( 0.1f );
+		solver->SetWeightDecayClip( 0.5f );
+		solver->SetUseNVLamb( true );
+		return solver.Ptr();
+	} );
+}
+
+TEST( CDnnFusedSolverTest, DecoupledWeightDecay )
+{
+	// AdamW doesn't change the gradient history
+	CRandom random( 42 );
+	CDnn dnn( random, MathEngine() );
+	CPtr<CSourceLayer> source = Source( dnn, "source" );
+	CPtr<CSourceLayer> target = Source( dnn, "target" );
+	CPtr<CFullyConnectedLayer> fc = FullyConnected( 3 )( "fc", source.Ptr() );
+	EuclideanLoss()( "loss", fc.Ptr(), target.Ptr() );
+	CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	solver->SetLearningRate( 0.1f );
+	solver->SetL2Regularization( 0.5f );
+	solver->SetDecoupledWeightDecay( true );
+	dnn.SetSolver( solver );
+
+	// With zero gradient the weights are only multiplied by ( 1 - learningRate * L2 )
+	CPtr<CDnnBlob> input = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 2, 4 );
+	input->Clear();
+	source->SetBlob( input );
+	CPtr<CDnnBlob> targetBlob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 2, 3 );
+	targetBlob->Clear();
+	target->SetBlob( targetBlob );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> freeTerm = CDnnBlob::CreateVector( MathEngine(), CT_Float, 3 );
+	freeTerm->Clear();
+	fc->SetFreeTermData( freeTerm );
+
+	CArray<float> expected;
+	expected.SetSize( fc->GetWeightsData()->GetDataSize() );
+	fc->GetWeightsData()->CopyTo( expected.GetPtr() );
+	dnn.RunAndLearnOnce();
+	CArray<float> result;
+	result.SetSize( expected.Size() );
+	fc->GetWeightsData()->CopyTo( result.GetPtr() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i] * 0.95f, result[i], 1e-6f );
+	}
+}
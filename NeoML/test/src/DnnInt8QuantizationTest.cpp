@@ -0,0 +1,145 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> createInt8QuantizationTestInput( IMathEngine& mathEngine, int seed )
+{
+	CRandom random( seed );
+	CPtr<CDnnBlob> blob = CDnnBlob::Create2DImageBlob( mathEngine, CT_Float, 1, 4, 8, 8, 3 );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+static void runInt8QuantizationTestDnn( CDnn& dnn, int seed, CArray<float>& result )
+{
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( createInt8QuantizationTestInput( dnn.GetMathEngine(), seed ) );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> output = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob();
+	result.SetSize( output->GetDataSize() );
+	output->CopyTo( result.GetPtr() );
+}
+
+static void checkInt8QuantizationResult( const CArray<float>& expected, const CArray<float>& result )
+{
+	ASSERT_EQ( expected.Size(), result.Size() );
+	float maxAbsValue = 0;
+	for( int i = 0; i < expected.Size(); ++i ) {
+		maxAbsValue = max( maxAbsValue, abs( expected[i] ) );
+	}
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i], result[i], 0.05f * maxAbsValue );
+	}
+}
+
+TEST( CDnnInt8QuantizationTest, QuantizedInference )
+{
+	IMathEngine& mathEngine = MathEngine();
+	if( mathEngine.GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+	CSourceLayer* source = Source( dnn, "source" );
+	CBaseLayer* conv = Relu()( Conv( 16, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1 ) )( source ) );
+	CBaseLayer* channelwise = Relu()( ChannelwiseConv( 16, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1 ) )( conv ) );
+	Sink( FullyConnected( 10 )( channelwise ), "sink" );
+
+	const int seeds[] = { 1, 2, 3 };
+	CArray<float> expected[3];
+	for( int i = 0; i < 3; ++i ) {
+		runInt8QuantizationTestDnn( dnn, seeds[i], expected[i] );
+	}
+
+	CMemoryFile floatFile;
+	{
+		CArchive archive( &floatFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+
+	// Nothing has been seen by the layers that need the input range
+	EXPECT_EQ( 1, QuantizeInt8( dnn ) );
+
+	// Calibrate on the first input only, the others check the generalization
+	CRandom otherRandom( 42 );
+	CDnn otherDnn( otherRandom, mathEngine );
+	floatFile.SeekToBegin();
+	{
+		CArchive archive( &floatFile, CArchive::SD_Loading );
+		archive.Serialize( otherDnn );
+	}
+	EnableInt8Calibration( otherDnn, true );
+	CArray<float> result;
+	runInt8QuantizationTestDnn( otherDnn, seeds[0], result );
+	EnableInt8Calibration( otherDnn, false );
+	EXPECT_EQ( 3, QuantizeInt8( otherDnn ) );
+
+	for( int i = 0; i < 3; ++i ) {
+		runInt8QuantizationTestDnn( otherDnn, seeds[i], result );
+		checkInt8QuantizationResult( expected[i], result );
+	}
+
+	// The quantized network is stored with the int8 weights
+	CMemoryFile int8File;
+	{
+		CArchive archive( &int8File, CArchive::SD_Storing );
+		archive.Serialize( otherDnn );
+	}
+	EXPECT_LT( int8File.GetLength(), floatFile.GetLength() );
+
+	CRandom loadedRandom( 42 );
+	CDnn loadedDnn( loadedRandom, mathEngine );
+	int8File.SeekToBegin();
+	{
+		CArchive archive( &int8File, CArchive::SD_Loading );
+		archive.Serialize( loadedDnn );
+	}
+	CArray<float> loadedResult;
+	for( int i = 0; i < 3; ++i ) {
+		runInt8QuantizationTestDnn( otherDnn, seeds[i], result );
+		runInt8QuantizationTestDnn( loadedDnn, seeds[i], loadedResult );
+		ASSERT_EQ( result.Size(), loadedResult.Size() );
+		for( int j = 0; j < result.Size(); ++j ) {
+			EXPECT_EQ( result[j], loadedResult[j] );
+		}
+	}
+
+	// The inference contexts of a frozen model share the int8 weights
+	int8File.SeekToBegin();
+	CArchive frozenArchive( &int8File, CArchive::SD_Loading );
+	CPtr<CDnnFrozenModel> frozenModel = new CDnnFrozenModel( mathEngine, frozenArchive );
+	frozenArchive.Close();
+	CPtr<CDnnInferenceContext> context = frozenModel->CreateContext();
+	for( int i = 0; i < 3; ++i ) {
+		runInt8QuantizationTestDnn( loadedDnn, seeds[i], loadedResult );
+		runInt8QuantizationTestDnn( context->Dnn(), seeds[i], result );
+		ASSERT_EQ( loadedResult.Size(), result.Size() );
+		for( int j = 0; j < result.Size(); ++j ) {
+			EXPECT_EQ( loadedResult[j], result[j] );
+		}
+	}
+}
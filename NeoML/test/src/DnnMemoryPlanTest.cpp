@@ -0,0 +1,84 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> createMemoryPlanTestInput( IMathEngine& mathEngine, int batchWidth )
+{
+	CRandom random( batchWidth );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, batchWidth, 10 );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1., 1. ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+static void runMemoryPlanTestDnn( CDnn& dnn, int batchWidth, CArray<float>& result )
+{
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( createMemoryPlanTestInput( dnn.GetMathEngine(), batchWidth ) );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> output = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob();
+	result.SetSize( output->GetDataSize() );
+	output->CopyTo( result.GetPtr() );
+}
+
+TEST( CDnnMemoryPlanTest, PlannedRunMatchesUsual )
+{
+	IMathEngine& mathEngine = MathEngine();
+
+	CRandom random( 42 );
+	CDnn dnn( random, mathEngine );
+	CSourceLayer* source = Source( dnn, "source" );
+	CBaseLayer* first = Relu()( FullyConnected( 32 )( source ) );
+	CBaseLayer* second = FullyConnected( 32 )( Tanh()( FullyConnected( 32 )( first ) ) );
+	Sink( FullyConnected( 4 )( Sigmoid()( ConcatChannels()( first, second ) ) ), "sink" );
+
+	const int batchWidths[] = { 3, 7, 3 };
+	for( int batchWidth : batchWidths ) {
+		dnn.EnableStaticMemoryPlanning( false );
+		CArray<float> expected;
+		runMemoryPlanTestDnn( dnn, batchWidth, expected );
+		EXPECT_EQ( 0u, dnn.GetPlannedArenaSize() );
+
+		dnn.EnableStaticMemoryPlanning( true );
+		for( int run = 0; run < 2; ++run ) {
+			CArray<float> actual;
+			runMemoryPlanTestDnn( dnn, batchWidth, actual );
+			ASSERT_EQ( expected.Size(), actual.Size() );
+			for( int i = 0; i < expected.Size(); ++i ) {
+				EXPECT_NEAR( expected[i], actual[i], 1e-5f ) << batchWidth << " " << i;
+			}
+		}
+
+		// The blobs with non-intersecting lifetimes share the memory
+		size_t outputsSize = 0;
+		CArray<const char*> layerList;
+		dnn.GetLayerList( layerList );
+		for( int i = 0; i < layerList.Size(); ++i ) {
+			outputsSize += dnn.GetLayer( layerList[i] )->GetOutputBlobsSize() * sizeof( float );
+		}
+		EXPECT_LT( 0u, dnn.GetPlannedArenaSize() );
+		EXPECT_GT( outputsSize, dnn.GetPlannedArenaSize() );
+	}
+}
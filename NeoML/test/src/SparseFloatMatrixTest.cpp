@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <TestFixture.h>
+#include <NeoML/TraditionalML/CrossValidationSubProblem.h>
 
 using namespace NeoML;
 using namespace NeoMLTest;
@@ -281,3 +282,165 @@ TEST_F( CSparseFloatMatrixTest, DISABLED_CreateHuge )
 	}
 }
 
+
+// A problem that gives out its matrix with the 64-bit indices
+class CProblem64 : public IProblem {
+public:
+	explicit CProblem64( const IProblem* _problem ) :
+		problem( _problem )
+	{
+		matrix = problem->GetMatrix();
+		for( int i = 0; i < matrix.Height; i++ ) {
+			pointerB.Add( matrix.GetRowBegin( i ) );
+			pointerE.Add( matrix.GetRowEnd( i ) );
+		}
+		matrix.PointerB = nullptr;
+		matrix.PointerE = nullptr;
+		matrix.PointerB64 = pointerB.GetPtr();
+		matrix.PointerE64 = pointerE.GetPtr();
+	}
+
+	// IProblem interface methods:
+	int GetClassCount() const override { return problem->GetClassCount(); }
+	int GetFeatureCount() const override { return problem->GetFeatureCount(); }
+	bool IsDiscreteFeature( int index ) const override { return problem->IsDiscreteFeature( index ); }
+	int GetVectorCount() const override { return problem->GetVectorCount(); }
+	int GetClass( int index ) const override { return problem->GetClass( index ); }
+	CFloatMatrixDesc GetMatrix() const override { return matrix; }
+	double GetVectorWeight( int index ) const override { return problem->GetVectorWeight( index ); }
+
+protected:
+	~CProblem64() override = default;
+
+private:
+	CPtr<const IProblem> problem;
+	CArray<__int64> pointerB;
+	CArray<__int64> pointerE;
+	CFloatMatrixDesc matrix;
+};
+
+static void checkRowsEqual( const CFloatVectorDesc& expected, const CFloatVectorDesc& actual )
+{
+	ASSERT_EQ( expected.Size, actual.Size );
+	for( int i = 0; i < expected.Size; ++i ) {
+		ASSERT_EQ( expected.Indexes[i], actual.Indexes[i] );
+		ASSERT_EQ( expected.Values[i], actual.Values[i] );
+	}
+}
+
+TEST_F( CSparseFloatMatrixTest, Desc64 )
+{
+	const int h = 100;
+	const int w = 20;
+	CRandom rand( 0 );
+	CPtr<CMemoryProblem> problem = new CMemoryProblem( w, 2 );
+	for( int i = 0; i < h; ++i ) {
+		problem->Add( generateRandomVector( rand, w ), i % 2 );
+	}
+	CPtr<CProblem64> problem64 = new CProblem64( problem );
+	const CFloatMatrixDesc desc = problem->GetMatrix();
+	const CFloatMatrixDesc desc64 = problem64->GetMatrix();
+	ASSERT_FALSE( desc.Is64Bit() );
+	ASSERT_TRUE( desc64.Is64Bit() );
+
+	for( int i = 0; i < h; ++i ) {
+		checkRowsEqual( desc.GetRow( i ), desc64.GetRow( i ) );
+	}
+	const CFloatMatrixDesc rows = desc.GetRows( 10, 20 );
+	const CFloatMatrixDesc rows64 = desc64.GetRows( 10, 20 );
+	ASSERT_TRUE( rows64.Is64Bit() );
+	for( int i = 0; i < rows.Height; ++i ) {
+		checkRowsEqual( rows.GetRow( i ), rows64.GetRow( i ) );
+	}
+
+	// A matrix created from the 64-bit desc uses the 32-bit indices as it is small enough
+	CSparseFloatMatrix matrix( desc64 );
+	ASSERT_FALSE( matrix.GetDesc().Is64Bit() );
+	ASSERT_EQ( h, matrix.GetHeight() );
+	ASSERT_EQ( desc.GetRowEnd( h - 1 ), matrix.GetElementCount() );
+	for( int i = 0; i < h; ++i ) {
+		checkRowsEqual( desc.GetRow( i ), matrix.GetRow( i ) );
+	}
+
+	// The sub-problems keep the 64-bit indices
+	CPtr<CCrossValidationSubProblem> subProblem = new CCrossValidationSubProblem( problem, 5, 1, false );
+	CPtr<CCrossValidationSubProblem> subProblem64 = new CCrossValidationSubProblem( problem64, 5, 1, false );
+	ASSERT_TRUE( subProblem64->GetMatrix().Is64Bit() );
+	ASSERT_EQ( subProblem->GetVectorCount(), subProblem64->GetVectorCount() );
+	for( int i = 0; i < subProblem->GetVectorCount(); ++i ) {
+		checkRowsEqual( subProblem->GetMatrix().GetRow( i ), subProblem64->GetMatrix().GetRow( i ) );
+	}
+}
+
+TEST_F( CSparseFloatMatrixTest, Train64 )
+{
+	const int h = 200;
+	const int w = 20;
+	CRandom rand( 0 );
+	CPtr<CMemoryProblem> problem = new CMemoryProblem( w, 2 );
+	for( int i = 0; i < h; ++i ) {
+		CSparseFloatVector vector = generateRandomVector( rand, w );
+		problem->Add( vector, GetValue( vector.GetDesc(), 0 ) > 0 ? 1 : 0 );
+	}
+	CPtr<CProblem64> problem64 = new CProblem64( problem );
+
+	CLinear linear( EF_LogReg );
+	CPtr<IModel> linearModel = linear.Train( *problem );
+	CPtr<IModel> linearModel64 = linear.Train( *problem64 );
+
+	CGradientBoost::CParams params;
+	params.IterationsCount = 10;
+	params.Random = &rand;
+	CGradientBoost boost( params );
+	rand.Reset( 0 );
+	CPtr<IModel> boostModel = boost.Train( *problem );
+	rand.Reset( 0 );
+	CPtr<IModel> boostModel64 = boost.Train( *problem64 );
+
+	for( int i = 0; i < h; ++i ) {
+		CClassificationResult result;
+		CClassificationResult result64;
+		linearModel->Classify( problem->GetVector( i ), result );
+		linearModel64->Classify( problem->GetVector( i ), result64 );
+		ASSERT_EQ( result.PreferredClass, result64.PreferredClass );
+		ASSERT_DOUBLE_EQ( result.Probabilities[1].GetValue(), result64.Probabilities[1].GetValue() );
+		boostModel->Classify( problem->GetVector( i ), result );
+		boostModel64->Classify( problem->GetVector( i ), result64 );
+		ASSERT_EQ( result.PreferredClass, result64.PreferredClass );
+		ASSERT_DOUBLE_EQ( result.Probabilities[1].GetValue(), result64.Probabilities[1].GetValue() );
+	}
+}
+
+TEST_F( CSparseFloatMatrixTest, SerializeAndAddRow )
+{
+	const int h = 50;
+	const int w = 30;
+	CRandom rand( 0 );
+	CSparseFloatMatrix matrix( w );
+	for( int i = 0; i < h; ++i ) {
+		matrix.AddRow( generateRandomVector( rand, w ) );
+	}
+
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive << matrix;
+	}
+	file.SeekToBegin();
+	CSparseFloatMatrix loaded;
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		archive >> loaded;
+	}
+	ASSERT_EQ( matrix.GetHeight(), loaded.GetHeight() );
+	ASSERT_EQ( matrix.GetElementCount(), loaded.GetElementCount() );
+
+	// The loaded matrix may be extended
+	CSparseFloatVector row = generateRandomVector( rand, w );
+	matrix.AddRow( row );
+	loaded.AddRow( row );
+	ASSERT_EQ( matrix.GetHeight(), loaded.GetHeight() );
+	for( int i = 0; i < matrix.GetHeight(); ++i ) {
+		checkRowsEqual( matrix.GetRow( i ), loaded.GetRow( i ) );
+	}
+}
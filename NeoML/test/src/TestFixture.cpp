@@ -273,6 +273,26 @@ CString GetTestDataFilePath( const CString& relativePath, const CString& fileNam
 	return mergePathSimple( mergePathSimple( testDir, relativePath ), fileName );
 }
 
+CString GetTestTempFilePath( const CString& fileName )
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	const char* tempDir = getenv( "TEMP" );
+#elif FINE_PLATFORM( FINE_LINUX ) || FINE_PLATFORM( FINE_DARWIN )
+	const char* tempDir = getenv( "TMPDIR" );
+	if( tempDir == nullptr || *tempDir == 0 ) {
+		tempDir = "/tmp";
+	}
+#elif FINE_PLATFORM( FINE_ANDROID ) || FINE_PLATFORM( FINE_IOS )
+	const char* tempDir = getenv( "TMPDIR" );
+#else
+	#error Unknown platform
+#endif
+	if( tempDir == nullptr || *tempDir == 0 ) {
+		return mergePathSimple( testDir, fileName );
+	}
+	return mergePathSimple( CString( tempDir ), fileName );
+}
+
 IMathEngine& MathEngine()
 {
 	if( mathEngine == nullptr ) {
@@ -22,6 +22,8 @@ limitations under the License.
 namespace NeoMLTest {
 
 CString GetTestDataFilePath( const CString& relativePath, const CString& fileName );
+// Gets the path for a temporary file in the system temporary directory (the test data directory if there is none)
+CString GetTestTempFilePath( const CString& fileName );
 
 // Get global MathEngine.
 IMathEngine& MathEngine();
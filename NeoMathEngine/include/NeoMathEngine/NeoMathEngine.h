@@ -295,6 +295,24 @@ public:
 
 //------------------------------------------------------------------------------------------------------------
 
+// A parameter tensor updated by a fused optimizer step (see IBlasEngine::Fused*Step)
+struct CFusedSolverTensor {
+	CFloatHandle Param; // the parameters
+	CConstFloatHandle Diff; // the gradient
+	CFloatHandle Moment; // the moving average of the gradient
+	CFloatHandle SecondMoment; // the moving average of the squared gradient (not used by SGD)
+	CFloatHandle SecondMomentMax; // the maximum of SecondMoment over the steps for AMSGrad, null if AMSGrad is off
+	int Size; // the number of elements in each of the tensors above
+	float Rate; // the learning rate
+	float L1; // the L1 regularization added to the gradient (the Huber function threshold)
+	float L2; // the L2 regularization added to the gradient
+	float WeightDecay; // the weight decay applied to the parameters directly
+
+	CFusedSolverTensor() : Size( 0 ), Rate( 0 ), L1( 0 ), L2( 0 ), WeightDecay( 0 ) {}
+};
+
+//------------------------------------------------------------------------------------------------------------
+
 // The class provides basic linear algebra operations
 class NEOMATHENGINE_API IBlasEngine : public IVectorMathEngine {
 public:
@@ -452,6 +470,16 @@ public:
 		int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle,
 		int resultBufferSize) = 0;
 
+	// Multiplies a matrix by an int8 quantized matrix, transposed; the result will be of firstHeight * secondHeight size
+	// The first matrix is quantized on the fly: q = round( first / firstScale ), clamped to [-127, 127]
+	// The second matrix stores secondHeight rows of int8 values packed by 4 into integers, (width + 3) / 4 integers per row
+	// secondScales contains the quantization step of each row of the second matrix
+	// result = firstScale * secondScales * q( first ) * T( second ) + freeTerm (if not null)
+	// Supported only on CPU
+	virtual void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight, int width,
+		float firstScale, const CConstIntHandle& secondHandle, const CConstFloatHandle& secondScalesHandle, int secondHeight,
+		const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle ) = 0;
+
 	// Operations on sparse matrices
 
 	// result = first * T(second). The result will be of firstHeight * secondHeight size
@@ -515,6 +543,37 @@ public:
 	virtual void MatrixSpreadRows( const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue ) = 0;
+	// Fused optimizer steps
+	// Each of the methods updates tensorCount parameter tensors and their history in one pass over the memory
+	// The elements of all the tensors are split between the threads as if they were one vector,
+	// so many small tensors are updated as fast as one big tensor
+	// In the formulas below diff' = Diff + L2 * Param + clamp( Param, -L1, L1 ) (with no L1 term if L1 is 0)
+	// Supported only on CPU and CUDA
+
+	// SGD with moment:
+	//    Moment = momentDecayRate * Moment - Rate * diff'
+	//    Param = Param + Moment
+	virtual void FusedSgdStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate ) = 0;
+	// Adam, AdamW (WeightDecay is not 0) and NAdam (nesterovDiffMult is not 0):
+	//    Moment = momentDecayRate * Moment + ( 1 - momentDecayRate ) * diff'
+	//    SecondMoment = secondMomentDecayRate * SecondMoment + ( 1 - secondMomentDecayRate ) * diff' * diff'
+	//    SecondMomentMax = max( SecondMomentMax, SecondMoment ), v = SecondMomentMax if AMSGrad is on, otherwise v = SecondMoment
+	//    update = ( nesterovDiffMult * diff' + nesterovMomentMult * Moment ) / ( sqrt( secondMomentMult * v ) + epsilon )
+	//    Param = Param - Rate * update - WeightDecay * Param
+	// Adam uses nesterovDiffMult = 0, nesterovMomentMult = 1, secondMomentMult = 1
+	virtual void FusedAdamStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult ) = 0;
+	// LAMB (L1 and L2 are not used):
+	//    Moment = momentDecayRate * Moment + ( 1 - momentDecayRate ) * diffMult * Diff
+	//    SecondMoment = secondMomentDecayRate * SecondMoment + ( 1 - secondMomentDecayRate ) * ( diffMult * Diff )^2
+	//    update = Moment / ( sqrt( SecondMoment ) + epsilon ) + WeightDecay * Param
+	//    Param = Param - Rate * trustRatio * update
+	// If useTrustRatio is true and both norms are positive, trustRatio = min( ||Param||, weightNormClip ) / ||update||,
+	// otherwise it is 1; weightNormClip <= 0 means no clip
+	// diffSquaredNorms, if not null, is filled with the squared L2 norms of Diff of each tensor
+	virtual void FusedLambStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float diffMult, bool useTrustRatio, float weightNormClip,
+		float* diffSquaredNorms ) = 0;
 };
 
 // Blob operations descriptors
@@ -623,6 +682,21 @@ public:
 	virtual void BlobConvolutionLearnAdd( const CConvolutionDesc& desc, const CFloatHandle& input,
 		const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) = 0;
+	// Some forward pass algorithms (e.g. Winograd on CPU) work with a transformed filter
+	// If the size returned is not 0, the filter may be transformed once by PrepareBlobConvolutionFilter
+	// and passed to BlobConvolutionWithPreparedFilter; the transformation should be repeated after the filter changes
+	// If the size is 0, the descriptor uses the original filter and the other two methods should not be called
+	virtual int GetBlobConvolutionPreparedFilterSize( const CConvolutionDesc& desc ) const = 0;
+	virtual void PrepareBlobConvolutionFilter( const CConvolutionDesc& desc, const CConstFloatHandle& filter,
+		const CFloatHandle& preparedFilter ) = 0;
+	virtual void BlobConvolutionWithPreparedFilter( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		const CConstFloatHandle& preparedFilter, const CConstFloatHandle* freeTerm, const CFloatHandle& result ) = 0;
+	// Convolution with the int8 quantized filter (forward pass only)
+	// The filter is stored as the second matrix of MultiplyMatrixByTransposedQuantizedMatrix, one row per filter
+	// The source is quantized with the sourceScale step
+	// Supported only on CPU
+	virtual void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CFloatHandle& source, float sourceScale,
+		const CIntHandle& filter, const CFloatHandle& filterScales, const CFloatHandle* freeTerm, const CFloatHandle& result ) = 0;
 
 	// Calculates channelwise convolution
 	// You can pass 0 for the freeTerm parameter, and the free terms will be 0
@@ -847,6 +921,58 @@ public:
 	virtual void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) = 0;
+
+	// Fused LSTM inference
+	// Pay attention that the function below emulates only recurrent part of the layer
+	// the result is
+	//    gates_t = wx_t + h_(t-1) * W^T
+	//    c_t = sigmoid( forget ) * c_(t-1) + sigmoid( input ) * tanh( main )
+	//    h_t = sigmoid( reset ) * tanh( c_t )
+	// where
+	//    wx - user input, processed by input fully connected layer with both free terms added.
+	//        Size: seqLen x batchSize x (4 * hiddenSize), the gates order is main, forget, input, reset
+	//    W - recurrent weights. Size: (4 * hiddenSize) x hiddenSize
+	//    initialOutput, initialState - (optional, may be null) h and c before the first step. Size: batchSize x hiddenSize
+	//    h, c - the outputs and the states on every step. Size: seqLen x batchSize x hiddenSize
+	virtual void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& wx, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& h, const CFloatHandle& c ) = 0;
+
+	// Fused GRU inference
+	// Pay attention that the function below emulates only recurrent part of the layer
+	// the result is
+	//    update_t, reset_t = sigmoid( gateWx_t + h_(t-1) * gateW^T )
+	//    main_t = tanh( mainWx_t + ( reset_t * h_(t-1) ) * mainW^T )
+	//    h_t = ( 1 - update_t ) * main_t + update_t * h_(t-1)
+	// where
+	//    gateWx - user input, processed by the input part of gate fully connected layer with free term added.
+	//        Size: seqLen x batchSize x (2 * hiddenSize), the gates order is update, reset
+	//    mainWx - user input, processed by the input part of main fully connected layer with free term added.
+	//        Size: seqLen x batchSize x hiddenSize
+	//    gateW, mainW - recurrent parts of the weights. Size: (2 * hiddenSize) x hiddenSize and hiddenSize x hiddenSize
+	//        with recurWeightsRowSize between the rows, so the recurrent parts may be used inside the full weights
+	//    initialOutput - (optional, may be null) h before the first step. Size: batchSize x hiddenSize
+	//    h - the outputs on every step. Size: seqLen x batchSize x hiddenSize
+	virtual void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& gateWx, const CConstFloatHandle& mainWx,
+		const CConstFloatHandle& gateRecurWeights, const CConstFloatHandle& mainRecurWeights, int recurWeightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& h ) = 0;
+
+	// Fused scaled dot-product attention inference
+	// For each batch element and each head the result is
+	//    result = softmax( scale * Q * K^T + mask ) * V
+	// where the softmax is calculated over the keys
+	// The attention matrix is not stored: it is calculated by blocks of keys and normalized on the fly
+	// where
+	//    q - the queries. Size: batchSize x queryLength x (headCount * headSize), the head number i takes i-th headSize columns
+	//    k, v - the keys and the values. Size: batchSize x keyLength x (headCount * headSize), the heads are laid out as in q
+	//    mask - (optional, may be null) the values added to the attention matrix before the softmax,
+	//        the same for all batch elements and heads. Size: queryLength x keyLength
+	//    result - the heads outputs, laid out as in q. Size: batchSize x queryLength x (headCount * headSize)
+	virtual void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+		float scale, const CConstFloatHandle& q, const CConstFloatHandle& k, const CConstFloatHandle& v,
+		const CConstFloatHandle& mask, const CFloatHandle& result ) = 0;
 };
 
 //------------------------------------------------------------------------------------------------------------
@@ -875,6 +1001,21 @@ struct CMathEngineInfo {
 	CMathEngineInfo( TMathEngineType type, size_t availableMemory, int id ) : Type( type ), AvailableMemory( availableMemory ), Id( id ) { Name[0] = 0; }
 };
 
+// The statistics of the memory manager of a math engine
+// The counters are collected over all threads since the math engine creation
+struct CMemoryPoolStatistics {
+	size_t AllocCount; // the number of allocations, including the memory for the stacks
+	size_t FreeCount; // the number of frees
+	size_t PoolHitCount; // the number of allocations served by the buffers kept in the pools
+	size_t CrossThreadFreeCount; // the number of buffers from the pools freed on another thread than allocated
+	size_t DeviceAllocCount; // the number of memory allocations on the device
+	size_t MemoryInPools; // the current size of memory in the pools of all threads
+	size_t ThreadCount; // the number of threads that have used the memory manager
+
+	CMemoryPoolStatistics() : AllocCount( 0 ), FreeCount( 0 ), PoolHitCount( 0 ), CrossThreadFreeCount( 0 ),
+		DeviceAllocCount( 0 ), MemoryInPools( 0 ), ThreadCount( 0 ) {}
+};
+
 // CMathEngine class implements an engine to perform calculations on data specified by CMemoryHandle (CFloatHandle)
 class NEOMATHENGINE_API IMathEngine : public IDnnEngine {
 public:
@@ -912,6 +1053,9 @@ public:
 	// The current size of memory in the pools
 	virtual size_t GetMemoryInPools() const = 0;
 
+	// Gets the statistics of the memory manager
+	virtual void GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const = 0;
+
 	// Releases all temporary resources allocated for the current thread
 	virtual void CleanUp() = 0;
 
@@ -951,6 +1095,28 @@ NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( int threadCount, size_t memo
 // Should be called only if there are no running CpuMathEngine instances
 NEOMATHENGINE_API void CpuMathEngineCleanUp();
 
+// Convolution autotuning for CPU math engines
+// When enabled, InitBlobConvolution measures all suitable implementations of the forward pass
+// the first time a convolution geometry is met and uses the fastest one
+// The results are kept in a cache shared between all CPU math engines
+// The cache key includes the CPU model and the number of threads, so the cache file may be shared between machines
+NEOMATHENGINE_API void SetCpuConvolutionAutotune( bool enable );
+NEOMATHENGINE_API bool IsCpuConvolutionAutotuneEnabled();
+// Saves the tuning results to a file; returns false if the file could not be written
+NEOMATHENGINE_API bool SaveCpuConvolutionTuningCache( const char* fileName );
+// Adds the tuning results from a file to the cache; returns false if the file could not be read
+// The loaded results are used even if the autotuning is disabled
+NEOMATHENGINE_API bool LoadCpuConvolutionTuningCache( const char* fileName );
+
+// The alignment of the external memory used by CPU math engines
+const size_t CpuExternalMemoryAlignment = 64;
+
+// Creates a CPU math engine handle for the memory allocated outside of the math engine
+// (for example, a file mapped into memory) so that it may be used without copying
+// The data pointer should be aligned to CpuExternalMemoryAlignment
+// The memory is not owned by the math engine: it should not be freed with HeapFree and should stay valid while used
+NEOMATHENGINE_API CMemoryHandle CreateCpuExternalMemoryHandle( IMathEngine& mathEngine, const void* data );
+
 // Gpu math engine flags
 
 // Use tensor cores in cublas (if possible)
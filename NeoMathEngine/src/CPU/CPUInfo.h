@@ -26,6 +26,7 @@ limitations under the License.
 #endif // !FINE_ARCHITECTURE( FINE_ARM64 )
 
 #include <cstring>
+#include <string>
 
 
 // The structure with CPU information
@@ -112,6 +113,26 @@ struct CCPUInfo {
 		}
 	}
 
+	// Gets the CPU brand string; empty if it's not available
+	static std::string GetCpuModelName()
+	{
+		Regs regs;
+		callCpuId( regs, 0x80000000 );
+		if( regs.eax < 0x80000004 ) {
+			return std::string();
+		}
+		char brand[3 * sizeof( Regs ) + 1] = {};
+		for( int i = 0; i < 3; ++i ) {
+			callCpuId( regs, 0x80000002 + i );
+			memcpy( brand + i * sizeof( Regs ), &regs, sizeof( Regs ) );
+		}
+		std::string result( brand );
+		// The brand string may be padded with spaces
+		const size_t first = result.find_first_not_of( ' ' );
+		const size_t last = result.find_last_not_of( ' ' );
+		return first == std::string::npos ? std::string() : result.substr( first, last - first + 1 );
+	}
+
 	// Defines the float alignment
 	static int DefineFloatAlignment()
 	{
@@ -0,0 +1,107 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuConvolutionTuningCache.h>
+#include <NeoMathEngine/NeoMathEngine.h>
+#include <fstream>
+
+namespace NeoML {
+
+CCpuConvolutionTuningCache& CCpuConvolutionTuningCache::Instance()
+{
+	static CCpuConvolutionTuningCache instance;
+	return instance;
+}
+
+bool CCpuConvolutionTuningCache::Lookup( const std::string& key, std::string& implName ) const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	auto result = results.find( key );
+	if( result == results.end() ) {
+		return false;
+	}
+	implName = result->second;
+	return true;
+}
+
+void CCpuConvolutionTuningCache::Add( const std::string& key, const std::string& implName )
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	results[key] = implName;
+}
+
+bool CCpuConvolutionTuningCache::IsEmpty() const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return results.empty();
+}
+
+bool CCpuConvolutionTuningCache::Save( const char* fileName ) const
+{
+	std::ofstream file( fileName );
+	if( !file ) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	for( const auto& result : results ) {
+		file << result.first << '\t' << result.second << '\n';
+	}
+	return static_cast<bool>( file );
+}
+
+bool CCpuConvolutionTuningCache::Load( const char* fileName )
+{
+	std::ifstream file( fileName );
+	if( !file ) {
+		return false;
+	}
+	std::string line;
+	std::lock_guard<std::mutex> lock( mutex );
+	while( std::getline( file, line ) ) {
+		const size_t separator = line.rfind( '\t' );
+		if( separator == std::string::npos || separator == 0 || separator + 1 == line.size() ) {
+			continue; // skip the malformed lines
+		}
+		results[line.substr( 0, separator )] = line.substr( separator + 1 );
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+void SetCpuConvolutionAutotune( bool enable )
+{
+	CCpuConvolutionTuningCache::Instance().SetAutotuneEnabled( enable );
+}
+
+bool IsCpuConvolutionAutotuneEnabled()
+{
+	return CCpuConvolutionTuningCache::Instance().IsAutotuneEnabled();
+}
+
+bool SaveCpuConvolutionTuningCache( const char* fileName )
+{
+	return CCpuConvolutionTuningCache::Instance().Save( fileName );
+}
+
+bool LoadCpuConvolutionTuningCache( const char* fileName )
+{
+	return CCpuConvolutionTuningCache::Instance().Load( fileName );
+}
+
+} // namespace NeoML
@@ -0,0 +1,53 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace NeoML {
+
+// The process-wide cache of the convolution autotuning results
+// Maps the convolution key (geometry, CPU model, thread count) to the name of the fastest implementation
+class CCpuConvolutionTuningCache {
+public:
+	static CCpuConvolutionTuningCache& Instance();
+
+	bool IsAutotuneEnabled() const { return isAutotuneEnabled; }
+	void SetAutotuneEnabled( bool enable ) { isAutotuneEnabled = enable; }
+
+	// Returns false if there is no result for the key
+	bool Lookup( const std::string& key, std::string& implName ) const;
+	void Add( const std::string& key, const std::string& implName );
+	bool IsEmpty() const;
+
+	// The file contains one "key<TAB>implementation" line per result
+	bool Save( const char* fileName ) const;
+	bool Load( const char* fileName );
+
+private:
+	mutable std::mutex mutex;
+	std::atomic<bool> isAutotuneEnabled;
+	std::map<std::string, std::string> results;
+
+	CCpuConvolutionTuningCache() : isAutotuneEnabled( false ) {}
+	CCpuConvolutionTuningCache( const CCpuConvolutionTuningCache& ) = delete;
+	CCpuConvolutionTuningCache& operator=( const CCpuConvolutionTuningCache& ) = delete;
+};
+
+} // namespace NeoML
@@ -81,13 +81,11 @@ CCpuMathEngine::~CCpuMathEngine()
 
 void CCpuMathEngine::SetReuseMemoryMode( bool enable )
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	memoryPool->SetReuseMemoryMode( enable );
 }
 
 CMemoryHandle CCpuMathEngine::HeapAlloc( size_t size )
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	CMemoryHandle result = memoryPool->Alloc( size );
 	if( result.IsNull() ) {
 		THROW_MEMORY_EXCEPTION;
@@ -99,13 +97,11 @@ void CCpuMathEngine::HeapFree( const CMemoryHandle& handle )
 {
 	ASSERT_EXPR( handle.GetMathEngine() == this );
 
-	std::lock_guard<std::mutex> lock( mutex );
 	memoryPool->Free( handle );
 }
 
 CMemoryHandle CCpuMathEngine::StackAlloc( size_t size )
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	CMemoryHandle result = stackAllocator->Alloc(size);
 	if( result.IsNull() ) {
 		THROW_MEMORY_EXCEPTION;
@@ -115,28 +111,29 @@ CMemoryHandle CCpuMathEngine::StackAlloc( size_t size )
 
 void CCpuMathEngine::StackFree( const CMemoryHandle& ptr )
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	stackAllocator->Free( ptr );
 }
 
 size_t CCpuMathEngine::GetFreeMemorySize() const
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	return memoryPool->GetFreeMemorySize();
 }
 
 size_t CCpuMathEngine::GetPeakMemoryUsage() const
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	return memoryPool->GetPeakMemoryUsage();
 }
 
 size_t CCpuMathEngine::GetMemoryInPools() const
 {
-	std::lock_guard<std::mutex> lock( mutex );
 	return memoryPool->GetMemoryInPools();
 }
 
+void CCpuMathEngine::GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const
+{
+	memoryPool->GetStatistics( statistics );
+}
+
 void CCpuMathEngine::CleanUp()
 {
 	std::lock_guard<std::mutex> lock( mutex );
@@ -252,4 +249,14 @@ void CpuMathEngineCleanUp()
 	mkl_free_buffers();
 #endif
 }
+
+CMemoryHandle CreateCpuExternalMemoryHandle( IMathEngine& mathEngine, const void* data )
+{
+	ASSERT_EXPR( mathEngine.GetType() == MET_Cpu );
+	ASSERT_EXPR( data != nullptr );
+	ASSERT_EXPR( reinterpret_cast<uintptr_t>( data ) % CpuExternalMemoryAlignment == 0 );
+	// The CPU math engine handles point to the memory directly
+	return CMemoryHandleInternal::CreateMemoryHandle( &mathEngine, data );
+}
+
 } // namespace NeoML
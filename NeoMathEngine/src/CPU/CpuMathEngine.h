@@ -48,6 +48,7 @@ public:
 	size_t GetFreeMemorySize() const override;
 	size_t GetPeakMemoryUsage() const override;
 	size_t GetMemoryInPools() const override;
+	void GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const override;
 	void CleanUp() override;
 	void* GetBuffer( const CMemoryHandle& handle, size_t pos, size_t size, bool exchange ) override;
 	void ReleaseBuffer( const CMemoryHandle& handle, void* ptr, bool exchange ) override;
@@ -306,6 +307,9 @@ public:
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
 	void MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight, int firstWidth,
 		const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize) override;
+	void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight, int width,
+		float firstScale, const CConstIntHandle& secondHandle, const CConstFloatHandle& secondScalesHandle, int secondHeight,
+		const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle ) override;
 	void MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
 		const CSparseMatrixDesc& firstDesc, const CConstFloatHandle& secondHandle, const CFloatHandle& resultHandle ) override;
 	void MultiplyTransposedMatrixBySparseMatrixAndAdd( int firstHeight, int firstWidth, int secondWidth,
@@ -342,6 +346,12 @@ public:
 	void MatrixSpreadRows(const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue) override;
+	void FusedSgdStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate ) override;
+	void FusedAdamStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult ) override;
+	void FusedLambStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float diffMult, bool useTrustRatio, float weightNormClip,
+		float* diffSquaredNorms ) override;
 
 	// IDnnEngine interface methods
 	void BlobMergeByDim(TBlobDim dim, const CBlobDesc* from, const CFloatHandle* fromData, int fromCount,
@@ -384,6 +394,13 @@ public:
 	void BlobConvolutionLearnAdd( const CConvolutionDesc& desc,
 	 const CFloatHandle& input, const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) override;
+	int GetBlobConvolutionPreparedFilterSize( const CConvolutionDesc& desc ) const override;
+	void PrepareBlobConvolutionFilter( const CConvolutionDesc& desc, const CConstFloatHandle& filter,
+		const CFloatHandle& preparedFilter ) override;
+	void BlobConvolutionWithPreparedFilter( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		const CConstFloatHandle& preparedFilter, const CConstFloatHandle* freeTerm, const CFloatHandle& result ) override;
+	void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CFloatHandle& source, float sourceScale,
+		const CIntHandle& filter, const CFloatHandle& filterScales, const CFloatHandle* freeTerm, const CFloatHandle& result ) override;
 	CChannelwiseConvolutionDesc* InitBlobChannelwiseConvolution( const CBlobDesc& input,
 		int paddingHeight, int paddingWidth, int strideHeight, int strideWidth,
 		const CBlobDesc& filter, const CBlobDesc* freeTerm, const CBlobDesc& output ) override;
@@ -491,6 +508,17 @@ public:
 	void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) override;
+	void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& wx, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& h, const CFloatHandle& c ) override;
+	void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& gateWx, const CConstFloatHandle& mainWx,
+		const CConstFloatHandle& gateRecurWeights, const CConstFloatHandle& mainRecurWeights, int recurWeightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& h ) override;
+	void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+		float scale, const CConstFloatHandle& q, const CConstFloatHandle& k, const CConstFloatHandle& v,
+		const CConstFloatHandle& mask, const CFloatHandle& result ) override;
 
 	IPerformanceCounters* CreatePerformanceCounters() const override;
 
@@ -505,7 +533,7 @@ private:
 	const int memoryAlignment; // allocation alignment
 	const std::unique_ptr<CMemoryPool> memoryPool; // the memory manager
 	const std::unique_ptr<CDeviceStackAllocator> stackAllocator; // the stack memory allocator
-	mutable std::mutex mutex; // to protect the allocations
+	mutable std::mutex mutex; // to serialize the clean-ups; the memory managers are thread-safe themselves
 
 	CDllLoader dllLoader; // loading library for simd instructions
 	std::unique_ptr<const ISimdMathEngine> simdMathEngine; // interface for using simd instructions
@@ -559,6 +587,16 @@ private:
 		int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle );
 	void multiplyMatrixByTransposedMatrixAndAdd( const float* first, int firstHeight, int firstWidth, int firstRowSize,
 		const float* second, int secondHeight, int secondRowSize, float* result, int resultRowSize );
+	// The quantized values of the first matrix in multiplyMatrixByTransposedQuantizedMatrix
+	// SSE2 has no int8 multiplication, so on x86 the values are stored widened to int16
+#ifdef NEOML_USE_NEON
+	typedef signed char CQuantizedValue;
+#else
+	typedef short CQuantizedValue;
+#endif
+	void quantizeMatrix( const float* data, int size, float scale, CQuantizedValue* result );
+	void multiplyMatrixByTransposedQuantizedMatrix( const CQuantizedValue* first, int firstHeight, int width, float firstScale,
+		const int* second, const float* secondScales, int secondHeight, const float* freeTerm, float* result, int resultRowSize );
 
 	template<class T>
 	void blobMergeByDimCommon( int dimNum, const CBlobDesc* from, const CTypedMemoryHandle<T>* fromData, int fromCount,
@@ -589,10 +627,16 @@ private:
 	void transposeResult( const CCpuConvolutionDesc& desc, const float* outputTransposedData,
 		int batch, int resultStart, int resultCount, float* result );
 	void fillTempData( const float* sourceData, float* filterData, const CCpuConvolutionDesc& desc, int start, int count );
+	void chooseConvolutionForwardImpl( CCpuConvolutionDesc& desc );
+	void tuneConvolutionForwardImpl( CCpuConvolutionDesc& desc );
+	void blobConvolutionForward( const CCpuConvolutionDesc& desc, const float* sourceData,
+		const float* filterData, const CFloatHandle* freeTermData, float* resultData );
 	void blobConvolutionForwardAlgo0( const CCpuConvolutionDesc& desc, const float* sourceData,
 		const float* filterData, const CFloatHandle* freeTermData, float* resultData );
 	void blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& desc, const float* sourceData,
 		const float* filterData, const CFloatHandle* freeTermData, float* resultData );
+	void blobConvolutionForwardWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+		const float* transformedFilter, const float* freeTerm, float* resultData );
 	void backwardConvolutionAddFilterToOutput( const CCpuConvolutionDesc& desc, const CFloatHandle& temp,
 		const CFloatHandle* freeTerm, const CFloatHandle& output );
 	void backwardDilationConvolutionAddFilterToOutput( const CCpuConvolutionDesc& desc, const CFloatHandle& temp,
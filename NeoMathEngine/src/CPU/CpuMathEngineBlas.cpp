@@ -892,9 +892,9 @@ void CCpuMathEngine::MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& f
 		if( OmpGetTaskIndexAndCount2D( firstHeight, 1, secondHeight, floatAlignment,
 			firstHeightStart, firstHeightCount, secondHeightStart, secondHeightCount ) )
 		{
-			const float* firstData = first + firstHeightStart * firstWidth;
-			float* resultData = result + firstHeightStart * secondHeight + secondHeightStart;
-			const float* secondData = second + secondHeightStart * firstWidth;
+			const float* firstData = first + firstHeightStart * firstRowSize;
+			float* resultData = result + firstHeightStart * resultRowSize + secondHeightStart;
+			const float* secondData = second + secondHeightStart * secondRowSize;
 
 			multiplyMatrixByTransposedMatrix( firstData, firstHeightCount, firstWidth, firstRowSize,
 				secondData, secondHeightCount, secondRowSize,
@@ -922,6 +922,47 @@ void CCpuMathEngine::MultiplyMatrixByTransposedMatrix( int batchSize, const CCon
 	}
 }
 
+void CCpuMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int width, float firstScale, const CConstIntHandle& secondHandle, const CConstFloatHandle& secondScalesHandle,
+	int secondHeight, const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( firstHandle.GetMathEngine() == this );
+	ASSERT_EXPR( secondHandle.GetMathEngine() == this );
+	ASSERT_EXPR( secondScalesHandle.GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	ASSERT_EXPR( firstScale > 0 );
+
+	const float* first = GetRaw( firstHandle );
+	const int* second = GetRaw( secondHandle );
+	const float* secondScales = GetRaw( secondScalesHandle );
+	const float* freeTerm = freeTermHandle != nullptr ? GetRaw( *freeTermHandle ) : nullptr;
+	float* result = GetRaw( resultHandle );
+	const int secondRowSize = ( width + 3 ) / 4;
+
+	// The first matrix is quantized once, the threads share it
+	CMemoryHandleStackVar<CQuantizedValue> quantizedFirstVar( mathEngine(), firstHeight * width );
+	CQuantizedValue* quantizedFirst = GetRaw( quantizedFirstVar.GetHandle() );
+	quantizeMatrix( first, firstHeight * width, firstScale, quantizedFirst );
+
+	const int curThreadCount = IsOmpRelevant( firstHeight * secondHeight, static_cast<int64_t>( width ) * firstHeight * secondHeight )
+		? threadCount : 1;
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		int firstHeightStart;
+		int firstHeightCount;
+		int secondHeightStart;
+		int secondHeightCount;
+		if( OmpGetTaskIndexAndCount2D( firstHeight, 4, secondHeight, 2,
+			firstHeightStart, firstHeightCount, secondHeightStart, secondHeightCount ) )
+		{
+			multiplyMatrixByTransposedQuantizedMatrix( quantizedFirst + firstHeightStart * width, firstHeightCount, width, firstScale,
+				second + secondHeightStart * secondRowSize, secondScales + secondHeightStart, secondHeightCount,
+				freeTerm != nullptr ? freeTerm + secondHeightStart : nullptr,
+				result + firstHeightStart * secondHeight + secondHeightStart, secondHeight );
+		}
+	}
+}
+
 void CCpuMathEngine::batchMultiplyTransposedMatrixByMatrix( int batchSize,
 	const float* first, int firstHeight, int firstWidth,
 	const float* second, int secondWidth,
@@ -1236,4 +1277,216 @@ void CCpuMathEngine::BitSetBinarization( int batchSize, int bitSetSize,
 	}
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Fused optimizer steps
+
+// The number of elements of a tensor processed by one task of a fused optimizer step
+static const int FusedSolverStepBlockSize = 16 * 1024;
+
+// A part of a tensor processed by one task of a fused optimizer step
+struct CFusedSolverStepBlock {
+	int Tensor; // the tensor index
+	int Start; // the first element
+	int Size; // the number of elements
+};
+
+// Splits all the tensors into blocks so that the threads get the same amount of work whatever the tensor sizes are
+static int64_t splitFusedSolverStep( const CFusedSolverTensor* tensors, int tensorCount,
+	std::vector<CFusedSolverStepBlock>& blocks )
+{
+	int64_t totalSize = 0;
+	blocks.clear();
+	for( int i = 0; i < tensorCount; ++i ) {
+		ASSERT_EXPR( tensors[i].Size >= 0 );
+		for( int start = 0; start < tensors[i].Size; start += FusedSolverStepBlockSize ) {
+			blocks.push_back( { i, start, min( FusedSolverStepBlockSize, tensors[i].Size - start ) } );
+		}
+		totalSize += tensors[i].Size;
+	}
+	return totalSize;
+}
+
+// The gradient with the regularization added
+static inline float fusedSolverDiff( float diff, float param, float l1, float l2 )
+{
+	return diff + l2 * param + min( max( param, -l1 ), l1 );
+}
+
+static void fusedSgdStep( const CFusedSolverTensor& tensor, float* param, const float* diff, float* moment, int size,
+	float momentDecayRate )
+{
+	for( int i = 0; i < size; ++i ) {
+		const float value = param[i];
+		moment[i] = momentDecayRate * moment[i] - tensor.Rate * fusedSolverDiff( diff[i], value, tensor.L1, tensor.L2 );
+		param[i] = value + moment[i];
+	}
+}
+
+template<bool IsAmsGrad>
+static void fusedAdamStep( const CFusedSolverTensor& tensor, float* param, const float* diff, float* moment,
+	float* secondMoment, float* secondMomentMax, int size, float momentDecayRate, float secondMomentDecayRate,
+	float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult )
+{
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+	for( int i = 0; i < size; ++i ) {
+		const float value = param[i];
+		const float grad = fusedSolverDiff( diff[i], value, tensor.L1, tensor.L2 );
+		const float m = momentDecayRate * moment[i] + opMomentDecayRate * grad;
+		float v = secondMomentDecayRate * secondMoment[i] + opSecondMomentDecayRate * grad * grad;
+		moment[i] = m;
+		secondMoment[i] = v;
+		if( IsAmsGrad ) {
+			v = max( secondMomentMax[i], v );
+			secondMomentMax[i] = v;
+		}
+		const float update = ( nesterovDiffMult * grad + nesterovMomentMult * m ) / ( sqrtf( secondMomentMult * v ) + epsilon );
+		param[i] = value - tensor.Rate * update - tensor.WeightDecay * value;
+	}
+}
+
+void CCpuMathEngine::FusedSgdStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate )
+{
+	for( int i = 0; i < tensorCount; ++i ) {
+		ASSERT_EXPR( tensors[i].Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Moment.GetMathEngine() == this );
+	}
+
+	std::vector<CFusedSolverStepBlock> blocks;
+	const int64_t totalSize = splitFusedSolverStep( tensors, tensorCount, blocks );
+	const int blockCount = static_cast<int>( blocks.size() );
+
+	const int curThreadCount = IsOmpRelevant( blockCount, totalSize ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int b = 0; b < blockCount; ++b ) {
+		const CFusedSolverStepBlock& block = blocks[b];
+		const CFusedSolverTensor& tensor = tensors[block.Tensor];
+		fusedSgdStep( tensor, GetRaw( tensor.Param ) + block.Start, GetRaw( tensor.Diff ) + block.Start,
+			GetRaw( tensor.Moment ) + block.Start, block.Size, momentDecayRate );
+	}
+}
+
+void CCpuMathEngine::FusedAdamStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+	float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult )
+{
+	for( int i = 0; i < tensorCount; ++i ) {
+		ASSERT_EXPR( tensors[i].Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Moment.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].SecondMoment.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].SecondMomentMax.IsNull() || tensors[i].SecondMomentMax.GetMathEngine() == this );
+	}
+
+	std::vector<CFusedSolverStepBlock> blocks;
+	const int64_t totalSize = splitFusedSolverStep( tensors, tensorCount, blocks );
+	const int blockCount = static_cast<int>( blocks.size() );
+
+	const int curThreadCount = IsOmpRelevant( blockCount, totalSize ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int b = 0; b < blockCount; ++b ) {
+		const CFusedSolverStepBlock& block = blocks[b];
+		const CFusedSolverTensor& tensor = tensors[block.Tensor];
+		float* param = GetRaw( tensor.Param ) + block.Start;
+		const float* diff = GetRaw( tensor.Diff ) + block.Start;
+		float* moment = GetRaw( tensor.Moment ) + block.Start;
+		float* secondMoment = GetRaw( tensor.SecondMoment ) + block.Start;
+		if( tensor.SecondMomentMax.IsNull() ) {
+			fusedAdamStep<false>( tensor, param, diff, moment, secondMoment, nullptr, block.Size, momentDecayRate,
+				secondMomentDecayRate, epsilon, secondMomentMult, nesterovDiffMult, nesterovMomentMult );
+		} else {
+			fusedAdamStep<true>( tensor, param, diff, moment, secondMoment, GetRaw( tensor.SecondMomentMax ) + block.Start,
+				block.Size, momentDecayRate, secondMomentDecayRate, epsilon, secondMomentMult, nesterovDiffMult,
+				nesterovMomentMult );
+		}
+	}
+}
+
+void CCpuMathEngine::FusedLambStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+	float secondMomentDecayRate, float epsilon, float diffMult, bool useTrustRatio, float weightNormClip,
+	float* diffSquaredNorms )
+{
+	for( int i = 0; i < tensorCount; ++i ) {
+		ASSERT_EXPR( tensors[i].Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Moment.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].SecondMoment.GetMathEngine() == this );
+	}
+
+	std::vector<CFusedSolverStepBlock> blocks;
+	const int64_t totalSize = splitFusedSolverStep( tensors, tensorCount, blocks );
+	const int blockCount = static_cast<int>( blocks.size() );
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+
+	// The first pass updates the moments and calculates the squared norms of the parameters, the updates, and the gradients
+	// The norms are summed up by blocks, so the result doesn't depend on the number of threads
+	std::vector<double> blockNorms( 3 * blocks.size() );
+	const int curThreadCount = IsOmpRelevant( blockCount, totalSize ) ? threadCount : 1;
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int b = 0; b < blockCount; ++b ) {
+		const CFusedSolverStepBlock& block = blocks[b];
+		const CFusedSolverTensor& tensor = tensors[block.Tensor];
+		const float* param = GetRaw( tensor.Param ) + block.Start;
+		const float* diff = GetRaw( tensor.Diff ) + block.Start;
+		float* moment = GetRaw( tensor.Moment ) + block.Start;
+		float* secondMoment = GetRaw( tensor.SecondMoment ) + block.Start;
+		double paramNorm = 0;
+		double updateNorm = 0;
+		double diffNorm = 0;
+		for( int i = 0; i < block.Size; ++i ) {
+			const float grad = diffMult * diff[i];
+			const float m = momentDecayRate * moment[i] + opMomentDecayRate * grad;
+			const float v = secondMomentDecayRate * secondMoment[i] + opSecondMomentDecayRate * grad * grad;
+			moment[i] = m;
+			secondMoment[i] = v;
+			const float update = m / ( sqrtf( v ) + epsilon ) + tensor.WeightDecay * param[i];
+			paramNorm += param[i] * param[i];
+			updateNorm += update * update;
+			diffNorm += diff[i] * diff[i];
+		}
+		blockNorms[3 * b] = paramNorm;
+		blockNorms[3 * b + 1] = updateNorm;
+		blockNorms[3 * b + 2] = diffNorm;
+	}
+
+	std::vector<double> norms( 3 * tensorCount, 0. );
+	for( int b = 0; b < blockCount; ++b ) {
+		for( int i = 0; i < 3; ++i ) {
+			norms[3 * blocks[b].Tensor + i] += blockNorms[3 * b + i];
+		}
+	}
+	std::vector<float> trustRatios( tensorCount, 1.f );
+	for( int i = 0; i < tensorCount; ++i ) {
+		if( useTrustRatio ) {
+			float paramNorm = static_cast<float>( sqrt( norms[3 * i] ) );
+			if( weightNormClip > 0 ) {
+				paramNorm = min( paramNorm, weightNormClip );
+			}
+			const float updateNorm = static_cast<float>( sqrt( norms[3 * i + 1] ) );
+			if( paramNorm > 0 && updateNorm > 0 ) {
+				trustRatios[i] = paramNorm / updateNorm;
+			}
+		}
+		if( diffSquaredNorms != nullptr ) {
+			diffSquaredNorms[i] = static_cast<float>( norms[3 * i + 2] );
+		}
+	}
+
+	// The second pass calculates the updates again from the new moments and changes the parameters
+	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+	for( int b = 0; b < blockCount; ++b ) {
+		const CFusedSolverStepBlock& block = blocks[b];
+		const CFusedSolverTensor& tensor = tensors[block.Tensor];
+		const float trustRatio = trustRatios[block.Tensor];
+		float* param = GetRaw( tensor.Param ) + block.Start;
+		const float* moment = GetRaw( tensor.Moment ) + block.Start;
+		const float* secondMoment = GetRaw( tensor.SecondMoment ) + block.Start;
+		for( int i = 0; i < block.Size; ++i ) {
+			const float update = moment[i] / ( sqrtf( secondMoment[i] ) + epsilon ) + tensor.WeightDecay * param[i];
+			param[i] -= tensor.Rate * ( trustRatio * update );
+		}
+	}
+}
+
 } // namespace NeoML
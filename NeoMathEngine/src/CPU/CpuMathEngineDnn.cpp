@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <CpuMathEngine.h>
+#include <float.h>
 #include <CpuMathEnginePrivate.h>
 #include <MemoryHandleInternal.h>
 #include <MathEngineCommon.h>
@@ -790,6 +791,310 @@ void CCpuMathEngine::IndRnnRecurrentLearn( bool reverse, int sequenceLength, int
 	}
 }
 
+// The activations of the fused recurrent layers
+static inline float recurrentSigmoid( float x )
+{
+	return 1.f / ( 1.f + expf( -x ) );
+}
+
+static inline float recurrentTanh( float x )
+{
+	return 2.f / ( 1.f + expf( -2.f * x ) ) - 1.f;
+}
+
+// One step of LSTM for one batch element after the recurrent matrix multiplication
+// gates and wx are 4 x hiddenSize in the main, forget, input, reset order; gates is null on the first step
+static inline void lstmStep( int hiddenSize, const float* gates, const float* wx, const float* cPrev, float* c, float* h )
+{
+	const float* mainWx = wx;
+	const float* forgetWx = mainWx + hiddenSize;
+	const float* inputWx = forgetWx + hiddenSize;
+	const float* resetWx = inputWx + hiddenSize;
+	for( int i = 0; i < hiddenSize; ++i ) {
+		float main = mainWx[i];
+		float forget = forgetWx[i];
+		float input = inputWx[i];
+		float reset = resetWx[i];
+		if( gates != nullptr ) {
+			main += gates[i];
+			forget += gates[hiddenSize + i];
+			input += gates[2 * hiddenSize + i];
+			reset += gates[3 * hiddenSize + i];
+		}
+		float state = recurrentSigmoid( input ) * recurrentTanh( main );
+		if( cPrev != nullptr ) {
+			state += recurrentSigmoid( forget ) * cPrev[i];
+		}
+		c[i] = state;
+		h[i] = recurrentSigmoid( reset ) * recurrentTanh( state );
+	}
+}
+
+void CCpuMathEngine::LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+	const CConstFloatHandle& wx, const CConstFloatHandle& recurWeights,
+	const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+	const CFloatHandle& h, const CFloatHandle& c )
+{
+	ASSERT_EXPR( sequenceLength >= 1 );
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( hiddenSize >= 1 );
+	ASSERT_EXPR( wx.GetMathEngine() == this );
+	ASSERT_EXPR( recurWeights.GetMathEngine() == this );
+	ASSERT_EXPR( initialOutput.IsNull() || initialOutput.GetMathEngine() == this );
+	ASSERT_EXPR( initialState.IsNull() || initialState.GetMathEngine() == this );
+	ASSERT_EXPR( h.GetMathEngine() == this );
+	ASSERT_EXPR( c.GetMathEngine() == this );
+
+	const int gateCount = 4;
+	const int dataSize = batchSize * hiddenSize;
+	const int gatesSize = gateCount * dataSize;
+	const int curThreadCount = IsOmpRelevant( batchSize, gatesSize ) ? threadCount : 1;
+
+	// The recurrent part of the gates of the current step: batchSize x 4 x hiddenSize
+	CFloatHandleStackVar gates( mathEngine(), gatesSize );
+	const float* gatesData = GetRaw( gates.GetHandle() );
+
+	CConstFloatHandle hPrev = initialOutput;
+	const float* cPrev = initialState.IsNull() ? nullptr : GetRaw( initialState );
+	for( int step = 0; step < sequenceLength; ++step ) {
+		const int pos = reverse ? sequenceLength - 1 - step : step;
+		const float* currWx = GetRaw( wx + pos * gatesSize );
+		float* currH = GetRaw( h + pos * dataSize );
+		float* currC = GetRaw( c + pos * dataSize );
+
+		if( !hPrev.IsNull() ) {
+			MultiplyMatrixByTransposedMatrix( hPrev, batchSize, hiddenSize, hiddenSize,
+				recurWeights, gateCount * hiddenSize, hiddenSize, gates.GetHandle(), gateCount * hiddenSize, gatesSize );
+		}
+
+		// All the gate math of the step is done in one pass
+		const bool hasRecurrentPart = !hPrev.IsNull();
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int b = 0; b < batchSize; ++b ) {
+			lstmStep( hiddenSize, hasRecurrentPart ? gatesData + b * gateCount * hiddenSize : nullptr,
+				currWx + b * gateCount * hiddenSize, cPrev == nullptr ? nullptr : cPrev + b * hiddenSize,
+				currC + b * hiddenSize, currH + b * hiddenSize );
+		}
+
+		hPrev = h + pos * dataSize;
+		cPrev = currC;
+	}
+}
+
+// Calculates the GRU gates for one batch element after the recurrent matrix multiplication
+// gates and gateWx are 2 x hiddenSize in the update, reset order; gates and hPrev are null on the first step
+// The update gate is stored into update, reset * hPrev into resetOutput
+static inline void gruGatesStep( int hiddenSize, const float* gates, const float* gateWx, const float* hPrev,
+	float* update, float* resetOutput )
+{
+	const float* updateWx = gateWx;
+	const float* resetWx = gateWx + hiddenSize;
+	for( int i = 0; i < hiddenSize; ++i ) {
+		if( gates == nullptr ) {
+			update[i] = recurrentSigmoid( updateWx[i] );
+		} else {
+			update[i] = recurrentSigmoid( updateWx[i] + gates[i] );
+			resetOutput[i] = recurrentSigmoid( resetWx[i] + gates[hiddenSize + i] ) * hPrev[i];
+		}
+	}
+}
+
+// Calculates the GRU output for one batch element: h = main + update * ( hPrev - main )
+// main is null on the first step, when the recurrent part is zero
+static inline void gruOutputStep( int hiddenSize, const float* main, const float* mainWx, const float* update,
+	const float* hPrev, float* h )
+{
+	for( int i = 0; i < hiddenSize; ++i ) {
+		const float mainGate = recurrentTanh( main == nullptr ? mainWx[i] : mainWx[i] + main[i] );
+		h[i] = mainGate + update[i] * ( ( hPrev == nullptr ? 0.f : hPrev[i] ) - mainGate );
+	}
+}
+
+void CCpuMathEngine::GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+	const CConstFloatHandle& gateWx, const CConstFloatHandle& mainWx,
+	const CConstFloatHandle& gateRecurWeights, const CConstFloatHandle& mainRecurWeights, int recurWeightsRowSize,
+	const CConstFloatHandle& initialOutput, const CFloatHandle& h )
+{
+	ASSERT_EXPR( sequenceLength >= 1 );
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( hiddenSize >= 1 );
+	ASSERT_EXPR( recurWeightsRowSize >= hiddenSize );
+	ASSERT_EXPR( gateWx.GetMathEngine() == this );
+	ASSERT_EXPR( mainWx.GetMathEngine() == this );
+	ASSERT_EXPR( gateRecurWeights.GetMathEngine() == this );
+	ASSERT_EXPR( mainRecurWeights.GetMathEngine() == this );
+	ASSERT_EXPR( initialOutput.IsNull() || initialOutput.GetMathEngine() == this );
+	ASSERT_EXPR( h.GetMathEngine() == this );
+
+	const int gateCount = 2;
+	const int dataSize = batchSize * hiddenSize;
+	const int gatesSize = gateCount * dataSize;
+	const int curThreadCount = IsOmpRelevant( batchSize, gatesSize ) ? threadCount : 1;
+
+	// The recurrent part of the gates of the current step: batchSize x 2 x hiddenSize
+	CFloatHandleStackVar gates( mathEngine(), gatesSize );
+	// The update gate, reset * hPrev and the recurrent part of the main gate: batchSize x hiddenSize each
+	CFloatHandleStackVar buffer( mathEngine(), 3 * dataSize );
+	const float* gatesData = GetRaw( gates.GetHandle() );
+	float* update = GetRaw( buffer.GetHandle() );
+	const CFloatHandle resetOutput = buffer.GetHandle() + dataSize;
+	const CFloatHandle main = resetOutput + dataSize;
+	float* resetOutputData = GetRaw( resetOutput );
+	const float* mainData = GetRaw( main );
+
+	CConstFloatHandle hPrev = initialOutput;
+	for( int step = 0; step < sequenceLength; ++step ) {
+		const int pos = reverse ? sequenceLength - 1 - step : step;
+		const float* currGateWx = GetRaw( gateWx + pos * gatesSize );
+		const float* currMainWx = GetRaw( mainWx + pos * dataSize );
+		float* currH = GetRaw( h + pos * dataSize );
+		const float* hPrevData = hPrev.IsNull() ? nullptr : GetRaw( hPrev );
+
+		if( hPrevData != nullptr ) {
+			MultiplyMatrixByTransposedMatrix( hPrev, batchSize, hiddenSize, hiddenSize,
+				gateRecurWeights, gateCount * hiddenSize, recurWeightsRowSize, gates.GetHandle(), gateCount * hiddenSize, gatesSize );
+		}
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int b = 0; b < batchSize; ++b ) {
+			gruGatesStep( hiddenSize, hPrevData == nullptr ? nullptr : gatesData + b * gateCount * hiddenSize,
+				currGateWx + b * gateCount * hiddenSize, hPrevData == nullptr ? nullptr : hPrevData + b * hiddenSize,
+				update + b * hiddenSize, resetOutputData + b * hiddenSize );
+		}
+
+		if( hPrevData != nullptr ) {
+			MultiplyMatrixByTransposedMatrix( resetOutput, batchSize, hiddenSize, hiddenSize,
+				mainRecurWeights, hiddenSize, recurWeightsRowSize, main, hiddenSize, dataSize );
+		}
+		NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
+		for( int b = 0; b < batchSize; ++b ) {
+			gruOutputStep( hiddenSize, hPrevData == nullptr ? nullptr : mainData + b * hiddenSize,
+				currMainWx + b * hiddenSize, update + b * hiddenSize,
+				hPrevData == nullptr ? nullptr : hPrevData + b * hiddenSize, currH + b * hiddenSize );
+		}
+
+		hPrev = h + pos * dataSize;
+	}
+}
+
+// The number of queries processed together by the fused attention
+static const int AttentionQueryBlockSize = 32;
+// The number of keys processed together by the fused attention
+static const int AttentionKeyBlockSize = 128;
+
+void CCpuMathEngine::ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+	float scale, const CConstFloatHandle& q, const CConstFloatHandle& k, const CConstFloatHandle& v,
+	const CConstFloatHandle& mask, const CFloatHandle& result )
+{
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( headCount >= 1 );
+	ASSERT_EXPR( queryLength >= 1 );
+	ASSERT_EXPR( keyLength >= 1 );
+	ASSERT_EXPR( headSize >= 1 );
+	ASSERT_EXPR( q.GetMathEngine() == this );
+	ASSERT_EXPR( k.GetMathEngine() == this );
+	ASSERT_EXPR( v.GetMathEngine() == this );
+	ASSERT_EXPR( mask.IsNull() || mask.GetMathEngine() == this );
+	ASSERT_EXPR( result.GetMathEngine() == this );
+
+	const float* qRaw = GetRaw( q );
+	const float* kRaw = GetRaw( k );
+	const float* vRaw = GetRaw( v );
+	const float* maskRaw = mask.IsNull() ? nullptr : GetRaw( mask );
+	float* resultRaw = GetRaw( result );
+
+	const int rowSize = headCount * headSize;
+	const int queryBlockCount = ( queryLength + AttentionQueryBlockSize - 1 ) / AttentionQueryBlockSize;
+	const int keyBlockSize = min( keyLength, AttentionKeyBlockSize );
+	// Each task is a block of queries of one head of one batch element
+	const int taskCount = batchSize * headCount * queryBlockCount;
+	const int curThreadCount = IsOmpRelevant( taskCount,
+		static_cast<int64_t>( batchSize ) * headCount * queryLength * keyLength * headSize ) ? threadCount : 1;
+
+	// The buffers of each thread: the attention matrix block, the not normalized result,
+	// the running maximum and the running sum of the exponents for each query
+	const int threadBufferSize = AttentionQueryBlockSize * ( keyBlockSize + headSize + 2 );
+	CFloatHandleStackVar buffer( mathEngine(), curThreadCount * threadBufferSize );
+	float* const bufferRaw = GetRaw( buffer.GetHandle() );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		float* const scores = bufferRaw + OmpGetThreadNum() * threadBufferSize;
+		float* const sum = scores + AttentionQueryBlockSize * keyBlockSize;
+		float* const rowMax = sum + AttentionQueryBlockSize * headSize;
+		float* const rowSum = rowMax + AttentionQueryBlockSize;
+
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( taskCount, start, count ) ) {
+			for( int task = start; task < start + count; ++task ) {
+				const int queryBlock = task % queryBlockCount;
+				const int head = ( task / queryBlockCount ) % headCount;
+				const int batch = task / ( queryBlockCount * headCount );
+				const int queryStart = queryBlock * AttentionQueryBlockSize;
+				const int queryCount = min( AttentionQueryBlockSize, queryLength - queryStart );
+
+				const float* const currQ = qRaw + ( batch * queryLength + queryStart ) * rowSize + head * headSize;
+				const float* const currK = kRaw + batch * keyLength * rowSize + head * headSize;
+				const float* const currV = vRaw + batch * keyLength * rowSize + head * headSize;
+				float* const currResult = resultRaw + ( batch * queryLength + queryStart ) * rowSize + head * headSize;
+
+				vectorFill( rowMax, -FLT_MAX, queryCount );
+				vectorFill0( rowSum, queryCount );
+				vectorFill0( sum, queryCount * headSize );
+
+				for( int keyStart = 0; keyStart < keyLength; keyStart += keyBlockSize ) {
+					const int keyCount = min( keyBlockSize, keyLength - keyStart );
+					multiplyMatrixByTransposedMatrix( currQ, queryCount, headSize, rowSize,
+						currK + keyStart * rowSize, keyCount, rowSize, scores, keyCount );
+
+					for( int i = 0; i < queryCount; ++i ) {
+						float* const scoresRow = scores + i * keyCount;
+						const float* const maskRow = maskRaw == nullptr ? nullptr
+							: maskRaw + ( queryStart + i ) * keyLength + keyStart;
+						float blockMax = -FLT_MAX;
+						for( int j = 0; j < keyCount; ++j ) {
+							scoresRow[j] *= scale;
+							if( maskRow != nullptr ) {
+								scoresRow[j] += maskRow[j];
+							}
+							blockMax = max( blockMax, scoresRow[j] );
+						}
+
+						// The exponents of the previous blocks are rescaled to the new maximum
+						const float newMax = max( rowMax[i], blockMax );
+						const float correction = expf( rowMax[i] - newMax );
+						float blockSum = 0;
+						for( int j = 0; j < keyCount; ++j ) {
+							scoresRow[j] = expf( scoresRow[j] - newMax );
+							blockSum += scoresRow[j];
+						}
+						rowSum[i] = rowSum[i] * correction + blockSum;
+						rowMax[i] = newMax;
+						if( correction != 1.f ) {
+							float* const sumRow = sum + i * headSize;
+							for( int j = 0; j < headSize; ++j ) {
+								sumRow[j] *= correction;
+							}
+						}
+					}
+
+					multiplyMatrixByMatrixAndAdd( scores, queryCount, keyCount, keyCount,
+						currV + keyStart * rowSize, headSize, rowSize, sum, headSize );
+				}
+
+				for( int i = 0; i < queryCount; ++i ) {
+					const float multiplier = 1.f / rowSum[i];
+					const float* const sumRow = sum + i * headSize;
+					float* const resultRow = currResult + i * rowSize;
+					for( int j = 0; j < headSize; ++j ) {
+						resultRow[j] = sumRow[j] * multiplier;
+					}
+				}
+			}
+		}
+	}
+}
+
 template<class T>
 static inline void SpaceToDepthFunc( const T* source, int dataRowCount, int dataRowWidth,
 	int blockChannels, int blockSize, bool isForward, T* result, int threadCount )
@@ -24,6 +24,10 @@ limitations under the License.
 #include <MathEngineDnnConv.h>
 #include <CpuMathEnginePrivate.h>
 #include <NeoMathEngine/SimdMathEngine.h>
+#include <CpuConvolutionTuningCache.h>
+#include <CPUInfo.h>
+#include <chrono>
+#include <sstream>
 
 namespace NeoML {
 
@@ -34,15 +38,35 @@ enum TConvAlgo {
 	CA_2,		// work with the data directly (only for stride = 1 and padding = 0)
 				// most efficient when the image is large and especially when it has many channels
 				
-	CA_1x1		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_1x1,		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_Winograd	// Winograd F(2x2, 3x3) for convolution with a 3*3 filter, stride = 1 and no dilation (forward pass only)
 };
 
+// The implementation of the forward pass
+enum TConvForwardImpl {
+	CFI_Simd,	// ISimdMathEngine
+	CFI_Algo0,	// blobConvolutionForwardAlgo0: the temporary matrix for a part of the result at a time
+	CFI_Algo1,	// blobConvolutionForwardAlgo1: the temporary matrix for an object at a time
+	CFI_1x1,	// blob3dConvolution1x1x1 (only if ForwardAlgo is CA_1x1)
+	CFI_Winograd,	// blobConvolutionForwardWinograd (only if IsWinogradAvailable)
+
+	CFI_Count
+};
+
+// The names of the implementations in the tuning cache
+static const char* const ConvForwardImplNames[CFI_Count] = { "simd", "algo0", "algo1", "1x1", "winograd" };
+
 const int BlobConvolutionCacheSize = 256 * 1024;
 
+// The minimum number of channels and filters for which the Winograd algorithm is chosen by default
+const int WinogradMinChannelCount = 16;
+const int WinogradMinFilterCount = 16;
+
 // Convolution descriptor
 struct CCpuConvolutionDesc : public CCommonConvolutionDesc {
 	TConvAlgo ForwardAlgo;
 	TConvAlgo BackwardAlgo;
+	TConvForwardImpl ForwardImpl;
 	unique_ptr<CConvolutionDesc> SimdConvolutionDesc;
 
 	CCpuConvolutionDesc( unique_ptr<CConvolutionDesc>& simdConvolutionDesc, const CBlobDesc& source, const CBlobDesc& result, const CBlobDesc& filter,
@@ -50,16 +74,42 @@ struct CCpuConvolutionDesc : public CCommonConvolutionDesc {
 		CCommonConvolutionDesc( source, result, filter, paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth ),
 		ForwardAlgo( getActualForwardAlgo() ),
 		BackwardAlgo( getActualBackwardAlgo() ),
+		ForwardImpl( CFI_Algo0 ),
 		SimdConvolutionDesc( std::move( simdConvolutionDesc ) )
 	{
 	}
 
+	// Checks if the Winograd algorithm may be used for this convolution
+	bool IsWinogradAvailable() const;
+
 	TConvAlgo getActualForwardAlgo() const;
 	TConvAlgo getActualBackwardAlgo() const;
+
+private:
+	TConvAlgo getActualGemmAlgo() const;
 };
 
-// Gets the algorithm to be used for this convolution
+inline bool CCpuConvolutionDesc::IsWinogradAvailable() const
+{
+	return Filter.Height() == 3 && Filter.Width() == 3
+		&& StrideHeight == 1 && StrideWidth == 1
+		&& DilationHeight == 1 && DilationWidth == 1;
+}
+
+// Gets the algorithm to be used for the forward pass of this convolution
 inline TConvAlgo CCpuConvolutionDesc::getActualForwardAlgo() const
+{
+	// The transforms of the data are paid off only if there are enough channels and filters
+	if( IsWinogradAvailable() && Source.Depth() * Source.Channels() >= WinogradMinChannelCount
+		&& Filter.ObjectCount() >= WinogradMinFilterCount )
+	{
+		return CA_Winograd;
+	}
+	return getActualGemmAlgo();
+}
+
+// Gets the algorithm which uses the matrix multiplication
+inline TConvAlgo CCpuConvolutionDesc::getActualGemmAlgo() const
 {
 	if( PaddingHeight == 0 && PaddingWidth == 0
 		&& DilationHeight == 1 && DilationWidth == 1
@@ -88,7 +138,7 @@ inline TConvAlgo CCpuConvolutionDesc::getActualForwardAlgo() const
 
 inline TConvAlgo CCpuConvolutionDesc::getActualBackwardAlgo() const
 {
-	TConvAlgo ret = getActualForwardAlgo();
+	TConvAlgo ret = getActualGemmAlgo();
 	if( ret == CA_2 && ( PaddingHeight != 0 || PaddingWidth != 0 ) ) {
 		ret = CA_1;
 	}
@@ -138,9 +188,130 @@ CConvolutionDesc* CCpuMathEngine::InitBlobConvolution( const CBlobDesc& source,
 
 	CCpuConvolutionDesc* desc = new CCpuConvolutionDesc( simdConvolutionDesc, source, result, filter,
 		paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth );
+	chooseConvolutionForwardImpl( *desc );
 	return desc;
 }
 
+// Checks if the forward pass implementation may be used for the convolution
+static bool isConvForwardImplAvailable( const CCpuConvolutionDesc& desc, TConvForwardImpl impl )
+{
+	switch( impl ) {
+		case CFI_Simd:
+			return desc.SimdConvolutionDesc != nullptr;
+		case CFI_Algo0:
+		case CFI_Algo1:
+			return desc.ForwardAlgo != CA_1x1;
+		case CFI_1x1:
+			return desc.ForwardAlgo == CA_1x1;
+		case CFI_Winograd:
+			return desc.IsWinogradAvailable();
+		default:
+			return false;
+	}
+}
+
+// Gets the key of the convolution in the tuning cache
+static std::string getConvTuningKey( const CCpuConvolutionDesc& desc, int threadCount )
+{
+	static const std::string cpuModelName = CCPUInfo::GetCpuModelName();
+
+	std::ostringstream key;
+	key << "cpu=" << cpuModelName << ";threads=" << threadCount << ";source=";
+	for( int i = 0; i < BD_Count; ++i ) {
+		key << ( i == 0 ? "" : "x" ) << desc.Source.DimSize( i );
+	}
+	key << ";filter=";
+	for( int i = 0; i < BD_Count; ++i ) {
+		key << ( i == 0 ? "" : "x" ) << desc.Filter.DimSize( i );
+	}
+	key << ";padding=" << desc.PaddingHeight << "x" << desc.PaddingWidth
+		<< ";stride=" << desc.StrideHeight << "x" << desc.StrideWidth
+		<< ";dilation=" << desc.DilationHeight << "x" << desc.DilationWidth;
+	return key.str();
+}
+
+// Chooses the forward pass implementation: by the tuning results if there are any, otherwise by heuristics
+void CCpuMathEngine::chooseConvolutionForwardImpl( CCpuConvolutionDesc& desc )
+{
+	if( desc.SimdConvolutionDesc != nullptr ) {
+		desc.ForwardImpl = CFI_Simd;
+	} else if( desc.ForwardAlgo == CA_Winograd ) {
+		desc.ForwardImpl = CFI_Winograd;
+	} else if( desc.ForwardAlgo == CA_1x1 ) {
+		desc.ForwardImpl = CFI_1x1;
+	} else {
+		const int algo0ThreadCount = IsOmpRelevant( desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height(),
+			static_cast<int64_t>( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+
+		const int algo1ThreadCount = IsOmpRelevant( desc.Result.ObjectCount() * desc.Result.Width(),
+			static_cast<int64_t>( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+		const int64_t algo1DataSize = static_cast<int64_t>( desc.Result.Width() ) * desc.Result.Height() * desc.Filter.ObjectSize() + desc.Result.ObjectSize();
+
+		desc.ForwardImpl = min( desc.Result.ObjectCount(), algo1ThreadCount ) * algo1DataSize <= algo0ThreadCount * BlobConvolutionCacheSize
+			? CFI_Algo1 : CFI_Algo0;
+	}
+
+	CCpuConvolutionTuningCache& cache = CCpuConvolutionTuningCache::Instance();
+	if( !cache.IsAutotuneEnabled() && cache.IsEmpty() ) {
+		return;
+	}
+
+	const std::string key = getConvTuningKey( desc, threadCount );
+	std::string implName;
+	if( cache.Lookup( key, implName ) ) {
+		for( int impl = 0; impl < CFI_Count; ++impl ) {
+			if( implName == ConvForwardImplNames[impl] && isConvForwardImplAvailable( desc, static_cast<TConvForwardImpl>( impl ) ) ) {
+				desc.ForwardImpl = static_cast<TConvForwardImpl>( impl );
+				return;
+			}
+		}
+	}
+
+	if( cache.IsAutotuneEnabled() ) {
+		tuneConvolutionForwardImpl( desc );
+		cache.Add( key, ConvForwardImplNames[desc.ForwardImpl] );
+	}
+}
+
+// The number of measured runs for each implementation; the best time is used
+static const int ConvTuningRunCount = 3;
+
+// Measures all available forward pass implementations and chooses the fastest
+void CCpuMathEngine::tuneConvolutionForwardImpl( CCpuConvolutionDesc& desc )
+{
+	CFloatHandleVar source( mathEngine(), desc.Source.BlobSize() );
+	CFloatHandleVar filter( mathEngine(), desc.Filter.BlobSize() );
+	CFloatHandleVar freeTerm( mathEngine(), desc.Filter.ObjectCount() );
+	CFloatHandleVar result( mathEngine(), desc.Result.BlobSize() );
+	VectorFill( source.GetHandle(), 0.1f, desc.Source.BlobSize() );
+	VectorFill( filter.GetHandle(), 0.1f, desc.Filter.BlobSize() );
+	VectorFill( freeTerm.GetHandle(), 0.1f, desc.Filter.ObjectCount() );
+	const CFloatHandle freeTermHandle = freeTerm.GetHandle();
+
+	TConvForwardImpl bestImpl = desc.ForwardImpl;
+	std::chrono::steady_clock::duration bestTime = std::chrono::steady_clock::duration::max();
+	for( int impl = 0; impl < CFI_Count; ++impl ) {
+		if( !isConvForwardImplAvailable( desc, static_cast<TConvForwardImpl>( impl ) ) ) {
+			continue;
+		}
+		desc.ForwardImpl = static_cast<TConvForwardImpl>( impl );
+		// The first run warms up the caches and the stack allocator
+		blobConvolutionForward( desc, GetRaw( source.GetHandle() ), GetRaw( filter.GetHandle() ), &freeTermHandle,
+			GetRaw( result.GetHandle() ) );
+		for( int run = 0; run < ConvTuningRunCount; ++run ) {
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			blobConvolutionForward( desc, GetRaw( source.GetHandle() ), GetRaw( filter.GetHandle() ), &freeTermHandle,
+				GetRaw( result.GetHandle() ) );
+			const std::chrono::steady_clock::duration time = std::chrono::steady_clock::now() - start;
+			if( time < bestTime ) {
+				bestTime = time;
+				bestImpl = desc.ForwardImpl;
+			}
+		}
+	}
+	desc.ForwardImpl = bestImpl;
+}
+
 // Creates a temporary blob with reordered input data that will be used to calculate convolution
 // This method allows for nonzero dilation
 void CCpuMathEngine::createDilationTemporaryBlob( const CCpuConvolutionDesc& desc, const float* inputData, int inputBatch,
@@ -504,47 +675,340 @@ void CCpuMathEngine::blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& des
 	}
 }
 
+// The Winograd F(2x2, 3x3) algorithm: each 2*2 tile of the result is calculated from a 4*4 tile of the source
+// The filter and the source tiles are transformed into 16 matrices each,
+// so the convolution becomes 16 matrix multiplications and the number of multiplications is 2.25 times smaller
+static const int WinogradOutputTileSize = 2;
+static const int WinogradInputTileSize = 4;
+static const int WinogradMatrixCount = WinogradInputTileSize * WinogradInputTileSize;
+
+// Transforms the filter: U = G * g * G^T
+// The filter is [filterCount][3][3][channelCount], the result is [16][filterCount][channelCount]
+static void winogradTransformFilter( const float* filter, int filterCount, int channelCount, float* result )
+{
+	const int matrixSize = filterCount * channelCount;
+	for( int f = 0; f < filterCount; f++ ) {
+		for( int c = 0; c < channelCount; c++ ) {
+			const float* g = filter + f * 9 * channelCount + c;
+			float temp[WinogradInputTileSize][3];
+			for( int x = 0; x < 3; x++ ) {
+				const float g0 = g[x * channelCount];
+				const float g1 = g[( 3 + x ) * channelCount];
+				const float g2 = g[( 6 + x ) * channelCount];
+				temp[0][x] = g0;
+				temp[1][x] = 0.5f * ( g0 + g1 + g2 );
+				temp[2][x] = 0.5f * ( g0 - g1 + g2 );
+				temp[3][x] = g2;
+			}
+			float* u = result + f * channelCount + c;
+			for( int i = 0; i < WinogradInputTileSize; i++ ) {
+				u[( i * 4 ) * matrixSize] = temp[i][0];
+				u[( i * 4 + 1 ) * matrixSize] = 0.5f * ( temp[i][0] + temp[i][1] + temp[i][2] );
+				u[( i * 4 + 2 ) * matrixSize] = 0.5f * ( temp[i][0] - temp[i][1] + temp[i][2] );
+				u[( i * 4 + 3 ) * matrixSize] = temp[i][2];
+			}
+		}
+	}
+}
+
+// Transforms the source tiles of one object: V = B^T * d * B
+// The result is [16][tileCount][channelCount]; zeros is a vector of channelCount zeros used for padding
+// temp must have space for 16 * channelCount
+static void winogradTransformSource( const CCpuConvolutionDesc& desc, const float* sourceData,
+	int tileStart, int tileCount, const float* zeros, float* temp, float* result )
+{
+	const int channelCount = desc.Source.Depth() * desc.Source.Channels();
+	const int tilesPerRow = ( desc.Result.Width() + WinogradOutputTileSize - 1 ) / WinogradOutputTileSize;
+	const int matrixSize = tileCount * channelCount;
+
+	for( int t = 0; t < tileCount; t++ ) {
+		const int y0 = ( ( tileStart + t ) / tilesPerRow ) * WinogradOutputTileSize - desc.PaddingHeight;
+		const int x0 = ( ( tileStart + t ) % tilesPerRow ) * WinogradOutputTileSize - desc.PaddingWidth;
+
+		// temp = B^T * d, column by column
+		for( int j = 0; j < WinogradInputTileSize; j++ ) {
+			const float* d[WinogradInputTileSize];
+			for( int i = 0; i < WinogradInputTileSize; i++ ) {
+				const int y = y0 + i;
+				const int x = x0 + j;
+				d[i] = ( y < 0 || y >= desc.Source.Height() || x < 0 || x >= desc.Source.Width() ) ? zeros
+					: sourceData + ( y * desc.Source.Width() + x ) * channelCount;
+			}
+			const float* d0 = d[0];
+			const float* d1 = d[1];
+			const float* d2 = d[2];
+			const float* d3 = d[3];
+			float* t0 = temp + j * channelCount;
+			float* t1 = temp + ( 4 + j ) * channelCount;
+			float* t2 = temp + ( 8 + j ) * channelCount;
+			float* t3 = temp + ( 12 + j ) * channelCount;
+			for( int c = 0; c < channelCount; c++ ) {
+				t0[c] = d0[c] - d2[c];
+				t1[c] = d1[c] + d2[c];
+				t2[c] = d2[c] - d1[c];
+				t3[c] = d1[c] - d3[c];
+			}
+		}
+
+		// V = temp * B, row by row
+		for( int i = 0; i < WinogradInputTileSize; i++ ) {
+			const float* t0 = temp + i * 4 * channelCount;
+			const float* t1 = t0 + channelCount;
+			const float* t2 = t1 + channelCount;
+			const float* t3 = t2 + channelCount;
+			float* v0 = result + i * 4 * matrixSize + t * channelCount;
+			float* v1 = v0 + matrixSize;
+			float* v2 = v1 + matrixSize;
+			float* v3 = v2 + matrixSize;
+			for( int c = 0; c < channelCount; c++ ) {
+				v0[c] = t0[c] - t2[c];
+				v1[c] = t1[c] + t2[c];
+				v2[c] = t2[c] - t1[c];
+				v3[c] = t1[c] - t3[c];
+			}
+		}
+	}
+}
+
+// Transforms the products back into the result tiles of one object: Y = A^T * M * A
+// The products are [16][tileCount][filterCount]; temp must have space for 8 * filterCount
+static void winogradTransformResult( const CCpuConvolutionDesc& desc, const float* products,
+	int tileStart, int tileCount, const float* freeTerm, float* temp, float* resultData )
+{
+	const int filterCount = desc.Filter.ObjectCount();
+	const int tilesPerRow = ( desc.Result.Width() + WinogradOutputTileSize - 1 ) / WinogradOutputTileSize;
+	const int matrixSize = tileCount * filterCount;
+
+	for( int t = 0; t < tileCount; t++ ) {
+		const int y0 = ( ( tileStart + t ) / tilesPerRow ) * WinogradOutputTileSize;
+		const int x0 = ( ( tileStart + t ) % tilesPerRow ) * WinogradOutputTileSize;
+
+		// temp = A^T * M, column by column
+		for( int j = 0; j < WinogradInputTileSize; j++ ) {
+			const float* m0 = products + j * matrixSize + t * filterCount;
+			const float* m1 = m0 + 4 * matrixSize;
+			const float* m2 = m1 + 4 * matrixSize;
+			const float* m3 = m2 + 4 * matrixSize;
+			float* t0 = temp + j * filterCount;
+			float* t1 = temp + ( 4 + j ) * filterCount;
+			for( int f = 0; f < filterCount; f++ ) {
+				t0[f] = m0[f] + m1[f] + m2[f];
+				t1[f] = m1[f] - m2[f] - m3[f];
+			}
+		}
+
+		// Y = temp * A, row by row; the tiles on the bottom and right borders may be incomplete
+		for( int i = 0; i < WinogradOutputTileSize && y0 + i < desc.Result.Height(); i++ ) {
+			const float* t0 = temp + i * 4 * filterCount;
+			const float* t1 = t0 + filterCount;
+			const float* t2 = t1 + filterCount;
+			const float* t3 = t2 + filterCount;
+			float* y = resultData + ( ( y0 + i ) * desc.Result.Width() + x0 ) * filterCount;
+			for( int f = 0; f < filterCount; f++ ) {
+				y[f] = t0[f] + t1[f] + t2[f];
+			}
+			if( freeTerm != nullptr ) {
+				vectorAdd( y, freeTerm, y, filterCount );
+			}
+			if( x0 + 1 < desc.Result.Width() ) {
+				y += filterCount;
+				for( int f = 0; f < filterCount; f++ ) {
+					y[f] = t1[f] - t2[f] - t3[f];
+				}
+				if( freeTerm != nullptr ) {
+					vectorAdd( y, freeTerm, y, filterCount );
+				}
+			}
+		}
+	}
+}
+
+// The size of the filter transformed for the Winograd algorithm
+static inline int getWinogradFilterSize( const CCpuConvolutionDesc& desc )
+{
+	return WinogradMatrixCount * desc.Filter.ObjectCount() * desc.Filter.Depth() * desc.Filter.Channels();
+}
+
+void CCpuMathEngine::blobConvolutionForwardWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* transformedFilter, const float* freeTerm, float* resultData )
+{
+	const int channelCount = desc.Source.Depth() * desc.Source.Channels();
+	const int filterCount = desc.Filter.ObjectCount();
+	const int tilesPerObject = ( ( desc.Result.Height() + WinogradOutputTileSize - 1 ) / WinogradOutputTileSize )
+		* ( ( desc.Result.Width() + WinogradOutputTileSize - 1 ) / WinogradOutputTileSize );
+	// The number of tiles processed at once: the transformed tiles and the products should fit into the cache
+	const int tileBlockSize = max( 1, min( tilesPerObject,
+		BlobConvolutionCacheSize / ( WinogradMatrixCount * ( channelCount + filterCount ) ) ) );
+	const int blocksPerObject = ( tilesPerObject + tileBlockSize - 1 ) / tileBlockSize;
+	const int taskCount = desc.Source.ObjectCount() * blocksPerObject;
+
+	const int curThreadCount = IsOmpRelevant( taskCount,
+		static_cast<int64_t>( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+	// The transformed source, the products and the temporary buffer for the transforms
+	const int threadBufferSize = WinogradMatrixCount * ( tileBlockSize + 1 ) * ( channelCount + filterCount );
+
+	CFloatHandleStackVar buffer( mathEngine(), curThreadCount * threadBufferSize + channelCount );
+	float* zeros = GetRaw( buffer.GetHandle() );
+	vectorFill( zeros, 0.f, channelCount );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		float* transformedSource = zeros + channelCount + OmpGetThreadNum() * threadBufferSize;
+		float* products = transformedSource + WinogradMatrixCount * tileBlockSize * channelCount;
+		float* temp = products + WinogradMatrixCount * tileBlockSize * filterCount;
+
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( taskCount, start, count ) ) {
+			for( int task = start; task < start + count; task++ ) {
+				const int batch = task / blocksPerObject;
+				const int tileStart = ( task % blocksPerObject ) * tileBlockSize;
+				const int tileCount = min( tileBlockSize, tilesPerObject - tileStart );
+
+				winogradTransformSource( desc, sourceData + batch * desc.Source.ObjectSize(), tileStart, tileCount,
+					zeros, temp, transformedSource );
+				for( int i = 0; i < WinogradMatrixCount; i++ ) {
+					multiplyMatrixByTransposedMatrix( transformedSource + i * tileCount * channelCount, tileCount,
+						channelCount, channelCount, transformedFilter + i * filterCount * channelCount, filterCount,
+						channelCount, products + i * tileCount * filterCount, filterCount );
+				}
+				winogradTransformResult( desc, products, tileStart, tileCount, freeTerm, temp,
+					resultData + batch * desc.Result.ObjectSize() );
+			}
+		}
+	}
+}
+
 void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CFloatHandle& source,
 	const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& result )
 {
 	const float* sourceRaw = GetRaw( source );
 	const float* filterRaw = GetRaw( filter );
-	float* freeTermRaw = freeTerm != nullptr ? GetRaw( *freeTerm ) : nullptr;
 	float* resultRaw = GetRaw( result );
 
 	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	blobConvolutionForward( desc, sourceRaw, filterRaw, freeTerm, resultRaw );
+}
 
-	if( desc.SimdConvolutionDesc != nullptr ) {
-		simdMathEngine->BlobConvolution( *desc.SimdConvolutionDesc, sourceRaw, filterRaw, freeTermRaw, resultRaw );
-		return;
-	}
+int CCpuMathEngine::GetBlobConvolutionPreparedFilterSize( const CConvolutionDesc& convDesc ) const
+{
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	return desc.ForwardImpl == CFI_Winograd ? getWinogradFilterSize( desc ) : 0;
+}
 
-	switch( desc.ForwardAlgo ) {
-		case CA_1:
-		case CA_2:
-		{
-			const int algo0ThreadCount = IsOmpRelevant( desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height(),
-				static_cast<int64_t>( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+void CCpuMathEngine::PrepareBlobConvolutionFilter( const CConvolutionDesc& convDesc, const CConstFloatHandle& filter,
+	const CFloatHandle& preparedFilter )
+{
+	ASSERT_EXPR( filter.GetMathEngine() == this );
+	ASSERT_EXPR( preparedFilter.GetMathEngine() == this );
 
-			const int algo1ThreadCount = IsOmpRelevant( desc.Result.ObjectCount() * desc.Result.Width(),
-				static_cast<int64_t>( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
-			const int64_t algo1DataSize = static_cast<int64_t>( desc.Result.Width() ) * desc.Result.Height() * desc.Filter.ObjectSize() + desc.Result.ObjectSize();
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	ASSERT_EXPR( desc.ForwardImpl == CFI_Winograd );
+	winogradTransformFilter( GetRaw( filter ), desc.Filter.ObjectCount(), desc.Filter.Depth() * desc.Filter.Channels(),
+		GetRaw( preparedFilter ) );
+}
 
-			if( min( desc.Result.ObjectCount(), algo1ThreadCount ) * algo1DataSize <= algo0ThreadCount * BlobConvolutionCacheSize ) {
-				blobConvolutionForwardAlgo1( desc, sourceRaw, filterRaw, freeTerm, resultRaw );
-			} else {
-				blobConvolutionForwardAlgo0( desc, sourceRaw, filterRaw, freeTerm, resultRaw );
+void CCpuMathEngine::BlobConvolutionWithPreparedFilter( const CConvolutionDesc& convDesc, const CConstFloatHandle& source,
+	const CConstFloatHandle& preparedFilter, const CConstFloatHandle* freeTerm, const CFloatHandle& result )
+{
+	ASSERT_EXPR( source.GetMathEngine() == this );
+	ASSERT_EXPR( preparedFilter.GetMathEngine() == this );
+	ASSERT_EXPR( result.GetMathEngine() == this );
+
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	ASSERT_EXPR( desc.ForwardImpl == CFI_Winograd );
+	blobConvolutionForwardWinograd( desc, GetRaw( source ), GetRaw( preparedFilter ),
+		freeTerm != nullptr ? GetRaw( *freeTerm ) : nullptr, GetRaw( result ) );
+}
+
+void CCpuMathEngine::BlobQuantizedConvolution( const CConvolutionDesc& convDesc, const CFloatHandle& source,
+	float sourceScale, const CIntHandle& filter, const CFloatHandle& filterScales, const CFloatHandle* freeTerm,
+	const CFloatHandle& result )
+{
+	ASSERT_EXPR( source.GetMathEngine() == this );
+	ASSERT_EXPR( filter.GetMathEngine() == this );
+	ASSERT_EXPR( filterScales.GetMathEngine() == this );
+	ASSERT_EXPR( result.GetMathEngine() == this );
+	ASSERT_EXPR( sourceScale > 0 );
+
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	const float* sourceData = GetRaw( source );
+	const int* filterData = GetRaw( filter );
+	const float* filterScalesData = GetRaw( filterScales );
+	const float* freeTermData = freeTerm != nullptr ? GetRaw( *freeTerm ) : nullptr;
+	float* resultData = GetRaw( result );
+
+	// The same as blobConvolutionForwardAlgo0, with the quantized matrix multiplication
+	const int filterObjectCount = desc.Filter.ObjectCount();
+	const int filterObjectSize = desc.Filter.ObjectSize();
+	const int resultItemCount = desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height();
+	const int curThreadCount = IsOmpRelevant( resultItemCount, static_cast< int64_t >( desc.Result.BlobSize() ) * filterObjectSize ) ? threadCount : 1;
+	const int cacheItemCount = max( 1, min( ceilTo( BlobConvolutionCacheSize / filterObjectSize, 16 ), resultItemCount / curThreadCount ) );
+	const int tempDataSize = curThreadCount * cacheItemCount * filterObjectSize;
+
+	CFloatHandleStackVar tempData( mathEngine(), tempDataSize );
+	float* tempDataRaw = GetRaw( tempData.GetHandle() );
+	CMemoryHandleStackVar<CQuantizedValue> quantizedData( mathEngine(), tempDataSize );
+	CQuantizedValue* quantizedDataRaw = GetRaw( quantizedData.GetHandle() );
+
+	NEOML_OMP_NUM_THREADS( curThreadCount )
+	{
+		float* tempDataPtr = tempDataRaw + OmpGetThreadNum() * cacheItemCount * filterObjectSize;
+		CQuantizedValue* quantizedDataPtr = quantizedDataRaw + OmpGetThreadNum() * cacheItemCount * filterObjectSize;
+
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( resultItemCount, start, count ) ) {
+			int index = 0;
+			while( index < count ) {
+				const int size = min( count - index, cacheItemCount );
+
+				fillTempData( sourceData, tempDataPtr, desc, start + index, size );
+				quantizeMatrix( tempDataPtr, size * filterObjectSize, sourceScale, quantizedDataPtr );
+
+				multiplyMatrixByTransposedQuantizedMatrix( quantizedDataPtr, size, filterObjectSize, sourceScale,
+					filterData, filterScalesData, filterObjectCount, freeTermData,
+					resultData + ( start + index ) * filterObjectCount, filterObjectCount );
+
+				index += size;
 			}
-			break;
 		}
-		case CA_1x1:
-			{
-				bool needsFlatten = desc.Source.Depth() != 1;
+	}
+}
 
-				blob3dConvolution1x1x1( needsFlatten ? flatten( desc.Source ) : desc.Source, needsFlatten ? flatten( desc.Filter ) : desc.Filter,
-					desc.Result, desc.StrideHeight, desc.StrideWidth, 1, sourceRaw, filterRaw, freeTermRaw, resultRaw );
-				break;
-			}
+void CCpuMathEngine::blobConvolutionForward( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* filterData, const CFloatHandle* freeTermData, float* resultData )
+{
+	switch( desc.ForwardImpl ) {
+		case CFI_Simd:
+			simdMathEngine->BlobConvolution( *desc.SimdConvolutionDesc, sourceData, filterData,
+				freeTermData != nullptr ? GetRaw( *freeTermData ) : nullptr, resultData );
+			break;
+		case CFI_Algo0:
+			blobConvolutionForwardAlgo0( desc, sourceData, filterData, freeTermData, resultData );
+			break;
+		case CFI_Algo1:
+			blobConvolutionForwardAlgo1( desc, sourceData, filterData, freeTermData, resultData );
+			break;
+		case CFI_1x1:
+		{
+			bool needsFlatten = desc.Source.Depth() != 1;
+
+			blob3dConvolution1x1x1( needsFlatten ? flatten( desc.Source ) : desc.Source, needsFlatten ? flatten( desc.Filter ) : desc.Filter,
+				desc.Result, desc.StrideHeight, desc.StrideWidth, 1, sourceData, filterData,
+				freeTermData != nullptr ? GetRaw( *freeTermData ) : nullptr, resultData );
+			break;
+		}
+		case CFI_Winograd:
+		{
+			// The filter is transformed on every call; use PrepareBlobConvolutionFilter to do it once
+			CFloatHandleStackVar transformedFilter( mathEngine(), getWinogradFilterSize( desc ) );
+			winogradTransformFilter( filterData, desc.Filter.ObjectCount(), desc.Filter.Depth() * desc.Filter.Channels(),
+				GetRaw( transformedFilter.GetHandle() ) );
+			blobConvolutionForwardWinograd( desc, sourceData, GetRaw( transformedFilter.GetHandle() ),
+				freeTermData != nullptr ? GetRaw( *freeTermData ) : nullptr, resultData );
+			break;
+		}
 		default:
 			ASSERT_EXPR( false );
 	}
@@ -25,6 +25,7 @@ limitations under the License.
 #include <MemoryHandleInternal.h>
 #include <MathEngineCommon.h>
 #include <CpuArmMathEngineVectorMathPrivate.h>
+#include <math.h>
 
 namespace NeoML {
 
@@ -472,6 +473,55 @@ void CCpuMathEngine::MultiplyDiagMatrixByMatrixAndAdd(int batchSize, const CCons
 	}
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Int8 quantized matrix multiplication
+// The sum of two products of int8 values in [-127, 127] range fits into int16, so vmull + vmlal do not overflow
+
+// Calculates the dot product of two int8 vectors
+static inline int quantizedDotProduct( const signed char* first, const signed char* second, int width )
+{
+	int32x4_t acc = vdupq_n_s32( 0 );
+	const int neonWidth = width / 16 * 16;
+	for( int k = 0; k < neonWidth; k += 16 ) {
+		const int8x16_t firstValue = vld1q_s8( first + k );
+		const int8x16_t secondValue = vld1q_s8( second + k );
+		int16x8_t products = vmull_s8( vget_low_s8( firstValue ), vget_low_s8( secondValue ) );
+		products = vmlal_s8( products, vget_high_s8( firstValue ), vget_high_s8( secondValue ) );
+		acc = vpadalq_s16( acc, products );
+	}
+
+	int result = vgetq_lane_s32( acc, 0 ) + vgetq_lane_s32( acc, 1 ) + vgetq_lane_s32( acc, 2 ) + vgetq_lane_s32( acc, 3 );
+	for( int k = neonWidth; k < width; ++k ) {
+		result += first[k] * second[k];
+	}
+	return result;
+}
+
+void CCpuMathEngine::quantizeMatrix( const float* data, int size, float scale, CQuantizedValue* result )
+{
+	const float multiplier = 1.f / scale;
+	for( int i = 0; i < size; ++i ) {
+		const float value = min( 127.f, max( -127.f, data[i] * multiplier ) );
+		result[i] = static_cast<signed char>( roundf( value ) );
+	}
+}
+
+void CCpuMathEngine::multiplyMatrixByTransposedQuantizedMatrix( const CQuantizedValue* first, int firstHeight, int width,
+	float firstScale, const int* second, const float* secondScales, int secondHeight, const float* freeTerm,
+	float* result, int resultRowSize )
+{
+	const signed char* secondData = reinterpret_cast<const signed char*>( second );
+	const int secondRowSize = ( width + 3 ) / 4 * 4;
+	for( int i = 0; i < firstHeight; ++i ) {
+		const signed char* firstRow = first + i * width;
+		float* resultRow = result + i * resultRowSize;
+		for( int j = 0; j < secondHeight; ++j ) {
+			const int product = quantizedDotProduct( firstRow, secondData + j * secondRowSize, width );
+			resultRow[j] = firstScale * secondScales[j] * product + ( freeTerm != nullptr ? freeTerm[j] : 0.f );
+		}
+	}
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_NEON
@@ -546,6 +546,140 @@ void CCpuMathEngine::MultiplyLookupMatrixByLookupVector(int batchSize, const CLo
 	}
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Int8 quantized matrix multiplication
+// SSE2 has no 8-bit multiplication, so the values are sign-extended to int16 and multiplied by pmaddwd
+// The products of two int8 values in [-127, 127] range do not overflow the int16 pairwise sums of pmaddwd
+
+// Quantizes the float values into [-127, 127] range and stores them as int16
+static inline void quantizeToInt16( const float* data, int size, float multiplier, short* result )
+{
+	const __m128 mult = _mm_set1_ps( multiplier );
+	const __m128 maxValue = _mm_set1_ps( 127.f );
+	const __m128 minValue = _mm_set1_ps( -127.f );
+
+	int sseSize = size / 8;
+	for( ; sseSize > 0; --sseSize ) {
+		const __m128 first = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( data ), mult ), minValue ), maxValue );
+		const __m128 second = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( data + 4 ), mult ), minValue ), maxValue );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( result ),
+			_mm_packs_epi32( _mm_cvtps_epi32( first ), _mm_cvtps_epi32( second ) ) );
+		data += 8;
+		result += 8;
+	}
+
+	for( int i = 0; i < size % 8; ++i ) {
+		const float value = min( 127.f, max( -127.f, data[i] * multiplier ) );
+		result[i] = static_cast<short>( _mm_cvtss_si32( _mm_set_ss( value ) ) );
+	}
+}
+
+// Loads 16 int8 values and sign-extends them into two int16 vectors
+static inline void loadInt8Sse( const signed char* data, __m128i& low, __m128i& high )
+{
+	const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) );
+	low = _mm_srai_epi16( _mm_unpacklo_epi8( value, value ), 8 );
+	high = _mm_srai_epi16( _mm_unpackhi_epi8( value, value ), 8 );
+}
+
+static inline int horizontalAddIntSse( __m128i value )
+{
+	value = _mm_add_epi32( value, _mm_shuffle_epi32( value, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	value = _mm_add_epi32( value, _mm_shuffle_epi32( value, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_cvtsi128_si32( value );
+}
+
+// Calculates the dot products of FirstCount int16 rows by SecondCount int8 rows
+template<int FirstCount, int SecondCount>
+static inline void quantizedDotProducts( const short* first, int width, const signed char* second, int secondRowSize,
+	int* result )
+{
+	__m128i acc[FirstCount][SecondCount];
+	for( int i = 0; i < FirstCount; ++i ) {
+		for( int j = 0; j < SecondCount; ++j ) {
+			acc[i][j] = _mm_setzero_si128();
+		}
+	}
+
+	const int sseWidth = width / 16 * 16;
+	for( int k = 0; k < sseWidth; k += 16 ) {
+		__m128i secondLow[SecondCount];
+		__m128i secondHigh[SecondCount];
+		for( int j = 0; j < SecondCount; ++j ) {
+			loadInt8Sse( second + j * secondRowSize + k, secondLow[j], secondHigh[j] );
+		}
+		for( int i = 0; i < FirstCount; ++i ) {
+			const __m128i firstLow = _mm_loadu_si128( reinterpret_cast<const __m128i*>( first + i * width + k ) );
+			const __m128i firstHigh = _mm_loadu_si128( reinterpret_cast<const __m128i*>( first + i * width + k + 8 ) );
+			for( int j = 0; j < SecondCount; ++j ) {
+				acc[i][j] = _mm_add_epi32( acc[i][j], _mm_add_epi32( _mm_madd_epi16( firstLow, secondLow[j] ),
+					_mm_madd_epi16( firstHigh, secondHigh[j] ) ) );
+			}
+		}
+	}
+
+	for( int i = 0; i < FirstCount; ++i ) {
+		for( int j = 0; j < SecondCount; ++j ) {
+			int sum = horizontalAddIntSse( acc[i][j] );
+			for( int k = sseWidth; k < width; ++k ) {
+				sum += first[i * width + k] * second[j * secondRowSize + k];
+			}
+			result[i * SecondCount + j] = sum;
+		}
+	}
+}
+
+// The size of the second matrix part that is processed with each block of the first matrix rows
+static const int QuantizedSecondBlockSize = 128 * 1024;
+
+void CCpuMathEngine::quantizeMatrix( const float* data, int size, float scale, CQuantizedValue* result )
+{
+	quantizeToInt16( data, size, 1.f / scale, result );
+}
+
+void CCpuMathEngine::multiplyMatrixByTransposedQuantizedMatrix( const CQuantizedValue* first, int firstHeight, int width,
+	float firstScale, const int* second, const float* secondScales, int secondHeight, const float* freeTerm,
+	float* result, int resultRowSize )
+{
+	const signed char* secondData = reinterpret_cast<const signed char*>( second );
+	const int secondRowSize = ( width + 3 ) / 4 * 4;
+	const int secondBlockHeight = max( 2, QuantizedSecondBlockSize / max( 1, secondRowSize ) / 2 * 2 );
+
+	int products[8];
+	for( int secondStart = 0; secondStart < secondHeight; secondStart += secondBlockHeight ) {
+		const int secondEnd = min( secondHeight, secondStart + secondBlockHeight );
+		for( int i = 0; i < firstHeight; i += 4 ) {
+			const int firstCount = min( 4, firstHeight - i );
+			for( int j = secondStart; j < secondEnd; j += 2 ) {
+				const int secondCount = min( 2, secondEnd - j );
+				const short* firstRow = first + i * width;
+				const signed char* secondRow = secondData + j * secondRowSize;
+				if( firstCount == 4 && secondCount == 2 ) {
+					quantizedDotProducts<4, 2>( firstRow, width, secondRow, secondRowSize, products );
+				} else if( firstCount == 4 ) {
+					quantizedDotProducts<4, 1>( firstRow, width, secondRow, secondRowSize, products );
+				} else {
+					for( int r = 0; r < firstCount; ++r ) {
+						if( secondCount == 2 ) {
+							quantizedDotProducts<1, 2>( firstRow + r * width, width, secondRow, secondRowSize, products + r * 2 );
+						} else {
+							quantizedDotProducts<1, 1>( firstRow + r * width, width, secondRow, secondRowSize, products + r );
+						}
+					}
+				}
+
+				for( int r = 0; r < firstCount; ++r ) {
+					float* resultRow = result + ( i + r ) * resultRowSize;
+					for( int c = 0; c < secondCount; ++c ) {
+						resultRow[j + c] = firstScale * secondScales[j + c] * products[r * secondCount + c]
+							+ ( freeTerm != nullptr ? freeTerm[j + c] : 0.f );
+					}
+				}
+			}
+		}
+	}
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_SSE
@@ -68,7 +68,8 @@ CConvolutionDesc* CAvxMathEngine::InitBlobConvolution( const CBlobDesc& source,
 	int strideHeight, int strideWidth, int dilationHeight, int dilationWidth, const CBlobDesc& filter,
 	const CBlobDesc& result ) const
 {
-	if( CBlobConvolutionFabric::IsBlobConvolutionAvailable( filter.BatchWidth() , filter.Height(), filter.Width() ) ) {
+	if( CBlobConvolutionFabric::IsBlobConvolutionAvailable( filter.BatchWidth(), filter.Channels() * filter.Depth(),
+		filter.Height(), filter.Width(), paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth ) ) {
 		return new CAvxConvolutionDesc( mathEngine, source, result, filter, paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth );
 	}
 	return nullptr;
@@ -63,6 +63,12 @@ size_t CCudaMathEngine::GetMemoryInPools() const
 	return memoryPool->GetMemoryInPools();
 }
 
+void CCudaMathEngine::GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	memoryPool->GetStatistics( statistics );
+}
+
 void CCudaMathEngine::SetReuseMemoryMode( bool )
 {
 	// Always true, because allocation is sync
@@ -1026,6 +1026,122 @@ void CCudaMathEngine::vectorMultichannelLookupAndAddToTable(int batchSize, int c
 	}
 }
 
+// The fused optimizer steps launch one kernel per tensor: the tensors are in different memory blocks
+void CCudaMathEngine::FusedSgdStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate )
+{
+	SetCudaDevice( device->DeviceNumber );
+
+	for( int i = 0; i < tensorCount; ++i ) {
+		const CFusedSolverTensor& tensor = tensors[i];
+		ASSERT_EXPR( tensor.Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.Moment.GetMathEngine() == this );
+		if( tensor.Size == 0 ) {
+			continue;
+		}
+
+		int blockCount;
+		int threadCount;
+		getCudaTaskGrid( blockCount, threadCount, tensor.Size, FusedSgdStepCombineCount );
+		FusedSgdStepKernel<<<blockCount, threadCount>>>( GetRaw( tensor.Param ), GetRaw( tensor.Diff ),
+			GetRaw( tensor.Moment ), tensor.Size, tensor.Rate, tensor.L1, tensor.L2, momentDecayRate );
+	}
+}
+
+void CCudaMathEngine::FusedAdamStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+	float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult )
+{
+	SetCudaDevice( device->DeviceNumber );
+
+	for( int i = 0; i < tensorCount; ++i ) {
+		const CFusedSolverTensor& tensor = tensors[i];
+		ASSERT_EXPR( tensor.Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.Moment.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.SecondMoment.GetMathEngine() == this );
+		ASSERT_EXPR( tensor.SecondMomentMax.IsNull() || tensor.SecondMomentMax.GetMathEngine() == this );
+		if( tensor.Size == 0 ) {
+			continue;
+		}
+
+		int blockCount;
+		int threadCount;
+		getCudaTaskGrid( blockCount, threadCount, tensor.Size, FusedAdamStepCombineCount );
+		FusedAdamStepKernel<<<blockCount, threadCount>>>( GetRaw( tensor.Param ), GetRaw( tensor.Diff ),
+			GetRaw( tensor.Moment ), GetRaw( tensor.SecondMoment ),
+			tensor.SecondMomentMax.IsNull() ? nullptr : GetRaw( tensor.SecondMomentMax ), tensor.Size,
+			tensor.Rate, tensor.L1, tensor.L2, tensor.WeightDecay, momentDecayRate, secondMomentDecayRate, epsilon,
+			secondMomentMult, nesterovDiffMult, nesterovMomentMult );
+	}
+}
+
+void CCudaMathEngine::FusedLambStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+	float secondMomentDecayRate, float epsilon, float diffMult, bool useTrustRatio, float weightNormClip,
+	float* diffSquaredNorms )
+{
+	SetCudaDevice( device->DeviceNumber );
+
+	int maxSize = 0;
+	for( int i = 0; i < tensorCount; ++i ) {
+		ASSERT_EXPR( tensors[i].Param.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Diff.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].Moment.GetMathEngine() == this );
+		ASSERT_EXPR( tensors[i].SecondMoment.GetMathEngine() == this );
+		maxSize = max( maxSize, tensors[i].Size );
+	}
+	if( maxSize == 0 ) {
+		for( int i = 0; diffSquaredNorms != nullptr && i < tensorCount; ++i ) {
+			diffSquaredNorms[i] = 0;
+		}
+		return;
+	}
+
+	// The update is kept until the trust ratio, which depends on its norm, is known
+	CFloatHandleStackVar update( mathEngine(), maxSize );
+	// The squared norms of the parameters, the update, and the gradient; then the update multiplier
+	CFloatHandleStackVar vars( mathEngine(), 4 );
+	for( int i = 0; i < tensorCount; ++i ) {
+		const CFusedSolverTensor& tensor = tensors[i];
+		if( tensor.Size == 0 ) {
+			if( diffSquaredNorms != nullptr ) {
+				diffSquaredNorms[i] = 0;
+			}
+			continue;
+		}
+
+		int blockCount;
+		int threadCount;
+		getCudaTaskGrid( blockCount, threadCount, tensor.Size, FusedLambMomentsCombineCount );
+		FusedLambMomentsKernel<<<blockCount, threadCount>>>( GetRaw( tensor.Param ), GetRaw( tensor.Diff ),
+			GetRaw( tensor.Moment ), GetRaw( tensor.SecondMoment ), GetRaw( update.GetHandle() ), tensor.Size,
+			tensor.WeightDecay, momentDecayRate, secondMomentDecayRate, epsilon, diffMult );
+
+		VectorDotProduct( tensor.Param, tensor.Param, tensor.Size, vars[0] );
+		VectorDotProduct( update, update, tensor.Size, vars[1] );
+		VectorDotProduct( tensor.Diff, tensor.Diff, tensor.Size, vars[2] );
+		float norms[3];
+		DataExchangeRaw( norms, vars.GetHandle(), sizeof( norms ) );
+
+		float trustRatio = 1.f;
+		if( useTrustRatio ) {
+			float paramNorm = sqrtf( norms[0] );
+			if( weightNormClip > 0 ) {
+				paramNorm = min( paramNorm, weightNormClip );
+			}
+			const float updateNorm = sqrtf( norms[1] );
+			if( paramNorm > 0 && updateNorm > 0 ) {
+				trustRatio = paramNorm / updateNorm;
+			}
+		}
+		if( diffSquaredNorms != nullptr ) {
+			diffSquaredNorms[i] = norms[2];
+		}
+
+		vars.SetValueAt( 3, -tensor.Rate * trustRatio );
+		VectorMultiplyAndAdd( tensor.Param, update, tensor.Param, tensor.Size, vars[3] );
+	}
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
@@ -643,6 +643,29 @@ void CCudaMathEngine::IndRnnRecurrentLearn( bool reverse, int sequenceLength, in
 		mask.IsNull() ? nullptr : GetRaw( mask ), GetRaw( u ), GetRaw( h ), GetRaw( hDiff ), GetRaw( uDiff ) );
 }
 
+void CCudaMathEngine::LstmRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*wx*/, const CConstFloatHandle& /*recurWeights*/,
+	const CConstFloatHandle& /*initialOutput*/, const CConstFloatHandle& /*initialState*/,
+	const CFloatHandle& /*h*/, const CFloatHandle& /*c*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::GruRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*gateWx*/, const CConstFloatHandle& /*mainWx*/,
+	const CConstFloatHandle& /*gateRecurWeights*/, const CConstFloatHandle& /*mainRecurWeights*/, int /*recurWeightsRowSize*/,
+	const CConstFloatHandle& /*initialOutput*/, const CFloatHandle& /*h*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::ScaledDotProductAttention( int /*batchSize*/, int /*headCount*/, int /*queryLength*/, int /*keyLength*/,
+	int /*headSize*/, float /*scale*/, const CConstFloatHandle& /*q*/, const CConstFloatHandle& /*k*/,
+	const CConstFloatHandle& /*v*/, const CConstFloatHandle& /*mask*/, const CFloatHandle& /*result*/ )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
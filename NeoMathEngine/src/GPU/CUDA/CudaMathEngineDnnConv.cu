@@ -235,6 +235,24 @@ void CCudaMathEngine::BlobConvolutionLearnAdd( const CConvolutionDesc& convDesc,
 		tempMatrix, matrixWidth, matrixWidth, filterDiff, matrixWidth, desc.Filter.BlobSize() );
 }
 
+// The filter is never prepared: GetBlobConvolutionPreparedFilterSize returns 0
+void CCudaMathEngine::PrepareBlobConvolutionFilter( const CConvolutionDesc&, const CConstFloatHandle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::BlobConvolutionWithPreparedFilter( const CConvolutionDesc&, const CConstFloatHandle&,
+	const CConstFloatHandle&, const CConstFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CFloatHandle&, float,
+	const CIntHandle&, const CFloatHandle&, const CFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
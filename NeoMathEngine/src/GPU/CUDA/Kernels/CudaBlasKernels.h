@@ -1250,4 +1250,87 @@ __global__ void MatrixColumnsEltwiseDivideKernel( const float* __restrict__ matr
 	}
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Fused optimizer steps
+
+// The gradient with the regularization added
+inline __device__ float fusedSolverDiff( float diff, float param, float l1, float l2 )
+{
+	return diff + l2 * param + fminf( fmaxf( param, -l1 ), l1 );
+}
+
+const int FusedSgdStepCombineCount = 8;
+__global__ void FusedSgdStepKernel( float* param, const float* __restrict__ diff, float* moment, int count,
+	float rate, float l1, float l2, float momentDecayRate )
+{
+	int index;
+	int step;
+	const int actionCount = GetCudaTaskCountAndIndex( count, FusedSgdStepCombineCount, index, step );
+
+	param += index;
+	diff += index;
+	moment += index;
+	for( int i = 0; i < actionCount; ++i ) {
+		const float value = *param;
+		const float m = momentDecayRate * *moment - rate * fusedSolverDiff( *diff, value, l1, l2 );
+		*moment = m;
+		*param = value + m;
+		param += step;
+		diff += step;
+		moment += step;
+	}
+}
+
+// secondMomentMax is null if AMSGrad is off
+const int FusedAdamStepCombineCount = 8;
+__global__ void FusedAdamStepKernel( float* param, const float* __restrict__ diff, float* moment, float* secondMoment,
+	float* secondMomentMax, int count, float rate, float l1, float l2, float weightDecay, float momentDecayRate,
+	float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult )
+{
+	int index;
+	int step;
+	const int actionCount = GetCudaTaskCountAndIndex( count, FusedAdamStepCombineCount, index, step );
+
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+	for( int j = 0; j < actionCount; ++j ) {
+		const int i = index + j * step;
+		const float value = param[i];
+		const float grad = fusedSolverDiff( diff[i], value, l1, l2 );
+		const float m = momentDecayRate * moment[i] + opMomentDecayRate * grad;
+		float v = secondMomentDecayRate * secondMoment[i] + opSecondMomentDecayRate * grad * grad;
+		moment[i] = m;
+		secondMoment[i] = v;
+		if( secondMomentMax != 0 ) {
+			v = fmaxf( secondMomentMax[i], v );
+			secondMomentMax[i] = v;
+		}
+		const float update = ( nesterovDiffMult * grad + nesterovMomentMult * m ) / ( sqrtf( secondMomentMult * v ) + epsilon );
+		param[i] = value - rate * update - weightDecay * value;
+	}
+}
+
+// Updates the moments and calculates the LAMB update before the trust ratio is applied
+const int FusedLambMomentsCombineCount = 8;
+__global__ void FusedLambMomentsKernel( const float* __restrict__ param, const float* __restrict__ diff, float* moment,
+	float* secondMoment, float* update, int count, float weightDecay, float momentDecayRate, float secondMomentDecayRate,
+	float epsilon, float diffMult )
+{
+	int index;
+	int step;
+	const int actionCount = GetCudaTaskCountAndIndex( count, FusedLambMomentsCombineCount, index, step );
+
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+	for( int j = 0; j < actionCount; ++j ) {
+		const int i = index + j * step;
+		const float grad = diffMult * diff[i];
+		const float m = momentDecayRate * moment[i] + opMomentDecayRate * grad;
+		const float v = secondMomentDecayRate * secondMoment[i] + opSecondMomentDecayRate * grad * grad;
+		moment[i] = m;
+		secondMoment[i] = v;
+		update[i] = m / ( sqrtf( v ) + epsilon ) + weightDecay * param[i];
+	}
+}
+
 } // namespace NeoML
@@ -144,6 +144,12 @@ size_t CMetalMathEngine::GetMemoryInPools() const
 	return memoryPool->GetMemoryInPools();
 }
 
+void CMetalMathEngine::GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const
+{
+	std::lock_guard<std::mutex> lock( *mutex );
+	memoryPool->GetStatistics( statistics );
+}
+
 void CMetalMathEngine::CleanUp()
 {
 	std::lock_guard<CMutex> lock( *mutex );
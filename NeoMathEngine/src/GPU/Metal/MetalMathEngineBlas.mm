@@ -696,6 +696,12 @@ void CMetalMathEngine::MultiplyMatrixByTransposedMatrix(int batchSize, const CCo
     kernel.Run();
 }
 
+void CMetalMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle&, int, int, float,
+	const CConstIntHandle&, const CConstFloatHandle&, int, const CConstFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 // result = first * T(second). The result size is firstHeight * secondHeight:
 void CMetalMathEngine::MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
 	const CSparseMatrixDesc& firstDesc, const CConstFloatHandle& secondHandle, const CFloatHandle& resultHandle )
@@ -1314,6 +1320,21 @@ void CMetalMathEngine::SumMatrixRows( int batchSize, const CFloatHandle& resultH
 	SumMatrixRowsAdd(batchSize, resultHandle, matrixHandle, matrixHeight, matrixWidth);
 }
 
+void CMetalMathEngine::FusedSgdStep( const CFusedSolverTensor*, int, float )
+{
+	ASSERT_EXPR( false );
+}
+
+void CMetalMathEngine::FusedAdamStep( const CFusedSolverTensor*, int, float, float, float, float, float, float )
+{
+	ASSERT_EXPR( false );
+}
+
+void CMetalMathEngine::FusedLambStep( const CFusedSolverTensor*, int, float, float, float, float, bool, float, float* )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_METAL
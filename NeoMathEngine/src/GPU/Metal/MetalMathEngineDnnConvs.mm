@@ -192,6 +192,24 @@ void CMetalMathEngine::BlobConvolutionLearnAdd( const CConvolutionDesc&, const C
 	ASSERT_EXPR( false );
 }
 
+// The filter is never prepared: GetBlobConvolutionPreparedFilterSize returns 0
+void CMetalMathEngine::PrepareBlobConvolutionFilter( const CConvolutionDesc&, const CConstFloatHandle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CMetalMathEngine::BlobConvolutionWithPreparedFilter( const CConvolutionDesc&, const CConstFloatHandle&,
+	const CConstFloatHandle&, const CConstFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CMetalMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CFloatHandle&, float,
+	const CIntHandle&, const CFloatHandle&, const CFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------------
 // 3D convolution
 
@@ -150,6 +150,12 @@ size_t CVulkanMathEngine::GetMemoryInPools() const
 	return memoryPool->GetMemoryInPools();
 }
 
+void CVulkanMathEngine::GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	memoryPool->GetStatistics( statistics );
+}
+
 void CVulkanMathEngine::CleanUp()
 {
 	std::lock_guard<std::mutex> lock( mutex );
@@ -65,6 +65,7 @@ public:
 	size_t GetFreeMemorySize() const override;
 	size_t GetPeakMemoryUsage() const override;
 	size_t GetMemoryInPools() const override;
+	void GetMemoryPoolStatistics( CMemoryPoolStatistics& statistics ) const override;
 	void CleanUp() override;
 	void* GetBuffer( const CMemoryHandle& handle, size_t pos, size_t size, bool exchange ) override;
 	void ReleaseBuffer( const CMemoryHandle& handle, void* ptr, bool exchange ) override;
@@ -330,6 +331,9 @@ public:
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
 	void MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight, int firstWidth,
 		const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize) override;
+	void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight, int width,
+		float firstScale, const CConstIntHandle& secondHandle, const CConstFloatHandle& secondScalesHandle, int secondHeight,
+		const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle ) override;
 	void MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
 		const CSparseMatrixDesc& firstDesc, const CConstFloatHandle& secondHandle, const CFloatHandle& resultHandle ) override;
 	void MultiplyTransposedMatrixBySparseMatrixAndAdd( int firstHeight, int firstWidth, int secondWidth,
@@ -366,6 +370,12 @@ public:
 	void MatrixSpreadRows(const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue) override;
+	void FusedSgdStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate ) override;
+	void FusedAdamStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float secondMomentMult, float nesterovDiffMult, float nesterovMomentMult ) override;
+	void FusedLambStep( const CFusedSolverTensor* tensors, int tensorCount, float momentDecayRate,
+		float secondMomentDecayRate, float epsilon, float diffMult, bool useTrustRatio, float weightNormClip,
+		float* diffSquaredNorms ) override;
 
 	// IDnnEngine interface methods
 	void BlobMergeByDim(TBlobDim dim, const CBlobDesc* from, const CFloatHandle* fromData, int fromCount,
@@ -410,6 +420,13 @@ public:
 	void BlobConvolutionLearnAdd( const CConvolutionDesc& desc,
 		const CFloatHandle& input, const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) override;
+	int GetBlobConvolutionPreparedFilterSize( const CConvolutionDesc& ) const override { return 0; }
+	void PrepareBlobConvolutionFilter( const CConvolutionDesc& desc, const CConstFloatHandle& filter,
+		const CFloatHandle& preparedFilter ) override;
+	void BlobConvolutionWithPreparedFilter( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		const CConstFloatHandle& preparedFilter, const CConstFloatHandle* freeTerm, const CFloatHandle& result ) override;
+	void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CFloatHandle& source, float sourceScale,
+		const CIntHandle& filter, const CFloatHandle& filterScales, const CFloatHandle* freeTerm, const CFloatHandle& result ) override;
 	CChannelwiseConvolutionDesc* InitBlobChannelwiseConvolution( const CBlobDesc& input,
 		int paddingHeight, int paddingWidth, int strideHeight, int strideWidth,
 		const CBlobDesc& filter, const CBlobDesc* freeTerm, const CBlobDesc& output ) override;
@@ -521,6 +538,17 @@ public:
 	void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) override;
+	void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& wx, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& h, const CFloatHandle& c ) override;
+	void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& gateWx, const CConstFloatHandle& mainWx,
+		const CConstFloatHandle& gateRecurWeights, const CConstFloatHandle& mainRecurWeights, int recurWeightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& h ) override;
+	void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+		float scale, const CConstFloatHandle& q, const CConstFloatHandle& k, const CConstFloatHandle& v,
+		const CConstFloatHandle& mask, const CFloatHandle& result ) override;
 	IPerformanceCounters* CreatePerformanceCounters() const override { 	return new CPerformanceCountersDefault(); }
 
 protected:
@@ -158,6 +158,12 @@ void CVulkanMathEngine::MultiplyMatrixByTransposedMatrix(int batchSize, const CC
 	}
 }
 
+void CVulkanMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle&, int, int, float,
+	const CConstIntHandle&, const CConstFloatHandle&, int, const CConstFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 void CVulkanMathEngine::MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
 	const CSparseMatrixDesc& firstDesc, const CConstFloatHandle& secondHandle, const CFloatHandle& resultHandle )
 {
@@ -1152,6 +1158,21 @@ void CVulkanMathEngine::MultiplyVectorByTransposedLookupVectorAndAddToTable( int
 	ASSERT_EXPR( false );
 }
 
+void CVulkanMathEngine::FusedSgdStep( const CFusedSolverTensor*, int, float )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::FusedAdamStep( const CFusedSolverTensor*, int, float, float, float, float, float, float )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::FusedLambStep( const CFusedSolverTensor*, int, float, float, float, float, bool, float, float* )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_VULKAN
@@ -585,6 +585,29 @@ void CVulkanMathEngine::IndRnnRecurrentLearn( bool /*reverse*/, int /*sequenceLe
 	ASSERT_EXPR( false );
 }
 
+void CVulkanMathEngine::LstmRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*wx*/, const CConstFloatHandle& /*recurWeights*/,
+	const CConstFloatHandle& /*initialOutput*/, const CConstFloatHandle& /*initialState*/,
+	const CFloatHandle& /*h*/, const CFloatHandle& /*c*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::GruRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*gateWx*/, const CConstFloatHandle& /*mainWx*/,
+	const CConstFloatHandle& /*gateRecurWeights*/, const CConstFloatHandle& /*mainRecurWeights*/, int /*recurWeightsRowSize*/,
+	const CConstFloatHandle& /*initialOutput*/, const CFloatHandle& /*h*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::ScaledDotProductAttention( int /*batchSize*/, int /*headCount*/, int /*queryLength*/, int /*keyLength*/,
+	int /*headSize*/, float /*scale*/, const CConstFloatHandle& /*q*/, const CConstFloatHandle& /*k*/,
+	const CConstFloatHandle& /*v*/, const CConstFloatHandle& /*mask*/, const CFloatHandle& /*result*/ )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_VULKAN
@@ -489,6 +489,24 @@ void CVulkanMathEngine::BlobConvolutionLearnAdd( const CConvolutionDesc&, const
 	ASSERT_EXPR( false );
 }
 
+// The filter is never prepared: GetBlobConvolutionPreparedFilterSize returns 0
+void CVulkanMathEngine::PrepareBlobConvolutionFilter( const CConvolutionDesc&, const CConstFloatHandle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::BlobConvolutionWithPreparedFilter( const CConvolutionDesc&, const CConstFloatHandle&,
+	const CConstFloatHandle&, const CConstFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CFloatHandle&, float,
+	const CIntHandle&, const CFloatHandle&, const CFloatHandle*, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 // Implements convolution 1x1 with stride 1
 void CVulkanMathEngine::blobConvolution1x1s1Common( const CCommonConvolutionDesc& desc,
 	const CFloatHandle& sourceData, const CFloatHandle& filterData, const CFloatHandle* freeTermData,
@@ -19,6 +19,7 @@ limitations under the License.
 #include <NeoMathEngine/CrtAllocatedObject.h>
 #include <MathEngineDeviceStackAllocator.h>
 #include <RawMemoryManager.h>
+#include <atomic>
 
 namespace NeoML {
 
@@ -172,9 +173,16 @@ private:
 
 //------------------------------------------------------------------------------------------------------------
 
+// The numbers of the allocators, to tell the allocators apart even if one is created at the address of another
+static std::atomic<unsigned long long> nextStackAllocatorId( 1 );
+// The allocator used last on this thread and the stack of this thread in it
+static thread_local unsigned long long lastStackAllocatorId = 0;
+static thread_local CDeviceStackMemoryManager* lastStackManager = nullptr;
+
 CDeviceStackAllocator::CDeviceStackAllocator( CMemoryPool& _memoryPool, int _memoryAlignment ) :
 	memoryPool( _memoryPool ),
-	memoryAlignment( _memoryAlignment )
+	memoryAlignment( _memoryAlignment ),
+	id( nextStackAllocatorId++ )
 {
 }
 
@@ -187,11 +195,9 @@ CDeviceStackAllocator::~CDeviceStackAllocator()
 
 void CDeviceStackAllocator::CleanUp()
 {
-	thread::id id = this_thread::get_id();
-
-	auto iterator = stackManagers.find( id );
-	if( iterator != stackManagers.end() ) {
-		iterator->second->CleanUp();
+	CDeviceStackMemoryManager* deviceManager = findStackManager( false );
+	if( deviceManager != 0 ) {
+		deviceManager->CleanUp();
 	}
 }
 
@@ -199,18 +205,7 @@ CMemoryHandle CDeviceStackAllocator::Alloc( size_t size )
 {
 	// Align size to keep correct data alignment
 	size = ( ( size + memoryAlignment - 1 ) / memoryAlignment ) * memoryAlignment;
-	CDeviceStackMemoryManager* deviceManager = 0;
-	thread::id id = this_thread::get_id();
-
-	{
-		auto result = stackManagers.find( id );
-		if( result == stackManagers.end() ) {
-			result = stackManagers.insert( make_pair( id,  new CDeviceStackMemoryManager( memoryPool ) ) ).first;
-		}
-		deviceManager = result->second;
-	}
-
-	return deviceManager->Alloc(size);
+	return findStackManager( true )->Alloc(size);
 }
 
 void CDeviceStackAllocator::Free( const CMemoryHandle& ptr )
@@ -219,14 +214,33 @@ void CDeviceStackAllocator::Free( const CMemoryHandle& ptr )
 		return;
 	}
 
-	CDeviceStackMemoryManager* deviceManager = 0;
-	thread::id id = this_thread::get_id();
+	findStackManager( false )->Free(ptr);
+}
+
+// Finds the stack of the current thread
+CDeviceStackMemoryManager* CDeviceStackAllocator::findStackManager( bool create )
+{
+	if( lastStackAllocatorId == id ) {
+		return lastStackManager;
+	}
 
+	thread::id threadId = this_thread::get_id();
+	CDeviceStackMemoryManager* deviceManager = 0;
 	{
-		deviceManager = stackManagers.find( id )->second;
+		std::lock_guard<std::mutex> lock( mutex );
+		auto result = stackManagers.find( threadId );
+		if( result == stackManagers.end() ) {
+			if( !create ) {
+				return 0;
+			}
+			result = stackManagers.insert( make_pair( threadId, new CDeviceStackMemoryManager( memoryPool ) ) ).first;
+		}
+		deviceManager = result->second;
 	}
 
-	deviceManager->Free(ptr);
+	lastStackAllocatorId = id;
+	lastStackManager = deviceManager;
+	return deviceManager;
 }
 
 } // namespace NeoML
@@ -30,6 +30,7 @@ namespace NeoML {
 class CDeviceStackMemoryManager;
 
 // Device memory stack implementation for MathEngine
+// Each thread has its own stack; may be used from several threads at once without external synchronization
 class CDeviceStackAllocator : public CCrtAllocatedObject {
 public:
 	CDeviceStackAllocator( CMemoryPool& memoryPool, int memoryAlignment );
@@ -43,8 +44,13 @@ public:
 private:
 	CMemoryPool& memoryPool;
 	const int memoryAlignment;
+	// The unique number of the allocator, used to find the stack of the current thread without locking
+	const unsigned long long id;
+	std::mutex mutex; // protects the map, not the stacks
 	std::unordered_map< thread::id, CDeviceStackMemoryManager*,
 		hash<thread::id>, equal_to<thread::id>, CrtAllocator< pair<const thread::id, CDeviceStackMemoryManager*> > > stackManagers;
+
+	CDeviceStackMemoryManager* findStackManager( bool create );
 };
 
 } // namespace NeoML
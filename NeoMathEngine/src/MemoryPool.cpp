@@ -40,35 +40,55 @@ private:
 //------------------------------------------------------------------------------------------------------------
 
 // A pool of buffers of the same size
+// Only the owner thread allocates from the pool; any thread may free a buffer into it
 class CMemoryBufferPool : public CCrtAllocatedObject {
 public:
 	const size_t BufferSize;
+	const std::thread::id OwnerId;
 
-	explicit CMemoryBufferPool( size_t bufferSize ) : BufferSize(bufferSize), head(0), memoryInPool(0) {}
+	CMemoryBufferPool( size_t bufferSize, std::thread::id ownerId ) :
+		BufferSize( bufferSize ), OwnerId( ownerId ), head( 0 ), remoteHead( 0 ), memoryInPool( 0 ) {}
 
 	// Allocates a buffer; returns 0 if no free buffers are available
+	// May be called only on the owner thread
 	CMemoryBuffer* TryAlloc();
 
-	// Releases a buffer
+	// Releases a buffer on the owner thread
 	void Free( CMemoryBuffer* data );
+	// Releases a buffer on any other thread
+	void FreeRemote( CMemoryBuffer* data );
 
 	// Gets the amount of memory used for the pool
+	// The buffers freed on the other threads are not counted until the owner thread needs them
 	size_t GetMemoryInPool() const { return memoryInPool; }
 
 private:
 	// Currently free buffers (a singly-linked list)
 	CMemoryBuffer* head;
-	size_t memoryInPool; // the amount of memory used for the pool
+	// The buffers freed on the other threads (a lock-free singly-linked list)
+	// The other threads only add to it, the owner takes the whole list at once, so there is no ABA problem
+	std::atomic<CMemoryBuffer*> remoteHead;
+	std::atomic<size_t> memoryInPool; // the amount of memory used for the pool
 };
 
 CMemoryBuffer* CMemoryBufferPool::TryAlloc()
 {
+	if( head == 0 && remoteHead.load( std::memory_order_relaxed ) != 0 ) {
+		// Take the buffers freed on the other threads
+		head = remoteHead.exchange( 0, std::memory_order_acquire );
+		size_t remoteMemory = 0;
+		for( CMemoryBuffer* buffer = head; buffer != 0; buffer = buffer->GetNext() ) {
+			remoteMemory += BufferSize;
+		}
+		memoryInPool.store( memoryInPool.load( std::memory_order_relaxed ) + remoteMemory, std::memory_order_relaxed );
+	}
+
 	CMemoryBuffer* result = head;
 
 	if( result != 0 ) {
 		head = result->GetNext();
 		result->SetNext(0);
-		memoryInPool -= BufferSize;
+		memoryInPool.store( memoryInPool.load( std::memory_order_relaxed ) - BufferSize, std::memory_order_relaxed );
 	}
 
 	return result;
@@ -78,7 +98,15 @@ void CMemoryBufferPool::Free(CMemoryBuffer* data)
 {
 	data->SetNext( head );
 	head = data;
-	memoryInPool += BufferSize;
+	memoryInPool.store( memoryInPool.load( std::memory_order_relaxed ) + BufferSize, std::memory_order_relaxed );
+}
+
+void CMemoryBufferPool::FreeRemote( CMemoryBuffer* data )
+{
+	CMemoryBuffer* oldHead = remoteHead.load( std::memory_order_relaxed );
+	do {
+		data->SetNext( oldHead );
+	} while( !remoteHead.compare_exchange_weak( oldHead, data, std::memory_order_release, std::memory_order_relaxed ) );
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -95,111 +123,190 @@ static const unsigned int BufferSizes[] = {
 template <typename T, int size>
 inline constexpr int lengthof( T(&)[size] ) { return size; }
 
+// Increments the counter that is changed only by one thread
+static inline void addToCounter( std::atomic<size_t>& counter, size_t value )
+{
+	counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+// The numbers of the pools, to tell the pools apart even if one is created at the address of another
+static std::atomic<unsigned long long> nextMemoryPoolId( 1 );
+// The pool used last on this thread and the data of this thread in it
+static thread_local unsigned long long lastMemoryPoolId = 0;
+static thread_local void* lastThreadData = nullptr;
+
 CMemoryPool::CMemoryPool( size_t _memoryLimit, IRawMemoryManager* _rawMemoryManager, bool reuseMemoryMode ) :
 	memoryLimit( _memoryLimit ),
 	rawMemoryManager( _rawMemoryManager ),
 	defaultReuseMemoryMode( reuseMemoryMode ),
+	id( nextMemoryPoolId++ ),
 	allocatedMemory( 0 ),
-	freeMemorySize( _memoryLimit ),
-	peakMemoryUsage( 0 )
+	peakMemoryUsage( 0 ),
+	deviceAllocCount( 0 )
 {
 }
 
 CMemoryPool::~CMemoryPool()
 {
-	for( auto curPool : pools ) {
-		cleanUp( curPool.first );
-		for( auto curMemBufferPool : curPool.second.Pool ) {
+	for( auto curThreadData : threadData ) {
+		cleanUp( *curThreadData.second );
+		for( auto curMemBufferPool : curThreadData.second->Pool ) {
 			delete curMemBufferPool;
 		}
+		delete curThreadData.second;
 	}
 }
 
 void CMemoryPool::SetReuseMemoryMode( bool enable )
 {
-	thread::id id = this_thread::get_id();
-	auto pool = pools.find( id );
-	if( pool == pools.end() ) {
-		createPools( id );
-		pool = pools.find( id );
-	}
-
-	pool->second.Enabled = enable;
+	getThreadData().Enabled = enable;
 }
 
 CMemoryHandle CMemoryPool::Alloc( size_t size )
 {
-	thread::id id = this_thread::get_id();
-	auto pool = pools.find( id );
-	if( pool == pools.end() ) {
-		createPools( id );
-		pool = pools.find( id );
+	CThreadData& data = getThreadData();
+
+	CMemoryHandle result = tryAlloc( size, data );
+	if( result.IsNull() ) {
+		// Not enough memory. Try to free all allocated pools
+		cleanUp( data );
+		result = tryAlloc( size, data );
 	}
 
-	CMemoryHandle result = tryAlloc( size, pool->second );
 	if( !result.IsNull() ) {
-		return result;
+		addToCounter( data.AllocCount, 1 );
 	}
-
-	// Not enough memory. Try to free all allocated pools
-	CleanUp();
-	return tryAlloc( size, pool->second );
+	return result;
 }
 
 void CMemoryPool::Free( const CMemoryHandle& handle )
 {
-	TUsedAddressMap::const_iterator pos = usedMap.find( GetRaw(handle) );
-	const CUsedInfo& info = pos->second;
+	CUsedInfo info;
+	{
+		CUsedAddressShard& shard = getShard( GetRaw( handle ) );
+		std::lock_guard<std::mutex> lock( shard.Mutex );
+		TUsedAddressMap::iterator pos = shard.UsedMap.find( GetRaw( handle ) );
+		info = pos->second;
+		shard.UsedMap.erase( pos );
+	}
+
+	CThreadData& data = getThreadData();
 	if( info.pool != 0 ) {
-		info.pool->Free(info.buffer);
-		freeMemorySize += info.pool->BufferSize;
+		if( info.pool->OwnerId == std::this_thread::get_id() ) {
+			info.pool->Free( info.buffer );
+		} else {
+			info.pool->FreeRemote( info.buffer );
+			addToCounter( data.CrossThreadFreeCount, 1 );
+		}
+		addToCounter( data.UsedMemory, 0 - info.pool->BufferSize );
 	} else {
 		// Large buffer, don't use the pool
-		freeMemory(info.size, handle);
-		freeMemorySize += info.size;
+		freeMemory( info.size, handle );
+		addToCounter( data.UsedMemory, 0 - info.size );
+	}
+	addToCounter( data.FreeCount, 1 );
+}
+
+size_t CMemoryPool::GetFreeMemorySize() const
+{
+	size_t usedMemory = 0;
+	std::lock_guard<std::mutex> lock( threadDataMutex );
+	for( auto curThreadData : threadData ) {
+		usedMemory += curThreadData.second->UsedMemory.load( std::memory_order_relaxed );
 	}
-	usedMap.erase( pos );
+	return memoryLimit - usedMemory;
 }
 
 size_t CMemoryPool::GetMemoryInPools() const
 {
-	thread::id id = this_thread::get_id();
-	auto pool = pools.find( id );
-	if( pool == pools.end() ) {
+	const CThreadData* data = findThreadData();
+	if( data == nullptr ) {
 		return 0;
 	}
-	const TPoolVector& threadPools = pool->second.Pool;
 	size_t res = 0;
-	for( auto cur : threadPools ) {
+	for( auto cur : data->Pool ) {
 		res += cur->GetMemoryInPool();
 	}
 	return res;
 }
 
+void CMemoryPool::GetStatistics( CMemoryPoolStatistics& statistics ) const
+{
+	statistics = CMemoryPoolStatistics();
+	statistics.DeviceAllocCount = deviceAllocCount.load( std::memory_order_relaxed );
+
+	std::lock_guard<std::mutex> lock( threadDataMutex );
+	statistics.ThreadCount = threadData.size();
+	for( auto curThreadData : threadData ) {
+		const CThreadData& data = *curThreadData.second;
+		statistics.AllocCount += data.AllocCount.load( std::memory_order_relaxed );
+		statistics.FreeCount += data.FreeCount.load( std::memory_order_relaxed );
+		statistics.PoolHitCount += data.PoolHitCount.load( std::memory_order_relaxed );
+		statistics.CrossThreadFreeCount += data.CrossThreadFreeCount.load( std::memory_order_relaxed );
+		for( auto cur : data.Pool ) {
+			statistics.MemoryInPools += cur->GetMemoryInPool();
+		}
+	}
+}
+
 void CMemoryPool::CleanUp()
 {
-	cleanUp( this_thread::get_id() );
+	const CThreadData* data = findThreadData();
+	if( data != nullptr ) {
+		cleanUp( const_cast<CThreadData&>( *data ) );
+	}
 }
 
-void CMemoryPool::createPools( thread::id id )
+// Gets the data of the current thread, creates it if necessary
+CMemoryPool::CThreadData& CMemoryPool::getThreadData()
 {
-	CThreadData threadData;
-	threadData.Enabled = defaultReuseMemoryMode;
-	for( size_t i = 0; i < sizeof( BufferSizes ) / sizeof( *BufferSizes ); ++i ) {
-		threadData.Pool.push_back( new CMemoryBufferPool( BufferSizes[i] ) );
+	if( lastMemoryPoolId == id ) {
+		return *static_cast<CThreadData*>( lastThreadData );
+	}
+
+	const std::thread::id threadId = std::this_thread::get_id();
+	CThreadData* data = nullptr;
+	{
+		std::lock_guard<std::mutex> lock( threadDataMutex );
+		auto pos = threadData.find( threadId );
+		if( pos == threadData.end() ) {
+			data = createThreadData( threadId );
+			threadData[threadId] = data;
+		} else {
+			data = pos->second;
+		}
+	}
+
+	lastMemoryPoolId = id;
+	lastThreadData = data;
+	return *data;
+}
+
+// Finds the data of the current thread; returns null if the thread has not used the pool yet
+const CMemoryPool::CThreadData* CMemoryPool::findThreadData() const
+{
+	if( lastMemoryPoolId == id ) {
+		return static_cast<const CThreadData*>( lastThreadData );
 	}
 
-	pools[id] = threadData;
+	std::lock_guard<std::mutex> lock( threadDataMutex );
+	auto pos = threadData.find( std::this_thread::get_id() );
+	return pos == threadData.end() ? nullptr : pos->second;
 }
 
-void CMemoryPool::cleanUp( thread::id id )
+CMemoryPool::CThreadData* CMemoryPool::createThreadData( std::thread::id threadId )
 {
-	auto pool = pools.find( id );
-	if( pool == pools.end() ) {
-		return;
+	CThreadData* data = new CThreadData();
+	data->Enabled = defaultReuseMemoryMode;
+	for( size_t i = 0; i < sizeof( BufferSizes ) / sizeof( *BufferSizes ); ++i ) {
+		data->Pool.push_back( new CMemoryBufferPool( BufferSizes[i], threadId ) );
 	}
+	return data;
+}
 
-	for( auto cur : pool->second.Pool ) {
+void CMemoryPool::cleanUp( CThreadData& data )
+{
+	for( auto cur : data.Pool ) {
 		CMemoryBuffer* buffer = cur->TryAlloc();
 		while( buffer != 0 ) {
 			freeMemory(cur->BufferSize, buffer->Data);
@@ -209,6 +316,20 @@ void CMemoryPool::cleanUp( thread::id id )
 	}
 }
 
+CMemoryPool::CUsedAddressShard& CMemoryPool::getShard( const void* address )
+{
+	// The blocks are aligned, so the lowest bits are useless
+	const size_t value = reinterpret_cast<size_t>( address );
+	return usedShards[( ( value >> 6 ) ^ ( value >> 16 ) ) % UsedAddressShardCount];
+}
+
+void CMemoryPool::registerUsed( const CMemoryHandle& handle, const CUsedInfo& info )
+{
+	CUsedAddressShard& shard = getShard( GetRaw( handle ) );
+	std::lock_guard<std::mutex> lock( shard.Mutex );
+	shard.UsedMap[GetRaw( handle )] = info;
+}
+
 inline static bool poolsCompare( const CMemoryBufferPool* a, const size_t& b )
 {
 	return a->BufferSize < b;
@@ -221,8 +342,8 @@ CMemoryHandle CMemoryPool::tryAlloc( size_t size, CThreadData& data )
 		// Allocate without using the buffers pool
 		CMemoryHandle result = alloc( size );
 		if( !result.IsNull() ) {
-			usedMap[GetRaw( result )] = CUsedInfo( size, 0, 0 );
-			freeMemorySize -= size;
+			registerUsed( result, CUsedInfo( size, 0, 0 ) );
+			addToCounter( data.UsedMemory, size );
 		}
 		return result;
 	}
@@ -239,25 +360,38 @@ CMemoryHandle CMemoryPool::tryAlloc( size_t size, CThreadData& data )
 			delete buffer;
 			return CMemoryHandle();
 		}
+	} else {
+		addToCounter( data.PoolHitCount, 1 );
 	}
-	freeMemorySize -= pool->BufferSize;
-	usedMap[GetRaw(buffer->Data)] = CUsedInfo(size, buffer, pool);
+	registerUsed( buffer->Data, CUsedInfo( size, buffer, pool ) );
+	addToCounter( data.UsedMemory, pool->BufferSize );
 
 	return buffer->Data;
 }
 
 CMemoryHandle CMemoryPool::alloc( size_t size )
 {
-	if( size > memoryLimit || allocatedMemory > memoryLimit - size ) {
-		return CMemoryHandle();
-	}
-	
+	// Reserve the memory within the limit first, so that the concurrent allocations could not exceed it
+	size_t reserved = allocatedMemory.load( std::memory_order_relaxed );
+	do {
+		if( size > memoryLimit || reserved > memoryLimit - size ) {
+			return CMemoryHandle();
+		}
+	} while( !allocatedMemory.compare_exchange_weak( reserved, reserved + size, std::memory_order_relaxed ) );
+
 	CMemoryHandle result = rawMemoryManager->Alloc( size );
 
-	if( !result.IsNull() ) {
-		allocatedMemory += size;
+	if( result.IsNull() ) {
+		allocatedMemory -= size;
+		return result;
+	}
+	deviceAllocCount.fetch_add( 1, std::memory_order_relaxed );
+
+	size_t peak = peakMemoryUsage.load( std::memory_order_relaxed );
+	while( peak < reserved + size
+		&& !peakMemoryUsage.compare_exchange_weak( peak, reserved + size, std::memory_order_relaxed ) )
+	{
 	}
-	peakMemoryUsage = max( peakMemoryUsage, allocatedMemory );
 
 	return result;
 }
@@ -16,9 +16,12 @@ limitations under the License.
 #pragma once
 
 #include <MathEngineAllocator.h>
+#include <NeoMathEngine/NeoMathEngine.h>
 #include <NeoMathEngine/MemoryHandle.h>
 #include <NeoMathEngine/CrtAllocatedObject.h>
 #include <RawMemoryManager.h>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 #include <thread>
 
@@ -28,6 +31,12 @@ class CMemoryBufferPool;
 class CMemoryBuffer;
 
 // The memory manager
+// May be used from several threads at once without external synchronization:
+//  - each thread has its own pools of free buffers and its own counters, so allocating and freeing
+//    on the same thread does not touch the data of the other threads;
+//  - a buffer freed on another thread is returned to the pool of its owner through a lock-free list;
+//  - the allocated blocks are registered in a table split into independently locked parts
+// As the buffers stay with the thread that allocated them, they are reused on the same NUMA node
 class CMemoryPool : public CCrtAllocatedObject {
 public:
 	CMemoryPool( size_t memoryLimit, IRawMemoryManager* rawMemoryManager, bool reuseMemoryMode );
@@ -43,34 +52,52 @@ public:
 	void Free( const CMemoryHandle& handle );
 
 	// Gets the amount of memory currently available
-	size_t GetFreeMemorySize() const { return freeMemorySize; }
+	size_t GetFreeMemorySize() const;
 
 	// Gets the peak memory usage achieved during processing
 	size_t GetPeakMemoryUsage() const { return peakMemoryUsage; }
 
-	// Gets the amount of memory used for the pools
+	// Gets the amount of memory used for the pools of the current thread
 	size_t GetMemoryInPools() const;
 
+	// Gets the statistics collected over all threads
+	void GetStatistics( CMemoryPoolStatistics& statistics ) const;
+
 	// Frees all memory on the current thread
 	void CleanUp();
 
 private:
 	typedef std::vector< CMemoryBufferPool*, CrtAllocator<CMemoryBufferPool*> > TPoolVector;
-	struct CThreadData {
+	// The data of one thread
+	// The counters are changed only by this thread and may be read by any other
+	struct CThreadData : public CCrtAllocatedObject {
 		TPoolVector Pool;
 		bool Enabled;
+		// The memory given to the user by this thread minus the memory freed by it
+		// May "overflow" if the thread frees the memory allocated on the other threads, the total is always correct
+		std::atomic<size_t> UsedMemory;
+		std::atomic<size_t> AllocCount;
+		std::atomic<size_t> FreeCount;
+		std::atomic<size_t> PoolHitCount;
+		std::atomic<size_t> CrossThreadFreeCount;
+
+		CThreadData() : Enabled( false ), UsedMemory( 0 ), AllocCount( 0 ), FreeCount( 0 ),
+			PoolHitCount( 0 ), CrossThreadFreeCount( 0 ) {}
 	};
-	typedef std::unordered_map< std::thread::id, CThreadData, std::hash<std::thread::id>, std::equal_to<std::thread::id>,
-		CrtAllocator< std::pair<const std::thread::id, CThreadData> > > TPoolMap;
+	typedef std::unordered_map< std::thread::id, CThreadData*, std::hash<std::thread::id>, std::equal_to<std::thread::id>,
+		CrtAllocator< std::pair<const std::thread::id, CThreadData*> > > TThreadDataMap;
 
 	const size_t memoryLimit;
 	IRawMemoryManager* const rawMemoryManager;
 	const bool defaultReuseMemoryMode;
+	// The unique number of the pool, used to find the data of the current thread without locking
+	const unsigned long long id;
 
-	TPoolMap pools;
-	size_t allocatedMemory; // the amount of memory allocated on device (belonging to the user + used for the pools)
-	size_t freeMemorySize; // the amount of free avialable memory
-	size_t peakMemoryUsage; // peak memory usage
+	mutable std::mutex threadDataMutex; // protects the map, not the data of the threads
+	TThreadDataMap threadData;
+	std::atomic<size_t> allocatedMemory; // the amount of memory allocated on device (belonging to the user + used for the pools)
+	std::atomic<size_t> peakMemoryUsage; // peak memory usage
+	std::atomic<size_t> deviceAllocCount; // the number of allocations on device
 
 	// The information about a memory block
 	struct CUsedInfo {
@@ -85,10 +112,20 @@ private:
 	};
 	typedef std::unordered_map< void*, CUsedInfo, std::hash<void*>, std::equal_to<void*>,
 		CrtAllocator< std::pair<void* const, CUsedInfo> > > TUsedAddressMap;
-	TUsedAddressMap usedMap;
-
-	void createPools( std::thread::id id );
-	void cleanUp( std::thread::id id );
+	// A part of the table of the allocated blocks
+	struct CUsedAddressShard {
+		std::mutex Mutex;
+		TUsedAddressMap UsedMap;
+	};
+	static const int UsedAddressShardCount = 64;
+	CUsedAddressShard usedShards[UsedAddressShardCount];
+
+	CThreadData& getThreadData();
+	const CThreadData* findThreadData() const;
+	CThreadData* createThreadData( std::thread::id threadId );
+	void cleanUp( CThreadData& data );
+	CUsedAddressShard& getShard( const void* address );
+	void registerUsed( const CMemoryHandle& handle, const CUsedInfo& info );
 	CMemoryHandle tryAlloc( size_t size, CThreadData& data );
 	CMemoryHandle alloc( size_t size );
 	void freeMemory( size_t size, const CMemoryHandle& data );
@@ -143,8 +143,13 @@ static void blobConvolutionImpl( const CTestParams& params, int seed )
 		paddingHeight, paddingWidth, filterCount, filterHeight, filterWidth,
 		dilationHeight, dilationWidth, strideHeight, strideWidth );
 
+	// The fast algorithms (e.g. Winograd) reorder the summation, so the error is compared with the output range
+	float maxAbsValue = 0;
 	for( int i = 0; i < outputSize; ++i ) {
-		ASSERT_TRUE( FloatEq( expectedData[i], actualData[i] ) );
+		maxAbsValue = std::max( maxAbsValue, std::fabs( expectedData[i] ) );
+	}
+	for( int i = 0; i < outputSize; ++i ) {
+		ASSERT_NEAR( expectedData[i], actualData[i], 1e-5f * maxAbsValue );
 	}
 }
 
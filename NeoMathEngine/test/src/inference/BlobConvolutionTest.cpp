@@ -15,6 +15,8 @@ limitations under the License.
 
 #include <TestFixture.h>
 
+#include <cstdio>
+
 using namespace NeoML;
 using namespace NeoMLTest;
 
@@ -635,6 +637,126 @@ INSTANTIATE_TEST_CASE_P( CMathEngineBlobConvolutionTestInstantiation, CMathEngin
 			"IsZeroFreeTerm = 1;"
 			"Values = (-10..10);"
 			"TestCount = 1;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..2);"
+			"InputHeight = (5..20);"
+			"InputWidth = (5..20);"
+			"InputDepth = 1;"
+			"InputChannels = (1..64);"
+			"FilterCount = (1..40);"
+			"FilterHeight = 3;"
+			"FilterWidth = 3;"
+			"PaddingHeight = (0..2);"
+			"PaddingWidth = (0..2);"
+			"DilationHeight = (1..2);"
+			"DilationWidth = (1..2);"
+			"StrideHeight = (1..2);"
+			"StrideWidth = (1..2);"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 50;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..2);"
+			"InputHeight = (1..15);"
+			"InputWidth = (1..15);"
+			"InputDepth = 1;"
+			"InputChannels = (1..16);"
+			"FilterCount = (1..40);"
+			"FilterHeight = 1;"
+			"FilterWidth = 1;"
+			"PaddingHeight = 0;"
+			"PaddingWidth = 0;"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = (1..2);"
+			"StrideWidth = (1..2);"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 20;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..2);"
+			"InputHeight = (5..20);"
+			"InputWidth = (5..20);"
+			"InputDepth = 1;"
+			"InputChannels = (1..32);"
+			"FilterCount = (1..40);"
+			"FilterHeight = 5;"
+			"FilterWidth = 5;"
+			"PaddingHeight = (0..2);"
+			"PaddingWidth = (0..2);"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = (1..2);"
+			"StrideWidth = (1..2);"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 20;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..2);"
+			"InputHeight = (7..25);"
+			"InputWidth = (7..25);"
+			"InputDepth = 1;"
+			"InputChannels = (1..16);"
+			"FilterCount = (1..40);"
+			"FilterHeight = 7;"
+			"FilterWidth = 7;"
+			"PaddingHeight = (0..3);"
+			"PaddingWidth = (0..3);"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = (1..2);"
+			"StrideWidth = (1..2);"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 20;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = 2;"
+			"InputHeight = 32;"
+			"InputWidth = 32;"
+			"InputDepth = 1;"
+			"InputChannels = 3;"
+			"FilterCount = 13;"
+			"FilterHeight = 7;"
+			"FilterWidth = 7;"
+			"PaddingHeight = 3;"
+			"PaddingWidth = 3;"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = 2;"
+			"StrideWidth = 2;"
+			"IsZeroFreeTerm = 0;"
+			"Values = (-10..10);"
+			"TestCount = 1;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..3);"
+			"InputHeight = (3..17);"
+			"InputWidth = (3..17);"
+			"InputDepth = (1..2);"
+			"InputChannels = (8..24);"
+			"FilterCount = (16..40);"
+			"FilterHeight = 3;"
+			"FilterWidth = 3;"
+			"PaddingHeight = (0..2);"
+			"PaddingWidth = (0..2);"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = 1;"
+			"StrideWidth = 1;"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 30;"
 		)
 	)
 );
@@ -643,3 +765,77 @@ TEST_P( CMathEngineBlobConvolutionTest, Random )
 {
 	RUN_TEST_IMPL( blobConvolutionImpl );
 }
+
+TEST_P( CMathEngineBlobConvolutionTest, Autotuned )
+{
+	const bool wasEnabled = IsCpuConvolutionAutotuneEnabled();
+	SetCpuConvolutionAutotune( true );
+	RUN_TEST_IMPL( blobConvolutionImpl );
+	SetCpuConvolutionAutotune( wasEnabled );
+}
+
+TEST( CMathEngineBlobConvolutionTuningCacheTest, SaveLoad )
+{
+	const char* fileName = "ConvolutionTuningCache.txt";
+	ASSERT_TRUE( SaveCpuConvolutionTuningCache( fileName ) );
+	ASSERT_TRUE( LoadCpuConvolutionTuningCache( fileName ) );
+	std::remove( fileName );
+	ASSERT_FALSE( LoadCpuConvolutionTuningCache( fileName ) );
+}
+
+TEST( CMathEngineBlobConvolutionWinogradTest, FilterChange )
+{
+	// The filter may be used as is or prepared once for the descriptor; both must follow the filter changes
+	const int batch = 2;
+	const int height = 9;
+	const int width = 7;
+	const int channels = 32;
+	const int filterCount = 24;
+
+	CRandom random( 0x1234 );
+	CREATE_FILL_FLOAT_ARRAY( inputData, -1, 1, batch * height * width * channels, random )
+	CFloatBlob inputBlob( MathEngine(), 1, batch, 1, height, width, 1, channels );
+	inputBlob.CopyFrom( inputData.data() );
+
+	CFloatBlob filterBlob( MathEngine(), filterCount, 3, 3, 1, channels );
+	CFloatBlob freeTermBlob( MathEngine(), 1, 1, 1, filterCount );
+	CREATE_FILL_FLOAT_ARRAY( freeTermData, -1, 1, filterCount, random )
+	freeTermBlob.CopyFrom( freeTermData.data() );
+	CFloatBlob outputBlob( MathEngine(), 1, batch, 1, height, width, 1, filterCount );
+
+	CConvolutionDesc* convDesc = MathEngine().InitBlobConvolution( inputBlob.GetDesc(), 1, 1, 1, 1, 1, 1,
+		filterBlob.GetDesc(), outputBlob.GetDesc() );
+	CFloatHandle freeTermDataPtr = freeTermBlob.GetData();
+
+	const int outputSize = batch * height * width * filterCount;
+	std::vector<float> expectedData( outputSize );
+	std::vector<float> actualData( outputSize );
+	for( int run = 0; run < 3; ++run ) {
+		CREATE_FILL_FLOAT_ARRAY( filterData, -1, 1, filterCount * 9 * channels, random )
+		filterBlob.CopyFrom( filterData.data() );
+
+		MathEngine().BlobConvolution( *convDesc, inputBlob.GetData(), filterBlob.GetData(), &freeTermDataPtr,
+			outputBlob.GetData() );
+		outputBlob.CopyTo( actualData.data() );
+
+		batchConvolutionForward( inputData.data(), filterData.data(), freeTermData.data(), expectedData.data(),
+			1, batch, height, width, 1, channels, 1, 1, filterCount, 3, 3, 1, 1, 1, 1 );
+		for( int i = 0; i < outputSize; ++i ) {
+			ASSERT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-3f ) );
+		}
+
+		const int preparedFilterSize = MathEngine().GetBlobConvolutionPreparedFilterSize( *convDesc );
+		if( preparedFilterSize > 0 ) {
+			CFloatBlob preparedFilterBlob( MathEngine(), 1, 1, 1, preparedFilterSize );
+			MathEngine().PrepareBlobConvolutionFilter( *convDesc, filterBlob.GetData(), preparedFilterBlob.GetData() );
+			const CConstFloatHandle freeTermConstPtr = freeTermBlob.GetData();
+			MathEngine().BlobConvolutionWithPreparedFilter( *convDesc, inputBlob.GetData(), preparedFilterBlob.GetData(),
+				&freeTermConstPtr, outputBlob.GetData() );
+			outputBlob.CopyTo( actualData.data() );
+			for( int i = 0; i < outputSize; ++i ) {
+				ASSERT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-3f ) );
+			}
+		}
+	}
+	delete convDesc;
+}
@@ -0,0 +1,161 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static inline float sigmoid( float x )
+{
+	if( x <= 0.f ) {
+		const float e = ::expf( x );
+		return e / ( e + 1.f );
+	} else {
+		return 1.f / ( 1.f + ::expf( -x ) );
+	}
+}
+
+static void gruRecurrentNaive( bool reverse, int seqLength, int batchSize, int hiddenSize,
+	const float* gateWx, const float* mainWx, const float* gateWeights, const float* mainWeights,
+	const float* initialOutput, float* h )
+{
+	const int dataSize = batchSize * hiddenSize;
+	std::vector<float> gates( 2 * hiddenSize );
+	std::vector<float> resetOutput( hiddenSize );
+	const float* hPrev = initialOutput;
+	for( int step = 0; step < seqLength; ++step ) {
+		const int pos = reverse ? seqLength - 1 - step : step;
+		for( int b = 0; b < batchSize; ++b ) {
+			for( int g = 0; g < 2 * hiddenSize; ++g ) {
+				gates[g] = gateWx[( pos * batchSize + b ) * 2 * hiddenSize + g];
+				if( hPrev != nullptr ) {
+					for( int i = 0; i < hiddenSize; ++i ) {
+						gates[g] += hPrev[b * hiddenSize + i] * gateWeights[g * hiddenSize + i];
+					}
+				}
+				gates[g] = sigmoid( gates[g] );
+			}
+			for( int i = 0; i < hiddenSize; ++i ) {
+				resetOutput[i] = hPrev == nullptr ? 0.f : gates[hiddenSize + i] * hPrev[b * hiddenSize + i];
+			}
+			for( int i = 0; i < hiddenSize; ++i ) {
+				const int index = pos * dataSize + b * hiddenSize + i;
+				float main = mainWx[index];
+				for( int j = 0; j < hiddenSize; ++j ) {
+					main += resetOutput[j] * mainWeights[i * hiddenSize + j];
+				}
+				main = ::tanhf( main );
+				const float prev = hPrev == nullptr ? 0.f : hPrev[b * hiddenSize + i];
+				h[index] = ( 1.f - gates[i] ) * main + gates[i] * prev;
+			}
+		}
+		hPrev = h + pos * dataSize;
+	}
+}
+
+static void gruInferenceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchLengthInterval = params.GetInterval( "BatchLength" );
+	const CInterval batchWidthInterval = params.GetInterval( "BatchWidth" );
+	const CInterval hiddenSizeInterval = params.GetInterval( "HiddenSize" );
+
+	const int batchLength = random.UniformInt( batchLengthInterval.Begin, batchLengthInterval.End );
+	const int batchWidth = random.UniformInt( batchWidthInterval.Begin, batchWidthInterval.End );
+	const int hiddenSize = random.UniformInt( hiddenSizeInterval.Begin, hiddenSizeInterval.End );
+	const bool reverse = random.Next() % 2 == 1;
+	const bool hasInitialOutput = random.Next() % 2 == 1;
+
+	const int dataSize = batchLength * batchWidth * hiddenSize;
+
+	CREATE_FILL_FLOAT_ARRAY( gateWxData, -2.f, 2.f, 2 * dataSize, random );
+	CFloatBlob gateWxBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, 2 * hiddenSize );
+	gateWxBlob.CopyFrom( gateWxData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( mainWxData, -2.f, 2.f, dataSize, random );
+	CFloatBlob mainWxBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	mainWxBlob.CopyFrom( mainWxData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( gateWeightsData, -0.5f, 0.5f, 2 * hiddenSize * hiddenSize, random );
+	CREATE_FILL_FLOAT_ARRAY( mainWeightsData, -0.5f, 0.5f, hiddenSize * hiddenSize, random );
+
+	// The recurrent weights are stored inside wider rows, as the layer passes them inside the full weights
+	const int weightsOffset = random.UniformInt( 0, 3 );
+	const int weightsRowSize = weightsOffset + hiddenSize;
+	std::vector<float> gateFullWeightsData( 2 * hiddenSize * weightsRowSize, 7.f );
+	for( int i = 0; i < 2 * hiddenSize; ++i ) {
+		std::copy( gateWeightsData.begin() + i * hiddenSize, gateWeightsData.begin() + ( i + 1 ) * hiddenSize,
+			gateFullWeightsData.begin() + i * weightsRowSize + weightsOffset );
+	}
+	CFloatBlob gateWeightsBlob( MathEngine(), 1, 2 * hiddenSize, 1, 1, 1, 1, weightsRowSize );
+	gateWeightsBlob.CopyFrom( gateFullWeightsData.data() );
+
+	std::vector<float> mainFullWeightsData( hiddenSize * weightsRowSize, 7.f );
+	for( int i = 0; i < hiddenSize; ++i ) {
+		std::copy( mainWeightsData.begin() + i * hiddenSize, mainWeightsData.begin() + ( i + 1 ) * hiddenSize,
+			mainFullWeightsData.begin() + i * weightsRowSize + weightsOffset );
+	}
+	CFloatBlob mainWeightsBlob( MathEngine(), 1, hiddenSize, 1, 1, 1, 1, weightsRowSize );
+	mainWeightsBlob.CopyFrom( mainFullWeightsData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialOutputData, -1.f, 1.f, batchWidth * hiddenSize, random );
+	CFloatBlob initialOutputBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialOutputBlob.CopyFrom( initialOutputData.data() );
+
+	std::vector<float> expectedData( dataSize );
+	gruRecurrentNaive( reverse, batchLength, batchWidth, hiddenSize, gateWxData.data(), mainWxData.data(),
+		gateWeightsData.data(), mainWeightsData.data(), hasInitialOutput ? initialOutputData.data() : nullptr,
+		expectedData.data() );
+
+	CFloatBlob actualBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	MathEngine().GruRecurrent( reverse, batchLength, batchWidth, hiddenSize, gateWxBlob.GetData(), mainWxBlob.GetData(),
+		gateWeightsBlob.GetData() + weightsOffset, mainWeightsBlob.GetData() + weightsOffset, weightsRowSize,
+		hasInitialOutput ? initialOutputBlob.GetData() : CFloatHandle(), actualBlob.GetData() );
+	std::vector<float> actualData( dataSize );
+	actualBlob.CopyTo( actualData.data() );
+
+	for( int i = 0; i < dataSize; ++i ) {
+		EXPECT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-4f ) );
+	}
+}
+
+class CGruInferenceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CGruInferenceTest, CGruInferenceTest,
+	::testing::Values(
+		CTestParams(
+			"BatchLength = (1..20);"
+			"BatchWidth = (1..10);"
+			"HiddenSize = (1..10);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"BatchLength = (1..10);"
+			"BatchWidth = (20..50);"
+			"HiddenSize = (50..100);"
+			"TestCount = 10;"
+		)
+	)
+);
+
+TEST_P( CGruInferenceTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( gruInferenceTestImpl );
+}
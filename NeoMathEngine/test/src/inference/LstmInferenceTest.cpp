@@ -0,0 +1,143 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static inline float sigmoid( float x )
+{
+	if( x <= 0.f ) {
+		const float e = ::expf( x );
+		return e / ( e + 1.f );
+	} else {
+		return 1.f / ( 1.f + ::expf( -x ) );
+	}
+}
+
+static void lstmRecurrentNaive( bool reverse, int seqLength, int batchSize, int hiddenSize,
+	const float* wx, const float* weights, const float* initialOutput, const float* initialState,
+	float* h, float* c )
+{
+	const int dataSize = batchSize * hiddenSize;
+	std::vector<float> gates( 4 * hiddenSize );
+	const float* hPrev = initialOutput;
+	const float* cPrev = initialState;
+	for( int step = 0; step < seqLength; ++step ) {
+		const int pos = reverse ? seqLength - 1 - step : step;
+		for( int b = 0; b < batchSize; ++b ) {
+			for( int g = 0; g < 4 * hiddenSize; ++g ) {
+				gates[g] = wx[( pos * batchSize + b ) * 4 * hiddenSize + g];
+				if( hPrev != nullptr ) {
+					for( int i = 0; i < hiddenSize; ++i ) {
+						gates[g] += hPrev[b * hiddenSize + i] * weights[g * hiddenSize + i];
+					}
+				}
+			}
+			for( int i = 0; i < hiddenSize; ++i ) {
+				const int index = pos * dataSize + b * hiddenSize + i;
+				const float prevState = cPrev == nullptr ? 0.f : cPrev[b * hiddenSize + i];
+				c[index] = sigmoid( gates[hiddenSize + i] ) * prevState
+					+ sigmoid( gates[2 * hiddenSize + i] ) * ::tanhf( gates[i] );
+				h[index] = sigmoid( gates[3 * hiddenSize + i] ) * ::tanhf( c[index] );
+			}
+		}
+		hPrev = h + pos * dataSize;
+		cPrev = c + pos * dataSize;
+	}
+}
+
+static void lstmInferenceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchLengthInterval = params.GetInterval( "BatchLength" );
+	const CInterval batchWidthInterval = params.GetInterval( "BatchWidth" );
+	const CInterval hiddenSizeInterval = params.GetInterval( "HiddenSize" );
+
+	const int batchLength = random.UniformInt( batchLengthInterval.Begin, batchLengthInterval.End );
+	const int batchWidth = random.UniformInt( batchWidthInterval.Begin, batchWidthInterval.End );
+	const int hiddenSize = random.UniformInt( hiddenSizeInterval.Begin, hiddenSizeInterval.End );
+	const bool reverse = random.Next() % 2 == 1;
+	const bool hasInitialState = random.Next() % 2 == 1;
+
+	const int dataSize = batchLength * batchWidth * hiddenSize;
+
+	CREATE_FILL_FLOAT_ARRAY( wxData, -2.f, 2.f, 4 * dataSize, random );
+	CFloatBlob wxBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, 4 * hiddenSize );
+	wxBlob.CopyFrom( wxData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( weightsData, -0.5f, 0.5f, 4 * hiddenSize * hiddenSize, random );
+	CFloatBlob weightsBlob( MathEngine(), 1, 4 * hiddenSize, 1, 1, 1, 1, hiddenSize );
+	weightsBlob.CopyFrom( weightsData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialOutputData, -1.f, 1.f, batchWidth * hiddenSize, random );
+	CFloatBlob initialOutputBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialOutputBlob.CopyFrom( initialOutputData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialStateData, -1.f, 1.f, batchWidth * hiddenSize, random );
+	CFloatBlob initialStateBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialStateBlob.CopyFrom( initialStateData.data() );
+
+	std::vector<float> expectedH( dataSize );
+	std::vector<float> expectedC( dataSize );
+	lstmRecurrentNaive( reverse, batchLength, batchWidth, hiddenSize, wxData.data(), weightsData.data(),
+		hasInitialState ? initialOutputData.data() : nullptr, hasInitialState ? initialStateData.data() : nullptr,
+		expectedH.data(), expectedC.data() );
+
+	CFloatBlob hBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	CFloatBlob cBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	MathEngine().LstmRecurrent( reverse, batchLength, batchWidth, hiddenSize, wxBlob.GetData(), weightsBlob.GetData(),
+		hasInitialState ? initialOutputBlob.GetData() : CFloatHandle(),
+		hasInitialState ? initialStateBlob.GetData() : CFloatHandle(),
+		hBlob.GetData(), cBlob.GetData() );
+	std::vector<float> actualH( dataSize );
+	hBlob.CopyTo( actualH.data() );
+	std::vector<float> actualC( dataSize );
+	cBlob.CopyTo( actualC.data() );
+
+	for( int i = 0; i < dataSize; ++i ) {
+		EXPECT_TRUE( FloatEq( expectedH[i], actualH[i], 1e-4f ) );
+		EXPECT_TRUE( FloatEq( expectedC[i], actualC[i], 1e-4f ) );
+	}
+}
+
+class CLstmInferenceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CLstmInferenceTest, CLstmInferenceTest,
+	::testing::Values(
+		CTestParams(
+			"BatchLength = (1..20);"
+			"BatchWidth = (1..10);"
+			"HiddenSize = (1..10);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"BatchLength = (1..10);"
+			"BatchWidth = (20..50);"
+			"HiddenSize = (50..100);"
+			"TestCount = 10;"
+		)
+	)
+);
+
+TEST_P( CLstmInferenceTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( lstmInferenceTestImpl );
+}
@@ -0,0 +1,114 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+using namespace std::chrono;
+
+// The blocks passed from one thread to another to be freed there
+struct CMemoryPoolTestMailbox {
+	std::mutex Mutex;
+	std::vector<CMemoryHandle> Handles;
+};
+
+// Allocates and frees memory blocks of different sizes in a loop
+// Every few iterations one block is passed to the next thread instead of being freed
+static void memoryPoolTestThread( IMathEngine& mathEngine, int seed, int iterationCount,
+	CMemoryPoolTestMailbox& ownMailbox, CMemoryPoolTestMailbox& nextMailbox )
+{
+	CRandom random( seed );
+	mathEngine.SetReuseMemoryMode( true );
+
+	const int blockCount = 4;
+	CMemoryHandle blocks[blockCount];
+	std::vector<CMemoryHandle> received;
+	for( int i = 0; i < iterationCount; ++i ) {
+		for( int j = 0; j < blockCount; ++j ) {
+			blocks[j] = mathEngine.HeapAlloc( random.UniformInt( 1, 64 * 1024 ) );
+		}
+		CMemoryHandle stackBlock = mathEngine.StackAlloc( random.UniformInt( 1, 4 * 1024 ) );
+		mathEngine.StackFree( stackBlock );
+
+		for( int j = 0; j < blockCount - 1; ++j ) {
+			mathEngine.HeapFree( blocks[j] );
+		}
+		if( i % 8 == 0 ) {
+			std::lock_guard<std::mutex> lock( nextMailbox.Mutex );
+			nextMailbox.Handles.push_back( blocks[blockCount - 1] );
+		} else {
+			mathEngine.HeapFree( blocks[blockCount - 1] );
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( ownMailbox.Mutex );
+			received.swap( ownMailbox.Handles );
+		}
+		for( size_t j = 0; j < received.size(); ++j ) {
+			mathEngine.HeapFree( received[j] );
+		}
+		received.clear();
+	}
+	// Releases the stack memory of the thread
+	mathEngine.CleanUp();
+}
+
+TEST( CMemoryPoolPerformanceTest, MultiThreadAllocFree )
+{
+	const size_t memoryLimit = 1024 * 1024 * 1024;
+	std::unique_ptr<IMathEngine> mathEngine( CreateCpuMathEngine( 1, memoryLimit ) );
+
+	const int threadCount = std::max( 2, std::min( 16, static_cast<int>( std::thread::hardware_concurrency() ) ) );
+	const int iterationCount = 20000;
+	std::vector<CMemoryPoolTestMailbox> mailboxes( threadCount );
+
+	auto startTime = high_resolution_clock::now();
+	std::vector<std::thread> threads;
+	for( int i = 0; i < threadCount; ++i ) {
+		threads.push_back( std::thread( memoryPoolTestThread, std::ref( *mathEngine ), i + 1, iterationCount,
+			std::ref( mailboxes[i] ), std::ref( mailboxes[( i + 1 ) % threadCount] ) ) );
+	}
+	for( size_t i = 0; i < threads.size(); ++i ) {
+		threads[i].join();
+	}
+	auto stopTime = high_resolution_clock::now();
+
+	// The blocks passed after the receiver has finished
+	for( int i = 0; i < threadCount; ++i ) {
+		for( size_t j = 0; j < mailboxes[i].Handles.size(); ++j ) {
+			mathEngine->HeapFree( mailboxes[i].Handles[j] );
+		}
+	}
+
+	CMemoryPoolStatistics statistics;
+	mathEngine->GetMemoryPoolStatistics( statistics );
+	GTEST_LOG_( INFO ) << "Threads: " << threadCount << ", allocations: " << statistics.AllocCount
+		<< ", time: " << std::setprecision( 3 ) << ( stopTime - startTime ).count() / 1e6 << " ms." << std::endl
+		<< "Pool hits: " << statistics.PoolHitCount << ", cross-thread frees: " << statistics.CrossThreadFreeCount
+		<< ", device allocations: " << statistics.DeviceAllocCount;
+
+	EXPECT_EQ( statistics.AllocCount, statistics.FreeCount );
+	EXPECT_GT( statistics.PoolHitCount, 0u );
+	EXPECT_GT( statistics.CrossThreadFreeCount, 0u );
+	EXPECT_LT( statistics.DeviceAllocCount, statistics.AllocCount );
+	EXPECT_EQ( memoryLimit, mathEngine->GetFreeMemorySize() );
+}
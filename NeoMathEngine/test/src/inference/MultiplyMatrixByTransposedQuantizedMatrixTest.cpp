@@ -0,0 +1,251 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <chrono>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+using namespace std::chrono;
+
+// Packs the int8 matrix rows by 4 values into integers
+static std::vector<int> packInt8Rows( const std::vector<int>& values, int height, int width )
+{
+	const int rowSize = ( width + 3 ) / 4;
+	std::vector<int> result( height * rowSize, 0 );
+	for( int i = 0; i < height; ++i ) {
+		signed char* row = reinterpret_cast<signed char*>( result.data() + i * rowSize );
+		for( int j = 0; j < width; ++j ) {
+			row[j] = static_cast<signed char>( values[i * width + j] );
+		}
+	}
+	return result;
+}
+
+static void multiplyMatrixByTransposedQuantizedMatrixTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+
+	const int firstHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int secondHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int width = random.UniformInt( widthInterval.Begin, widthInterval.End );
+	const bool hasFreeTerm = random.Next() % 2 == 1;
+	const float firstScale = static_cast<float>( random.Uniform( 0.01, 0.1 ) );
+
+	CREATE_FILL_FLOAT_ARRAY( first, -15.f, 15.f, firstHeight * width, random )
+	CREATE_FILL_INT_ARRAY( second, -127, 127, secondHeight * width, random )
+	CREATE_FILL_FLOAT_ARRAY( secondScales, 0.001f, 0.01f, secondHeight, random )
+	CREATE_FILL_FLOAT_ARRAY( freeTerm, -1.f, 1.f, secondHeight, random )
+	std::vector<int> packedSecond = packInt8Rows( second, secondHeight, width );
+
+	std::vector<float> expected( firstHeight * secondHeight );
+	for( int i = 0; i < firstHeight; ++i ) {
+		for( int j = 0; j < secondHeight; ++j ) {
+			int sum = 0;
+			for( int k = 0; k < width; ++k ) {
+				const float value = std::min( 127.f, std::max( -127.f, first[i * width + k] / firstScale ) );
+				sum += static_cast<int>( std::nearbyint( value ) ) * second[j * width + k];
+			}
+			expected[i * secondHeight + j] = firstScale * secondScales[j] * sum + ( hasFreeTerm ? freeTerm[j] : 0.f );
+		}
+	}
+
+	std::vector<float> result( firstHeight * secondHeight );
+	{
+		CFloatWrapper freeTermWrapper( MathEngine(), freeTerm.data(), secondHeight );
+		CConstFloatHandle freeTermHandle = freeTermWrapper;
+		MathEngine().MultiplyMatrixByTransposedQuantizedMatrix( CARRAY_FLOAT_WRAPPER( first ), firstHeight, width,
+			firstScale, CARRAY_INT_WRAPPER( packedSecond ), CARRAY_FLOAT_WRAPPER( secondScales ), secondHeight,
+			hasFreeTerm ? &freeTermHandle : nullptr, CARRAY_FLOAT_WRAPPER( result ) );
+	}
+
+	// The rounding of the values exactly between two integers may differ
+	const float tolerance = firstScale * 0.01f * 127 + 1e-3f;
+	for( int i = 0; i < firstHeight * secondHeight; ++i ) {
+		ASSERT_NEAR( expected[i], result[i], tolerance );
+	}
+}
+
+static void blobQuantizedConvolutionTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval sizeInterval = params.GetInterval( "Size" );
+	const CInterval channelsInterval = params.GetInterval( "Channels" );
+	const CInterval filterSizeInterval = params.GetInterval( "FilterSize" );
+	const CInterval strideInterval = params.GetInterval( "Stride" );
+
+	const int batchSize = random.UniformInt( 1, 3 );
+	const int height = random.UniformInt( sizeInterval.Begin, sizeInterval.End );
+	const int width = random.UniformInt( sizeInterval.Begin, sizeInterval.End );
+	const int channels = random.UniformInt( channelsInterval.Begin, channelsInterval.End );
+	const int filterCount = random.UniformInt( channelsInterval.Begin, channelsInterval.End );
+	const int filterHeight = std::min( height, random.UniformInt( filterSizeInterval.Begin, filterSizeInterval.End ) );
+	const int filterWidth = std::min( width, random.UniformInt( filterSizeInterval.Begin, filterSizeInterval.End ) );
+	const int stride = random.UniformInt( strideInterval.Begin, strideInterval.End );
+	const int padding = random.UniformInt( 0, ( filterHeight - 1 ) / 2 );
+	const int outputHeight = ( height + 2 * padding - filterHeight ) / stride + 1;
+	const int outputWidth = ( width + 2 * padding - filterWidth ) / stride + 1;
+
+	// The values are the exact multiples of the power of two scales, so the float convolution gives the same result
+	const float sourceScale = 0.125f;
+	const int filterSize = filterHeight * filterWidth * channels;
+	CREATE_FILL_INT_ARRAY( sourceInt, -127, 127, batchSize * height * width * channels, random )
+	CREATE_FILL_INT_ARRAY( filterInt, -127, 127, filterCount * filterSize, random )
+	CREATE_FILL_FLOAT_ARRAY( freeTermData, -1.f, 1.f, filterCount, random )
+	std::vector<float> filterScales( filterCount );
+	for( int i = 0; i < filterCount; ++i ) {
+		filterScales[i] = 1.f / ( 1 << random.UniformInt( 5, 8 ) );
+	}
+
+	std::vector<float> sourceData( sourceInt.size() );
+	for( size_t i = 0; i < sourceInt.size(); ++i ) {
+		sourceData[i] = sourceInt[i] * sourceScale;
+	}
+	std::vector<float> filterData( filterInt.size() );
+	for( size_t i = 0; i < filterInt.size(); ++i ) {
+		filterData[i] = filterInt[i] * filterScales[i / filterSize];
+	}
+	std::vector<int> packedFilter = packInt8Rows( filterInt, filterCount, filterSize );
+
+	CFloatBlob source( MathEngine(), batchSize, 1, 1, height, width, 1, channels );
+	source.CopyFrom( sourceData.data() );
+	CFloatBlob filter( MathEngine(), filterCount, filterHeight, filterWidth, 1, channels );
+	filter.CopyFrom( filterData.data() );
+	CFloatBlob freeTerm( MathEngine(), 1, 1, 1, filterCount );
+	freeTerm.CopyFrom( freeTermData.data() );
+	CFloatBlob expectedBlob( MathEngine(), batchSize, 1, 1, outputHeight, outputWidth, 1, filterCount );
+	CFloatBlob resultBlob( MathEngine(), batchSize, 1, 1, outputHeight, outputWidth, 1, filterCount );
+
+	CConvolutionDesc* desc = MathEngine().InitBlobConvolution( source.GetDesc(), padding, padding, stride, stride, 1, 1,
+		filter.GetDesc(), resultBlob.GetDesc() );
+	CFloatHandle freeTermHandle = freeTerm.GetData();
+	MathEngine().BlobConvolution( *desc, source.GetData(), filter.GetData(), &freeTermHandle, expectedBlob.GetData() );
+	{
+		CIntWrapper packedFilterWrapper( MathEngine(), packedFilter.data(), static_cast<int>( packedFilter.size() ) );
+		CFloatWrapper filterScalesWrapper( MathEngine(), filterScales.data(), filterCount );
+		MathEngine().BlobQuantizedConvolution( *desc, source.GetData(), sourceScale, packedFilterWrapper,
+			filterScalesWrapper, &freeTermHandle, resultBlob.GetData() );
+	}
+	delete desc;
+
+	std::vector<float> expected( expectedBlob.GetDesc().BlobSize() );
+	expectedBlob.CopyTo( expected.data() );
+	std::vector<float> result( resultBlob.GetDesc().BlobSize() );
+	resultBlob.CopyTo( result.data() );
+	for( size_t i = 0; i < expected.size(); ++i ) {
+		ASSERT_NEAR( expected[i], result[i], 1e-3f + 1e-5f * std::fabs( expected[i] ) );
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class CMultiplyMatrixByTransposedQuantizedMatrixTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CMultiplyMatrixByTransposedQuantizedMatrixTestInstantiation, CMultiplyMatrixByTransposedQuantizedMatrixTest,
+	::testing::Values(
+		CTestParams(
+			"Height = (1..50);"
+			"Width = (1..50);"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"Height = (100..300);"
+			"Width = (100..600);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CMultiplyMatrixByTransposedQuantizedMatrixTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( multiplyMatrixByTransposedQuantizedMatrixTestImpl )
+}
+
+class CBlobQuantizedConvolutionTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CBlobQuantizedConvolutionTestInstantiation, CBlobQuantizedConvolutionTest,
+	::testing::Values(
+		CTestParams(
+			"Size = (3..20);"
+			"Channels = (1..40);"
+			"FilterSize = (1..5);"
+			"Stride = (1..2);"
+			"TestCount = 50;"
+		)
+	)
+);
+
+TEST_P( CBlobQuantizedConvolutionTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( blobQuantizedConvolutionTestImpl )
+}
+
+// Compares the quantized matrix multiplication time with the float one on a fully connected layer size
+TEST( CMultiplyMatrixByTransposedQuantizedMatrixPerformanceTest, CompareWithFloat )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x1E3 );
+	const int firstHeight = 64;
+	const int width = 1024;
+	const int secondHeight = 1024;
+	const int runCount = 20;
+
+	CREATE_FILL_FLOAT_ARRAY( first, -1.f, 1.f, firstHeight * width, random )
+	CREATE_FILL_FLOAT_ARRAY( second, -1.f, 1.f, secondHeight * width, random )
+	CREATE_FILL_INT_ARRAY( secondInt, -127, 127, secondHeight * width, random )
+	CREATE_FILL_FLOAT_ARRAY( secondScales, 0.001f, 0.01f, secondHeight, random )
+	std::vector<int> packedSecond = packInt8Rows( secondInt, secondHeight, width );
+	std::vector<float> result( firstHeight * secondHeight );
+
+	CFloatWrapper firstWrapper( MathEngine(), first.data(), firstHeight * width );
+	CFloatWrapper secondWrapper( MathEngine(), second.data(), secondHeight * width );
+	CIntWrapper packedSecondWrapper( MathEngine(), packedSecond.data(), static_cast<int>( packedSecond.size() ) );
+	CFloatWrapper secondScalesWrapper( MathEngine(), secondScales.data(), secondHeight );
+	CFloatWrapper resultWrapper( MathEngine(), result.data(), firstHeight * secondHeight );
+
+	auto startTime = high_resolution_clock::now();
+	for( int i = 0; i < runCount; ++i ) {
+		MathEngine().MultiplyMatrixByTransposedMatrix( firstWrapper, firstHeight, width, width,
+			secondWrapper, secondHeight, width, resultWrapper, secondHeight, firstHeight * secondHeight );
+	}
+	const double floatTime = ( high_resolution_clock::now() - startTime ).count() / 1e6 / runCount;
+
+	startTime = high_resolution_clock::now();
+	for( int i = 0; i < runCount; ++i ) {
+		MathEngine().MultiplyMatrixByTransposedQuantizedMatrix( firstWrapper, firstHeight, width, 1.f / 127,
+			packedSecondWrapper, secondScalesWrapper, secondHeight, nullptr, resultWrapper );
+	}
+	const double quantizedTime = ( high_resolution_clock::now() - startTime ).count() / 1e6 / runCount;
+
+	GTEST_LOG_( INFO ) << firstHeight << " x " << width << " by " << secondHeight << " x " << width << std::endl
+		<< "Float time: " << std::setprecision( 3 ) << floatTime << " ms., quantized time: " << quantizedTime
+		<< " ms., speedup: " << floatTime / quantizedTime;
+}
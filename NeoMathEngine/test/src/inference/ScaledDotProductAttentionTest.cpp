@@ -0,0 +1,145 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void scaledDotProductAttentionNaive( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+	float scale, const float* q, const float* k, const float* v, const float* mask, float* result )
+{
+	const int rowSize = headCount * headSize;
+	std::vector<float> scores( keyLength );
+	for( int b = 0; b < batchSize; ++b ) {
+		for( int h = 0; h < headCount; ++h ) {
+			for( int i = 0; i < queryLength; ++i ) {
+				const float* query = q + ( b * queryLength + i ) * rowSize + h * headSize;
+				float maxScore = -FLT_MAX;
+				for( int j = 0; j < keyLength; ++j ) {
+					const float* key = k + ( b * keyLength + j ) * rowSize + h * headSize;
+					float score = 0;
+					for( int d = 0; d < headSize; ++d ) {
+						score += query[d] * key[d];
+					}
+					scores[j] = score * scale + ( mask == nullptr ? 0.f : mask[i * keyLength + j] );
+					maxScore = std::max( maxScore, scores[j] );
+				}
+				float sum = 0;
+				for( int j = 0; j < keyLength; ++j ) {
+					scores[j] = ::expf( scores[j] - maxScore );
+					sum += scores[j];
+				}
+				float* output = result + ( b * queryLength + i ) * rowSize + h * headSize;
+				for( int d = 0; d < headSize; ++d ) {
+					float value = 0;
+					for( int j = 0; j < keyLength; ++j ) {
+						value += scores[j] * v[( b * keyLength + j ) * rowSize + h * headSize + d];
+					}
+					output[d] = value / sum;
+				}
+			}
+		}
+	}
+}
+
+static void scaledDotProductAttentionTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchSizeInterval = params.GetInterval( "BatchSize" );
+	const CInterval headCountInterval = params.GetInterval( "HeadCount" );
+	const CInterval queryLengthInterval = params.GetInterval( "QueryLength" );
+	const CInterval keyLengthInterval = params.GetInterval( "KeyLength" );
+	const CInterval headSizeInterval = params.GetInterval( "HeadSize" );
+
+	const int batchSize = random.UniformInt( batchSizeInterval.Begin, batchSizeInterval.End );
+	const int headCount = random.UniformInt( headCountInterval.Begin, headCountInterval.End );
+	const int queryLength = random.UniformInt( queryLengthInterval.Begin, queryLengthInterval.End );
+	const int keyLength = random.UniformInt( keyLengthInterval.Begin, keyLengthInterval.End );
+	const int headSize = random.UniformInt( headSizeInterval.Begin, headSizeInterval.End );
+	const bool hasMask = random.Next() % 2 == 1;
+	const float scale = static_cast<float>( 1. / sqrt( 1. * headSize ) );
+
+	const int rowSize = headCount * headSize;
+	const int querySize = batchSize * queryLength * rowSize;
+	const int keySize = batchSize * keyLength * rowSize;
+
+	CREATE_FILL_FLOAT_ARRAY( qData, -2.f, 2.f, querySize, random );
+	CFloatBlob qBlob( MathEngine(), 1, batchSize, queryLength, 1, 1, 1, rowSize );
+	qBlob.CopyFrom( qData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( kData, -2.f, 2.f, keySize, random );
+	CFloatBlob kBlob( MathEngine(), 1, batchSize, keyLength, 1, 1, 1, rowSize );
+	kBlob.CopyFrom( kData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( vData, -2.f, 2.f, keySize, random );
+	CFloatBlob vBlob( MathEngine(), 1, batchSize, keyLength, 1, 1, 1, rowSize );
+	vBlob.CopyFrom( vData.data() );
+
+	// The mask excludes some of the keys, as the attention layer does
+	std::vector<float> maskData( queryLength * keyLength );
+	for( size_t i = 0; i < maskData.size(); ++i ) {
+		maskData[i] = random.Next() % 5 == 0 ? -1e9f : 0.f;
+	}
+	CFloatBlob maskBlob( MathEngine(), 1, 1, 1, 1, queryLength, 1, keyLength );
+	maskBlob.CopyFrom( maskData.data() );
+
+	std::vector<float> expectedData( querySize );
+	scaledDotProductAttentionNaive( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		qData.data(), kData.data(), vData.data(), hasMask ? maskData.data() : nullptr, expectedData.data() );
+
+	CFloatBlob actualBlob( MathEngine(), 1, batchSize, queryLength, 1, 1, 1, rowSize );
+	MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		qBlob.GetData(), kBlob.GetData(), vBlob.GetData(), hasMask ? maskBlob.GetData() : CFloatHandle(),
+		actualBlob.GetData() );
+	std::vector<float> actualData( querySize );
+	actualBlob.CopyTo( actualData.data() );
+
+	for( int i = 0; i < querySize; ++i ) {
+		EXPECT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-4f ) );
+	}
+}
+
+class CScaledDotProductAttentionTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CScaledDotProductAttentionTest, CScaledDotProductAttentionTest,
+	::testing::Values(
+		CTestParams(
+			"BatchSize = (1..3);"
+			"HeadCount = (1..4);"
+			"QueryLength = (1..10);"
+			"KeyLength = (1..10);"
+			"HeadSize = (1..8);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"BatchSize = (1..2);"
+			"HeadCount = (1..4);"
+			"QueryLength = (20..80);"
+			"KeyLength = (100..300);"
+			"HeadSize = (16..64);"
+			"TestCount = 10;"
+		)
+	)
+);
+
+TEST_P( CScaledDotProductAttentionTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( scaledDotProductAttentionTestImpl );
+}